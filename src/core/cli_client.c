@@ -261,5 +261,8 @@ int HandleCliCommandLocally(char *cmd_buf, char *db_file)
 
     err = CLI_SERVER_ExecuteCliCommand(cmd_buf);
 
+    // Close the database, ensuring that any writes queued by the command have been written to it
+    DATABASE_Destroy();
+
     return err;
 }
@@ -58,8 +58,11 @@
 #include "data_model.h"
 #include "device.h"
 #include "database.h"
+#include "db_bench.h"
+#include "dm_bench.h"
 #include "path_resolver.h"
 #include "dm_trans.h"
+#include "dm_key_index.h"
 #include "expr_vector.h"
 #include "text_utils.h"
 #include "version.h"
@@ -85,6 +88,8 @@ int ExecuteCli_Perm(char *arg1, char *arg2, char *usage);
 int ExecuteCli_DbGet(char *param, char *arg2, char *usage);
 int ExecuteCli_DbSet(char *param, char *value, char *usage);
 int ExecuteCli_DbDel(char *param, char *arg2, char *usage);
+int ExecuteCli_DbBench(char *dir, char *arg2, char *usage);
+int ExecuteCli_DmBench(char *name, char *arg2, char *usage);
 int ExecuteCli_Verbose(char *level, char *arg2, char *usage);
 int ExecuteCli_ProtoTrace(char *level, char *arg2, char *usage);
 int ExecuteCli_Stop(char *arg1, char *arg2, char *usage);
@@ -135,11 +140,13 @@ cli_cmd_t cli_commands[] =
     { "operate", 1, RUN_REMOTELY, ExecuteCli_Operate,"operate [operation]"},
     { "instances", 1, RUN_REMOTELY, ExecuteCli_GetInstances,   "instances [path-expr]" },
     { "show",    1, RUN_LOCALLY,  ExecuteCli_Show,  "show ['datamodel' | 'database' ]"},
-    { "dump",    1, RUN_REMOTELY, ExecuteCli_Dump,  "dump ['memory' | 'mdelta' | 'subscriptions' | 'instances' ]"},
+    { "dump",    1, RUN_REMOTELY, ExecuteCli_Dump,  "dump ['memory' | 'mdelta' | 'subscriptions' | 'instances' | 'pathcache' | 'dbcache' | 'startup' ]"},
     { "perm",    1, RUN_REMOTELY, ExecuteCli_Perm,  "perm [parameter or object]"},
     { "dbget",   1, RUN_LOCALLY,  ExecuteCli_DbGet, "dbget [parameter]"},
     { "dbset",   2, RUN_LOCALLY,  ExecuteCli_DbSet, "dbset [parameter] [value]"},
     { "dbdel",   1, RUN_LOCALLY,  ExecuteCli_DbDel, "dbdel [parameter]"},
+    { "dbbench", 1, RUN_LOCALLY,  ExecuteCli_DbBench, "dbbench [scratch directory]"},
+    { "dmbench", 1, RUN_REMOTELY, ExecuteCli_DmBench, "dmbench ['dbcache' | 'delete' | 'watch' | 'instances' | 'resolve' | 'nested' | 'perms' ]"},
     { "verbose", 1, RUN_REMOTELY, ExecuteCli_Verbose, "verbose [level]"},
     { "prototrace", 1, RUN_REMOTELY, ExecuteCli_ProtoTrace, "prototrace [enable]"},
     { "stop",    0, RUN_REMOTELY, ExecuteCli_Stop, "stop"},
@@ -1221,6 +1228,27 @@ int ExecuteCli_Dump(char *arg1, char *arg2, char *usage)
         return USP_ERR_OK;
     }
 
+    // Show the hit/miss statistics of the data model path cache, if required
+    if (strcmp(arg1, "pathcache")==0)
+    {
+        DATA_MODEL_DumpPathCache();
+        return USP_ERR_OK;
+    }
+
+    // Show the hit/miss statistics of the database value cache, if required
+    if (strcmp(arg1, "dbcache")==0)
+    {
+        DATABASE_DumpCache();
+        return USP_ERR_OK;
+    }
+
+    // Show the time taken by each phase of starting the data model, if required
+    if (strcmp(arg1, "startup")==0)
+    {
+        DATA_MODEL_DumpStartupTimes();
+        return USP_ERR_OK;
+    }
+
     // If the code gets here, there is an unknown value for arg1
     SendCliResponse_InvalidValue(arg1, usage);
     return USP_ERR_INVALID_ARGUMENTS;
@@ -1411,12 +1439,61 @@ int ExecuteCli_DbDel(char *param, char *arg2, char *usage)
         return err;
     }
 
+    // Discard the unique key indexes, as the database has been modified without going through the data model
+    DM_KEY_INDEX_InvalidateAll();
+
     // If the code gets here, deletion was successful
     SendCliResponse("Deleted %s\n", param);
 
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** ExecuteCli_DbBench
+**
+** Executes the dbbench CLI command
+**
+** \param   dir - directory in which the benchmark creates its scratch database files. These are deleted after use
+** \param   arg2 - unused
+** \param   usage - pointer to string containing usage info for this command
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int ExecuteCli_DbBench(char *dir, char *arg2, char *usage)
+{
+    // NOTE: The benchmark only uses (and deletes) files that it has created itself, so it cannot overwrite the agent's database
+    return DB_BENCH_Run(dir);
+}
+
+/*********************************************************************//**
+**
+** ExecuteCli_DmBench
+**
+** Executes the dmbench CLI command
+**
+** \param   name - name of the benchmark to run
+** \param   arg2 - unused
+** \param   usage - pointer to string containing usage info for this command
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int ExecuteCli_DmBench(char *name, char *arg2, char *usage)
+{
+    int err;
+
+    // NOTE: The benchmark runs within a transaction which is aborted, so it leaves the agent's data model unchanged
+    err = DM_BENCH_Run(name);
+    if (err == USP_ERR_INVALID_ARGUMENTS)
+    {
+        SendCliResponse_InvalidValue(name, usage);
+    }
+
+    return err;
+}
+
 /*********************************************************************//**
 **
 ** ExecuteCli_Verbose
@@ -111,7 +111,10 @@ typedef struct
 } coap_client_t;
 
 
-coap_client_t coap_clients[MAX_COAP_CLIENTS];
+// Array of CoAP clients, grown on demand
+// NOTE: This is an array of pointers, so that a CoAP client does not move in memory once allocated
+coap_client_t **coap_clients = NULL;
+int num_coap_clients = 0;
 
 //------------------------------------------------------------------------------
 // USP Message to send in queue
@@ -182,17 +185,9 @@ void RemoveExpiredCoapMessages(coap_client_t *cc);
 **************************************************************************/
 int COAP_CLIENT_Init(void)
 {
-    int i;
-    coap_client_t *cc;
-    
-    // Initialise the CoAP clients array
-    memset(coap_clients, 0, sizeof(coap_clients));
-    for (i=0; i<MAX_COAP_CLIENTS; i++)
-    {
-        cc = &coap_clients[i];
-        cc->cont_instance = INVALID;
-        cc->socket_fd = INVALID;
-    }
+    // Start with no CoAP client slots. These are allocated as CoAP clients are started
+    coap_clients = NULL;
+    num_coap_clients = 0;
 
     return USP_ERR_OK;
 }
@@ -238,15 +233,22 @@ void COAP_CLIENT_Destroy(void)
     coap_client_t *cc;
     
     // Free all CoAP clients
-    for (i=0; i<MAX_COAP_CLIENTS; i++)
+    for (i=0; i<num_coap_clients; i++)
     {
-        cc = &coap_clients[i];
+        cc = coap_clients[i];
         if (cc->cont_instance != INVALID)
         {
             COAP_CLIENT_Stop(cc->cont_instance, cc->mtp_instance);
         }
     }
 
+    // Free all CoAP client slots
+    for (i=0; i<num_coap_clients; i++)
+    {
+        USP_FREE(coap_clients[i]);
+    }
+    USP_SAFE_FREE(coap_clients);
+    num_coap_clients = 0;
 }
 
 /*********************************************************************//**
@@ -397,9 +399,9 @@ void COAP_CLIENT_UpdateAllSockSet(socket_set_t *set)
     #define CALC_TIMEOUT(res, t) res = t - cur_time; if (res < 0) { res = 0; }
     
     // Add all CoAP client sockets (these receive CoAP ACK packets from the controller)
-    for (i=0; i<MAX_COAP_CLIENTS; i++)
+    for (i=0; i<num_coap_clients; i++)
     {
-        cc = &coap_clients[i];
+        cc = coap_clients[i];
         if (cc->cont_instance != INVALID)
         {
             if (cc->socket_fd != INVALID)
@@ -451,9 +453,9 @@ void COAP_CLIENT_ProcessAllSocketActivity(socket_set_t *set)
     cur_time = time(NULL);
 
     // Service all CoAP client sockets (these receive CoAP ACK packets from the controller)
-    for (i=0; i<MAX_COAP_CLIENTS; i++)
+    for (i=0; i<num_coap_clients; i++)
     {
-        cc = &coap_clients[i];
+        cc = coap_clients[i];
         if (cc->cont_instance != INVALID)
         {
             if (cc->socket_fd != INVALID)
@@ -595,9 +597,9 @@ bool COAP_CLIENT_AreAllResponsesSent(void)
     coap_client_t *cc;
 
     // Iterate over all CoAP clients, seeing if there are any messages which are still being sent out and have not been fully acknowledged
-    for (i=0; i<MAX_COAP_CLIENTS; i++)
+    for (i=0; i<num_coap_clients; i++)
     {
-        cc = &coap_clients[i];
+        cc = coap_clients[i];
         if (cc->cont_instance != INVALID)
         {
             if (cc->send_queue.head != NULL)
@@ -1518,11 +1520,12 @@ int CalcCoapInitialTimeout(void)
 **
 ** FindUnusedCoapClient
 **
-** Finds an unused CoAP client slot
+** Finds an unused CoAP client slot, allocating a new slot if all slots are in use
+** NOTE: This function must be called with the CoAP mutex held
 **
 ** \param   None
 **
-** \return  pointer to free CoAP client, or NULL if none found
+** \return  pointer to free CoAP client, or NULL if MAX_COAP_CLIENTS slots are already in use
 **
 **************************************************************************/
 coap_client_t *FindUnusedCoapClient(void)
@@ -1531,17 +1534,32 @@ coap_client_t *FindUnusedCoapClient(void)
     coap_client_t *cc;
     
     // Iterate over all CoAP controllers, trying to find a free slot
-    for (i=0; i<MAX_COAP_CLIENTS; i++)
+    for (i=0; i<num_coap_clients; i++)
     {
-        cc = &coap_clients[i];
+        cc = coap_clients[i];
         if (cc->cont_instance == INVALID)
         {
             return cc;
         }
     }
 
-    // If the code gets here, then no free CoAP clients were found
-    return NULL;
+    // Exit if the table has already grown to its limit
+    if (num_coap_clients >= MAX_COAP_CLIENTS)
+    {
+        return NULL;
+    }
+
+    // If the code gets here, then no free CoAP clients were found, so allocate another slot
+    cc = USP_MALLOC(sizeof(coap_client_t));
+    memset(cc, 0, sizeof(coap_client_t));
+    cc->cont_instance = INVALID;
+    cc->socket_fd = INVALID;
+
+    coap_clients = USP_REALLOC(coap_clients, (num_coap_clients+1)*sizeof(coap_client_t *));
+    coap_clients[num_coap_clients] = cc;
+    num_coap_clients++;
+
+    return cc;
 }
 
 
@@ -1563,9 +1581,9 @@ coap_client_t *FindCoapClientByInstance(int cont_instance, int mtp_instance)
     coap_client_t *cc;
     
     // Iterate over all CoAP clients, trying to find a match
-    for (i=0; i<MAX_COAP_CLIENTS; i++)
+    for (i=0; i<num_coap_clients; i++)
     {
-        cc = &coap_clients[i];
+        cc = coap_clients[i];
         if ((cc->cont_instance == cont_instance) && (cc->mtp_instance == mtp_instance))
         {
             return cc;
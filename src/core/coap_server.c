@@ -128,7 +128,9 @@ typedef struct
     int listen_sock;        // Socket listening for new connections, this socket will get moved to one of the CoAP
                             // sessions when a new packet is received, and a new listening socket will take its place
 
-    coap_server_session_t sessions[MAX_COAP_SERVER_SESSIONS]; // concurrent communication sessions with this server
+    coap_server_session_t **sessions; // concurrent communication sessions with this server. Sessions are allocated on demand
+                            // NOTE: This is an array of pointers, because the SSL object for a session holds a pointer into the session
+    int num_sessions;       // Number of sessions allocated. This never exceeds MAX_COAP_SERVER_SESSIONS
 
 } coap_server_t;
 
@@ -295,9 +297,7 @@ void COAP_SERVER_Destroy(void)
 **************************************************************************/
 int COAP_SERVER_Start(int instance, char *interface, coap_config_t *config)
 {
-    int j;
     coap_server_t *cs;
-    coap_server_session_t *css;
     int err = USP_ERR_OK;
 
     COAP_LockMutex();
@@ -328,14 +328,10 @@ int COAP_SERVER_Start(int instance, char *interface, coap_config_t *config)
     cs->listen_resource = USP_STRDUP(config->resource);
     cs->enable_encryption = config->enable_encryption;
 
-    // Mark all sockets and CoAP sessions as not in use yet
+    // Mark listening socket as not in use yet. CoAP sessions are allocated when the first packet is received from a peer
     cs->listen_sock = INVALID;
-    for (j=0; j<MAX_COAP_SERVER_SESSIONS; j++)
-    {
-        css = &cs->sessions[j];
-        css->socket_fd = INVALID;
-        css->index = j;
-    }
+    cs->sessions = NULL;
+    cs->num_sessions = 0;
 
     USP_LOG_Info("%s: Starting CoAP server on interface=%s, port=%d (%s), resource=%s", __FUNCTION__, interface, cs->listen_port, IS_ENCRYPTED_STRING(cs->enable_encryption), cs->listen_resource);
 
@@ -400,12 +396,14 @@ int COAP_SERVER_Stop(int instance, char *interface, coap_config_t *unused)
     // Free all dynamically allocated buffers    
     USP_SAFE_FREE(cs->listen_resource);
 
-    // Close all session sockets and any associated SSL, BIO objects and buffers
-    for (i=0; i<MAX_COAP_SERVER_SESSIONS; i++)
+    // Close all session sockets and any associated SSL, BIO objects and buffers, then free the sessions
+    for (i=0; i<cs->num_sessions; i++)
     {
-        css = &cs->sessions[i];
+        css = cs->sessions[i];
         StopCoapSession(css);
+        USP_FREE(css);
     }
+    USP_SAFE_FREE(cs->sessions);
 
     // Put back to init state
     memset(cs, 0, sizeof(coap_server_t));
@@ -496,9 +494,9 @@ void COAP_SERVER_UpdateAllSockSet(socket_set_t *set)
             }
 
             // Iterate over all existing sessions on this interface
-            for (j=0; j<MAX_COAP_SERVER_SESSIONS; j++)
+            for (j=0; j<cs->num_sessions; j++)
             {
-                css = &cs->sessions[j];
+                css = cs->sessions[j];
                 if (css->socket_fd != INVALID)
                 {
                     SOCKET_SET_AddSocketToReceiveFrom(css->socket_fd, MAX_SOCKET_TIMEOUT, set);
@@ -532,9 +530,9 @@ void COAP_SERVER_ProcessAllSocketActivity(socket_set_t *set)
         if (cs->instance != INVALID)
         {
             // Service existing connections
-            for (j=0; j<MAX_COAP_SERVER_SESSIONS; j++)
+            for (j=0; j<cs->num_sessions; j++)
             {
-                css = &cs->sessions[j];
+                css = cs->sessions[j];
                 if (css->socket_fd != INVALID)
                 {
                     if (SOCKET_SET_IsReadyToRead(css->socket_fd, set))
@@ -580,9 +578,9 @@ bool COAP_SERVER_AreNoOutstandingIncomingMessages(void)
         cs = &coap_servers[i];
         if (cs->instance != INVALID)
         {
-            for (j=0; j<MAX_COAP_SERVER_SESSIONS; j++)
+            for (j=0; j<cs->num_sessions; j++)
             {
-                css = &cs->sessions[j];
+                css = cs->sessions[j];
                 if (css->usp_buf_len != 0)
                 {
                     return false;
@@ -865,7 +863,8 @@ int GetPeerAddr(int sock, nu_ipaddr_t *peer_addr, uint16_t *peer_port)
 ** FindCoapSession
 **
 ** Gets a new CoAP session on which to process the new PDU
-** NOTE: This function may shutdown an unused session in order to achieve this
+** Sessions are allocated on demand, up to MAX_COAP_SERVER_SESSIONS per server
+** NOTE: Once that limit is reached, this function may shutdown an existing session in order to achieve this
 **
 ** \param   cs - pointer to coap server
 ** \param   peer_addr - IP address of peer that is starting a new session
@@ -883,20 +882,34 @@ coap_server_session_t *FindCoapSession(coap_server_t *cs, nu_ipaddr_t *peer_addr
     coap_server_session_t *chosen_css = NULL;
 
     // Exit if there is an existing unused session
-    for (j=0; j<MAX_COAP_SERVER_SESSIONS; j++)
+    for (j=0; j<cs->num_sessions; j++)
     {
-        css = &cs->sessions[j];
+        css = cs->sessions[j];
         if (css->socket_fd == INVALID)
         {
             return css;
         }
     }
 
+    // Exit if there is room to allocate another session
+    if (cs->num_sessions < MAX_COAP_SERVER_SESSIONS)
+    {
+        css = USP_MALLOC(sizeof(coap_server_session_t));
+        memset(css, 0, sizeof(coap_server_session_t));
+        css->socket_fd = INVALID;
+        css->index = cs->num_sessions;
+
+        cs->sessions = USP_REALLOC(cs->sessions, (cs->num_sessions+1)*sizeof(coap_server_session_t *));
+        cs->sessions[cs->num_sessions] = css;
+        cs->num_sessions++;
+        return css;
+    }
+
     // Iterate over all existing sessions, choosing the one with the highest score
     cur_time = time(NULL);
-    for (j=0; j<MAX_COAP_SERVER_SESSIONS; j++)
+    for (j=0; j<cs->num_sessions; j++)
     {
-        css = &cs->sessions[j];
+        css = cs->sessions[j];
         if (css->socket_fd != INVALID)
         {
             // Choose to reuse sessions with longest inactive time
@@ -2273,9 +2286,9 @@ int UpdateCoapServerInterfaces(void)
             if ((has_changed) && (has_addr))
             {
                 USP_LOG_Error("%s: Restarting CoAP server on interface=%s after IP address change", __FUNCTION__, cs->interface);
-                for (j=0; j<MAX_COAP_SERVER_SESSIONS; j++)
+                for (j=0; j<cs->num_sessions; j++)
                 {
-                    css = &cs->sessions[j];
+                    css = cs->sessions[j];
                     StopCoapSession(css);
                 }
 
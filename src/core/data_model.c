@@ -48,12 +48,14 @@
 #include "database.h"
 #include "int_vector.h"
 #include "dm_inst_vector.h"
+#include "dm_key_index.h"
 #include "dm_trans.h"
 #include "dm_access.h"
 #include "cli.h"
 #include "vendor_api.h"
 #include "text_utils.h"
 #include "iso8601.h"
+#include "uptime.h"
 
 #ifdef ENABLE_COAP
 #include "usp_coap.h"
@@ -64,6 +66,27 @@
 // Boolean that allows us to control which scope the USP_REGISTER_XXX() functions can be called in
 bool is_executing_within_dm_init = false;
 
+//--------------------------------------------------------------------
+// Time taken (in microseconds) by each phase of building and starting the data model at startup
+// These are printed by the 'dump startup' CLI command, to measure cold start latency on the target device
+typedef struct
+{
+    uint64_t core_register;     // Registering the schema nodes implemented by the core agent
+    uint64_t vendor_register;   // VENDOR_Init() - registering the schema nodes implemented by the vendor
+    uint64_t compact;           // Compacting the schema into a single block of memory
+    uint64_t database_start;    // DATABASE_Start() - opening the database and performing any programmatic factory reset
+    uint64_t set_defaults;      // DEVICE_LOCAL_AGENT_SetDefaults()
+    uint64_t seed_instances;    // Seeding the data model with instance numbers from the database
+    uint64_t trust;             // Registering controller trust roles and permissions
+    uint64_t components_start;  // Starting all data model components (including VENDOR_Start)
+} startup_times_t;
+
+static startup_times_t startup_times;
+
+//--------------------------------------------------------------------
+// Number of nodes created in the data model schema. Also used to give each node its registration ordinal
+static unsigned num_schema_nodes = 0;
+
 //--------------------------------------------------------------------
 // Segment of a data model path e.g. "Device" or "LocalAgent"
 typedef struct
@@ -110,14 +133,54 @@ typedef struct
 } node_lookup_t;
 
 
-// This vector is used when reading the database at startup to determine which parameters (in the DB) to delete and which to add
-// based on the current schema
+// This open addressed hash table is used when reading the database at startup to determine which parameters (in the DB) to delete and which to add
+// based on the current schema. It is also used to detect hash collisions when registering parameters in the schema
+// NOTE: Empty slots in the table have node==NULL. The number of slots is always a power of 2
 static node_lookup_t *node_lookup = NULL;
-static int node_lookup_count = 0;
+static int node_lookup_count = 0;       // Number of nodes in the table
+static int node_lookup_size = 0;        // Number of slots in the table
+
+//--------------------------------------------------------------------
+// Block of memory containing all data model schema nodes, their child indexes and strings, once the schema has been compacted
+// NULL if the schema has not been compacted, in which case each node (and its strings) is a separate allocation
+static void *schema_arena = NULL;
+
+#ifdef COMPACT_DM_SCHEMA
+// Structure used to intern the names of nodes whilst compacting the schema
+typedef struct
+{
+    char *name;                 // Name of the node (in its original allocation). NULL if this slot in the table is empty
+    char *arena_name;           // Copy of the name in the schema arena
+} interned_name_t;
+#endif
 
 //--------------------------------------------------------------------
-// Typedef for the compare callback
-typedef int (*dm_cmp_cb_t)(char *lhs, expr_op_t op, char *rhs, bool *result);
+// Cache of the results of DM_PRIV_GetNodeFromPath(), indexed by data model path
+// The least recently used entry is reused when the cache is full
+typedef struct path_cache_entry_tag
+{
+    double_link_t link;                         // Link in the LRU list. NOTE: This must be the first member of this structure
+    struct path_cache_entry_tag *next_in_bucket;// Next entry in the hash bucket chain containing this entry
+    unsigned path_hash;                         // Hash of the path. Used to select the hash bucket
+    unsigned generation;                        // Value of path_cache_generation when this entry was filled in. Entry is stale if this does not match
+    char path[MAX_DM_PATH];                     // Data model path that was resolved
+    dm_node_t *node;                            // Node that the path resolved to
+    dm_instances_t inst;                        // Instance numbers (and associated nodes) parsed from the path
+    bool is_qualified_instance;                 // Whether the instance numbers in the path fully qualified the node
+} path_cache_entry_t;
+
+#define PATH_CACHE_NUM_BUCKETS  (2*PATH_CACHE_ENTRIES)
+static path_cache_entry_t path_cache[PATH_CACHE_ENTRIES];
+static path_cache_entry_t *path_cache_buckets[PATH_CACHE_NUM_BUCKETS];
+static double_linked_list_t path_cache_lru;     // Head=most recently used, Tail=least recently used
+static unsigned path_cache_generation = 1;      // Incremented to invalidate all entries in the cache
+static unsigned path_cache_hits = 0;
+static unsigned path_cache_misses = 0;
+
+//--------------------------------------------------------------------
+// Minimum number of children that a node must have before a hash table index is built for them
+// Nodes with fewer children than this are searched linearly, as this is just as fast
+#define MIN_CHILDREN_TO_INDEX 4
 
 //--------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
@@ -127,11 +190,13 @@ dm_node_t *CreateNode(char *name, dm_node_type_t type, char *schema_path);
 int ParseSchemaPath(char *path, char *path_segments, int path_segment_len, dm_node_type_t type, dm_path_segment *segments, int max_segments);
 int ParsePath(char *path, char *path_segments, int path_segment_len, char *segments[], int max_segments, dm_instances_t *inst);
 dm_node_t *FindNodeFromHash(dm_hash_t hash);
+void AddNodeToHashLookup(dm_node_t *node);
 int ParseInstanceString(char *instances, dm_instances_t *inst);
 char *ParseInstanceInteger(char *p, int *p_value);
 int AddChildParamsDefaultValues(char *path, int path_len, dm_node_t *node, dm_instances_t *inst);
-int DeleteChildParams(char *path, int path_len, dm_node_t *node, dm_instances_t *inst);
-int DeleteChildParams_MultiInstanceObject(char *path, int path_len, dm_node_t *node, dm_instances_t *inst);
+void GetChildDBParamHashes(dm_node_t *node, int_vector_t *hashes);
+int DeleteChildInstances(char *path, int path_len, dm_node_t *node, dm_instances_t *inst);
+int DeleteChildInstances_MultiInstanceObject(char *path, int path_len, dm_node_t *node, dm_instances_t *inst);
 int strncpy_path_segments(char *dst, char *src, int maxlen);
 void DumpSchemaFromRoot(dm_node_t *root, char *name);
 void AddChildNodes(dm_node_t *parent, str_vector_t *sv);
@@ -141,6 +206,28 @@ void DestroySchemaRecursive(dm_node_t *parent);
 void DestroyInstanceVectorRecursive(dm_node_t *parent);
 void DumpInstanceVectorRecursive(dm_node_t *parent);
 void GetAllInstancePathsRecursive(dm_node_t *node, dm_instances_t *inst, str_vector_t *sv, combined_role_t *combined_role);
+void InitPathCache(void);
+dm_node_t *LookupPathCache(char *path, dm_instances_t *inst, bool *is_qualified_instance);
+void AddToPathCache(char *path, dm_node_t *node, dm_instances_t *inst, bool is_qualified_instance);
+path_cache_entry_t *FindPathCacheEntry(char *path, unsigned path_hash);
+void UnlinkPathCacheEntryFromBucket(path_cache_entry_t *pce);
+void BuildChildIndex(dm_node_t *parent);
+dm_node_t *CheckInstanceOrder(char *path, dm_node_t *node, dm_instances_t *inst, bool *is_qualified_instance);
+void AddChildToIndex(dm_node_t *parent, dm_node_t *child);
+dm_node_t *FindMatchingChild_Linear(dm_node_t *parent, char *name);
+dm_node_t *ResolveSchemaPath(char *path, bool use_index);
+int CountSchemaNodesRecursive(dm_node_t *parent);
+void CollectSchemaNodesRecursive(dm_node_t *parent, dm_node_t **nodes, int *num_nodes);
+#ifdef COMPACT_DM_SCHEMA
+void CompactSchema(void);
+interned_name_t *FindInternedName(interned_name_t *name_table, int size, char *name);
+dm_node_t *RemapNode(dm_node_t *old_node);
+void RemapInstances(dm_instances_t *inst);
+#endif
+int GetVendorParamGroupId(dm_node_t *node, dm_instances_t *inst);
+int GetVendorGroupValues(int group_id, kv_vector_t *params);
+void SaveFirstError(int index, int err, int *first_err_index, int *first_err, char *first_err_msg);
+uint64_t UpdateStartupTime(uint64_t *phase_time, uint64_t start_time);
 
 /*********************************************************************//**
 **
@@ -156,6 +243,10 @@ void GetAllInstancePathsRecursive(dm_node_t *node, dm_instances_t *inst, str_vec
 int DATA_MODEL_Init(void)
 {
     int err;
+    uint64_t t;
+
+    t = tu_uptime_usecs();
+    InitPathCache();
 
     // Allocate the root nodes for the data model
     #define DEVICE_NODE_NAME "Device"
@@ -197,6 +288,7 @@ int DATA_MODEL_Init(void)
     {
         return err;
     }
+    t = UpdateStartupTime(&startup_times.core_register, t);
 
     // Register vendor nodes in the schema
     err = VENDOR_Init();
@@ -204,6 +296,17 @@ int DATA_MODEL_Init(void)
     {
         return err;
     }
+    t = UpdateStartupTime(&startup_times.vendor_register, t);
+
+    // The schema is now complete. Prevent any further nodes from being registered
+    // (DATABASE_Start() and DEVICE_LOCAL_AGENT_SetDefaults() call vendor hooks, which must not modify the schema)
+    is_executing_within_dm_init = false;
+
+#ifdef COMPACT_DM_SCHEMA
+    // Repack the (now immutable) schema into a single block of memory
+    CompactSchema();
+#endif
+    t = UpdateStartupTime(&startup_times.compact, t);
 
     // Exit if unable to potentially perform a programmatic factory reset of the parameters in the database
     // NOTE: This must be performed before DEVICE_LOCAL_AGENT_SetDefaults(), but after VENDOR_Init()
@@ -212,6 +315,7 @@ int DATA_MODEL_Init(void)
     {
         return err;
     }
+    t = UpdateStartupTime(&startup_times.database_start, t);
 
     // Set the default values of OUI, Serial Number and (LocalAgent) EndpointID, and cache EndpointID
     err = DEVICE_LOCAL_AGENT_SetDefaults();
@@ -219,14 +323,7 @@ int DATA_MODEL_Init(void)
     {
         return err;
     }
-
-    is_executing_within_dm_init = false;
-
-    // Exit if unable to register all nodes in the schema
-    if (err != USP_ERR_OK)
-    {
-        return err;
-    }
+    UpdateStartupTime(&startup_times.set_defaults, t);
 
     // If the code gets here, then all of the data model components initialised successfully
     return USP_ERR_OK;
@@ -248,8 +345,10 @@ int DATA_MODEL_Start(void)
     int err;
     dm_trans_vector_t trans;
     register_controller_trust_cb_t   register_controller_trust_cb;
+    uint64_t t;
 
     // Seed data model with instance numbers from the database    
+    t = tu_uptime_usecs();
     if (is_running_cli_local_command == false)
     {
         err = DATABASE_ReadDataModelInstanceNumbers(false);
@@ -258,6 +357,7 @@ int DATA_MODEL_Start(void)
             return err;
         }
     }
+    t = UpdateStartupTime(&startup_times.seed_instances, t);
 
     // Determine function to call to register controller trust
     register_controller_trust_cb = vendor_hook_callbacks.register_controller_trust_cb;
@@ -275,6 +375,7 @@ int DATA_MODEL_Start(void)
         USP_ERR_SetMessage("%s: register_controller_trust_cb() failed", __FUNCTION__);
         return err;
     }
+    t = UpdateStartupTime(&startup_times.trust, t);
 
     // As most start routines also clean the database, start a transaction
     err = DM_TRANS_Start(&trans);
@@ -317,6 +418,7 @@ exit:
     {
         DM_TRANS_Abort(); // Ignore error from this - we want to return the error from the body of this function instead
     }
+    UpdateStartupTime(&startup_times.components_start, t);
 
     return err;
 }
@@ -344,7 +446,8 @@ void DATA_MODEL_Stop(void)
     DEVICE_LOCAL_AGENT_Stop();
 
 
-    // Free the instance vectors here, so that they are not reported as a memory leak
+    // Free the instance vectors and unique key indexes here, so that they are not reported as a memory leak
+    DM_KEY_INDEX_InvalidateAll();
     DestroyInstanceVectorRecursive(root_device_node);
     DestroyInstanceVectorRecursive(root_internal_node);
 
@@ -356,7 +459,10 @@ void DATA_MODEL_Stop(void)
     // Free all allocations that occurred before mem info collection was turned on    
     DestroySchemaRecursive(root_device_node);
     DestroySchemaRecursive(root_internal_node);
+    USP_SAFE_FREE(schema_arena);
     USP_SAFE_FREE(node_lookup);
+    node_lookup_count = 0;
+    node_lookup_size = 0;
 
     // If logging memory usage, print out all memory still in use, after attempting to free all known references
     USP_MEM_PrintLeakReport();
@@ -379,17 +485,9 @@ void DATA_MODEL_Stop(void)
 int DATA_MODEL_GetParameterValue(char *path, char *buf, int len, unsigned flags)
 {
     dm_node_t *node;
-    dm_node_t *table_node;
-    dm_get_value_cb_t get_cb;
-    int err;
     dm_instances_t inst;
-    char instances[MAX_DM_PATH];
-    bool exists;
-    dm_req_t req;
     bool is_qualified_instance;
-    int num_instances;
-    char *default_value;
-    unsigned db_flags = 0;          // Default to database not unobfuscating values. NOTE Only secure nodes are obfuscated
+    int err;
 
     // Exit if unable to get node associated with parameter
     // This could occur if the parameter is not present in the schema, or if the specified instance does not exist
@@ -400,12 +498,44 @@ int DATA_MODEL_GetParameterValue(char *path, char *buf, int len, unsigned flags)
     }
 
     // NOTE: We do not check 'is_qualified_instance' here, because the only time it would be unqualified, is if the
-    //       path represented a multi-instance object. If path does represent this, then it will be caught below (switch statement)
+    //       path represented a multi-instance object. If path does represent this, then it will be caught in DM_PRIV_GetParameterValue()
+    err = DM_PRIV_GetParameterValue(path, node, &inst, buf, len, flags);
+
+    return err;
+}
+
+/*********************************************************************//**
+**
+** DM_PRIV_GetParameterValue
+**
+** Gets a single parameter from the data model, given the node and instance numbers which its path has already been resolved to
+**
+** \param   path - pointer to string containing complete data model path to the parameter
+** \param   node - pointer to node in the data model representing the parameter
+** \param   inst - pointer to instance numbers of the parameter (parsed from path)
+** \param   buf - pointer to buffer into which to return the value of the parameter (as a textual string)
+** \param   len - length of buffer in which to return the value of the parameter
+** \param   flags - options to control execution of this function (eg SHOW_PASSWORD)
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int DM_PRIV_GetParameterValue(char *path, dm_node_t *node, dm_instances_t *inst, char *buf, int len, unsigned flags)
+{
+    dm_node_t *table_node;
+    dm_get_value_cb_t get_cb;
+    int err;
+    char instances[MAX_DM_PATH];
+    bool exists;
+    dm_req_t req;
+    int num_instances;
+    char *default_value;
+    unsigned db_flags = 0;          // Default to database not unobfuscating values. NOTE Only secure nodes are obfuscated
 
     // Validate that the parsed object instance numbers exist in the data model (if parameter contains multi-instance objects in it's path)
-    if (inst.order > 0)
+    if (inst->order > 0)
     {
-        exists = DM_INST_VECTOR_IsExist(&inst);
+        exists = DM_INST_VECTOR_IsExist(inst);
         if (exists == false)
         {
             USP_ERR_SetMessage("%s: Path %s: Instance numbers do not exist", __FUNCTION__, path);
@@ -434,7 +564,7 @@ int DATA_MODEL_GetParameterValue(char *path, char *buf, int len, unsigned flags)
         case kDMNodeType_DBParam_ReadOnly:
         case kDMNodeType_DBParam_ReadOnlyAuto:
         case kDMNodeType_DBParam_ReadWriteAuto:
-            FormInstanceString(&inst, instances, sizeof(instances));
+            FormInstanceString(inst, instances, sizeof(instances));
             err = DATABASE_GetParameterValue(path, node->hash, instances, buf, len, db_flags);
             if (err == USP_ERR_OBJECT_DOES_NOT_EXIST)
             {
@@ -458,18 +588,42 @@ int DATA_MODEL_GetParameterValue(char *path, char *buf, int len, unsigned flags)
 
         case kDMNodeType_Param_NumEntries:
             table_node = node->registered.param_info.table_node;
-            num_instances = DM_INST_VECTOR_GetNumInstances(table_node, &inst);
+            num_instances = DM_INST_VECTOR_GetNumInstances(table_node, inst);
             USP_SNPRINTF(buf, len, "%d", num_instances);
             break;
 
             
         case kDMNodeType_VendorParam_ReadOnly:
         case kDMNodeType_VendorParam_ReadWrite:
+            // If the parameter is part of a group, then get it using the group's vendor hook
+            if (node->registered.param_info.group_id != NON_GROUPED)
+            {
+                kv_pair_t pair = { path, NULL };
+                kv_vector_t kvv = { &pair, 1 };
+
+                err = GetVendorGroupValues(node->registered.param_info.group_id, &kvv);
+                if (err != USP_ERR_OK)
+                {
+                    return err;
+                }
+
+                // Exit if the vendor did not return a value for the parameter
+                if (pair.value == NULL)
+                {
+                    USP_ERR_SetMessage("%s: Get group callback did not return a value for path %s", __FUNCTION__, path);
+                    return USP_ERR_INTERNAL_ERROR;
+                }
+
+                USP_STRNCPY(buf, pair.value, len);
+                USP_FREE(pair.value);
+                break;
+            }
+
             get_cb = node->registered.param_info.get_cb;
             USP_ASSERT(get_cb != NULL)
 
             // Exit if unable to get the value from the vendor code
-            DM_PRIV_RequestInit(&req, node, path, &inst);
+            DM_PRIV_RequestInit(&req, node, path, inst);
             USP_ERR_ClearMessage();
             buf[0] = '\0';
 
@@ -515,6 +669,151 @@ int DATA_MODEL_GetParameterValue(char *path, char *buf, int len, unsigned flags)
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** DATA_MODEL_GetParameterValues
+**
+** Gets the values of a number of parameters from the data model
+** Grouped vendor parameters are got using a single call to their group's vendor hook (per group),
+** rather than one call per parameter
+** NOTE: Each path is resolved only once. The resolved node is used both to determine the parameter's group and to get its value
+**
+** \param   params - key-value vector containing the complete data model paths of the parameters to get (as keys)
+**                   On return, the values of the parameters. Parameters which could not be got have an empty string value.
+** \param   flags - options to control execution of this function (eg SHOW_PASSWORD)
+**
+** \return  USP_ERR_OK if all parameters were got successfully,
+**          otherwise the error for the first parameter (in 'params') which could not be got
+**
+**************************************************************************/
+int DATA_MODEL_GetParameterValues(kv_vector_t *params, unsigned flags)
+{
+    int i, j;
+    int err;
+    int group_id;
+    int *group_ids;
+    int *indexes;
+    dm_node_t **nodes;
+    dm_instances_t *insts;
+    bool is_qualified_instance;
+    kv_vector_t group_params;
+    kv_pair_t *pair;
+    char buf[MAX_DM_VALUE_LEN];
+    int first_err_index = INVALID;
+    int first_err = USP_ERR_OK;
+    char first_err_msg[USP_ERR_MAXLEN];
+
+    // Exit if there are no parameters to get
+    if (params->num_entries == 0)
+    {
+        return USP_ERR_OK;
+    }
+
+    // Resolve the path of each parameter, and determine which group (if any) it belongs to
+    // NOTE: A node of NULL indicates that the parameter is not present in the schema, or that the specified instance does not exist
+    nodes = USP_MALLOC(params->num_entries * sizeof(dm_node_t *));
+    insts = USP_MALLOC(params->num_entries * sizeof(dm_instances_t));
+    group_ids = USP_MALLOC(params->num_entries * sizeof(int));
+    for (i=0; i < params->num_entries; i++)
+    {
+        nodes[i] = DM_PRIV_GetNodeFromPath(params->vector[i].key, &insts[i], &is_qualified_instance);
+        group_ids[i] = GetVendorParamGroupId(nodes[i], &insts[i]);
+    }
+
+    // Get all parameters which are not part of a group, one at a time
+    for (i=0; i < params->num_entries; i++)
+    {
+        if (group_ids[i] == NON_GROUPED)
+        {
+            pair = &params->vector[i];
+            USP_ERR_ClearMessage();
+            if (nodes[i] == NULL)
+            {
+                // The path could not be resolved. Resolve it again to regenerate its error message, which would have been
+                // overwritten by resolving the paths after it. This only occurs on the error path.
+                err = DATA_MODEL_GetParameterValue(pair->key, buf, sizeof(buf), flags);
+            }
+            else
+            {
+                // NOTE: 'is_qualified_instance' is not checked, for the same reason as in DATA_MODEL_GetParameterValue()
+                err = DM_PRIV_GetParameterValue(pair->key, nodes[i], &insts[i], buf, sizeof(buf), flags);
+            }
+
+            if (err != USP_ERR_OK)
+            {
+                SaveFirstError(i, err, &first_err_index, &first_err, first_err_msg);
+                buf[0] = '\0';
+            }
+
+            USP_SAFE_FREE(pair->value);
+            pair->value = USP_STRDUP(buf);
+        }
+    }
+
+    // Get the parameters in each group, using a single call to the group's vendor hook
+    group_params.vector = USP_MALLOC(params->num_entries * sizeof(kv_pair_t));
+    indexes = USP_MALLOC(params->num_entries * sizeof(int));
+    for (i=0; i < params->num_entries; i++)
+    {
+        // Skip if this parameter is not grouped, or has already been got as part of an earlier group
+        group_id = group_ids[i];
+        if (group_id == NON_GROUPED)
+        {
+            continue;
+        }
+
+        // Gather all parameters in this group (the keys are not copied, only referenced)
+        group_params.num_entries = 0;
+        for (j=i; j < params->num_entries; j++)
+        {
+            if (group_ids[j] == group_id)
+            {
+                group_params.vector[group_params.num_entries].key = params->vector[j].key;
+                group_params.vector[group_params.num_entries].value = NULL;
+                indexes[group_params.num_entries] = j;
+                group_params.num_entries++;
+                group_ids[j] = NON_GROUPED;     // Mark this parameter as done
+            }
+        }
+
+        // Get the values of the parameters in this group from the vendor
+        USP_ERR_ClearMessage();
+        err = GetVendorGroupValues(group_id, &group_params);
+
+        // Move the values back into the parameter vector
+        for (j=0; j < group_params.num_entries; j++)
+        {
+            pair = &params->vector[indexes[j]];
+            if (err != USP_ERR_OK)
+            {
+                SaveFirstError(indexes[j], err, &first_err_index, &first_err, first_err_msg);
+            }
+            else if (group_params.vector[j].value == NULL)
+            {
+                USP_ERR_SetMessage("%s: Get group callback did not return a value for path %s", __FUNCTION__, pair->key);
+                SaveFirstError(indexes[j], USP_ERR_INTERNAL_ERROR, &first_err_index, &first_err, first_err_msg);
+            }
+
+            USP_SAFE_FREE(pair->value);
+            pair->value = (group_params.vector[j].value != NULL) ? group_params.vector[j].value : USP_STRDUP("");
+        }
+    }
+
+    USP_FREE(group_params.vector);
+    USP_FREE(indexes);
+    USP_FREE(group_ids);
+    USP_FREE(insts);
+    USP_FREE(nodes);
+
+    // Restore the error message of the first parameter which failed
+    if (first_err != USP_ERR_OK)
+    {
+        USP_ERR_SetMessage("%s", first_err_msg);
+    }
+
+    return first_err;
+}
+
 /*********************************************************************//**
 **
 ** DATA_MODEL_SetParameterValue
@@ -539,6 +838,7 @@ int DATA_MODEL_SetParameterValue(char *path, char *new_value, unsigned flags)
     dm_req_t req;
     bool is_qualified_instance;
     bool exists;
+    int group_id;
     unsigned db_flags = 0;          // Default to database not unobfuscating values. NOTE Only secure nodes are obfuscated
 
     USP_ASSERT(DM_TRANS_IsWithinTransaction()==true);
@@ -611,6 +911,21 @@ int DATA_MODEL_SetParameterValue(char *path, char *new_value, unsigned flags)
     switch(node->type)
     {
         case kDMNodeType_VendorParam_ReadWrite:
+            // If the parameter is part of a group, then defer passing it to the vendor until the transaction is committed
+            group_id = node->registered.param_info.group_id;
+            if (group_id != NON_GROUPED)
+            {
+                // Exit if the vendor has not registered a hook to set the values of this group
+                if (group_vendor_hooks[group_id].set_group_cb == NULL)
+                {
+                    USP_ERR_SetMessage("%s: No set group callback registered for group %d (path=%s)", __FUNCTION__, group_id, path);
+                    return USP_ERR_INTERNAL_ERROR;
+                }
+
+                DM_TRANS_AddGroupedSet(group_id, path, new_value);
+                break;
+            }
+
             // Exit if unable to set the vendor parameter, aborting the transaction
             set_cb = node->registered.param_info.set_cb;
             if (set_cb != NULL)
@@ -651,6 +966,8 @@ int DATA_MODEL_SetParameterValue(char *path, char *new_value, unsigned flags)
             {
                 return err;
             }
+            DM_KEY_INDEX_UpdateParam(node, &inst, new_value);
+            DEVICE_SUBSCRIPTION_NotifyParamValueChanged(path);
             break;
 
         case kDMNodeType_DBParam_ReadOnly:
@@ -664,6 +981,8 @@ int DATA_MODEL_SetParameterValue(char *path, char *new_value, unsigned flags)
             {
                 return err;
             }
+            DM_KEY_INDEX_UpdateParam(node, &inst, new_value);
+            DEVICE_SUBSCRIPTION_NotifyParamValueChanged(path);
             break;
 
         case kDMNodeType_Param_ConstantValue:
@@ -922,6 +1241,8 @@ int DATA_MODEL_DeleteInstance(char *path, unsigned flags)
     dm_node_t *node;
     int err;
     char child_path[MAX_DM_PATH];
+    char instances[MAX_DM_PATH];
+    int_vector_t hashes;
     dm_validate_del_cb_t validate_del;
     dm_del_cb_t del;
     dm_req_t req;
@@ -1013,16 +1334,27 @@ int DATA_MODEL_DeleteInstance(char *path, unsigned flags)
     // it determines the list of objects which will send ObjectDeletion notifies based on the objects currently in the data model
     DM_TRANS_Add(kDMOp_Del, path, NULL, NULL, node, &inst);
 
-    // Now delete all child parameters and instances
+    // Now delete all child parameters of this instance (and of all of its child object instances) from the database, in a single SQL statement
+    INT_VECTOR_Init(&hashes);
+    GetChildDBParamHashes(node, &hashes);
+    FormInstanceString(&inst, instances, sizeof(instances));
+    err = DATABASE_DeleteParameterRange(path, &hashes, instances);
+    INT_VECTOR_Destroy(&hashes);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Then delete all child object instances
     USP_STRNCPY(child_path, path, sizeof(child_path));
-    err = DeleteChildParams(child_path, strlen(child_path), node, &inst);
+    err = DeleteChildInstances(child_path, strlen(child_path), node, &inst);
     if (err != USP_ERR_OK)
     {
         return err;
     }
 
     // DeRegister the instance number with the data model
-    // NOTE: This must be performed after DeleteChildParams(), otherwise that function will not be aware of the child instance numbers to delete
+    // NOTE: This must be performed after DeleteChildInstances(), otherwise that function will not be aware of the child instance numbers to delete
     DM_INST_VECTOR_Remove(&inst);
 
     return USP_ERR_OK;
@@ -1483,51 +1815,117 @@ int DATA_MODEL_CompareParameterValue(char *path, expr_op_t op, char *expr_consta
     dm_node_t *node;
     dm_instances_t inst;
     bool is_qualified_instance;
-    dm_cmp_cb_t cmp_cb;
-    char buf[MAX_DM_SHORT_VALUE_LEN];
+
+    // Exit if unable to get node associated with the parameter
+    node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
+    if (node == NULL)
+    {
+        return USP_ERR_INVALID_PATH;
+    }
+
+    err = DM_PRIV_CompareParameterValue(path, node, &inst, op, expr_constant, result);
+
+    return err;
+}
+
+/*********************************************************************//**
+**
+** DM_PRIV_CompareParameterValue
+**
+** Compares the value of the specified parameter against the specified constant,
+** given the node and instance numbers which the path of the parameter has already been resolved to
+**
+** \param   path - pointer to string containing complete data model path to the parameter
+** \param   node - pointer to node in the data model representing the parameter
+** \param   inst - pointer to instance numbers of the parameter (parsed from path)
+** \param   op - operator to use in the comparison
+** \param   expr_constant - constant to compare the value of the parameter against
+** \param   result - pointer to variable in which to return the result of the comparison
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int DM_PRIV_CompareParameterValue(char *path, dm_node_t *node, dm_instances_t *inst, expr_op_t op, char *expr_constant, bool *result)
+{
+    int err;
+    expr_predicate_t pred;
+
+    DM_PRIV_CompilePredicate(node, op, expr_constant, &pred);
+    err = DM_PRIV_EvaluatePredicate(path, node, inst, &pred, result);
+
+    return err;
+}
+
+/*********************************************************************//**
+**
+** DM_PRIV_CompilePredicate
+**
+** Compiles a search expression component, for comparison against the values of the specified parameter
+** This should be used instead of DM_PRIV_CompareParameterValue() when comparing the same expression against many instances of a parameter
+**
+** \param   node - pointer to node in the data model representing the parameter
+** \param   op - operator to use in the comparison
+** \param   expr_constant - constant to compare the value of the parameter against. NOTE: This must exist for the lifetime of the predicate
+** \param   pred - pointer to structure in which to return the compiled predicate
+**
+** \return  None
+**
+**************************************************************************/
+void DM_PRIV_CompilePredicate(dm_node_t *node, expr_op_t op, char *expr_constant, expr_predicate_t *pred)
+{
     unsigned type_flags;
 
+    // NOTE: If the node is not a parameter, then an error will be reported when trying to get its value in DM_PRIV_EvaluatePredicate()
+    type_flags = 0;
+    if ((node->type != kDMNodeType_Object_MultiInstance) && (node->type != kDMNodeType_Object_SingleInstance) &&
+        (node->type != kDMNodeType_SyncOperation) && (node->type != kDMNodeType_AsyncOperation) &&
+        (node->type != kDMNodeType_Event))
+    {
+        type_flags = node->registered.param_info.type_flags;
+    }
+
+    DM_ACCESS_CompilePredicate(type_flags, op, expr_constant, pred);
+}
+
+/*********************************************************************//**
+**
+** DM_PRIV_EvaluatePredicate
+**
+** Compares the value of the specified parameter against a compiled search expression component,
+** given the node and instance numbers which the path of the parameter has already been resolved to
+**
+** \param   path - pointer to string containing complete data model path to the parameter
+** \param   node - pointer to node in the data model representing the parameter
+** \param   inst - pointer to instance numbers of the parameter (parsed from path)
+** \param   pred - pointer to predicate compiled for this parameter (see DM_PRIV_CompilePredicate)
+** \param   result - pointer to variable in which to return the result of the comparison
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int DM_PRIV_EvaluatePredicate(char *path, dm_node_t *node, dm_instances_t *inst, expr_predicate_t *pred, bool *result)
+{
+    int err;
+    char buf[MAX_DM_SHORT_VALUE_LEN];
+
     // Exit if unable to get the value of the parameter
     // NOTE: Passwords will return empty string
-    err = DATA_MODEL_GetParameterValue(path, buf, sizeof(buf), 0);
+    err = DM_PRIV_GetParameterValue(path, node, inst, buf, sizeof(buf), 0);
     if (err != USP_ERR_OK)
     {
         return err;
     }
 
-    // Exit if unable to get node associated with the parameter
-    // NOTE: This should not fail, as we've already got the parameter's value
-    node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
-    USP_ASSERT(node != NULL);
+    // NOTE: The node must be a parameter, as we've already got the parameter's value
     USP_ASSERT( ((node->type != kDMNodeType_Object_MultiInstance) &&
                  (node->type != kDMNodeType_Object_SingleInstance) &&
                  (node->type != kDMNodeType_SyncOperation) &&
                  (node->type != kDMNodeType_AsyncOperation) &&
                  (node->type != kDMNodeType_Event)) );
 
-    // Determine the function to call to perform the comparison
-    type_flags = node->registered.param_info.type_flags;
-    if (type_flags & (DM_INT | DM_UINT | DM_ULONG))
-    {
-        cmp_cb = DM_ACCESS_CompareNumber;
-    }
-    else if (type_flags & DM_BOOL)
-    {
-        cmp_cb = DM_ACCESS_CompareBool;
-    }
-    else if (type_flags & DM_DATETIME)
-    {
-        cmp_cb = DM_ACCESS_CompareDateTime;
-    }
-    else
-    {
-        // Default, and also for DM_STRING
-        cmp_cb = DM_ACCESS_CompareString;
-    }
-    
     // Exit if an error occurred when comparing the values
     // This could occur if the operator was invalid for the specified type, or type conversion failed
-    err = cmp_cb(buf, op, expr_constant, result);
+    err = DM_ACCESS_EvaluatePredicate(pred, buf, result);
     if (err != USP_ERR_OK)
     {
         return err;
@@ -1558,22 +1956,48 @@ unsigned DATA_MODEL_GetPathProperties(char *path, combined_role_t *combined_role
 {
     dm_node_t *node;
     dm_instances_t inst;
-    bool exists;
     bool is_qualified_instance;
-    unsigned flags = 0;               // default return value
+    unsigned flags;
 
-    // Default return value for permissions
-    if (permission_bitmask != NULL)
-    {
-        *permission_bitmask = PERMIT_NONE;
-    }
-    
     // Exit if path does not exist in the schema
     node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
     if (node == NULL)
     {
-        return flags;
+        if (permission_bitmask != NULL)
+        {
+            *permission_bitmask = PERMIT_NONE;
+        }
+        return 0;
     }
+
+    flags = DM_PRIV_GetPathProperties(node, &inst, is_qualified_instance, combined_role, permission_bitmask);
+
+    return flags;
+}
+
+/*********************************************************************//**
+**
+** DM_PRIV_GetPathProperties
+**
+** Determines the properties of a path, given the node and instance numbers which the path has already been resolved to
+**
+** \param   node - pointer to node in the data model which the path resolved to
+** \param   path_inst - pointer to instance numbers parsed from the path
+** \param   is_qualified_instance - set if the path was qualified by all of its instance numbers
+** \param   combined_role - role to use when calculating the permissions
+** \param   permission_bitmask - pointer to variable in which to return the permissions for the path, or NULL if this is not required
+**
+** \return  bitmask of properties of the path (PP_XXX flags)
+**
+**************************************************************************/
+unsigned DM_PRIV_GetPathProperties(dm_node_t *node, dm_instances_t *path_inst, bool is_qualified_instance, combined_role_t *combined_role, unsigned short *permission_bitmask)
+{
+    dm_instances_t inst;
+    bool exists;
+    unsigned flags = 0;
+
+    // Take a copy of the instance numbers, as this function may modify them
+    memcpy(&inst, path_inst, sizeof(inst));
     flags |= PP_EXISTS_IN_SCHEMA;
 
     // Setup permissions to return
@@ -1977,13 +2401,165 @@ void DATA_MODEL_DumpInstances(void)
 
 /*********************************************************************//**
 **
-** DATA_MODEL_GetNumInstances
+** DATA_MODEL_DumpPathCache
 **
-** Gets the number of instances of the specified object
-** NOTE: You almost certainly want to call DATA_MODEL_GetInstances() instead, 
-**       unless you know the instances are contiguous and count from 1
+** Prints out the statistics of the cache of resolved data model paths
+** This may be used to determine whether PATH_CACHE_ENTRIES is sized correctly
 **
-** \param   path - path of the object. NOTE: This is not a schema path (ie no '{i}' in the path. Use a partial path).
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void DATA_MODEL_DumpPathCache(void)
+{
+    int i;
+    int num_valid = 0;
+    unsigned total;
+
+    for (i=0; i<PATH_CACHE_ENTRIES; i++)
+    {
+        if (path_cache[i].generation == path_cache_generation)
+        {
+            num_valid++;
+        }
+    }
+
+    total = path_cache_hits + path_cache_misses;
+    USP_DUMP("Dumping DataModel Path Cache...");
+    USP_DUMP("Entries: %d (of %d)", num_valid, PATH_CACHE_ENTRIES);
+    USP_DUMP("Hits: %u", path_cache_hits);
+    USP_DUMP("Misses: %u", path_cache_misses);
+    USP_DUMP("Hit ratio: %u%%", (total == 0) ? 0 : (unsigned)((100ULL * path_cache_hits) / total));
+}
+
+/*********************************************************************//**
+**
+** DATA_MODEL_BenchResolve
+**
+** Measures the time taken to resolve randomly chosen schema paths by walking the data model tree,
+** both using the index of each node's children, and by searching each node's list of children
+** This is used by the 'dmbench' CLI command
+**
+** \param   num_paths - number of schema paths to resolve
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INTERNAL_ERROR if a schema path did not resolve to its node
+**
+**************************************************************************/
+int DATA_MODEL_BenchResolve(int num_paths)
+{
+    int i;
+    int err;
+    int num_nodes = 0;
+    int max_children = 0;
+    dm_node_t **nodes;
+    int *picks;
+    dm_node_t *node;
+    unsigned seed = 1;
+    uint64_t start_time;
+    uint64_t indexed_time;
+    uint64_t linear_time;
+
+    // Collect all nodes in the schema, and determine the widest object
+    nodes = USP_MALLOC(CountSchemaNodesRecursive(root_device_node)*sizeof(dm_node_t *));
+    CollectSchemaNodesRecursive(root_device_node, nodes, &num_nodes);
+    for (i=0; i < num_nodes; i++)
+    {
+        if (nodes[i]->num_children > max_children)
+        {
+            max_children = nodes[i]->num_children;
+        }
+    }
+
+    // Choose the schema paths to resolve. The same paths are resolved using both lookup methods
+    picks = USP_MALLOC(num_paths*sizeof(int));
+    for (i=0; i < num_paths; i++)
+    {
+        picks[i] = rand_r(&seed) % num_nodes;
+    }
+
+    // Exit if any path did not resolve to its node, when using the index of each node's children
+    start_time = tu_uptime_usecs();
+    for (i=0; i < num_paths; i++)
+    {
+        node = nodes[picks[i]];
+        if (ResolveSchemaPath(node->path, true) != node)
+        {
+            USP_ERR_SetMessage("%s: Schema path %s did not resolve to its node", __FUNCTION__, node->path);
+            err = USP_ERR_INTERNAL_ERROR;
+            goto exit;
+        }
+    }
+    indexed_time = tu_uptime_usecs() - start_time;
+
+    // Exit if any path did not resolve to its node, when searching each node's list of children
+    start_time = tu_uptime_usecs();
+    for (i=0; i < num_paths; i++)
+    {
+        node = nodes[picks[i]];
+        if (ResolveSchemaPath(node->path, false) != node)
+        {
+            USP_ERR_SetMessage("%s: Schema path %s did not resolve to its node", __FUNCTION__, node->path);
+            err = USP_ERR_INTERNAL_ERROR;
+            goto exit;
+        }
+    }
+    linear_time = tu_uptime_usecs() - start_time;
+
+    USP_DUMP("Schema path resolve benchmark (%d schema nodes, widest object has %d children)", num_nodes, max_children);
+    USP_DUMP("Indexed children: %d paths resolved in %llu us (%.3f us/path)", num_paths, (unsigned long long)indexed_time, (double)indexed_time/num_paths);
+    USP_DUMP("Linear search of children: %d paths resolved in %llu us (%.3f us/path)", num_paths, (unsigned long long)linear_time, (double)linear_time/num_paths);
+    err = USP_ERR_OK;
+
+exit:
+    USP_FREE(picks);
+    USP_FREE(nodes);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** DATA_MODEL_DumpStartupTimes
+**
+** Prints out the time taken by each phase of building and starting the data model when the agent started
+** This may be used to measure cold start latency on the target device
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void DATA_MODEL_DumpStartupTimes(void)
+{
+    startup_times_t *st = &startup_times;
+    uint64_t total;
+
+    total = st->core_register + st->vendor_register + st->compact + st->database_start + st->set_defaults +
+            st->seed_instances + st->trust + st->components_start;
+
+    USP_DUMP("Dumping DataModel Startup Times...");
+    USP_DUMP("Schema nodes: %u", num_schema_nodes);
+    USP_DUMP("%-36s %10.2f ms", "Core schema registration", st->core_register/1000.0);
+    USP_DUMP("%-36s %10.2f ms", "Vendor schema registration", st->vendor_register/1000.0);
+    USP_DUMP("%-36s %10.2f ms", "Schema compaction", st->compact/1000.0);
+    USP_DUMP("%-36s %10.2f ms", "Database start", st->database_start/1000.0);
+    USP_DUMP("%-36s %10.2f ms", "Agent defaults", st->set_defaults/1000.0);
+    USP_DUMP("%-36s %10.2f ms", "Instance seeding from database", st->seed_instances/1000.0);
+    USP_DUMP("%-36s %10.2f ms", "Controller trust registration", st->trust/1000.0);
+    USP_DUMP("%-36s %10.2f ms", "Component start", st->components_start/1000.0);
+    USP_DUMP("%-36s %10.2f ms", "Total", total/1000.0);
+}
+
+/*********************************************************************//**
+**
+** DATA_MODEL_GetNumInstances
+**
+** Gets the number of instances of the specified object
+** NOTE: You almost certainly want to call DATA_MODEL_GetInstances() instead, 
+**       unless you know the instances are contiguous and count from 1
+**
+** \param   path - path of the object. NOTE: This is not a schema path (ie no '{i}' in the path. Use a partial path).
 ** \param   num_instances - pointer to variable in which to store the number of instances
 **
 ** \return  USP_ERR_OK if successful
@@ -2301,20 +2877,16 @@ int DATA_MODEL_SetParameterInDatabase(char *path, char *value)
     int err;
     dm_hash_t hash;
     char instances[MAX_DM_PATH];
-    unsigned path_flags;
     unsigned db_flags;
     
     // Exit if parameter path is incorrect
-    err = DM_PRIV_FormDB_FromPath(path, &hash, instances, sizeof(instances));
+    // NOTE: This also determines if this parameter is secure and hence whether the database needs to obfuscate the value
+    err = DM_PRIV_FormDBParam_FromPath(path, &hash, instances, sizeof(instances), &db_flags);
     if (err != USP_ERR_OK)
     {
         return err;
     }
 
-    // Determine if this parameter is secure and hence whether the database needs to obfuscate the value
-    path_flags = DATA_MODEL_GetPathProperties(path, INTERNAL_ROLE, NULL);
-    db_flags = (path_flags & PP_IS_SECURE_PARAM) ? OBFUSCATED_VALUE : 0;
-
     // Exit if unable to set value of parameter in DB
     err = DATABASE_SetParameterValue(path, hash, instances, value, db_flags);
     if (err != USP_ERR_OK)
@@ -2322,9 +2894,61 @@ int DATA_MODEL_SetParameterInDatabase(char *path, char *value)
         return err;
     }
 
+    // Discard the unique key indexes, as the database has been modified without going through the data model
+    DM_KEY_INDEX_InvalidateAll();
+
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** DATA_MODEL_IsDatabaseParam
+**
+** Determines whether the value of the specified parameter is stored in the database
+** The values of these parameters only change when set through DATA_MODEL_SetParameterValue() (or directly in the database)
+**
+** \param   path - data model path of the parameter
+**
+** \return  true if the parameter's value is stored in the database
+**
+**************************************************************************/
+bool DATA_MODEL_IsDatabaseParam(char *path)
+{
+    dm_node_t *node;
+    dm_instances_t inst;
+    bool is_qualified_instance;     // unused
+
+    node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
+    if (node == NULL)
+    {
+        return false;
+    }
+
+    return IsDbParam(node);
+}
+
+/*********************************************************************//**
+**
+** DATA_MODEL_IsGroupedVendorParam
+**
+** Determines whether the specified parameter is a vendor parameter whose value is got using a group vendor hook
+** The values of these parameters should be got together (using DATA_MODEL_GetParameterValues), rather than individually
+**
+** \param   path - data model path of the parameter
+**
+** \return  true if the parameter is a grouped vendor parameter
+**
+**************************************************************************/
+bool DATA_MODEL_IsGroupedVendorParam(char *path)
+{
+    dm_node_t *node;
+    dm_instances_t inst;
+    bool is_qualified_instance;     // unused
+
+    node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
+    return (GetVendorParamGroupId(node, &inst) != NON_GROUPED) ? true : false;
+}
+
 /*********************************************************************//**
 **
 ** GetAllInstancePathsRecursive
@@ -2444,11 +3068,46 @@ void DM_PRIV_RequestInit(dm_req_t *req, dm_node_t *node, char *path, dm_instance
     memset(&req->val_union, 0, sizeof(req->val_union));
 }
 
+/*********************************************************************//**
+**
+** DM_PRIV_InvalidatePathCache
+**
+** Invalidates all entries in the cache of resolved data model paths
+** This is called whenever object instances are added to or removed from the data model
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void DM_PRIV_InvalidatePathCache(void)
+{
+    path_cache_generation++;
+}
+
+/*********************************************************************//**
+**
+** DM_PRIV_GetInstancesGeneration
+**
+** Returns a number which changes whenever object instances are added to or removed from the data model
+** This allows callers to determine whether paths which they have previously resolved are still valid
+**
+** \param   None
+**
+** \return  generation number of the object instances in the data model
+**
+**************************************************************************/
+unsigned DM_PRIV_GetInstancesGeneration(void)
+{
+    return path_cache_generation;
+}
+
 /*********************************************************************//**
 **
 ** DM_PRIV_GetNodeFromPath
 **
 ** Walks the data model tree, returning the node associated with the given path
+** NOTE: Previously resolved paths are returned from a cache, without walking the data model tree
 ** NOTE: Checks that path is specified with the correct number of {i} instance numbers in it
 ** NOTE: Does not check that the instance numbers are present in the data model
 **
@@ -2472,6 +3131,13 @@ dm_node_t *DM_PRIV_GetNodeFromPath(char *path, dm_instances_t *inst, bool *is_qu
     char path_segments[MAX_DM_PATH];
     int i;
 
+    // Exit if the path has been resolved previously
+    parent = LookupPathCache(path, inst, is_qualified_instance);
+    if (parent != NULL)
+    {
+        return parent;
+    }
+
     // Exit if there were too many or not enough segments in the path
     num_segments = ParsePath(path, path_segments, sizeof(path_segments), segments, MAX_PATH_SEGMENTS, inst);
     if (num_segments < 1)
@@ -2508,29 +3174,139 @@ dm_node_t *DM_PRIV_GetNodeFromPath(char *path, dm_instances_t *inst, bool *is_qu
         parent = child;
     }
 
+    // Exit if the object instance order in the path is incorrect
+    parent = CheckInstanceOrder(path, parent, inst, is_qualified_instance);
+    if (parent == NULL)
+    {
+        return NULL;
+    }
+
+    // If the code gets here, then all segments have been traversed in the data model
+    // So cache the result, to speed up resolving this path next time
+    AddToPathCache(path, parent, inst, *is_qualified_instance);
+    return parent;
+}
+
+/*********************************************************************//**
+**
+** DM_PRIV_GetSubPathNode
+**
+** Gets the node in the data model associated with the specified path, given that the first part of the path
+** has already been resolved. Only the remaining part of the path is parsed, and the path cache is not used.
+** This is used by the path resolver, which expands many paths sharing the same (already resolved) prefix
+**
+** \param   path - full data model path
+** \param   offset - number of characters at the start of the path which have already been resolved.
+**                   This must be at a path segment boundary (ie 0 or the character after a '.')
+** \param   parent - pointer to node which the first 'offset' characters of the path resolved to
+**                   (or root node, if offset is 0)
+** \param   inst - On input, the instance numbers parsed from the first 'offset' characters of the path
+**                 On output, the instance numbers parsed from the whole path
+** \param   is_qualified_instance - pointer to variable in which to return whether the path was qualified by all of its instance numbers
+**
+** \return  pointer to node representing the path, or NULL if the path does not exist in the schema
+**
+**************************************************************************/
+dm_node_t *DM_PRIV_GetSubPathNode(char *path, int offset, dm_node_t *parent, dm_instances_t *inst, bool *is_qualified_instance)
+{
+    dm_node_t *child;
+    char segment[MAX_DM_PATH];
+    char *p;
+    int len;
+
+    // Iterate over the segments in the unresolved part of the path, using them to traverse the data model tree
+    p = &path[offset];
+    while (*p != '\0')
+    {
+        // Skip path separators
+        if (*p == '.')
+        {
+            p++;
+            continue;
+        }
+
+        len = strcspn(p, ".");
+        if (IS_NUMERIC(*p))
+        {
+            // Special case of this segment represents an instance number
+            if (inst->order == MAX_DM_INSTANCE_ORDER)
+            {
+                USP_ERR_SetMessage("%s: More than %d instance numbers in path", __FUNCTION__, MAX_DM_INSTANCE_ORDER);
+                return NULL;
+            }
+            inst->instances[ inst->order ] = atoi(p);
+            inst->order++;
+        }
+        else
+        {
+            // Exit if unable to find the child matching the segment
+            if (len >= sizeof(segment))
+            {
+                USP_ERR_SetMessage("%s: Path is invalid: %s", __FUNCTION__, path);
+                return NULL;
+            }
+            memcpy(segment, p, len);
+            segment[len] = '\0';
+            child = DM_PRIV_FindMatchingChild(parent, segment);
+            if (child == NULL)
+            {
+                USP_ERR_SetMessage("%s: Path is invalid: %s", __FUNCTION__, path);
+                return NULL;
+            }
+
+            // Found the child matching the segment, so move to the child, and search for next segment
+            parent = child;
+        }
+
+        p += len;
+    }
+
+    // Exit if the object instance order in the path is incorrect
+    parent = CheckInstanceOrder(path, parent, inst, is_qualified_instance);
+
+    return parent;
+}
+
+/*********************************************************************//**
+**
+** CheckInstanceOrder
+**
+** Checks that the number of instance numbers parsed from a path matches the node that the path resolved to
+** and fills in the nodes associated with each instance number
+**
+** \param   path - full data model path (used for error messages)
+** \param   node - node which the path resolved to
+** \param   inst - pointer to instance numbers parsed from the path. On output, the nodes are also filled in.
+** \param   is_qualified_instance - pointer to variable in which to return whether the path was qualified by all of its instance numbers
+**
+** \return  node, or NULL if the path contained the wrong number of instance numbers
+**
+**************************************************************************/
+dm_node_t *CheckInstanceOrder(char *path, dm_node_t *node, dm_instances_t *inst, bool *is_qualified_instance)
+{
     // Check that the object instance order in the path is correct
     // This is complicated by the fact that MultiInstanceObjects may be specified without the trailing instance (ie. unqualified) for some operations
-    if (inst->order == parent->order)
+    if (inst->order == node->order)
     {
         *is_qualified_instance = true;
     }
     else
     {
         // Only multi-instance objects are allowed to be specified unqualified
-        if (parent->type != kDMNodeType_Object_MultiInstance)
+        if (node->type != kDMNodeType_Object_MultiInstance)
         {
-            USP_ERR_SetMessage("%s: Path %s does not have the right number of '{i}' instances (got %d, expected %d)", __FUNCTION__, path, inst->order, parent->order);
+            USP_ERR_SetMessage("%s: Path %s does not have the right number of '{i}' instances (got %d, expected %d)", __FUNCTION__, path, inst->order, node->order);
             return NULL;
         }
         else
         {
-            if (inst->order == parent->order-1)
+            if (inst->order == node->order-1)
             {
                 *is_qualified_instance = false;
             }
             else
             {
-                USP_ERR_SetMessage("%s: Path %s does not have the right number of '{i}' instances (got %d, expected %d)", __FUNCTION__, path, inst->order, parent->order);
+                USP_ERR_SetMessage("%s: Path %s does not have the right number of '{i}' instances (got %d, expected %d)", __FUNCTION__, path, inst->order, node->order);
                 return NULL;
             }
         }
@@ -2539,13 +3315,12 @@ dm_node_t *DM_PRIV_GetNodeFromPath(char *path, dm_instances_t *inst, bool *is_qu
     // Copy the nodes associated with each multi-instance object into the instances structure
     if (inst->order > 0)
     {
-        memcpy(inst->nodes, parent->instance_nodes, (inst->order)*sizeof(dm_node_t *));
+        memcpy(inst->nodes, node->instance_nodes, (inst->order)*sizeof(dm_node_t *));
     }
     // NOTE: We do not validate that the parsed instances actually exist in the data model in this function
     //       This is because for a SetParameterValues and AddObject, the instance might not yet exist
 
-    // If the code gets here, then all segments have been traversed in the data model
-    return parent;
+    return node;
 }
 
 /*********************************************************************//**
@@ -2619,6 +3394,13 @@ dm_node_t *DM_PRIV_AddSchemaPath(char *path, dm_node_type_t type, unsigned flags
         child = DM_PRIV_FindMatchingChild(parent, seg->name);
         if (child == NULL)
         {
+            // Exit if the schema has been compacted. Nodes cannot be added to it after this, as the child index of the parent is part of the schema arena
+            if (schema_arena != NULL)
+            {
+                USP_ERR_SetMessage("%s: Unable to register %s. The schema cannot be modified after VENDOR_Init() has returned", __FUNCTION__, path);
+                return NULL;
+            }
+
             // Node has not yet been added, so add it
             child = CreateNode(seg->name, seg->type, schema_path);
             if (child == NULL)
@@ -2629,6 +3411,9 @@ dm_node_t *DM_PRIV_AddSchemaPath(char *path, dm_node_type_t type, unsigned flags
             // Add the node to it's parent
             DLLIST_LinkToTail(&parent->child_nodes, child);
 
+            // Keep the parent's child index in step with it's list of children
+            AddChildToIndex(parent, child);
+
             // Add this node to the instance node array, if it is a multi-instance object
             if (seg->type == kDMNodeType_Object_MultiInstance)
             {
@@ -2766,6 +3551,30 @@ char *DM_PRIV_FormPath_FromDM(dm_node_t *node, dm_instances_t *inst, char *buf,
 **
 **************************************************************************/
 int DM_PRIV_FormDB_FromPath(char *path, dm_hash_t *hash, char *instances, int len)
+{
+    return DM_PRIV_FormDBParam_FromPath(path, hash, instances, len, NULL);
+}
+
+/*********************************************************************//**
+**
+** DM_PRIV_FormDBParam_FromPath
+**
+** Forms the hash, instance string and database flags of the specified parameter path, resolving the path only once
+** This function is called when writing parameters directly to the database (eg 'dbset' CLI command and factory reset import)
+**
+** \param   path - path to parameter in the data model
+** \param   hash - pointer to variable in which to store the hash identifying the data model parameter
+** \param   instances - pointer to buffer to return a string containing the instance numbers of the multi-instance objects in the path
+** \param   len - length of the buffer
+** \param   db_flags - pointer to variable in which to return the flags to use when storing the parameter in the database (eg OBFUSCATED_VALUE)
+**                     or NULL if the flags are not required
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INTERNAL_ERROR if the parameter does not exist in the data model or the
+**          instance numbers are not correct (invalid, too many or not enough for the object's path)
+**
+**************************************************************************/
+int DM_PRIV_FormDBParam_FromPath(char *path, dm_hash_t *hash, char *instances, int len, unsigned *db_flags)
 {
     dm_node_t *node;
     dm_instances_t inst;
@@ -2796,6 +3605,13 @@ int DM_PRIV_FormDB_FromPath(char *path, dm_hash_t *hash, char *instances, int le
 
     *hash = node->hash;
     FormInstanceString(&inst, instances, len);
+
+    // Secure parameters are obfuscated in the database
+    if (db_flags != NULL)
+    {
+        *db_flags = (node->type == kDMNodeType_DBParam_Secure) ? OBFUSCATED_VALUE : 0;
+    }
+
     return USP_ERR_OK;
 }
 
@@ -2864,50 +3680,153 @@ int DM_PRIV_FormPath_FromDB(dm_hash_t hash, char *instances, char *buf, int len)
 dm_node_t *DM_PRIV_FindMatchingChild(dm_node_t *parent, char *name)
 {
     dm_node_t *child;
-    
-    // Iterate over list of children, seeing if any match
-    child = (dm_node_t *) parent->child_nodes.head;
-    while (child != NULL)
+    unsigned mask;
+    unsigned slot;
+
+    // If the children of this node have been indexed, then lookup the child in the hash table
+    if (parent->child_index != NULL)
     {
-        if (strcmp(child->name, name)==0)
+        mask = parent->child_index_size - 1;
+        slot = ((unsigned)TEXT_UTILS_CalcHash(name)) & mask;
+        child = parent->child_index[slot];
+        while (child != NULL)
         {
-            // Found a match
-            return child;
+            if (strcmp(child->name, name)==0)
+            {
+                // Found a match
+                return child;
+            }
+
+            // Move to next slot (linear probing)
+            slot = (slot + 1) & mask;
+            child = parent->child_index[slot];
         }
 
-        // Move to next sibling in the data model tree
-        child = (dm_node_t *) child->link.next;
+        // If the code gets here, then no match was found
+        return NULL;
     }
 
-    // If the code gets here, then no match was found
-    return NULL;
+    // Otherwise search the list of children
+    return FindMatchingChild_Linear(parent, name);
 }
 
 /*********************************************************************//**
 **
-** DM_PRIV_AddUniqueKey
+** ResolveSchemaPath
 **
-** Adds a unique key to the vector of unique keys for a table
+** Walks the data model tree, returning the node associated with the given schema path
+** This is used by the 'dmbench resolve' CLI command, to measure the cost of finding child nodes
 **
-** \param   node - pointer to multi-instance object in data model to register the unique key with
-** \param   unique_key - pointer to structure representing the unique key to add
+** \param   path - schema path of the node to find (eg 'Device.LocalAgent.Controller.{i}.Enable')
+** \param   use_index - set if the index of each node's children should be used, otherwise each node's list of children is searched
 **
-** \return  None
+** \return  pointer to node, or NULL if no matching node was found
 **
 **************************************************************************/
-void DM_PRIV_AddUniqueKey(dm_node_t *node, dm_unique_key_t *unique_key)
+dm_node_t *ResolveSchemaPath(char *path, bool use_index)
 {
-    int new_num_entries;
-    dm_unique_key_vector_t *ukv;
-
-    USP_ASSERT(node->type == kDMNodeType_Object_MultiInstance);
-    ukv = &node->registered.object_info.unique_keys;
-    new_num_entries = ukv->num_entries + 1;
-    ukv->vector = USP_REALLOC(ukv->vector, new_num_entries*sizeof(dm_unique_key_t));
+    dm_node_t *parent;
+    char buf[MAX_DM_PATH];
+    char *segment;
+    char *next;
 
-    memcpy(&ukv->vector[ ukv->num_entries ], unique_key, sizeof(dm_unique_key_t));
-    ukv->num_entries = new_num_entries;
-}
+    USP_STRNCPY(buf, path, sizeof(buf));
+
+    // Exit if the first segment is not the root of the schema
+    next = strchr(buf, '.');
+    if (next != NULL)
+    {
+        *next++ = '\0';
+    }
+
+    if (strcmp(buf, root_device_node->name) != 0)
+    {
+        return NULL;
+    }
+    parent = root_device_node;
+
+    // Iterate over subsequent segments, using them to traverse the data model tree
+    while ((next != NULL) && (parent != NULL))
+    {
+        segment = next;
+        next = strchr(segment, '.');
+        if (next != NULL)
+        {
+            *next++ = '\0';
+        }
+
+        // Skip instance separators, as they do not have their own node
+        if (strcmp(segment, "{i}")==0)
+        {
+            continue;
+        }
+
+        parent = (use_index) ? DM_PRIV_FindMatchingChild(parent, segment) : FindMatchingChild_Linear(parent, segment);
+    }
+
+    return parent;
+}
+
+/*********************************************************************//**
+**
+** FindMatchingChild_Linear
+**
+** Finds the data model child node matching the specified name, given a parent node, by searching its list of children
+** This is used for nodes with too few children to be worth indexing, and by the 'dmbench resolve' CLI command
+**
+** \param   parent - pointer to data model node to find child node for
+** \param   name - name of child node
+**
+** \return  pointer to matching child node, or NULL if no match was found
+**
+**************************************************************************/
+dm_node_t *FindMatchingChild_Linear(dm_node_t *parent, char *name)
+{
+    dm_node_t *child;
+
+    // Iterate over list of children, seeing if any match
+    child = (dm_node_t *) parent->child_nodes.head;
+    while (child != NULL)
+    {
+        if (strcmp(child->name, name)==0)
+        {
+            // Found a match
+            return child;
+        }
+
+        // Move to next sibling in the data model tree
+        child = (dm_node_t *) child->link.next;
+    }
+
+    // If the code gets here, then no match was found
+    return NULL;
+}
+
+/*********************************************************************//**
+**
+** DM_PRIV_AddUniqueKey
+**
+** Adds a unique key to the vector of unique keys for a table
+**
+** \param   node - pointer to multi-instance object in data model to register the unique key with
+** \param   unique_key - pointer to structure representing the unique key to add
+**
+** \return  None
+**
+**************************************************************************/
+void DM_PRIV_AddUniqueKey(dm_node_t *node, dm_unique_key_t *unique_key)
+{
+    int new_num_entries;
+    dm_unique_key_vector_t *ukv;
+
+    USP_ASSERT(node->type == kDMNodeType_Object_MultiInstance);
+    ukv = &node->registered.object_info.unique_keys;
+    new_num_entries = ukv->num_entries + 1;
+    ukv->vector = USP_REALLOC(ukv->vector, new_num_entries*sizeof(dm_unique_key_t));
+
+    memcpy(&ukv->vector[ ukv->num_entries ], unique_key, sizeof(dm_unique_key_t));
+    ukv->num_entries = new_num_entries;
+}
 
 /*********************************************************************//**
 **
@@ -2995,6 +3914,9 @@ int DM_PRIV_ReRegister_DBParam_Default(char *path, char *value)
     USP_SAFE_FREE(info->default_value);
     info->default_value = USP_STRDUP(value);
 
+    // Discard the unique key indexes, as they may contain the old default value
+    DM_KEY_INDEX_InvalidateAll();
+
     return USP_ERR_OK;
 }
 
@@ -3253,10 +4175,8 @@ dm_node_t *CreateNode(char *name, dm_node_type_t type, char *schema_path)
 {
     dm_node_t *node;
     dm_node_t *n;
-    node_lookup_t *nl;
     dm_hash_t hash;
-    int size;
-    
+
     // Allocate memory for the node
     node = USP_MALLOC(sizeof(dm_node_t));
     memset(node, 0, sizeof(dm_node_t));     // NOTE: All roles start from zero permissions
@@ -3266,6 +4186,7 @@ dm_node_t *CreateNode(char *name, dm_node_type_t type, char *schema_path)
     node->type = type;
     node->name = USP_STRDUP(name);
     node->path = USP_STRDUP(schema_path);
+    node->ordinal = num_schema_nodes++;
     DLLIST_Init(&node->child_nodes);
 
     // Calculate hash of node (for use in database lookups) if node is a DB parameter
@@ -3282,19 +4203,13 @@ dm_node_t *CreateNode(char *name, dm_node_type_t type, char *schema_path)
         n = FindNodeFromHash(hash);
         if (n != NULL)
         {
-            USP_ERR_SetMessage("%s: Failed to add node %s because it's node hash conflicted with %s", __FUNCTION__, schema_path, n->name);
+            USP_ERR_SetMessage("%s: Failed to add node %s because it's node hash conflicted with %s", __FUNCTION__, schema_path, n->path);
             return NULL;
         }
         node->hash = hash;
 
-        // Append hash to node lookup
-        size = (node_lookup_count+1) * sizeof(node_lookup_t);
-        node_lookup = USP_REALLOC(node_lookup, size);
-
-        nl = &node_lookup[node_lookup_count];
-        nl->hash = node->hash;
-        nl->node = node;
-        node_lookup_count++;
+        // Add hash to node lookup
+        AddNodeToHashLookup(node);
     }
 
     return node;
@@ -3554,6 +4469,7 @@ int AddChildParamsDefaultValues(char *path, int path_len, dm_node_t *node, dm_in
                     {
                         return err;
                     }
+                    DM_KEY_INDEX_UpdateParam(child, inst, new_value);
                 
                     // Intentionally not intending to notify vendor of params which are defaulted,
                     // as we have a notify for when the whole instance has been added anyway
@@ -3598,7 +4514,7 @@ int AddChildParamsDefaultValues(char *path, int path_len, dm_node_t *node, dm_in
                     {
                         return err;
                     }
-                
+                    DM_KEY_INDEX_UpdateParam(child, inst, new_value);
                 }
                 break;
 
@@ -3638,25 +4554,22 @@ int AddChildParamsDefaultValues(char *path, int path_len, dm_node_t *node, dm_in
 
 /*********************************************************************//**
 **
-** DeleteChildParams
+** GetChildDBParamHashes
 **
-** Deletes all child parameters and object instances of the specified node
+** Gets the hashes of all database parameters which are children of the specified node,
+** including those in child single-instance and multi-instance objects
 ** NOTE: This function is recursive
 **
-** \param   path - path of the object instance to delete children from. This code will modify the buffer pointed to by this path
-**                 NOTE: path is only actually needed for debug and error reporting purposes
-** \param   path_len - length of path (position to append child node names)
-** \param   node - Node to delete children of
-** \param   inst - pointer to instance structure locating the parent node
+** \param   node - Node to get the child database parameters of
+** \param   hashes - pointer to vector in which to add the hashes
 **
-** \return  USP_ERR_OK if successful
+** \return  None
 **
 **************************************************************************/
-int DeleteChildParams(char *path, int path_len, dm_node_t *node, dm_instances_t *inst)
+void GetChildDBParamHashes(dm_node_t *node, int_vector_t *hashes)
 {
-    int err;
     dm_node_t *child;
-    
+
     // Iterate over list of children
     child = (dm_node_t *) node->child_nodes.head;
     while (child != NULL)
@@ -3668,47 +4581,14 @@ int DeleteChildParams(char *path, int path_len, dm_node_t *node, dm_instances_t
             case kDMNodeType_DBParam_ReadOnlyAuto:
             case kDMNodeType_DBParam_ReadWriteAuto:
             case kDMNodeType_DBParam_Secure:
-                {
-                    char instances[MAX_DM_PATH];
-
-                    // Append the name of this parameter to the parent path
-                    USP_SNPRINTF(&path[path_len], MAX_DM_PATH-path_len, ".%s", child->name);
-
-                    FormInstanceString(inst, instances, sizeof(instances));
-                    err = DATABASE_DeleteParameter(path, child->hash, instances);
-                    if (err != USP_ERR_OK)
-                    {
-                        return err;
-                    }
-                }
+                INT_VECTOR_Add(hashes, child->hash);
                 break;
 
-            // For single instance child object nodes, ensure that all of their children are deleted
             case kDMNodeType_Object_SingleInstance:
-                {
-                    int len;
-                    len = USP_SNPRINTF(&path[path_len], MAX_DM_PATH-path_len, ".%s", child->name);
-                    err = DeleteChildParams(path, path_len+len, child, inst);
-                    if (err != USP_ERR_OK)
-                    {
-                        return err;
-                    }
-                }
-                break;
-
-            // For multi-instance child objects, ensure that all instances of all of their children are deleted
             case kDMNodeType_Object_MultiInstance:
-                {
-                    int len;
-                    len = USP_SNPRINTF(&path[path_len], MAX_DM_PATH-path_len, ".%s", child->name);
-                    err = DeleteChildParams_MultiInstanceObject(path, path_len+len, child, inst);
-                    if (err != USP_ERR_OK)
-                    {
-                        return err;
-                    }
-                }
+                GetChildDBParamHashes(child, hashes);
                 break;
-                
+
             // Nothing to do for non database parameters
             case kDMNodeType_VendorParam_ReadOnly:
             case kDMNodeType_VendorParam_ReadWrite:
@@ -3727,15 +4607,73 @@ int DeleteChildParams(char *path, int path_len, dm_node_t *node, dm_instances_t
         // Move to next sibling in the data model tree
         child = (dm_node_t *) child->link.next;
     }
+}
+
+/*********************************************************************//**
+**
+** DeleteChildInstances
+**
+** Deletes all child object instances of the specified node from the data model
+** NOTE: The child parameters are not deleted from the database by this function. See DATABASE_DeleteParameterRange()
+** NOTE: This function is recursive
+**
+** \param   path - path of the object instance to delete children from. This code will modify the buffer pointed to by this path
+** \param   path_len - length of path (position to append child node names)
+** \param   node - Node to delete children of
+** \param   inst - pointer to instance structure locating the parent node
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int DeleteChildInstances(char *path, int path_len, dm_node_t *node, dm_instances_t *inst)
+{
+    int err;
+    int len;
+    dm_node_t *child;
+    
+    // Iterate over list of children
+    child = (dm_node_t *) node->child_nodes.head;
+    while (child != NULL)
+    {
+        switch(child->type)
+        {
+            // For single instance child object nodes, ensure that all of their child object instances are deleted
+            case kDMNodeType_Object_SingleInstance:
+                len = USP_SNPRINTF(&path[path_len], MAX_DM_PATH-path_len, ".%s", child->name);
+                err = DeleteChildInstances(path, path_len+len, child, inst);
+                if (err != USP_ERR_OK)
+                {
+                    return err;
+                }
+                break;
+
+            // For multi-instance child objects, ensure that all of their instances are deleted
+            case kDMNodeType_Object_MultiInstance:
+                len = USP_SNPRINTF(&path[path_len], MAX_DM_PATH-path_len, ".%s", child->name);
+                err = DeleteChildInstances_MultiInstanceObject(path, path_len+len, child, inst);
+                if (err != USP_ERR_OK)
+                {
+                    return err;
+                }
+                break;
+                
+            // Nothing to do for parameters, operations and events
+            default:
+                break;
+        }
+
+        // Move to next sibling in the data model tree
+        child = (dm_node_t *) child->link.next;
+    }
 
     return USP_ERR_OK;
 }
 
 /*********************************************************************//**
 **
-** DeleteChildParams_MultiInstanceObject
+** DeleteChildInstances_MultiInstanceObject
 **
-** Iterates over all instances of a multi-instance object, deleting Deletes all child parameters and child object instances
+** Iterates over all instances of a multi-instance object, deleting them and all of their child object instances from the data model
 ** NOTE: This function is recursive
 **
 ** \param   path - path of the object to delete children from. This code will modify the buffer pointed to by this path
@@ -3747,7 +4685,7 @@ int DeleteChildParams(char *path, int path_len, dm_node_t *node, dm_instances_t
 ** \return  USP_ERR_OK if successful
 **
 **************************************************************************/
-int DeleteChildParams_MultiInstanceObject(char *path, int path_len, dm_node_t *node, dm_instances_t *inst)
+int DeleteChildInstances_MultiInstanceObject(char *path, int path_len, dm_node_t *node, dm_instances_t *inst)
 {
     int_vector_t iv;
     int instance;
@@ -3776,9 +4714,9 @@ int DeleteChildParams_MultiInstanceObject(char *path, int path_len, dm_node_t *n
         instance = iv.vector[i];
         len = USP_SNPRINTF(&path[path_len], MAX_DM_PATH-path_len, ".%d", instance);
 
-        // Delete all child parameters of this object
+        // Delete all child object instances of this object
         inst->instances[order] = instance;
-        err = DeleteChildParams(path, path_len+len, node, inst);
+        err = DeleteChildInstances(path, path_len+len, node, inst);
         if (err != USP_ERR_OK)
         {
             goto exit;
@@ -3870,10 +4808,14 @@ void DestroySchemaRecursive(dm_node_t *parent)
             break;
     }
 
-    // Finally free this node itself
-    USP_FREE(parent->path);
-    USP_FREE(parent->name);    
-    USP_FREE(parent);    
+    // Finally free this node itself (unless it is part of the schema arena, which is freed separately)
+    if (schema_arena == NULL)
+    {
+        USP_SAFE_FREE(parent->child_index);
+        USP_FREE(parent->path);
+        USP_FREE(parent->name);
+        USP_FREE(parent);
+    }
 }
 
 /*********************************************************************//**
@@ -4032,66 +4974,875 @@ void AddChildNodes(dm_node_t *parent, str_vector_t *sv)
 
 /*********************************************************************//**
 **
-** FindNodeFromHash
+** InitPathCache
 **
-** Finds the node that matches the specified hash value
+** Initialises the cache of resolved data model paths, marking all entries as unused
 **
-** \param   hash - hash value of the node path of the node to find
+** \param   None
 **
-** \return  pointer to node matching hash in the data model, or NULL if no match
+** \return  None
 **
 **************************************************************************/
-dm_node_t *FindNodeFromHash(dm_hash_t hash)
+void InitPathCache(void)
 {
-    node_lookup_t *nl;
     int i;
+    path_cache_entry_t *pce;
+
+    memset(path_cache, 0, sizeof(path_cache));
+    memset(path_cache_buckets, 0, sizeof(path_cache_buckets));
+    DLLIST_Init(&path_cache_lru);
 
-    // Iterate over all nodes in the node lookup vector, looking for a match
-    for (i=0; i<node_lookup_count; i++)
+    // Add all entries to the LRU list. NOTE: None are in a hash bucket and all are stale (generation=0)
+    for (i=0; i<PATH_CACHE_ENTRIES; i++)
     {
-        nl = &node_lookup[i];
-        if (nl->hash == hash)
-        {
-            return nl->node;
-        }
+        pce = &path_cache[i];
+        DLLIST_LinkToTail(&path_cache_lru, pce);
     }
 
-    // if the code gets here, then no matching node was found
-    return NULL;
+    path_cache_hits = 0;
+    path_cache_misses = 0;
 }
 
 /*********************************************************************//**
 **
-** RegisterDefaultControllerTrust
+** LookupPathCache
 **
-** This function is called if no vendor hook overrides it
-** Registers all controller trust roles and permissions 
-** This function is called inbetween VENDOR_Init() and VENDOR_Start()
+** Returns the result of resolving the specified data model path, if it is present in the cache
 **
-** \param   None
+** \param   path - full data model path of the parameter or object to return the node of
+** \param   inst - pointer to instances structure, filled in from the cache
+** \param   is_qualified_instance - Pointer to boolean, filled in from the cache
 **
-** \return  USP_ERR_OK if successful
+** \return  pointer to node, or NULL if the path is not present in the cache
 **
 **************************************************************************/
-int RegisterDefaultControllerTrust(void)
+dm_node_t *LookupPathCache(char *path, dm_instances_t *inst, bool *is_qualified_instance)
 {
-    int err = USP_ERR_OK;
+    path_cache_entry_t *pce;
 
-    // Currently, it is important that the first role registered is full access, as all controllers
-    // inherit the first role in this table, and we currently want all controllers to have full access
-    err |= USP_DM_RegisterRoleName(kCTrustRole_FullAccess, "Full Access");
-    err |= USP_DM_AddControllerTrustPermission(kCTrustRole_FullAccess, "Device.", PERMIT_ALL);
+    pce = FindPathCacheEntry(path, (unsigned) TEXT_UTILS_CalcHash(path));
+    if ((pce == NULL) || (pce->generation != path_cache_generation))
+    {
+        path_cache_misses++;
+        return NULL;
+    }
 
-    err |= USP_DM_RegisterRoleName(kCTrustRole_Untrusted,  "Untrusted");
-    err |= USP_DM_AddControllerTrustPermission(kCTrustRole_Untrusted, "Device.", PERMIT_NONE);
-    err |= USP_DM_AddControllerTrustPermission(kCTrustRole_Untrusted, "Device.DeviceInfo.", PERMIT_GET | PERMIT_OBJ_INFO);
+    memcpy(inst, &pce->inst, sizeof(dm_instances_t));
+    *is_qualified_instance = pce->is_qualified_instance;
 
-    if (err != USP_ERR_OK)
+    // Mark this entry as the most recently used
+    DLLIST_Unlink(&path_cache_lru, pce);
+    DLLIST_LinkToHead(&path_cache_lru, pce);
+    path_cache_hits++;
+
+    return pce->node;
+}
+
+/*********************************************************************//**
+**
+** AddToPathCache
+**
+** Adds the result of resolving the specified data model path to the cache
+** If the cache is full, the least recently used entry is replaced
+**
+** \param   path - full data model path of the parameter or object that was resolved
+** \param   node - pointer to node that the path resolved to
+** \param   inst - pointer to instances structure parsed from the path
+** \param   is_qualified_instance - whether the instances fully qualified the node
+**
+** \return  None
+**
+**************************************************************************/
+void AddToPathCache(char *path, dm_node_t *node, dm_instances_t *inst, bool is_qualified_instance)
+{
+    path_cache_entry_t *pce;
+    unsigned path_hash;
+    int bucket;
+
+    // Exit if the path is too long to be cached
+    if (strlen(path) >= MAX_DM_PATH)
     {
-        USP_ERR_SetMessage("%s() failed", __FUNCTION__);
-        return USP_ERR_INTERNAL_ERROR;
+        return;
     }
 
-    return USP_ERR_OK;
+    // Reuse the stale entry for this path (if there is one), otherwise reuse the least recently used entry
+    path_hash = (unsigned) TEXT_UTILS_CalcHash(path);
+    pce = FindPathCacheEntry(path, path_hash);
+    if (pce == NULL)
+    {
+        pce = (path_cache_entry_t *) path_cache_lru.tail;
+        UnlinkPathCacheEntryFromBucket(pce);
+
+        USP_STRNCPY(pce->path, path, sizeof(pce->path));
+        pce->path_hash = path_hash;
+        bucket = path_hash % PATH_CACHE_NUM_BUCKETS;
+        pce->next_in_bucket = path_cache_buckets[bucket];
+        path_cache_buckets[bucket] = pce;
+    }
+
+    pce->generation = path_cache_generation;
+    pce->node = node;
+    memcpy(&pce->inst, inst, sizeof(dm_instances_t));
+    pce->is_qualified_instance = is_qualified_instance;
+
+    // Mark this entry as the most recently used
+    DLLIST_Unlink(&path_cache_lru, pce);
+    DLLIST_LinkToHead(&path_cache_lru, pce);
+}
+
+/*********************************************************************//**
+**
+** FindPathCacheEntry
+**
+** Finds the path cache entry for the specified data model path
+** NOTE: The entry returned may be stale. The caller must check its generation
+**
+** \param   path - data model path to find
+** \param   path_hash - hash of the data model path
+**
+** \return  pointer to path cache entry, or NULL if the path is not present in the cache
+**
+**************************************************************************/
+path_cache_entry_t *FindPathCacheEntry(char *path, unsigned path_hash)
+{
+    path_cache_entry_t *pce;
+
+    pce = path_cache_buckets[path_hash % PATH_CACHE_NUM_BUCKETS];
+    while (pce != NULL)
+    {
+        if ((pce->path_hash == path_hash) && (strcmp(pce->path, path)==0))
+        {
+            return pce;
+        }
+
+        pce = pce->next_in_bucket;
+    }
+
+    return NULL;
 }
 
+/*********************************************************************//**
+**
+** UnlinkPathCacheEntryFromBucket
+**
+** Removes the specified path cache entry from the hash bucket chain it is in (if any)
+**
+** \param   pce - pointer to path cache entry to remove
+**
+** \return  None
+**
+**************************************************************************/
+void UnlinkPathCacheEntryFromBucket(path_cache_entry_t *pce)
+{
+    path_cache_entry_t **p;
+
+    // Exit if this entry has never been used
+    if (pce->path[0] == '\0')
+    {
+        return;
+    }
+
+    p = &path_cache_buckets[pce->path_hash % PATH_CACHE_NUM_BUCKETS];
+    while (*p != NULL)
+    {
+        if (*p == pce)
+        {
+            *p = pce->next_in_bucket;
+            break;
+        }
+        p = &(*p)->next_in_bucket;
+    }
+
+    pce->next_in_bucket = NULL;
+    pce->path[0] = '\0';
+}
+
+/*********************************************************************//**
+**
+** BuildChildIndex
+**
+** (Re)builds the open addressed hash table used to lookup the children of the specified node by name
+** NOTE: The linked list of children is retained, as it defines the order of iteration over the children
+**
+** \param   parent - pointer to data model node to index the children of
+**
+** \return  None
+**
+**************************************************************************/
+void BuildChildIndex(dm_node_t *parent)
+{
+    dm_node_t *child;
+    int num_children;
+    int size;
+    unsigned mask;
+    unsigned slot;
+
+    // Count the number of children of this node
+    num_children = 0;
+    child = (dm_node_t *) parent->child_nodes.head;
+    while (child != NULL)
+    {
+        num_children++;
+        child = (dm_node_t *) child->link.next;
+    }
+
+    parent->num_children = num_children;
+
+    // Exit if the node has too few children to be worth indexing
+    USP_SAFE_FREE(parent->child_index);
+    parent->child_index_size = 0;
+    if (num_children < MIN_CHILDREN_TO_INDEX)
+    {
+        return;
+    }
+
+    // Size the hash table to be a power of 2, with a load factor of at most 50%
+    size = 1;
+    while (size < 2*num_children)
+    {
+        size *= 2;
+    }
+    mask = size - 1;
+
+    parent->child_index = USP_MALLOC(size*sizeof(dm_node_t *));
+    memset(parent->child_index, 0, size*sizeof(dm_node_t *));
+    parent->child_index_size = size;
+
+    // Add all children to the hash table, resolving collisions by linear probing
+    child = (dm_node_t *) parent->child_nodes.head;
+    while (child != NULL)
+    {
+        slot = ((unsigned)TEXT_UTILS_CalcHash(child->name)) & mask;
+        while (parent->child_index[slot] != NULL)
+        {
+            slot = (slot + 1) & mask;
+        }
+        parent->child_index[slot] = child;
+
+        child = (dm_node_t *) child->link.next;
+    }
+}
+
+/*********************************************************************//**
+**
+** AddChildToIndex
+**
+** Adds a newly created child node to the child index hash table of its parent
+** The hash table is created once the parent has enough children to make it worthwhile, and
+** is rebuilt at double the size whenever it becomes more than half full.
+** This keeps the cost of registering a node independent of the number of siblings it has.
+** NOTE: The child must already have been added to the parent's linked list of children
+** NOTE: The caller must ensure that the schema has not been compacted, as the child index is then part of the schema arena
+**
+** \param   parent - pointer to data model node which the child has been added to
+** \param   child - pointer to data model node which has been added
+**
+** \return  None
+**
+**************************************************************************/
+void AddChildToIndex(dm_node_t *parent, dm_node_t *child)
+{
+    unsigned mask;
+    unsigned slot;
+
+    parent->num_children++;
+
+    // Rebuild the index if the node does not have one yet (and now has enough children to warrant one), or if it is too full
+    if (2*parent->num_children > parent->child_index_size)
+    {
+        if (parent->num_children >= MIN_CHILDREN_TO_INDEX)
+        {
+            BuildChildIndex(parent);
+        }
+        return;
+    }
+
+    // Otherwise add the child to the existing index, resolving collisions by linear probing
+    mask = parent->child_index_size - 1;
+    slot = ((unsigned)TEXT_UTILS_CalcHash(child->name)) & mask;
+    while (parent->child_index[slot] != NULL)
+    {
+        slot = (slot + 1) & mask;
+    }
+    parent->child_index[slot] = child;
+}
+
+/*********************************************************************//**
+**
+** CountSchemaNodesRecursive
+**
+** Counts the number of nodes in the data model schema, rooted at the specified node
+**
+** \param   parent - pointer to node at the root of the part of the schema to count
+**
+** \return  number of nodes (including the specified node)
+**
+**************************************************************************/
+int CountSchemaNodesRecursive(dm_node_t *parent)
+{
+    dm_node_t *child;
+    int count;
+
+    count = 1;
+    child = (dm_node_t *) parent->child_nodes.head;
+    while (child != NULL)
+    {
+        count += CountSchemaNodesRecursive(child);
+        child = (dm_node_t *) child->link.next;
+    }
+
+    return count;
+}
+
+/*********************************************************************//**
+**
+** CollectSchemaNodesRecursive
+**
+** Adds all nodes in the data model schema rooted at the specified node to the given array, in depth first order
+**
+** \param   parent - pointer to node at the root of the part of the schema to collect
+** \param   nodes - array in which to store the pointers to the nodes
+** \param   num_nodes - pointer to variable containing the number of entries in the array. Updated by this function
+**
+** \return  None
+**
+**************************************************************************/
+void CollectSchemaNodesRecursive(dm_node_t *parent, dm_node_t **nodes, int *num_nodes)
+{
+    dm_node_t *child;
+
+    nodes[*num_nodes] = parent;
+    (*num_nodes)++;
+
+    child = (dm_node_t *) parent->child_nodes.head;
+    while (child != NULL)
+    {
+        CollectSchemaNodesRecursive(child, nodes, num_nodes);
+        child = (dm_node_t *) child->link.next;
+    }
+}
+
+#ifdef COMPACT_DM_SCHEMA
+/*********************************************************************//**
+**
+** CompactSchema
+**
+** Repacks all nodes in the data model schema into a single block of memory, once the schema has been fully registered
+** The nodes are stored in depth first order (so that the children of a node are close to it in memory),
+** followed by the child index tables, then the node names (interned, so that each distinct name is stored only once),
+** and finally the schema paths (which are rarely accessed)
+** NOTE: This function must only be called after the schema has been registered and indexed, and before any
+**       references to schema nodes have been taken (other than those in the tree itself, node_lookup and the path cache)
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void CompactSchema(void)
+{
+    int num_nodes;
+    int num_slots;
+    int names_len;
+    int paths_len;
+    int name_table_size;
+    interned_name_t *name_table;
+    interned_name_t *in;
+    dm_node_t **old_nodes;
+    dm_node_t *new_nodes;
+    dm_node_t **next_slot;
+    char *next_name;
+    char *next_path;
+    dm_node_t *old;
+    dm_node_t *node;
+    dm_instances_vector_t *div;
+    dm_unique_key_vector_t *ukv;
+    int len;
+    int i, j, k;
+
+    // Exit if the schema has already been compacted
+    if (schema_arena != NULL)
+    {
+        return;
+    }
+
+    // Make a list of all nodes in the schema, in depth first order
+    num_nodes = CountSchemaNodesRecursive(root_device_node) + CountSchemaNodesRecursive(root_internal_node);
+    old_nodes = USP_MALLOC(num_nodes*sizeof(dm_node_t *));
+    i = 0;
+    CollectSchemaNodesRecursive(root_device_node, old_nodes, &i);
+    CollectSchemaNodesRecursive(root_internal_node, old_nodes, &i);
+    USP_ASSERT(i == num_nodes);
+
+    // Size the string pools and child index tables, interning the names of the nodes
+    name_table_size = 1;
+    while (name_table_size < 2*num_nodes)
+    {
+        name_table_size *= 2;
+    }
+    name_table = USP_MALLOC(name_table_size*sizeof(interned_name_t));
+    memset(name_table, 0, name_table_size*sizeof(interned_name_t));
+
+    num_slots = 0;
+    names_len = 0;
+    paths_len = 0;
+    for (i=0; i<num_nodes; i++)
+    {
+        old = old_nodes[i];
+        num_slots += old->child_index_size;
+        paths_len += strlen(old->path) + 1;
+
+        in = FindInternedName(name_table, name_table_size, old->name);
+        if (in->name == NULL)
+        {
+            in->name = old->name;
+            names_len += strlen(old->name) + 1;
+        }
+    }
+
+    // Allocate the arena, and work out where each part of it starts
+    schema_arena = USP_MALLOC(num_nodes*sizeof(dm_node_t) + num_slots*sizeof(dm_node_t *) + names_len + paths_len);
+    new_nodes = (dm_node_t *) schema_arena;
+    next_slot = (dm_node_t **) &new_nodes[num_nodes];
+    next_name = (char *) &next_slot[num_slots];
+    next_path = &next_name[names_len];
+
+    // Copy the interned names into the arena
+    for (i=0; i<name_table_size; i++)
+    {
+        in = &name_table[i];
+        if (in->name != NULL)
+        {
+            len = strlen(in->name) + 1;
+            memcpy(next_name, in->name, len);
+            in->arena_name = next_name;
+            next_name += len;
+        }
+    }
+
+    // Copy each node into the arena
+    // NOTE: Ownership of the allocations held in the 'registered' union is transferred to the copy of the node
+    for (i=0; i<num_nodes; i++)
+    {
+        old = old_nodes[i];
+        node = &new_nodes[i];
+        memcpy(node, old, sizeof(dm_node_t));
+
+        node->name = FindInternedName(name_table, name_table_size, old->name)->arena_name;
+        len = strlen(old->path) + 1;
+        memcpy(next_path, old->path, len);
+        node->path = next_path;
+        next_path += len;
+
+        if (old->child_index != NULL)
+        {
+            node->child_index = next_slot;
+            memcpy(node->child_index, old->child_index, old->child_index_size*sizeof(dm_node_t *));
+            next_slot += old->child_index_size;
+        }
+
+        // Now that the original node has been copied, its link is reused to point to its copy in the arena (see RemapNode)
+        old->link.next = (double_link_t *) node;
+    }
+
+    // Update all pointers to nodes in the arena, so that they point to the copies in the arena, rather than the original nodes
+    for (i=0; i<num_nodes; i++)
+    {
+        node = &new_nodes[i];
+        node->link.next = (double_link_t *) RemapNode((dm_node_t *) node->link.next);
+        node->link.prev = (double_link_t *) RemapNode((dm_node_t *) node->link.prev);
+        node->child_nodes.head = (double_link_t *) RemapNode((dm_node_t *) node->child_nodes.head);
+        node->child_nodes.tail = (double_link_t *) RemapNode((dm_node_t *) node->child_nodes.tail);
+
+        for (j=0; j < node->child_index_size; j++)
+        {
+            node->child_index[j] = RemapNode(node->child_index[j]);
+        }
+
+        for (j=0; j<MAX_DM_INSTANCE_ORDER; j++)
+        {
+            node->instance_nodes[j] = RemapNode(node->instance_nodes[j]);
+        }
+
+        switch (node->type)
+        {
+            case kDMNodeType_Param_NumEntries:
+                node->registered.param_info.table_node = RemapNode(node->registered.param_info.table_node);
+                break;
+
+            case kDMNodeType_Object_MultiInstance:
+                // NOTE: Normally there will not be any instances at this point, unless the vendor informed us of them in VENDOR_Init()
+                div = &node->registered.object_info.inst_vector;
+                for (j=0; j < div->num_entries; j++)
+                {
+                    RemapInstances(&div->vector[j]);
+                }
+                DM_INST_VECTOR_Sort(div);
+
+                // Unique keys point to the names of their parameter nodes, so must point to the interned names in the arena instead
+                ukv = &node->registered.object_info.unique_keys;
+                for (j=0; j < ukv->num_entries; j++)
+                {
+                    for (k=0; (k < MAX_COMPOUND_KEY_PARAMS) && (ukv->vector[j].param[k] != NULL); k++)
+                    {
+                        ukv->vector[j].param[k] = FindInternedName(name_table, name_table_size, ukv->vector[j].param[k])->arena_name;
+                    }
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    // Update all other references to nodes, so that they point into the arena
+    root_device_node = RemapNode(root_device_node);
+    root_internal_node = RemapNode(root_internal_node);
+    for (i=0; i<node_lookup_size; i++)
+    {
+        node_lookup[i].node = RemapNode(node_lookup[i].node);
+    }
+    DM_PRIV_InvalidatePathCache();
+
+    // Finally free the original nodes
+    for (i=0; i<num_nodes; i++)
+    {
+        old = old_nodes[i];
+        USP_SAFE_FREE(old->child_index);
+        USP_FREE(old->path);
+        USP_FREE(old->name);
+        USP_FREE(old);
+    }
+
+    USP_FREE(name_table);
+    USP_FREE(old_nodes);
+}
+
+/*********************************************************************//**
+**
+** FindInternedName
+**
+** Finds the slot in the (open addressed) interned name table which contains the specified name,
+** or the empty slot which it should be stored in, if it has not been interned yet
+**
+** \param   name_table - pointer to interned name table
+** \param   size - number of slots in the interned name table. Always a power of 2
+** \param   name - name to find
+**
+** \return  pointer to slot in the interned name table
+**
+**************************************************************************/
+interned_name_t *FindInternedName(interned_name_t *name_table, int size, char *name)
+{
+    unsigned mask;
+    unsigned slot;
+
+    mask = size - 1;
+    slot = ((unsigned)TEXT_UTILS_CalcHash(name)) & mask;
+    while ((name_table[slot].name != NULL) && (strcmp(name_table[slot].name, name) != 0))
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return &name_table[slot];
+}
+
+/*********************************************************************//**
+**
+** RemapNode
+**
+** Returns the address in the schema arena of the specified node, whilst the schema is being compacted
+** NOTE: Once a node has been copied into the arena, the link.next field of the original node points to the copy
+**
+** \param   old_node - original address of the node, or NULL
+**
+** \return  address of the node in the schema arena, or NULL if old_node was NULL
+**
+**************************************************************************/
+dm_node_t *RemapNode(dm_node_t *old_node)
+{
+    if (old_node == NULL)
+    {
+        return NULL;
+    }
+
+    return (dm_node_t *) old_node->link.next;
+}
+
+/*********************************************************************//**
+**
+** RemapInstances
+**
+** Updates the node pointers in the specified instances structure, so that they point into the schema arena
+**
+** \param   inst - pointer to instances structure to update
+**
+** \return  None
+**
+**************************************************************************/
+void RemapInstances(dm_instances_t *inst)
+{
+    int i;
+
+    for (i=0; i < inst->order; i++)
+    {
+        inst->nodes[i] = RemapNode(inst->nodes[i]);
+    }
+}
+#endif
+
+/*********************************************************************//**
+**
+** FindNodeFromHash
+**
+** Finds the node that matches the specified hash value
+**
+** \param   hash - hash value of the node path of the node to find
+**
+** \return  pointer to node matching hash in the data model, or NULL if no match
+**
+**************************************************************************/
+dm_node_t *FindNodeFromHash(dm_hash_t hash)
+{
+    node_lookup_t *nl;
+    unsigned mask;
+    unsigned slot;
+
+    // Exit if no nodes have been added yet
+    if (node_lookup_size == 0)
+    {
+        return NULL;
+    }
+
+    // Probe the hash table, starting at the slot selected by the hash, until we find a match or an empty slot
+    mask = node_lookup_size - 1;
+    slot = ((unsigned)hash) & mask;
+    nl = &node_lookup[slot];
+    while (nl->node != NULL)
+    {
+        if (nl->hash == hash)
+        {
+            return nl->node;
+        }
+
+        slot = (slot + 1) & mask;
+        nl = &node_lookup[slot];
+    }
+
+    // if the code gets here, then no matching node was found
+    return NULL;
+}
+
+/*********************************************************************//**
+**
+** AddNodeToHashLookup
+**
+** Adds the specified node to the hash table used to lookup DB parameter nodes by their hash
+** The hash table is doubled in size (and rehashed) whenever it becomes more than half full
+** NOTE: The caller must have already checked that the hash of the node is not already present in the table
+**
+** \param   node - pointer to node to add. The hash of the node must already have been calculated
+**
+** \return  None
+**
+**************************************************************************/
+void AddNodeToHashLookup(dm_node_t *node)
+{
+    node_lookup_t *old_lookup;
+    int old_size;
+    node_lookup_t *nl;
+    unsigned mask;
+    unsigned slot;
+    int i;
+
+    // Grow the hash table, if adding this node would make it more than half full
+    if (2*(node_lookup_count+1) > node_lookup_size)
+    {
+        old_lookup = node_lookup;
+        old_size = node_lookup_size;
+
+        node_lookup_size = (old_size == 0) ? 256 : 2*old_size;
+        node_lookup = USP_MALLOC(node_lookup_size*sizeof(node_lookup_t));
+        memset(node_lookup, 0, node_lookup_size*sizeof(node_lookup_t));
+        node_lookup_count = 0;
+
+        // Rehash all existing nodes into the new table
+        for (i=0; i<old_size; i++)
+        {
+            if (old_lookup[i].node != NULL)
+            {
+                AddNodeToHashLookup(old_lookup[i].node);
+            }
+        }
+        USP_SAFE_FREE(old_lookup);
+    }
+
+    // Find the first free slot, starting at the slot selected by the hash
+    mask = node_lookup_size - 1;
+    slot = ((unsigned)node->hash) & mask;
+    nl = &node_lookup[slot];
+    while (nl->node != NULL)
+    {
+        USP_ASSERT(nl->hash != node->hash);
+        slot = (slot + 1) & mask;
+        nl = &node_lookup[slot];
+    }
+
+    nl->hash = node->hash;
+    nl->node = node;
+    node_lookup_count++;
+}
+
+/*********************************************************************//**
+**
+** RegisterDefaultControllerTrust
+**
+** This function is called if no vendor hook overrides it
+** Registers all controller trust roles and permissions 
+** This function is called inbetween VENDOR_Init() and VENDOR_Start()
+**
+** \param   None
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int RegisterDefaultControllerTrust(void)
+{
+    int err = USP_ERR_OK;
+
+    // Currently, it is important that the first role registered is full access, as all controllers
+    // inherit the first role in this table, and we currently want all controllers to have full access
+    err |= USP_DM_RegisterRoleName(kCTrustRole_FullAccess, "Full Access");
+    err |= USP_DM_AddControllerTrustPermission(kCTrustRole_FullAccess, "Device.", PERMIT_ALL);
+
+    err |= USP_DM_RegisterRoleName(kCTrustRole_Untrusted,  "Untrusted");
+    err |= USP_DM_AddControllerTrustPermission(kCTrustRole_Untrusted, "Device.", PERMIT_NONE);
+    err |= USP_DM_AddControllerTrustPermission(kCTrustRole_Untrusted, "Device.DeviceInfo.", PERMIT_GET | PERMIT_OBJ_INFO);
+
+    if (err != USP_ERR_OK)
+    {
+        USP_ERR_SetMessage("%s() failed", __FUNCTION__);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    return USP_ERR_OK;
+}
+
+
+/*********************************************************************//**
+**
+** GetVendorParamGroupId
+**
+** Determines the group of vendor parameters (if any) that the specified parameter belongs to
+**
+** \param   node - pointer to the resolved node of the parameter, or NULL if the path could not be resolved
+** \param   inst - pointer to instance structure specifying the object instances in the parameter's path
+**
+** \return  group_id of the parameter, or NON_GROUPED if the parameter is not a grouped vendor parameter
+**          NOTE: NON_GROUPED is also returned if the parameter does not exist, so that the error is reported when getting it individually
+**
+**************************************************************************/
+int GetVendorParamGroupId(dm_node_t *node, dm_instances_t *inst)
+{
+    if ((node == NULL) || ((node->type != kDMNodeType_VendorParam_ReadOnly) && (node->type != kDMNodeType_VendorParam_ReadWrite)))
+    {
+        return NON_GROUPED;
+    }
+
+    if ((inst->order > 0) && (DM_INST_VECTOR_IsExist(inst) == false))
+    {
+        return NON_GROUPED;
+    }
+
+    return node->registered.param_info.group_id;
+}
+
+/*********************************************************************//**
+**
+** GetVendorGroupValues
+**
+** Calls the vendor hook to get the values of the specified parameters in a group
+**
+** \param   group_id - group which all of the parameters belong to
+** \param   params - key-value vector containing the paths of the parameters to get (as keys), with all values NULL
+**                   On return, the values set by the vendor hook. All values are NULL if an error is returned.
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int GetVendorGroupValues(int group_id, kv_vector_t *params)
+{
+    int i;
+    int err;
+    dm_get_group_cb_t get_group_cb;
+
+    // Exit if the vendor has not registered a hook to get the values of this group
+    get_group_cb = group_vendor_hooks[group_id].get_group_cb;
+    if (get_group_cb == NULL)
+    {
+        USP_ERR_SetMessage("%s: No get group callback registered for group %d", __FUNCTION__, group_id);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if unable to get the values from the vendor code, discarding any values it may have set
+    USP_ERR_ClearMessage();
+    err = get_group_cb(group_id, params);
+    if (err != USP_ERR_OK)
+    {
+        USP_ERR_ReplaceEmptyMessage("%s: Get group callback for group %d returned error %d", __FUNCTION__, group_id, err);
+        for (i=0; i < params->num_entries; i++)
+        {
+            USP_SAFE_FREE(params->vector[i].value);
+        }
+        return err;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** SaveFirstError
+**
+** Saves the error code and message of a parameter which could not be got, if it occurs earlier
+** in the parameter vector than any previously saved error
+**
+** \param   index - index of the parameter which could not be got
+** \param   err - error code of the parameter
+** \param   first_err_index - pointer to variable containing the index of the earliest parameter which could not be got
+** \param   first_err - pointer to variable containing the error code of the earliest parameter which could not be got
+** \param   first_err_msg - buffer (of size USP_ERR_MAXLEN) containing the error message of the earliest parameter which could not be got
+**
+** \return  None
+**
+**************************************************************************/
+void SaveFirstError(int index, int err, int *first_err_index, int *first_err, char *first_err_msg)
+{
+    if ((*first_err_index == INVALID) || (index < *first_err_index))
+    {
+        *first_err_index = index;
+        *first_err = err;
+        USP_STRNCPY(first_err_msg, USP_ERR_GetMessage(), USP_ERR_MAXLEN);
+    }
+}
+
+/*********************************************************************//**
+**
+** UpdateStartupTime
+**
+** Records the time taken by a phase of building or starting the data model
+**
+** \param   phase_time - pointer to variable in which to store the time taken by the phase (in microseconds)
+** \param   start_time - time (in microseconds, from tu_uptime_usecs) at which the phase started
+**
+** \return  Current time (in microseconds), which is the start time of the next phase
+**
+**************************************************************************/
+uint64_t UpdateStartupTime(uint64_t *phase_time, uint64_t start_time)
+{
+    uint64_t now;
+
+    now = tu_uptime_usecs();
+    *phase_time = now - start_time;
+    return now;
+}
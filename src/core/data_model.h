@@ -48,6 +48,7 @@
 #include "sync_timer.h"
 #include "subs_vector.h"
 #include "device.h"
+#include "dm_access.h"
 
 //-----------------------------------------------------------------------------------------
 // Type of each data model node
@@ -123,8 +124,12 @@ typedef struct
     dm_set_value_cb_t set_cb;
     unsigned type_flags;                  // type of the parameter
     struct dm_node_tag *table_node;       // database node representing the table which we need to get the number of entries in (for kDMNodeType_Param_NumEntries)
+    int group_id;                         // Group of vendor parameters which this parameter belongs to, or NON_GROUPED if the vendor parameter has its own vendor hooks
 } dm_param_info_t;
 
+// Value of group_id for vendor parameters which are not part of a group
+#define NON_GROUPED -1
+
 // Information registered in the data model for objects
 typedef struct
 {
@@ -136,6 +141,7 @@ typedef struct
     dm_notify_del_cb_t   notify_del_cb;
     dm_unique_key_vector_t unique_keys;
     dm_instances_vector_t inst_vector;
+    struct dm_key_index_tag *key_index;  // Index of the values of the unique key parameters, or NULL if not built yet (see dm_key_index.c)
 } dm_object_info_t;
 
 // Information registered in the data model for operations
@@ -167,14 +173,19 @@ typedef int dm_hash_t;
 // Structure describing each data model node
 typedef struct dm_node_tag
 {
-    double_link_t link;         // Link to siblings in the data model tree
-    char *path;                 // Schema path for this node. Used for debug, passed to the vendor hooks and with GetSupportedDM
+    // NOTE: The fields in this structure are ordered so that those accessed whilst walking the data model tree (resolving paths)
+    // are grouped together at the start of the structure, and those only used once the node has been found are at the end
+    double_link_t link;         // Link to siblings in the data model tree. NOTE: This must be the first member of this structure
 
     char *name;                 // Part of the path that this node implements
     dm_node_type_t type;
+    dm_hash_t hash;             // If this is a parameter (not object), contains hash of the node path to this parameter
     double_linked_list_t child_nodes;
 
-    dm_hash_t hash;             // If this is a parameter (not object), contains hash of the node path to this parameter
+    struct dm_node_tag **child_index; // Open addressed hash table of child nodes, keyed by name. Used to speed up DM_PRIV_FindMatchingChild()
+                                      // NULL if the node has too few children to be worth indexing
+    int child_index_size;             // Number of slots in child_index[]. Always a power of 2
+    int num_children;                 // Number of nodes in child_nodes
 
     int order;                   // Number of instance separators in the path to this node
                                  // e.g. Device.Wifi.{i}.Interface.{i}.Enable would have an order of 2
@@ -182,10 +193,14 @@ typedef struct dm_node_tag
                                  // 'Device.Wifi.{i}.Interface' in the instance_nodes[] array
                                  // For nodes which are objects, if the node is a multi-instance object, then 
                                  // it's instance separator is included e.g. Device.Wifi.{i}.Interface.{i} would have an order of 2
-    struct dm_node_tag *instance_nodes[MAX_DM_INSTANCE_ORDER]; // See 'order' above
+
+    unsigned ordinal;            // Order in which this node was registered. Used as a stable key when sorting object instances (see dm_inst_vector.c)
 
     unsigned short permissions[kCTrustRole_Max];    // Bitmask of permissions for each role
 
+    char *path;                 // Schema path for this node. Used for debug, passed to the vendor hooks and with GetSupportedDM
+    struct dm_node_tag *instance_nodes[MAX_DM_INSTANCE_ORDER]; // See 'order' above
+
     union
     {
         dm_param_info_t  param_info;                    // Parameters
@@ -200,6 +215,17 @@ typedef struct dm_node_tag
 // Structure containing the vendor hook callbacks
 extern vendor_hook_cb_t vendor_hook_callbacks;
 
+//------------------------------------------------------------------------------
+// Structure containing the vendor hook callbacks for a group of vendor parameters
+typedef struct
+{
+    dm_get_group_cb_t get_group_cb;
+    dm_set_group_cb_t set_group_cb;
+} group_vendor_hook_t;
+
+// Array of vendor hook callbacks for each group of vendor parameters, indexed by group_id
+extern group_vendor_hook_t group_vendor_hooks[MAX_VENDOR_PARAM_GROUPS];
+
 //------------------------------------------------------------------------------
 // Boolean that allows us to control which scope the USP_REGISTER_XXX() functions can be called in
 extern bool is_executing_within_dm_init;
@@ -277,6 +303,7 @@ int DATA_MODEL_GetPermissions(char *path, combined_role_t *combined_role, unsign
 int DATA_MODEL_NotifyInstanceAdded(char *path);
 int DATA_MODEL_NotifyInstanceDeleted(char *path);
 int DATA_MODEL_GetParameterValue(char *path, char *buf, int len, unsigned flags);
+int DATA_MODEL_GetParameterValues(kv_vector_t *params, unsigned flags);
 int DATA_MODEL_SetParameterValue(char *path, char *new_value, unsigned flags);
 int DATA_MODEL_Operate(char *path, kv_vector_t *input_args, kv_vector_t *output_args, char *command_key, int *instance);
 int DATA_MODEL_ShouldOperationRestart(char *path, int instance, bool *is_restart, int *err_code, char *err_msg, int err_msg_len, kv_vector_t *output_args);
@@ -290,16 +317,30 @@ int DATA_MODEL_GetUniqueKeys(char *path, dm_unique_key_vector_t *ukv);
 int DATA_MODEL_GetUniqueKeyParams(char *obj_path, kv_vector_t *params, combined_role_t *combined_role);
 void DATA_MODEL_DumpSchema(void);
 void DATA_MODEL_DumpInstances(void);
+void DATA_MODEL_DumpPathCache(void);
+int DATA_MODEL_BenchResolve(int num_paths);
+void DATA_MODEL_DumpStartupTimes(void);
 char DATA_MODEL_GetJSONParameterType(char *path);
 int DATA_MODEL_SetParameterInDatabase(char *path, char *value);
+bool DATA_MODEL_IsDatabaseParam(char *path);
+bool DATA_MODEL_IsGroupedVendorParam(char *path);
 
 int DM_PRIV_InitSetRequest(dm_req_t *req, dm_node_t *node, char *path, dm_instances_t *inst, char *new_value);
 void DM_PRIV_RequestInit(dm_req_t *req, dm_node_t *node, char *path, dm_instances_t *inst);
 char *DM_PRIV_FormPath_FromDM(dm_node_t *node, dm_instances_t *inst, char *buf, int len);
 dm_node_t *DM_PRIV_AddSchemaPath(char *path, dm_node_type_t type, unsigned flags);
 int DM_PRIV_FormDB_FromPath(char *path, dm_hash_t *hash, char *instances, int len);
+int DM_PRIV_FormDBParam_FromPath(char *path, dm_hash_t *hash, char *instances, int len, unsigned *db_flags);
 int DM_PRIV_FormPath_FromDB(dm_hash_t hash, char *instances, char *buf, int len);
 dm_node_t *DM_PRIV_GetNodeFromPath(char *path, dm_instances_t *inst, bool *is_qualified_instance);
+dm_node_t *DM_PRIV_GetSubPathNode(char *path, int offset, dm_node_t *parent, dm_instances_t *inst, bool *is_qualified_instance);
+unsigned DM_PRIV_GetPathProperties(dm_node_t *node, dm_instances_t *path_inst, bool is_qualified_instance, combined_role_t *combined_role, unsigned short *permission_bitmask);
+int DM_PRIV_GetParameterValue(char *path, dm_node_t *node, dm_instances_t *inst, char *buf, int len, unsigned flags);
+int DM_PRIV_CompareParameterValue(char *path, dm_node_t *node, dm_instances_t *inst, expr_op_t op, char *expr_constant, bool *result);
+void DM_PRIV_CompilePredicate(dm_node_t *node, expr_op_t op, char *expr_constant, expr_predicate_t *pred);
+int DM_PRIV_EvaluatePredicate(char *path, dm_node_t *node, dm_instances_t *inst, expr_predicate_t *pred, bool *result);
+void DM_PRIV_InvalidatePathCache(void);
+unsigned DM_PRIV_GetInstancesGeneration(void);
 dm_node_t *DM_PRIV_FindMatchingChild(dm_node_t *parent, char *name);
 void DM_PRIV_AddUniqueKey(dm_node_t *node, dm_unique_key_t *unique_key);
 void DM_PRIV_ApplyPermissions(dm_node_t *node, ctrust_role_t role, unsigned short permission_bitmask);
@@ -52,6 +52,9 @@
 #include "os_utils.h"
 #include "text_utils.h"
 #include "vendor_api.h"
+#include "sync_timer.h"
+#include "dllist.h"
+#include "dm_key_index.h"
 
 //--------------------------------------------------------------------
 // Prepared SQL statements
@@ -60,6 +63,7 @@ typedef enum
     kSqlStmt_Get=0,
     kSqlStmt_Set,
     kSqlStmt_Del,
+    kSqlStmt_DataVersion,
 
     kSqlStmt_Max            // Always last in the enumeration - used to size arrays
 } sql_stmt_t;
@@ -72,7 +76,8 @@ static char *prepared_stmt_sql[kSqlStmt_Max] =
 {
     "select value from data_model where hash = ?1 and instances = ?2;",           // kSqlStmt_Get
     "insert or replace into data_model(hash,instances,value) values(?1, ?2, ?3);", // kSqlStmt_Set
-    "delete from data_model where hash = ?1 and instances = ?2;"                  // kSqlStmt_Del
+    "delete from data_model where hash = ?1 and instances = ?2;",                 // kSqlStmt_Del
+    "pragma data_version;"                                                        // kSqlStmt_DataVersion
 };
 
 //--------------------------------------------------------------------
@@ -94,6 +99,96 @@ static bool schedule_factory_reset_init = false;
 // String, set by '-r' command line option to specify a text file containing the factory reset database parameters
 char *factory_reset_text_file = NULL;
 
+//--------------------------------------------------------------------
+// Settings used to tune SQLite's access to the database. Set by the '--dbtuning' command line option, and the get_db_tuning_cb vendor hook
+static db_tuning_t db_tuning = { kDbJournal_Default, kDbSync_Default, -1, 0 };
+
+// Tables converting the journal mode and synchronous level to the strings used by the '--dbtuning' option and SQLite pragmas
+static const enum_entry_t db_journal_modes[] =
+{
+    { kDbJournal_Delete,   "delete" },
+    { kDbJournal_Truncate, "truncate" },
+    { kDbJournal_Persist,  "persist" },
+    { kDbJournal_Wal,      "wal" },
+};
+
+static const enum_entry_t db_sync_levels[] =
+{
+    { kDbSync_Normal, "normal" },
+    { kDbSync_Full,   "full" },
+    { kDbSync_Extra,  "extra" },
+};
+
+//--------------------------------------------------------------------
+// Cache of the values of parameters read from the database, indexed by hash and instances
+// Sets and deletes update the cache as they are written to the database
+// The least recently used entry is reused when the cache is full
+typedef struct db_cache_entry_tag
+{
+    double_link_t link;                         // Link in the LRU list. NOTE: This must be the first member of this structure
+    struct db_cache_entry_tag *next_in_bucket;  // Next entry in the hash bucket chain containing this entry
+    unsigned key_hash;                          // Hash of the parameter's hash and instances. Used to select the hash bucket
+    unsigned generation;                        // Value of db_cache_generation when this entry was filled in. Entry is stale if this does not match
+    dm_hash_t hash;                             // hash identifying the data model parameter
+    char instances[MAX_DM_INSTANCE_ORDER*12];   // Instance numbers of the data model parameter. Empty string if this entry has never been used
+    char *value;                                // Value of the parameter, as stored in the database (ie obfuscated if secure). NULL if the parameter is not in the database
+    int len;                                    // Length of the value. NOTE: An obfuscated value may contain embedded NULLs
+} db_cache_entry_t;
+
+#define DB_CACHE_NUM_BUCKETS  (2*DATABASE_CACHE_ENTRIES)
+static db_cache_entry_t db_cache[DATABASE_CACHE_ENTRIES];
+static db_cache_entry_t *db_cache_buckets[DB_CACHE_NUM_BUCKETS];
+static double_linked_list_t db_cache_lru;       // Head=most recently used, Tail=least recently used
+static unsigned db_cache_generation = 1;        // Incremented to invalidate all entries in the cache
+static unsigned db_cache_hits = 0;
+static unsigned db_cache_misses = 0;
+
+// The database may be modified by another process (eg by the 'dbset' CLI command), so at most once a second,
+// the cache checks whether the database has changed since the cache was filled in, using SQLite's data_version
+static time_t db_cache_check_time = 0;          // Time at which the database was last checked for modification by another process
+static int db_cache_data_version = 0;           // SQLite data_version of the database, when last checked
+
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+//--------------------------------------------------------------------
+// Queue of parameter sets and deletes made outside of a transaction, which have not been written to the database yet
+// These are written together in a single transaction, when the queue becomes full, or DATABASE_WRITE_BEHIND_PERIOD seconds after the first was queued
+typedef struct
+{
+    dm_hash_t hash;         // hash identifying the data model parameter
+    char *instances;        // instance numbers of the data model parameter
+    char *value;            // value to write (already obfuscated, if required), or NULL if the parameter is to be deleted
+    int len;                // length of the value. NOTE: An obfuscated value may contain embedded NULLs
+} write_behind_entry_t;
+
+#define MAX_WRITE_BEHIND_ENTRIES 64     // Maximum number of parameters queued before the queue is written to the database
+
+static write_behind_entry_t write_behind_queue[MAX_WRITE_BEHIND_ENTRIES];
+static int num_write_behind_entries = 0;
+
+//--------------------------------------------------------------------
+// Set whilst a transaction started by DATABASE_StartTransaction() is in progress. Writes made during a transaction are not queued.
+static bool is_transaction_in_progress = false;
+#endif
+
+//--------------------------------------------------------------------
+// Structure used to import factory reset parameters into the database in bulk, using multi-row insert statements within a single transaction
+#define BULK_IMPORT_ROWS 32             // Maximum number of rows inserted by each statement
+typedef struct
+{
+    dm_hash_t hash;                                 // Hash identifying the parameter
+    char instances[MAX_DM_INSTANCE_ORDER*12];       // Instance numbers of the parameter
+    char *value;                                    // Value to store in the database (obfuscated, if the parameter is secure)
+    int len;                                        // Length of the value
+} bulk_import_row_t;
+
+typedef struct
+{
+    sqlite3_stmt *stmt;                             // Prepared statement inserting BULK_IMPORT_ROWS rows
+    bulk_import_row_t rows[BULK_IMPORT_ROWS];       // Rows waiting to be inserted
+    int num_rows;                                   // Number of rows waiting to be inserted
+    int total_rows;                                 // Total number of rows imported
+} bulk_import_t;
+
 //--------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
 int PrepareSQLStatements(void);
@@ -102,7 +197,33 @@ void ObfuscatedCopy(unsigned char *dest, unsigned char *src, int len);
 int CopyFactoryResetDatabase(char *reset_file, char *db_file);
 int ResetFactoryParameters(void);
 int ResetFactoryParametersFromFile(char *file);
+int StartBulkImport(bulk_import_t *bi);
+int BulkImportParam(bulk_import_t *bi, char *path, char *value);
+int FinishBulkImport(bulk_import_t *bi, int err);
+int InsertBulkImportRows(bulk_import_t *bi);
+char *FormBulkInsertSql(int num_rows);
 void LogSQLStatement(char *op, char *path, sqlite3_stmt *stmt);
+int ExecPragma(sqlite3 *handle, char *sql, char *buf, int len);
+void RemoveJournalFiles(char *db_file);
+void CopyValueFromDatabase(const unsigned char *value, int value_len, char *buf, int buflen, unsigned flags);
+int WriteParameter(char *path, dm_hash_t hash, char *instances, char *value, int len);
+int DeleteParameter(char *path, dm_hash_t hash, char *instances);
+void InitDatabaseCache(void);
+void FreeDatabaseCache(void);
+db_cache_entry_t *LookupDatabaseCache(dm_hash_t hash, char *instances);
+void AddToDatabaseCache(dm_hash_t hash, char *instances, const unsigned char *value, int len);
+db_cache_entry_t *FindDatabaseCacheEntry(dm_hash_t hash, char *instances, unsigned key_hash);
+void UnlinkDatabaseCacheEntryFromBucket(db_cache_entry_t *dce);
+unsigned CalcDatabaseCacheKeyHash(dm_hash_t hash, char *instances);
+void CheckDatabaseCacheCoherent(void);
+void RemoveRangeFromDatabaseCache(int_vector_t *hashes, char *instances);
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+write_behind_entry_t *FindWriteBehindEntry(dm_hash_t hash, char *instances);
+int QueueWriteBehind(dm_hash_t hash, char *instances, char *value, int len);
+int FlushWriteBehindQueue(void);
+void DiscardWriteBehindQueue(void);
+void FlushWriteBehindTimer(int id);
+#endif
 
 /*********************************************************************//**
 **
@@ -124,10 +245,15 @@ int DATABASE_Init(char *db_file)
     // Keep a copy of the database filename, this will be needed when performing a controller initiated factory reset
     USP_STRNCPY(database_filename, db_file, sizeof(database_filename));
 
+    InitDatabaseCache();
+
     // Perform a factory reset, if no database file exists at the specified location
     fp = fopen(db_file, "r");
     if (fp == NULL)
     {
+        // Delete any journal files left over from a previous database, so that they are not applied to the new database
+        RemoveJournalFiles(db_file);
+
         // Copy across the factory reset database (if specified)
         if (factory_reset_file[0] != '\0')
         {
@@ -156,6 +282,15 @@ int DATABASE_Init(char *db_file)
         return err;
     }
 
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+    // Register the timer used to write queued parameters to the database. It is started when the first parameter is queued.
+    err = SYNC_TIMER_Add(FlushWriteBehindTimer, 0, END_OF_TIME);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+#endif
+
     return USP_ERR_OK;
 }
 
@@ -174,6 +309,25 @@ int DATABASE_Init(char *db_file)
 int DATABASE_Start(void)
 {
     int err;
+    get_db_tuning_cb_t get_db_tuning_cb;
+
+    // Exit if the vendor failed to modify the tuning settings of the database, or they could not be applied
+    get_db_tuning_cb = vendor_hook_callbacks.get_db_tuning_cb;
+    if (get_db_tuning_cb != NULL)
+    {
+        err = get_db_tuning_cb(&db_tuning);
+        if (err != USP_ERR_OK)
+        {
+            USP_ERR_SetMessage("%s: get_db_tuning_cb() failed", __FUNCTION__);
+            return USP_ERR_INTERNAL_ERROR;
+        }
+
+        err = DATABASE_ApplyTuning(db_handle, &db_tuning);
+        if (err != USP_ERR_OK)
+        {
+            return err;
+        }
+    }
 
     // Initialise the database with it's factory reset parameters (if required)
     if (schedule_factory_reset_init)
@@ -219,6 +373,15 @@ void DATABASE_Destroy(void)
     int err;
     int i;
 
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+    // Write all queued parameters to the database before closing it (eg before a reboot or factory reset)
+    err = FlushWriteBehindQueue();
+    if (err != USP_ERR_OK)
+    {
+        DiscardWriteBehindQueue();
+    }
+#endif
+
     // Iterate over the prepared SQL statements, finalizing them
     for (i=0; i<NUM_ELEM(prepared_stmts); i++)
     {
@@ -238,6 +401,9 @@ void DATABASE_Destroy(void)
 
     // Finally shutdown SQLite
     sqlite3_shutdown();
+
+    // Discard all cached values, as the database may be replaced (eg by a factory reset)
+    FreeDatabaseCache();
 }
 
 /*********************************************************************//**
@@ -268,6 +434,9 @@ void DATABASE_PerformFactoryReset_ControllerInitiated(void)
         return;
     }
 
+    // Delete any journal files left over from the current database, so that they are not applied to the factory reset database
+    RemoveJournalFiles(db_file);
+
     // Copy across the factory reset database (which has reboot cause set to "LocalFactoryReset")
     CopyFactoryResetDatabase(FACTORY_RESET_FILE, db_file);
 
@@ -365,6 +534,10 @@ int DATABASE_GetParameterValue(char *path, dm_hash_t hash, char *instances, char
     const unsigned char *value;
     int err;
     int result = USP_ERR_INTERNAL_ERROR;        // Assume an error
+    db_cache_entry_t *dce;
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+    write_behind_entry_t *wb;
+#endif
 
     // Exit if this function is not being called from the data model thread
     if (OS_UTILS_IsDataModelThread(__FUNCTION__, PRINT_WARNING)==false)
@@ -372,6 +545,34 @@ int DATABASE_GetParameterValue(char *path, dm_hash_t hash, char *instances, char
         return USP_ERR_INTERNAL_ERROR;
     }
 
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+    // Exit if the parameter has been set or deleted, but not yet written to the database
+    wb = FindWriteBehindEntry(hash, instances);
+    if (wb != NULL)
+    {
+        if (wb->value == NULL)
+        {
+            return USP_ERR_OBJECT_DOES_NOT_EXIST;
+        }
+
+        CopyValueFromDatabase((unsigned char *)wb->value, wb->len, buf, buflen, flags);
+        return USP_ERR_OK;
+    }
+#endif
+
+    // Exit if the value of the parameter has been cached
+    dce = LookupDatabaseCache(hash, instances);
+    if (dce != NULL)
+    {
+        if (dce->value == NULL)
+        {
+            return USP_ERR_OBJECT_DOES_NOT_EXIST;
+        }
+
+        CopyValueFromDatabase((unsigned char *)dce->value, dce->len, buf, buflen, flags);
+        return USP_ERR_OK;
+    }
+
     // Decide which prepared statement to use
     stmt = prepared_stmts[kSqlStmt_Get];
 
@@ -401,6 +602,7 @@ int DATABASE_GetParameterValue(char *path, dm_hash_t hash, char *instances, char
     {
         // No entry exists (yet) in the database. The data model will use the registered default value.
         // NOTE: Do not set USP error message, as this is not really an error (handled by caller)
+        AddToDatabaseCache(hash, instances, NULL, 0);
         result = USP_ERR_OBJECT_DOES_NOT_EXIST;
         goto exit;
     }
@@ -412,32 +614,12 @@ int DATABASE_GetParameterValue(char *path, dm_hash_t hash, char *instances, char
         goto exit;
     }
 
-    // Determine the length of the value string to copy into the return buffer, truncating it, if it is too long    
-    value_len = sqlite3_column_bytes(stmt, 0);
-    value_len = MIN(value_len, buflen-1);
-
-    // Get a pointer to the data
+    // Copy the value into the return buffer, and cache it
+    // NOTE: sqlite3_column_text() must be called before sqlite3_column_bytes(), as it may convert the value to text
     value = sqlite3_column_text(stmt, 0);
-
-    // Copy the value into the return buffer
-    if ((value != NULL) && (value_len >0))
-    {
-        if (flags & OBFUSCATED_VALUE)
-        {
-            // Unobfuscate value
-            ObfuscatedCopy((unsigned char *)buf, (unsigned char *)value, value_len);
-        }
-        else
-        {
-            // Normal case: value is not obfuscated (or we don't want to return an unobfuscated value)
-            memcpy(buf, value, value_len);
-        }
-        buf[value_len] = '\0'; // Ensure return buffer is always zero terminated
-    }
-    else
-    {
-        *buf = '\0';        // Case of value set to NULL in DB
-    }
+    value_len = sqlite3_column_bytes(stmt, 0);
+    CopyValueFromDatabase(value, value_len, buf, buflen, flags);
+    AddToDatabaseCache(hash, instances, value, value_len);
 
     // If the code gets here, then the parameter has been successfully retrieved from the database
     result = USP_ERR_OK;
@@ -472,9 +654,6 @@ exit:
 **************************************************************************/
 int DATABASE_SetParameterValue(char *path, dm_hash_t hash, char *instances, char *new_value, unsigned flags)
 {
-    sqlite3_stmt *stmt;
-    int err;
-    int result = USP_ERR_INTERNAL_ERROR;        // Assume an error
     char *value_to_bind;
     char obfuscated_value[MAX_DM_SHORT_VALUE_LEN];
     int len;
@@ -497,53 +676,15 @@ int DATABASE_SetParameterValue(char *path, dm_hash_t hash, char *instances, char
         value_to_bind = new_value;
     }
 
-    // Exit if unable to set the value of the hash in the prepared statement
-    stmt = prepared_stmts[kSqlStmt_Set];
-    err = sqlite3_bind_int64(stmt, 1, hash);
-    if (err != SQLITE_OK)
-    {
-        USP_ERR_SQL_PARAM(db_handle, "sqlite3_bind_int");
-        goto exit;
-    }
-
-    // Exit if unable to set the value of the instances in the prepared statement
-    err = sqlite3_bind_text(stmt, 2, instances, SQLITE_ZERO_TERMINATED, SQLITE_STATIC);
-    if (err != SQLITE_OK)
-    {
-        USP_ERR_SQL_PARAM(db_handle, "sqlite3_bind_text");
-        goto exit;
-    }
-
-    // Exit if unable to set the new value of the parameter in the prepared statement
-    err = sqlite3_bind_text(stmt, 3, value_to_bind, len, SQLITE_STATIC);
-    if (err != SQLITE_OK)
-    {
-        USP_ERR_SQL_PARAM(db_handle, "sqlite3_bind_text");
-        goto exit;
-    }
-
-    //LogSQLStatement("SET", path, stmt);
-
-    // Exit if unable to perform the set
-    err = sqlite3_step(stmt);
-    if (err != SQLITE_DONE)     // We are not expecting any rows
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+    // Exit if the write has been queued, to be written later in a single transaction with other writes
+    if (is_transaction_in_progress == false)
     {
-        USP_ERR_SQL_PARAM(db_handle, "sqlite3_step");
-        goto exit;
+        return QueueWriteBehind(hash, instances, value_to_bind, len);
     }
+#endif
 
-    // If the code gets here, then the parameter has been successfully set in the database
-    result = USP_ERR_OK;
-
-exit:
-    // Always reset the statement in preparation for next time, even if an error occurred
-    err = sqlite3_reset(stmt);
-    if ((err != SQLITE_OK) && (result == USP_ERR_OK))
-    {
-        USP_ERR_SQL_PARAM(db_handle, "sqlite3_reset");
-    }
-    
-    return result;
+    return WriteParameter(path, hash, instances, value_to_bind, len);
 }
 
 /*********************************************************************//**
@@ -563,8 +704,48 @@ exit:
 **************************************************************************/
 int DATABASE_DeleteParameter(char *path, dm_hash_t hash, char *instances)
 {
-    sqlite3_stmt *stmt;
+    // Exit if this function is not being called from the data model thread
+    if (OS_UTILS_IsDataModelThread(__FUNCTION__, PRINT_WARNING)==false)
+    {
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+    // Exit if the delete has been queued, to be written later in a single transaction with other writes
+    if (is_transaction_in_progress == false)
+    {
+        return QueueWriteBehind(hash, instances, NULL, 0);
+    }
+#endif
+
+    return DeleteParameter(path, hash, instances);
+}
+
+/*********************************************************************//**
+**
+** DATABASE_DeleteParameterRange
+**
+** Deletes the specified parameters of an object instance, and of all of its child object instances, from the database
+** using a single SQL statement. This deletes all rows with one of the specified hashes, whose instances string
+** is the specified instances string, or starts with the specified instances string followed by a '.'
+**
+** \param   path - data model path of the object instance being deleted (only used for debug)
+** \param   hashes - hashes identifying the data model parameters to delete
+** \param   instances - string identifying the object instance. NOTE: This must not be an empty string
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INTERNAL_ERROR if any other error occurred
+**
+**************************************************************************/
+int DATABASE_DeleteParameterRange(char *path, int_vector_t *hashes, char *instances)
+{
+    sqlite3_stmt *stmt = NULL;
+    char *sql;
+    int sql_len;
+    int offset;
+    char upper[MAX_DM_PATH];
     int err;
+    int i;
     int result = USP_ERR_INTERNAL_ERROR;        // Assume an error
 
     // Exit if this function is not being called from the data model thread
@@ -573,28 +754,56 @@ int DATABASE_DeleteParameter(char *path, dm_hash_t hash, char *instances)
         return USP_ERR_INTERNAL_ERROR;
     }
 
-    stmt = prepared_stmts[kSqlStmt_Del];
+    // Exit if there are no parameters to delete
+    if (hashes->num_entries == 0)
+    {
+        return USP_ERR_OK;
+    }
 
-    // Exit if unable to set the value of the hash in the prepared statement
-    err = sqlite3_bind_int64(stmt, 1, hash);
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+    // Exit if unable to write all queued parameters first, as queued writes to the deleted parameters would be written after them
+    err = FlushWriteBehindQueue();
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+#endif
+
+    // Form the SQL statement, listing all hashes
+    // NOTE: The instances are selected using a range on the primary key. As instances strings only contain digits and '.',
+    //       and '/' follows '.' in ASCII, the range ['1.2', '1.2/') contains only '1.2' and strings starting with '1.2.'
+    #define DELETE_RANGE_START_STR   "delete from data_model where hash in ("
+    #define DELETE_RANGE_END_STR     ") and instances >= ?1 and instances < ?2;"
+    sql_len = sizeof(DELETE_RANGE_START_STR) + hashes->num_entries*12 + sizeof(DELETE_RANGE_END_STR);
+    sql = USP_MALLOC(sql_len);
+    offset = USP_SNPRINTF(sql, sql_len, "%s", DELETE_RANGE_START_STR);
+    for (i=0; i < hashes->num_entries; i++)
+    {
+        offset += USP_SNPRINTF(&sql[offset], sql_len-offset, "%s%d", (i==0) ? "" : ",", hashes->vector[i]);
+    }
+    USP_SNPRINTF(&sql[offset], sql_len-offset, "%s", DELETE_RANGE_END_STR);
+
+    // Exit if unable to prepare the SQL statement
+    err = sqlite3_prepare_v2(db_handle, sql, SQLITE_ZERO_TERMINATED, &stmt, NULL);
     if (err != SQLITE_OK)
     {
-        USP_ERR_SQL_PARAM(db_handle, "sqlite3_bind_int");
+        USP_ERR_SQL(db_handle,"sqlite3_prepare_v2");
         goto exit;
     }
 
-    // Exit if unable to set the value of the instances in the prepared statement
-    err = sqlite3_bind_text(stmt, 2, instances, SQLITE_ZERO_TERMINATED, SQLITE_STATIC);
+    // Exit if unable to bind the range of instances to delete
+    USP_SNPRINTF(upper, sizeof(upper), "%s/", instances);
+    err = sqlite3_bind_text(stmt, 1, instances, SQLITE_ZERO_TERMINATED, SQLITE_STATIC);
+    err |= sqlite3_bind_text(stmt, 2, upper, SQLITE_ZERO_TERMINATED, SQLITE_STATIC);
     if (err != SQLITE_OK)
     {
         USP_ERR_SQL_PARAM(db_handle, "sqlite3_bind_text");
         goto exit;
     }
 
-    //LogSQLStatement("DEL", path, stmt);
+    //LogSQLStatement("DEL RANGE", path, stmt);
 
     // Exit if unable to perform the delete
-    // NOTE: If the parameter is not present in the DB, then SQLite still returns OK
     err = sqlite3_step(stmt);
     if (err != SQLITE_DONE)     // We are not expecting any rows
     {
@@ -602,17 +811,19 @@ int DATABASE_DeleteParameter(char *path, dm_hash_t hash, char *instances)
         goto exit;
     }
 
-    // If the code gets here, then the parameter has been successfully deleted from the database
+    // If the code gets here, then the parameters have been successfully deleted from the database
+    RemoveRangeFromDatabaseCache(hashes, instances);
     result = USP_ERR_OK;
 
 exit:
-    // Always reset the statement in preparation for next time, even if an error occurred
-    err = sqlite3_reset(stmt);
+    err = sqlite3_finalize(stmt);
     if ((err != SQLITE_OK) && (result == USP_ERR_OK))
     {
-        USP_ERR_SQL_PARAM(db_handle, "sqlite3_reset");
+        USP_ERR_SQL(db_handle,"sqlite3_finalize");
+        result = USP_ERR_INTERNAL_ERROR;
     }
-    
+    USP_FREE(sql);
+
     return result;
 }
 
@@ -637,6 +848,16 @@ int DATABASE_StartTransaction(void)
         return USP_ERR_INTERNAL_ERROR;
     }
 
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+    // Exit if unable to write all queued parameters first, so that they are not lost if this transaction is aborted,
+    // and so that they are not written after (overwriting) the parameters set in this transaction
+    err = FlushWriteBehindQueue();
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+#endif
+
     err = sqlite3_exec(db_handle, "begin transaction;", NULL, NULL, NULL);
     if (err != SQLITE_OK)
     {
@@ -644,6 +865,10 @@ int DATABASE_StartTransaction(void)
         return USP_ERR_INTERNAL_ERROR;
     }
 
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+    is_transaction_in_progress = true;
+#endif
+
     return USP_ERR_OK;
 }
 
@@ -668,10 +893,15 @@ int DATABASE_CommitTransaction(void)
         return USP_ERR_INTERNAL_ERROR;
     }
 
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+    is_transaction_in_progress = false;
+#endif
+
     err = sqlite3_exec(db_handle, "commit transaction;", NULL, NULL, NULL);
     if (err != SQLITE_OK)
     {
         USP_ERR_SQL(db_handle,"sqlite3_exec");
+        db_cache_generation++;      // The cache may contain values which were not committed
         return USP_ERR_INTERNAL_ERROR;
     }
 
@@ -701,6 +931,13 @@ int DATABASE_AbortTransaction(void)
     // whilst writing the transactions, then an error will be returned here
     sqlite3_exec(db_handle, "rollback;", NULL, NULL, NULL);
 
+    // Invalidate all cached values, as the cache may contain values set during the transaction which has been rolled back
+    db_cache_generation++;
+
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+    is_transaction_in_progress = false;
+#endif
+
     return USP_ERR_OK;
 }
 
@@ -726,6 +963,11 @@ int DATABASE_ReadDataModelInstanceNumbers(bool remove_unknown_params)
     char *instances;
     dm_hash_t hash;
 
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+    // Ensure that all queued parameters are in the database before reading it
+    FlushWriteBehindQueue();
+#endif
+
     // Exit if unable to prepare the SQL statement
     #define SELECT_ALL_INST_STR   "select hash,instances from data_model;"
     sql_err = sqlite3_prepare_v2(db_handle, SELECT_ALL_INST_STR, SQLITE_ZERO_TERMINATED, &stmt, NULL);
@@ -803,6 +1045,11 @@ void DATABASE_Dump(void)
     char *value;
     dm_hash_t hash;
 
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+    // Ensure that all queued parameters are in the database before reading it
+    FlushWriteBehindQueue();
+#endif
+
     // Exit if unable to prepare the SQL statement
     #define SELECT_ALL_STR   "select hash,instances,value from data_model;"
     err = sqlite3_prepare_v2(db_handle, SELECT_ALL_STR, SQLITE_ZERO_TERMINATED, &stmt, NULL);
@@ -851,55 +1098,355 @@ void DATABASE_Dump(void)
 
 /*********************************************************************//**
 **
-** OpenUspDatabase
+** DATABASE_FlushCache
 **
-** Opens the USP database, ensures the table is created in it and the SQL statements prepared
+** Discards all values held in the cache of parameter values read from the database, and clears its statistics
+** This is used by the 'dmbench' CLI command, to measure the cache starting from cold
 **
-** \param   db_file - path to file to use for the database
+** \param   None
 **
-** \return  USP_ERR_OK if successful
+** \return  None
 **
 **************************************************************************/
-int OpenUspDatabase(char *db_file)
+void DATABASE_FlushCache(void)
 {
-    int err;
-
-    // Exit if unable to open the database
-    err = sqlite3_open(db_file, &db_handle);
-    if (err != SQLITE_OK)
-    {
-        USP_ERR_SQL(db_handle,"sqlite3_open");
-        return USP_ERR_INTERNAL_ERROR;
-    }
+    FreeDatabaseCache();
+}
 
-    // Exit if unable to create the data model parameter table (if it does not already exist)
-    #define CREATE_TABLE_STR "create table if not exists data_model (hash integer, instances text, value text, primary key (hash, instances));"
-    err = sqlite3_exec(db_handle, CREATE_TABLE_STR, NULL, NULL, NULL);
-    if (err != SQLITE_OK)
-    {
-        USP_ERR_SQL(db_handle,"sqlite3_exec");
-        return USP_ERR_INTERNAL_ERROR;
-    }
+/*********************************************************************//**
+**
+** DATABASE_DumpCache
+**
+** Prints out the statistics of the cache of parameter values read from the database
+** This may be used to determine whether DATABASE_CACHE_ENTRIES is sized correctly
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void DATABASE_DumpCache(void)
+{
+    int i;
+    int num_valid = 0;
+    unsigned total;
 
-    // Exit if unable to prepare all SQL statements to be used
-    err = PrepareSQLStatements();
-    if (err != USP_ERR_OK)
+    for (i=0; i<DATABASE_CACHE_ENTRIES; i++)
     {
-        return USP_ERR_INTERNAL_ERROR;
+        if (db_cache[i].generation == db_cache_generation)
+        {
+            num_valid++;
+        }
     }
 
-    return USP_ERR_OK;
+    total = db_cache_hits + db_cache_misses;
+    USP_DUMP("Dumping Database Cache...");
+    USP_DUMP("Entries: %d (of %d)", num_valid, DATABASE_CACHE_ENTRIES);
+    USP_DUMP("Hits: %u", db_cache_hits);
+    USP_DUMP("Misses: %u", db_cache_misses);
+    USP_DUMP("Hit ratio: %u%%", (total == 0) ? 0 : (unsigned)((100ULL * db_cache_hits) / total));
 }
 
 /*********************************************************************//**
 **
-** CopyFactoryResetDatabase
+** DATABASE_GetDataVersion
 **
-** Performs a factory reset of the database, by copying a factory reset database file
-** NOTE: The factory reset database will have been generated with the reboot cause set to "LocalFactoryReset"
-** NOTE: This function must only be called when the database is not open
+** Returns a number which changes whenever another process (eg the 'dbset' CLI command) commits changes to the database
+** NOTE: The number does not change for changes made by this process
 **
-** \param   reset_file - filename of the file containing the SQLite factory reset database
+** \param   None
+**
+** \return  data version of the database, or INVALID if it could not be read
+**
+**************************************************************************/
+int DATABASE_GetDataVersion(void)
+{
+    sqlite3_stmt *stmt;
+    int data_version;
+    int err;
+
+    stmt = prepared_stmts[kSqlStmt_DataVersion];
+    err = sqlite3_step(stmt);
+    if (err != SQLITE_ROW)
+    {
+        USP_ERR_SQL(db_handle, "sqlite3_step");
+        sqlite3_reset(stmt);
+        return INVALID;
+    }
+    data_version = sqlite3_column_int(stmt, 0);
+    sqlite3_reset(stmt);
+
+    return data_version;
+}
+
+/*********************************************************************//**
+**
+** DATABASE_SetTuning
+**
+** Sets the settings used to tune SQLite's access to the database (from the '--dbtuning' command line option)
+** NOTE: This function must be called before the database is opened
+**
+** \param   str - comma separated list of settings eg "journal=wal,sync=normal,mmap=67108864,cache=-2048"
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INVALID_ARGUMENTS if the string contained an unknown setting or value
+**
+**************************************************************************/
+int DATABASE_SetTuning(char *str)
+{
+    return DATABASE_ParseTuning(str, &db_tuning);
+}
+
+/*********************************************************************//**
+**
+** DATABASE_ParseTuning
+**
+** Parses a comma separated list of settings used to tune SQLite's access to a database
+** Settings not present in the string are left unchanged in the tuning structure
+** Supported settings are:
+**     journal=delete|truncate|persist|wal
+**     sync=normal|full|extra
+**     mmap=<maximum bytes to memory map>
+**     cache=<pages, or KiB if negative>
+**
+** \param   str - comma separated list of settings eg "journal=wal,sync=normal,mmap=67108864,cache=-2048"
+** \param   tuning - pointer to structure in which to return the settings
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INVALID_ARGUMENTS if the string contained an unknown setting or value
+**
+**************************************************************************/
+int DATABASE_ParseTuning(char *str, db_tuning_t *tuning)
+{
+    str_vector_t sv;
+    char buf[MAX_DM_SHORT_VALUE_LEN];
+    char *key;
+    char *value;
+    unsigned long long mmap_size;
+    int i;
+    int err = USP_ERR_OK;
+
+    TEXT_UTILS_SplitString(str, &sv, ",");
+    for (i=0; i < sv.num_entries; i++)
+    {
+        // Exit if this setting is not of the form key=value
+        USP_STRNCPY(buf, sv.vector[i], sizeof(buf));
+        key = buf;
+        value = strchr(buf, '=');
+        if (value == NULL)
+        {
+            USP_ERR_SetMessage("%s: Database tuning setting '%s' is not of the form key=value", __FUNCTION__, buf);
+            err = USP_ERR_INVALID_ARGUMENTS;
+            goto exit;
+        }
+        *value++ = '\0';
+
+        if (strcmp(key, "journal")==0)
+        {
+            tuning->journal_mode = TEXT_UTILS_StringToEnum(value, db_journal_modes, NUM_ELEM(db_journal_modes));
+            err = (tuning->journal_mode == INVALID) ? USP_ERR_INVALID_ARGUMENTS : USP_ERR_OK;
+        }
+        else if (strcmp(key, "sync")==0)
+        {
+            tuning->synchronous = TEXT_UTILS_StringToEnum(value, db_sync_levels, NUM_ELEM(db_sync_levels));
+            err = (tuning->synchronous == INVALID) ? USP_ERR_INVALID_ARGUMENTS : USP_ERR_OK;
+        }
+        else if (strcmp(key, "mmap")==0)
+        {
+            err = TEXT_UTILS_StringToUnsignedLongLong(value, &mmap_size);
+            tuning->mmap_size = (long long) mmap_size;
+        }
+        else if (strcmp(key, "cache")==0)
+        {
+            err = TEXT_UTILS_StringToInteger(value, &tuning->cache_size);
+        }
+        else
+        {
+            USP_ERR_SetMessage("%s: Unknown database tuning setting '%s'", __FUNCTION__, key);
+            err = USP_ERR_INVALID_ARGUMENTS;
+        }
+
+        // Exit if the value of the setting was invalid
+        if (err != USP_ERR_OK)
+        {
+            err = USP_ERR_INVALID_ARGUMENTS;
+            goto exit;
+        }
+    }
+
+exit:
+    STR_VECTOR_Destroy(&sv);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** DATABASE_ApplyTuning
+**
+** Applies the specified tuning settings to an open SQLite database connection
+** NOTE: synchronous=normal is only safe against corruption on power loss with WAL journaling,
+**       so with any other journal mode, synchronous=full is used instead
+**
+** \param   handle - SQLite database connection to apply the settings to
+** \param   tuning - pointer to structure containing the settings to apply
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int DATABASE_ApplyTuning(sqlite3 *handle, db_tuning_t *tuning)
+{
+    char sql[64];
+    char journal_mode[32];
+    char *requested_mode;
+    int synchronous;
+    int err;
+
+    // Exit if unable to set the journal mode (if specified)
+    // NOTE: The journal mode is stored persistently in the database file in the case of WAL
+    if (tuning->journal_mode != kDbJournal_Default)
+    {
+        requested_mode = TEXT_UTILS_EnumToString(tuning->journal_mode, db_journal_modes, NUM_ELEM(db_journal_modes));
+        USP_SNPRINTF(sql, sizeof(sql), "pragma journal_mode=%s;", requested_mode);
+        err = ExecPragma(handle, sql, journal_mode, sizeof(journal_mode));
+        if (err != USP_ERR_OK)
+        {
+            return err;
+        }
+
+        // SQLite returns the journal mode actually in use, which may differ from the one requested (eg WAL is not supported by the file system)
+        if (strcmp(journal_mode, requested_mode) != 0)
+        {
+            USP_LOG_Warning("%s: Unable to set database journal mode to '%s' (using '%s')", __FUNCTION__, requested_mode, journal_mode);
+        }
+    }
+
+    // Exit if unable to determine the journal mode in use
+    err = ExecPragma(handle, "pragma journal_mode;", journal_mode, sizeof(journal_mode));
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Exit if unable to set the synchronous level (if specified)
+    synchronous = tuning->synchronous;
+    if ((synchronous == kDbSync_Normal) && (strcmp(journal_mode, "wal") != 0))
+    {
+        USP_LOG_Warning("%s: Database synchronous=normal is only crash-safe with journal=wal. Using synchronous=full", __FUNCTION__);
+        synchronous = kDbSync_Full;
+    }
+
+    if (synchronous != kDbSync_Default)
+    {
+        USP_SNPRINTF(sql, sizeof(sql), "pragma synchronous=%s;", TEXT_UTILS_EnumToString(synchronous, db_sync_levels, NUM_ELEM(db_sync_levels)));
+        err = ExecPragma(handle, sql, NULL, 0);
+        if (err != USP_ERR_OK)
+        {
+            return err;
+        }
+    }
+
+    // Exit if unable to set the maximum size of memory-mapped I/O (if specified)
+    if (tuning->mmap_size >= 0)
+    {
+        USP_SNPRINTF(sql, sizeof(sql), "pragma mmap_size=%lld;", tuning->mmap_size);
+        err = ExecPragma(handle, sql, NULL, 0);
+        if (err != USP_ERR_OK)
+        {
+            return err;
+        }
+    }
+
+    // Exit if unable to set the size of the page cache (if specified)
+    if (tuning->cache_size != 0)
+    {
+        USP_SNPRINTF(sql, sizeof(sql), "pragma cache_size=%d;", tuning->cache_size);
+        err = ExecPragma(handle, sql, NULL, 0);
+        if (err != USP_ERR_OK)
+        {
+            return err;
+        }
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** DATABASE_RemoveFiles
+**
+** Deletes the specified database file, and any journal files associated with it
+** NOTE: This function must only be called when the database is not open
+**
+** \param   db_file - path of the database file
+**
+** \return  None
+**
+**************************************************************************/
+void DATABASE_RemoveFiles(char *db_file)
+{
+    remove(db_file);
+    RemoveJournalFiles(db_file);
+}
+
+/*********************************************************************//**
+**
+** OpenUspDatabase
+**
+** Opens the USP database, ensures the table is created in it and the SQL statements prepared
+**
+** \param   db_file - path to file to use for the database
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int OpenUspDatabase(char *db_file)
+{
+    int err;
+
+    // Exit if unable to open the database
+    err = sqlite3_open(db_file, &db_handle);
+    if (err != SQLITE_OK)
+    {
+        USP_ERR_SQL(db_handle,"sqlite3_open");
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if unable to apply the tuning settings
+    // NOTE: These must be applied every time the database is opened, as most of them only apply to the current connection
+    err = DATABASE_ApplyTuning(db_handle, &db_tuning);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Exit if unable to create the data model parameter table (if it does not already exist)
+    #define CREATE_TABLE_STR "create table if not exists data_model (hash integer, instances text, value text, primary key (hash, instances));"
+    err = sqlite3_exec(db_handle, CREATE_TABLE_STR, NULL, NULL, NULL);
+    if (err != SQLITE_OK)
+    {
+        USP_ERR_SQL(db_handle,"sqlite3_exec");
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if unable to prepare all SQL statements to be used
+    err = PrepareSQLStatements();
+    if (err != USP_ERR_OK)
+    {
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** CopyFactoryResetDatabase
+**
+** Performs a factory reset of the database, by copying a factory reset database file
+** NOTE: The factory reset database will have been generated with the reboot cause set to "LocalFactoryReset"
+** NOTE: This function must only be called when the database is not open
+**
+** \param   reset_file - filename of the file containing the SQLite factory reset database
 **                       NOTE: This maybe an empty string or NULL if factory reset is not implemented by a static file
 ** \param   db_file - filename
 **
@@ -908,8 +1455,8 @@ int OpenUspDatabase(char *db_file)
 **************************************************************************/
 int CopyFactoryResetDatabase(char *reset_file, char *db_file)
 {
-    #define CHUNK_SIZE 1024             // source and destination files are read and written in byte sized chunks
-    unsigned char chunk[CHUNK_SIZE];
+    #define CHUNK_SIZE (64*1024)        // source and destination files are read and written in chunks of this size
+    unsigned char *chunk = NULL;
     FILE *src = NULL;
     FILE *dest = NULL;
     char buf[128];
@@ -936,7 +1483,7 @@ int CopyFactoryResetDatabase(char *reset_file, char *db_file)
 
     // Exit if unable to open the target database file for writing
     dest = fopen(db_file, "w");
-    if (src == NULL)
+    if (dest == NULL)
     {
         USP_LOG_Error("%s: Failed to open destination database %s for writing: %s", __FUNCTION__, db_file, USP_ERR_ToString(errno, buf, sizeof(buf)) );
         err = USP_ERR_INTERNAL_ERROR;
@@ -944,7 +1491,8 @@ int CopyFactoryResetDatabase(char *reset_file, char *db_file)
     }
 
     // Exit if an error occurred whilst reading the first chunk of the source file
-    bytes_read = fread(chunk, 1, sizeof(chunk), src);
+    chunk = USP_MALLOC(CHUNK_SIZE);
+    bytes_read = fread(chunk, 1, CHUNK_SIZE, src);
     if (ferror(src) != 0)
     {
         USP_LOG_Error("%s: Failed to read factory reset database %s", __FUNCTION__, reset_file);
@@ -965,7 +1513,7 @@ int CopyFactoryResetDatabase(char *reset_file, char *db_file)
         }
 
         // Exit if an error occurred whilst reading a chunk of the source file
-        bytes_read = fread(chunk, 1, sizeof(chunk), src);
+        bytes_read = fread(chunk, 1, CHUNK_SIZE, src);
         if (ferror(src) != 0)
         {
             USP_LOG_Error("%s: Failed to read factory reset database %s", __FUNCTION__, reset_file);
@@ -978,6 +1526,8 @@ int CopyFactoryResetDatabase(char *reset_file, char *db_file)
     err = USP_ERR_OK;
 
 exit:
+    USP_SAFE_FREE(chunk);
+
     if (dest != NULL)
     {
         fclose(dest);
@@ -1009,6 +1559,7 @@ int ResetFactoryParameters(void)
     int err;
     kv_vector_t params;
     kv_pair_t *kv;
+    bulk_import_t bi;
 
     // Exit if unable to get the factory reset parameters
     KV_VECTOR_Init(&params);
@@ -1020,19 +1571,29 @@ int ResetFactoryParameters(void)
 
     USP_LOG_Info("%s: Setting factory reset parameters", __FUNCTION__);
 
+    // Exit if unable to start importing the parameters
+    err = StartBulkImport(&bi);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
     // Set all factory reset parameters provided by the vendor in the database
     for (i=0; i<params.num_entries; i++)
     {
         kv = &params.vector[i];
 
-        // Exit if a parameter was not in the data model or failed to set    
-        err = DATA_MODEL_SetParameterInDatabase(kv->key, kv->value);
+        // Exit loop if a parameter was not in the data model or failed to set
+        err = BulkImportParam(&bi, kv->key, kv->value);
         if (err != USP_ERR_OK)
         {
-            goto exit;
+            break;
         }
     }
 
+    // Commit all parameters to the database (or abort if an error occurred)
+    err = FinishBulkImport(&bi, err);
+
 exit:
     // Ensure that the parameters signalled by the vendor are freed
     KV_VECTOR_Destroy(&params);
@@ -1046,6 +1607,7 @@ exit:
 ** ResetFactoryParametersFromFile
 **
 ** Sets the data model parameters specified in the file
+** NOTE: The file is streamed line by line, and all parameters are written in a single transaction
 **
 ** \param   file - name of file containing parameters to set
 **
@@ -1061,6 +1623,7 @@ int ResetFactoryParametersFromFile(char *file)
     char *key;
     char *value;
     int line_number = 1;
+    bulk_import_t bi;
 
     // Exit if unable to open the file containing factory reset parameters
     fp = fopen(file, "r");
@@ -1070,6 +1633,14 @@ int ResetFactoryParametersFromFile(char *file)
         return USP_ERR_INTERNAL_ERROR;
     }
 
+    // Exit if unable to start importing the parameters
+    err = StartBulkImport(&bi);
+    if (err != USP_ERR_OK)
+    {
+        fclose(fp);
+        return err;
+    }
+
     // Iterate over all lines in the file
     result = fgets(buf, sizeof(buf), fp);
     while (result != NULL)
@@ -1085,7 +1656,7 @@ int ResetFactoryParametersFromFile(char *file)
         // Set the parameter (if the line was not blank or a comment)
         if ((key != NULL) & (value != NULL))
         {
-            err = DATA_MODEL_SetParameterInDatabase(key, value);
+            err = BulkImportParam(&bi, key, value);
             if (err != USP_ERR_OK)
             {
                 USP_LOG_Error("%s: Failed to set parameter at line %d of %s", __FUNCTION__, line_number, file);
@@ -1102,10 +1673,1112 @@ int ResetFactoryParametersFromFile(char *file)
     err = USP_ERR_OK;
 
 exit:
+    // Commit all parameters to the database (or abort if an error occurred)
     fclose(fp);
+    err = FinishBulkImport(&bi, err);
     return err;
 }
 
+/*********************************************************************//**
+**
+** StartBulkImport
+**
+** Starts importing parameters into the database in bulk
+** The parameters are written using multi-row insert statements within a single transaction, and without
+** calling any vendor hooks or validation callbacks, as the source of the parameters (factory reset) is trusted
+**
+** \param   bi - pointer to structure used to import the parameters
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int StartBulkImport(bulk_import_t *bi)
+{
+    char *sql;
+    int err;
+
+    memset(bi, 0, sizeof(bulk_import_t));
+
+    // Exit if unable to prepare the statement used to insert a full batch of rows
+    sql = FormBulkInsertSql(BULK_IMPORT_ROWS);
+    err = sqlite3_prepare_v2(db_handle, sql, SQLITE_ZERO_TERMINATED, &bi->stmt, NULL);
+    USP_FREE(sql);
+    if (err != SQLITE_OK)
+    {
+        USP_ERR_SQL(db_handle,"sqlite3_prepare_v2");
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if unable to start a transaction
+    err = DATABASE_StartTransaction();
+    if (err != USP_ERR_OK)
+    {
+        sqlite3_finalize(bi->stmt);
+        return err;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** BulkImportParam
+**
+** Adds the specified parameter to the bulk import, writing the batch of rows to the database when it is full
+**
+** \param   bi - pointer to structure used to import the parameters
+** \param   path - data model path of the parameter
+** \param   value - value to set the parameter to
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BulkImportParam(bulk_import_t *bi, char *path, char *value)
+{
+    bulk_import_row_t *row;
+    unsigned db_flags;
+    int err;
+
+    // Exit if the parameter does not exist in the data model, or is not stored in the database
+    row = &bi->rows[bi->num_rows];
+    err = DM_PRIV_FormDBParam_FromPath(path, &row->hash, row->instances, sizeof(row->instances), &db_flags);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Take a copy of the value, obfuscating it if the parameter is secure
+    row->len = strlen(value);
+    row->value = USP_MALLOC(row->len+1);
+    if (db_flags & OBFUSCATED_VALUE)
+    {
+        ObfuscatedCopy((unsigned char *)row->value, (unsigned char *)value, row->len);
+    }
+    else
+    {
+        memcpy(row->value, value, row->len);
+    }
+    row->value[row->len] = '\0';
+    bi->num_rows++;
+
+    // Exit if the batch is not full yet
+    if (bi->num_rows < BULK_IMPORT_ROWS)
+    {
+        return USP_ERR_OK;
+    }
+
+    return InsertBulkImportRows(bi);
+}
+
+/*********************************************************************//**
+**
+** FinishBulkImport
+**
+** Writes any remaining rows of the bulk import to the database, then commits the transaction (or aborts it if an error occurred)
+**
+** \param   bi - pointer to structure used to import the parameters
+** \param   err - error code from importing the parameters. If this is not USP_ERR_OK, then the transaction is aborted
+**
+** \return  USP_ERR_OK if all parameters were committed to the database successfully
+**
+**************************************************************************/
+int FinishBulkImport(bulk_import_t *bi, int err)
+{
+    int i;
+
+    // Write any remaining rows
+    if ((err == USP_ERR_OK) && (bi->num_rows > 0))
+    {
+        err = InsertBulkImportRows(bi);
+    }
+
+    // Free any rows which were not written, because an error occurred
+    for (i=0; i < bi->num_rows; i++)
+    {
+        USP_FREE(bi->rows[i].value);
+    }
+    bi->num_rows = 0;
+
+    sqlite3_finalize(bi->stmt);
+    bi->stmt = NULL;
+
+    // Commit the transaction, or abort it if an error occurred
+    if (err == USP_ERR_OK)
+    {
+        err = DATABASE_CommitTransaction();
+    }
+    else
+    {
+        DATABASE_AbortTransaction();
+    }
+
+    // Invalidate all cached values, as the import does not update the cache
+    db_cache_generation++;
+
+    // Discard the unique key indexes, as the database has been modified without going through the data model
+    DM_KEY_INDEX_InvalidateAll();
+
+    USP_LOG_Info("%s: Imported %d parameters", __FUNCTION__, bi->total_rows);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** InsertBulkImportRows
+**
+** Writes all rows waiting in the bulk import to the database, using a single multi-row insert statement
+**
+** \param   bi - pointer to structure used to import the parameters
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int InsertBulkImportRows(bulk_import_t *bi)
+{
+    sqlite3_stmt *stmt;
+    bulk_import_row_t *row;
+    char *sql;
+    int i;
+    int err;
+    int result = USP_ERR_INTERNAL_ERROR;        // Assume an error
+
+    // Use the prepared statement for a full batch, otherwise prepare a statement for the partial batch
+    if (bi->num_rows == BULK_IMPORT_ROWS)
+    {
+        stmt = bi->stmt;
+    }
+    else
+    {
+        sql = FormBulkInsertSql(bi->num_rows);
+        err = sqlite3_prepare_v2(db_handle, sql, SQLITE_ZERO_TERMINATED, &stmt, NULL);
+        USP_FREE(sql);
+        if (err != SQLITE_OK)
+        {
+            USP_ERR_SQL(db_handle,"sqlite3_prepare_v2");
+            return USP_ERR_INTERNAL_ERROR;
+        }
+    }
+
+    // Exit if unable to bind the rows to the statement
+    for (i=0; i < bi->num_rows; i++)
+    {
+        row = &bi->rows[i];
+        err = sqlite3_bind_int64(stmt, 3*i+1, row->hash);
+        err |= sqlite3_bind_text(stmt, 3*i+2, row->instances, SQLITE_ZERO_TERMINATED, SQLITE_STATIC);
+        err |= sqlite3_bind_text(stmt, 3*i+3, row->value, row->len, SQLITE_STATIC);
+        if (err != SQLITE_OK)
+        {
+            USP_ERR_SQL(db_handle,"sqlite3_bind");
+            goto exit;
+        }
+    }
+
+    // Exit if unable to insert the rows
+    err = sqlite3_step(stmt);
+    if (err != SQLITE_DONE)     // We are not expecting any rows
+    {
+        USP_ERR_SQL(db_handle,"sqlite3_step");
+        goto exit;
+    }
+
+    bi->total_rows += bi->num_rows;
+    result = USP_ERR_OK;
+
+exit:
+    // Free the rows, as they have been copied into the database (or an error occurred)
+    // NOTE: The statement must be reset before freeing the values bound to it
+    if (stmt == bi->stmt)
+    {
+        sqlite3_reset(stmt);
+    }
+    else
+    {
+        sqlite3_finalize(stmt);
+    }
+
+    for (i=0; i < bi->num_rows; i++)
+    {
+        USP_FREE(bi->rows[i].value);
+    }
+    bi->num_rows = 0;
+
+    return result;
+}
+
+/*********************************************************************//**
+**
+** FormBulkInsertSql
+**
+** Forms the SQL statement used to insert the specified number of rows into the database
+**
+** \param   num_rows - number of rows inserted by the statement
+**
+** \return  pointer to dynamically allocated string containing the SQL statement. The caller must free this.
+**
+**************************************************************************/
+char *FormBulkInsertSql(int num_rows)
+{
+    #define BULK_INSERT_PREFIX "insert or replace into data_model(hash,instances,value) values"
+    #define BULK_INSERT_ROW    "(?,?,?)"
+    char *sql;
+    char *p;
+    int i;
+
+    // NOTE: Each row is followed by a separator (or the terminating ';'), and the string is NULL terminated
+    sql = USP_MALLOC(sizeof(BULK_INSERT_PREFIX) + num_rows*sizeof(BULK_INSERT_ROW));
+    p = sql;
+    memcpy(p, BULK_INSERT_PREFIX, sizeof(BULK_INSERT_PREFIX)-1);
+    p += sizeof(BULK_INSERT_PREFIX)-1;
+
+    for (i=0; i < num_rows; i++)
+    {
+        memcpy(p, BULK_INSERT_ROW, sizeof(BULK_INSERT_ROW)-1);
+        p += sizeof(BULK_INSERT_ROW)-1;
+        *p++ = (i == num_rows-1) ? ';' : ',';
+    }
+    *p = '\0';
+
+    return sql;
+}
+
+/*********************************************************************//**
+**
+** CopyValueFromDatabase
+**
+** Copies a value read from the database into the return buffer, truncating and unobfuscating it if necessary
+**
+** \param   value - pointer to value read from the database (may be NULL)
+** \param   value_len - length of the value read from the database
+** \param   buf - pointer to buffer in which to return the value
+** \param   buflen - length of buffer in which to return the value
+** \param   flags - flags controlling getting the value (eg OBFUSCATED_VALUE)
+**
+** \return  None
+**
+**************************************************************************/
+void CopyValueFromDatabase(const unsigned char *value, int value_len, char *buf, int buflen, unsigned flags)
+{
+    // Truncate the value, if it is too long for the return buffer
+    value_len = MIN(value_len, buflen-1);
+
+    // Copy the value into the return buffer
+    if ((value != NULL) && (value_len >0))
+    {
+        if (flags & OBFUSCATED_VALUE)
+        {
+            // Unobfuscate value
+            ObfuscatedCopy((unsigned char *)buf, (unsigned char *)value, value_len);
+        }
+        else
+        {
+            // Normal case: value is not obfuscated (or we don't want to return an unobfuscated value)
+            memcpy(buf, value, value_len);
+        }
+        buf[value_len] = '\0'; // Ensure return buffer is always zero terminated
+    }
+    else
+    {
+        *buf = '\0';        // Case of value set to NULL in DB
+    }
+}
+
+/*********************************************************************//**
+**
+** InitDatabaseCache
+**
+** Initialises the cache of parameter values read from the database, marking all entries as unused
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void InitDatabaseCache(void)
+{
+    int i;
+    db_cache_entry_t *dce;
+
+    memset(db_cache, 0, sizeof(db_cache));
+    memset(db_cache_buckets, 0, sizeof(db_cache_buckets));
+    DLLIST_Init(&db_cache_lru);
+
+    // Add all entries to the LRU list. NOTE: None are in a hash bucket and all are stale (generation=0)
+    for (i=0; i<DATABASE_CACHE_ENTRIES; i++)
+    {
+        dce = &db_cache[i];
+        DLLIST_LinkToTail(&db_cache_lru, dce);
+    }
+
+    db_cache_hits = 0;
+    db_cache_misses = 0;
+    db_cache_check_time = 0;
+}
+
+/*********************************************************************//**
+**
+** FreeDatabaseCache
+**
+** Frees all values held in the cache of parameter values read from the database, and marks all entries as unused
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void FreeDatabaseCache(void)
+{
+    int i;
+
+    for (i=0; i<DATABASE_CACHE_ENTRIES; i++)
+    {
+        USP_SAFE_FREE(db_cache[i].value);
+    }
+
+    InitDatabaseCache();
+}
+
+/*********************************************************************//**
+**
+** LookupDatabaseCache
+**
+** Returns the cached value of the specified parameter, if it is present in the cache
+**
+** \param   hash - hash identifying the data model parameter
+** \param   instances - string identifying which instance of the data model parameter
+**
+** \return  pointer to cache entry, or NULL if the parameter is not present in the cache
+**
+**************************************************************************/
+db_cache_entry_t *LookupDatabaseCache(dm_hash_t hash, char *instances)
+{
+    db_cache_entry_t *dce;
+
+    // Invalidate the cache, if the database has been modified by another process
+    CheckDatabaseCacheCoherent();
+
+    dce = FindDatabaseCacheEntry(hash, instances, CalcDatabaseCacheKeyHash(hash, instances));
+    if ((dce == NULL) || (dce->generation != db_cache_generation))
+    {
+        db_cache_misses++;
+        return NULL;
+    }
+
+    // Mark this entry as the most recently used
+    DLLIST_Unlink(&db_cache_lru, dce);
+    DLLIST_LinkToHead(&db_cache_lru, dce);
+    db_cache_hits++;
+
+    return dce;
+}
+
+/*********************************************************************//**
+**
+** AddToDatabaseCache
+**
+** Adds the value of the specified parameter to the cache, replacing any value already cached for it
+** If the cache is full, the least recently used entry is replaced
+**
+** \param   hash - hash identifying the data model parameter
+** \param   instances - string identifying which instance of the data model parameter
+** \param   value - pointer to value of the parameter, as stored in the database, or NULL if the parameter is not in the database
+** \param   len - length of the value
+**
+** \return  None
+**
+**************************************************************************/
+void AddToDatabaseCache(dm_hash_t hash, char *instances, const unsigned char *value, int len)
+{
+    db_cache_entry_t *dce;
+    unsigned key_hash;
+    int bucket;
+
+    // Exit if the instances string is too long to be cached
+    if (strlen(instances) >= sizeof(dce->instances))
+    {
+        return;
+    }
+
+    // Reuse the stale entry for this parameter (if there is one), otherwise reuse the least recently used entry
+    key_hash = CalcDatabaseCacheKeyHash(hash, instances);
+    dce = FindDatabaseCacheEntry(hash, instances, key_hash);
+    if (dce == NULL)
+    {
+        dce = (db_cache_entry_t *) db_cache_lru.tail;
+        UnlinkDatabaseCacheEntryFromBucket(dce);
+
+        dce->hash = hash;
+        USP_STRNCPY(dce->instances, instances, sizeof(dce->instances));
+        dce->key_hash = key_hash;
+        bucket = key_hash % DB_CACHE_NUM_BUCKETS;
+        dce->next_in_bucket = db_cache_buckets[bucket];
+        db_cache_buckets[bucket] = dce;
+    }
+
+    // Copy the value, reusing the entry's existing buffer
+    // NOTE: memcpy is used, as an obfuscated value may contain embedded NULLs
+    if (value != NULL)
+    {
+        dce->value = USP_REALLOC(dce->value, len+1);
+        memcpy(dce->value, value, len);
+        dce->value[len] = '\0';
+        dce->len = len;
+    }
+    else
+    {
+        USP_SAFE_FREE(dce->value);
+        dce->len = 0;
+    }
+    dce->generation = db_cache_generation;
+
+    // Mark this entry as the most recently used
+    DLLIST_Unlink(&db_cache_lru, dce);
+    DLLIST_LinkToHead(&db_cache_lru, dce);
+}
+
+/*********************************************************************//**
+**
+** FindDatabaseCacheEntry
+**
+** Finds the cache entry for the specified parameter
+** NOTE: The entry returned may be stale. The caller must check its generation
+**
+** \param   hash - hash identifying the data model parameter
+** \param   instances - string identifying which instance of the data model parameter
+** \param   key_hash - hash of the parameter's hash and instances
+**
+** \return  pointer to cache entry, or NULL if the parameter is not present in the cache
+**
+**************************************************************************/
+db_cache_entry_t *FindDatabaseCacheEntry(dm_hash_t hash, char *instances, unsigned key_hash)
+{
+    db_cache_entry_t *dce;
+
+    dce = db_cache_buckets[key_hash % DB_CACHE_NUM_BUCKETS];
+    while (dce != NULL)
+    {
+        if ((dce->key_hash == key_hash) && (dce->hash == hash) && (strcmp(dce->instances, instances)==0))
+        {
+            return dce;
+        }
+
+        dce = dce->next_in_bucket;
+    }
+
+    return NULL;
+}
+
+/*********************************************************************//**
+**
+** UnlinkDatabaseCacheEntryFromBucket
+**
+** Removes the specified cache entry from the hash bucket chain it is in (if any)
+**
+** \param   dce - pointer to cache entry to remove
+**
+** \return  None
+**
+**************************************************************************/
+void UnlinkDatabaseCacheEntryFromBucket(db_cache_entry_t *dce)
+{
+    db_cache_entry_t **p;
+
+    // Exit if this entry has never been used
+    if (dce->generation == 0)
+    {
+        return;
+    }
+
+    p = &db_cache_buckets[dce->key_hash % DB_CACHE_NUM_BUCKETS];
+    while (*p != NULL)
+    {
+        if (*p == dce)
+        {
+            *p = dce->next_in_bucket;
+            break;
+        }
+        p = &(*p)->next_in_bucket;
+    }
+
+    dce->next_in_bucket = NULL;
+    dce->generation = 0;
+}
+
+/*********************************************************************//**
+**
+** CalcDatabaseCacheKeyHash
+**
+** Calculates the hash used to select the cache bucket for the specified parameter
+**
+** \param   hash - hash identifying the data model parameter
+** \param   instances - string identifying which instance of the data model parameter
+**
+** \return  hash of the parameter's hash and instances
+**
+**************************************************************************/
+unsigned CalcDatabaseCacheKeyHash(dm_hash_t hash, char *instances)
+{
+    unsigned key_hash;
+
+    key_hash = (unsigned) hash;
+    while (*instances != '\0')
+    {
+        key_hash = (key_hash * 31) + (unsigned char)*instances;
+        instances++;
+    }
+
+    return key_hash;
+}
+
+/*********************************************************************//**
+**
+** CheckDatabaseCacheCoherent
+**
+** Invalidates all cached values, if the database has been modified by another process (eg by the 'dbset' CLI command)
+** NOTE: To limit the cost, the database is checked at most once a second
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void CheckDatabaseCacheCoherent(void)
+{
+    sqlite3_stmt *stmt;
+    time_t cur_time;
+    int data_version;
+    int err;
+
+    // Exit if the database has already been checked this second
+    cur_time = time(NULL);
+    if (cur_time == db_cache_check_time)
+    {
+        return;
+    }
+    db_cache_check_time = cur_time;
+
+    // Exit if unable to read the data version of the database. The cache is invalidated, to be safe
+    stmt = prepared_stmts[kSqlStmt_DataVersion];
+    err = sqlite3_step(stmt);
+    if (err != SQLITE_ROW)
+    {
+        USP_ERR_SQL(db_handle, "sqlite3_step");
+        sqlite3_reset(stmt);
+        db_cache_generation++;
+        return;
+    }
+    data_version = sqlite3_column_int(stmt, 0);
+    sqlite3_reset(stmt);
+
+    // Invalidate all cached values, if another process has committed changes to the database since the last check
+    if (data_version != db_cache_data_version)
+    {
+        db_cache_data_version = data_version;
+        db_cache_generation++;
+    }
+}
+
+/*********************************************************************//**
+**
+** RemoveRangeFromDatabaseCache
+**
+** Marks the cached values of parameters deleted by DATABASE_DeleteParameterRange() as not present in the database
+**
+** \param   hashes - hashes identifying the data model parameters which were deleted
+** \param   instances - string identifying the object instance whose parameters were deleted
+**
+** \return  None
+**
+**************************************************************************/
+void RemoveRangeFromDatabaseCache(int_vector_t *hashes, char *instances)
+{
+    int i;
+    int len;
+    db_cache_entry_t *dce;
+
+    len = strlen(instances);
+    for (i=0; i<DATABASE_CACHE_ENTRIES; i++)
+    {
+        // Skip entries which are stale, or are not the specified object instance or one of its child object instances
+        dce = &db_cache[i];
+        if ((dce->generation != db_cache_generation) || (strncmp(dce->instances, instances, len) != 0) ||
+            ((dce->instances[len] != '\0') && (dce->instances[len] != '.')))
+        {
+            continue;
+        }
+
+        if (INT_VECTOR_Find(hashes, dce->hash) != INVALID)
+        {
+            USP_SAFE_FREE(dce->value);
+            dce->len = 0;
+        }
+    }
+}
+
+/*********************************************************************//**
+**
+** WriteParameter
+**
+** Writes the value of the specified parameter to the database
+**
+** \param   path - data model path to parameter to set (only used for debug)
+** \param   hash - hash identifying the data model parameter to set
+** \param   instances - string identifying which instance of the data model parameter to set
+** \param   value - pointer to buffer containing the value to write (already obfuscated, if required)
+** \param   len - length of the value to write
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INTERNAL_ERROR if any other error occurred
+**
+**************************************************************************/
+int WriteParameter(char *path, dm_hash_t hash, char *instances, char *value, int len)
+{
+    sqlite3_stmt *stmt;
+    int err;
+    int result = USP_ERR_INTERNAL_ERROR;        // Assume an error
+
+    // Exit if unable to set the value of the hash in the prepared statement
+    stmt = prepared_stmts[kSqlStmt_Set];
+    err = sqlite3_bind_int64(stmt, 1, hash);
+    if (err != SQLITE_OK)
+    {
+        USP_ERR_SQL_PARAM(db_handle, "sqlite3_bind_int");
+        goto exit;
+    }
+
+    // Exit if unable to set the value of the instances in the prepared statement
+    err = sqlite3_bind_text(stmt, 2, instances, SQLITE_ZERO_TERMINATED, SQLITE_STATIC);
+    if (err != SQLITE_OK)
+    {
+        USP_ERR_SQL_PARAM(db_handle, "sqlite3_bind_text");
+        goto exit;
+    }
+
+    // Exit if unable to set the new value of the parameter in the prepared statement
+    err = sqlite3_bind_text(stmt, 3, value, len, SQLITE_STATIC);
+    if (err != SQLITE_OK)
+    {
+        USP_ERR_SQL_PARAM(db_handle, "sqlite3_bind_text");
+        goto exit;
+    }
+
+    //LogSQLStatement("SET", path, stmt);
+
+    // Exit if unable to perform the set
+    err = sqlite3_step(stmt);
+    if (err != SQLITE_DONE)     // We are not expecting any rows
+    {
+        USP_ERR_SQL_PARAM(db_handle, "sqlite3_step");
+        goto exit;
+    }
+
+    // If the code gets here, then the parameter has been successfully set in the database
+    AddToDatabaseCache(hash, instances, (unsigned char *)value, len);
+    result = USP_ERR_OK;
+
+exit:
+    // Always reset the statement in preparation for next time, even if an error occurred
+    err = sqlite3_reset(stmt);
+    if ((err != SQLITE_OK) && (result == USP_ERR_OK))
+    {
+        USP_ERR_SQL_PARAM(db_handle, "sqlite3_reset");
+    }
+    
+    return result;
+}
+
+/*********************************************************************//**
+**
+** DeleteParameter
+**
+** Deletes the specified parameter from the database
+**
+** \param   path - data model path to parameter to delete (only used for debug)
+** \param   hash - hash identifying the data model parameter to delete
+** \param   instances - string identifying which instance of the data model parameter to delete
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INTERNAL_ERROR if any other error occurred
+**
+**************************************************************************/
+int DeleteParameter(char *path, dm_hash_t hash, char *instances)
+{
+    sqlite3_stmt *stmt;
+    int err;
+    int result = USP_ERR_INTERNAL_ERROR;        // Assume an error
+
+    stmt = prepared_stmts[kSqlStmt_Del];
+
+    // Exit if unable to set the value of the hash in the prepared statement
+    err = sqlite3_bind_int64(stmt, 1, hash);
+    if (err != SQLITE_OK)
+    {
+        USP_ERR_SQL_PARAM(db_handle, "sqlite3_bind_int");
+        goto exit;
+    }
+
+    // Exit if unable to set the value of the instances in the prepared statement
+    err = sqlite3_bind_text(stmt, 2, instances, SQLITE_ZERO_TERMINATED, SQLITE_STATIC);
+    if (err != SQLITE_OK)
+    {
+        USP_ERR_SQL_PARAM(db_handle, "sqlite3_bind_text");
+        goto exit;
+    }
+
+    //LogSQLStatement("DEL", path, stmt);
+
+    // Exit if unable to perform the delete
+    // NOTE: If the parameter is not present in the DB, then SQLite still returns OK
+    err = sqlite3_step(stmt);
+    if (err != SQLITE_DONE)     // We are not expecting any rows
+    {
+        USP_ERR_SQL_PARAM(db_handle, "sqlite3_step");
+        goto exit;
+    }
+
+    // If the code gets here, then the parameter has been successfully deleted from the database
+    AddToDatabaseCache(hash, instances, NULL, 0);
+    result = USP_ERR_OK;
+
+exit:
+    // Always reset the statement in preparation for next time, even if an error occurred
+    err = sqlite3_reset(stmt);
+    if ((err != SQLITE_OK) && (result == USP_ERR_OK))
+    {
+        USP_ERR_SQL_PARAM(db_handle, "sqlite3_reset");
+    }
+    
+    return result;
+}
+
+#ifdef DATABASE_WRITE_BEHIND_PERIOD
+/*********************************************************************//**
+**
+** FindWriteBehindEntry
+**
+** Finds the queued write for the specified parameter
+**
+** \param   hash - hash identifying the data model parameter
+** \param   instances - string identifying which instance of the data model parameter
+**
+** \return  pointer to queued write, or NULL if the parameter has no write queued
+**
+**************************************************************************/
+write_behind_entry_t *FindWriteBehindEntry(dm_hash_t hash, char *instances)
+{
+    int i;
+    write_behind_entry_t *wb;
+
+    for (i=0; i < num_write_behind_entries; i++)
+    {
+        wb = &write_behind_queue[i];
+        if ((wb->hash == hash) && (strcmp(wb->instances, instances)==0))
+        {
+            return wb;
+        }
+    }
+
+    return NULL;
+}
+
+/*********************************************************************//**
+**
+** QueueWriteBehind
+**
+** Queues a write of the specified parameter to the database, replacing any write of the parameter already queued
+** The queue is written to the database when it becomes full, or when the write-behind timer fires
+**
+** \param   hash - hash identifying the data model parameter
+** \param   instances - string identifying which instance of the data model parameter
+** \param   value - pointer to buffer containing the value to write (already obfuscated, if required), or NULL to delete the parameter
+** \param   len - length of the value to write
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INTERNAL_ERROR if the queue was full and the parameter could not be written directly to the database
+**
+**************************************************************************/
+int QueueWriteBehind(dm_hash_t hash, char *instances, char *value, int len)
+{
+    write_behind_entry_t *wb;
+
+    // Replace the value of any write of this parameter which is already queued, otherwise add a new entry to the queue
+    wb = FindWriteBehindEntry(hash, instances);
+    if (wb != NULL)
+    {
+        USP_SAFE_FREE(wb->value);
+    }
+    else
+    {
+        // Exit if the queue is still full because the queued writes could not be written to the database,
+        // writing this parameter directly instead
+        if (num_write_behind_entries == MAX_WRITE_BEHIND_ENTRIES)
+        {
+            if (value != NULL)
+            {
+                return WriteParameter("WriteBehind", hash, instances, value, len);
+            }
+            return DeleteParameter("WriteBehind", hash, instances);
+        }
+
+        // Start the write-behind timer, if this is the first write queued
+        if (num_write_behind_entries == 0)
+        {
+            SYNC_TIMER_Reload(FlushWriteBehindTimer, 0, time(NULL) + DATABASE_WRITE_BEHIND_PERIOD);
+        }
+
+        wb = &write_behind_queue[num_write_behind_entries];
+        wb->hash = hash;
+        wb->instances = USP_STRDUP(instances);
+        num_write_behind_entries++;
+    }
+
+    // Copy the value to write
+    // NOTE: memcpy is used, as an obfuscated value may contain embedded NULLs
+    wb->len = len;
+    wb->value = NULL;
+    if (value != NULL)
+    {
+        wb->value = USP_MALLOC(len+1);
+        memcpy(wb->value, value, len);
+        wb->value[len] = '\0';
+    }
+
+    // Write the queue to the database, if it is now full
+    // NOTE: If this fails, the queued writes are kept, and retried when the write-behind timer fires
+    if (num_write_behind_entries == MAX_WRITE_BEHIND_ENTRIES)
+    {
+        FlushWriteBehindQueue();
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** FlushWriteBehindQueue
+**
+** Writes all queued parameters to the database in a single transaction, then empties the queue
+** If any of the queued writes fail, then the transaction is rolled back and all queued writes are kept,
+** to be retried when the write-behind timer fires
+** NOTE: Reads of queued parameters continue to return the queued values, until they have been written
+**
+** \param   None
+**
+** \return  USP_ERR_OK if the queue is now empty
+**          USP_ERR_INTERNAL_ERROR if the queued writes could not be committed, and are still queued
+**
+**************************************************************************/
+int FlushWriteBehindQueue(void)
+{
+    int i;
+    int err;
+    write_behind_entry_t *wb;
+
+    // Exit if there are no queued writes
+    if (num_write_behind_entries == 0)
+    {
+        return USP_ERR_OK;
+    }
+
+    // Exit if unable to start a transaction, so that all queued writes are committed to the database in a single write
+    err = sqlite3_exec(db_handle, "begin transaction;", NULL, NULL, NULL);
+    if (err != SQLITE_OK)
+    {
+        USP_ERR_SQL(db_handle,"sqlite3_exec");
+        goto retry;
+    }
+
+    // Iterate over all queued writes, writing them to the database
+    for (i=0; i < num_write_behind_entries; i++)
+    {
+        wb = &write_behind_queue[i];
+        if (wb->value != NULL)
+        {
+            err = WriteParameter("WriteBehind", wb->hash, wb->instances, wb->value, wb->len);
+        }
+        else
+        {
+            err = DeleteParameter("WriteBehind", wb->hash, wb->instances);
+        }
+
+        if (err != USP_ERR_OK)
+        {
+            break;
+        }
+    }
+
+    // Commit the transaction, if all queued writes succeeded
+    if (err == USP_ERR_OK)
+    {
+        err = sqlite3_exec(db_handle, "commit transaction;", NULL, NULL, NULL);
+        if (err != SQLITE_OK)
+        {
+            USP_ERR_SQL(db_handle,"sqlite3_exec");
+            err = USP_ERR_INTERNAL_ERROR;
+        }
+    }
+
+    // Exit if any queued write failed or the commit failed, rolling back all queued writes, so that they can be retried
+    if (err != USP_ERR_OK)
+    {
+        sqlite3_exec(db_handle, "rollback;", NULL, NULL, NULL);
+        db_cache_generation++;      // The cache may contain values which were not committed
+        goto retry;
+    }
+
+    // Empty the queue, now that it has been committed
+    for (i=0; i < num_write_behind_entries; i++)
+    {
+        wb = &write_behind_queue[i];
+        USP_FREE(wb->instances);
+        USP_SAFE_FREE(wb->value);
+    }
+    num_write_behind_entries = 0;
+
+    return USP_ERR_OK;
+
+retry:
+    // Keep all queued writes, and retry them when the write-behind timer next fires
+    USP_LOG_Error("%s: Failed to write %d queued parameters to the database. Retrying in %d seconds", __FUNCTION__, num_write_behind_entries, DATABASE_WRITE_BEHIND_PERIOD);
+    SYNC_TIMER_Reload(FlushWriteBehindTimer, 0, time(NULL) + DATABASE_WRITE_BEHIND_PERIOD);
+    return USP_ERR_INTERNAL_ERROR;
+}
+
+/*********************************************************************//**
+**
+** DiscardWriteBehindQueue
+**
+** Empties the queue without writing it to the database, logging each parameter whose value set is lost
+** This is only called when closing the database, if the queued writes could not be written
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void DiscardWriteBehindQueue(void)
+{
+    int i;
+    int err;
+    write_behind_entry_t *wb;
+    char path[MAX_DM_PATH];
+
+    for (i=0; i < num_write_behind_entries; i++)
+    {
+        wb = &write_behind_queue[i];
+        err = DM_PRIV_FormPath_FromDB(wb->hash, wb->instances, path, sizeof(path));
+        if (err != USP_ERR_OK)
+        {
+            USP_SNPRINTF(path, sizeof(path), "hash=%d (instances=%s)", wb->hash, wb->instances);
+        }
+        USP_LOG_Error("%s: Failed to write %s to the database. The value set has been lost", __FUNCTION__, path);
+
+        USP_FREE(wb->instances);
+        USP_SAFE_FREE(wb->value);
+    }
+    num_write_behind_entries = 0;
+}
+
+/*********************************************************************//**
+**
+** FlushWriteBehindTimer
+**
+** Called by the sync timer when queued writes have been waiting for DATABASE_WRITE_BEHIND_PERIOD seconds
+**
+** \param   id - (unused) identifier of the sync timer which caused this callback
+**
+** \return  None
+**
+**************************************************************************/
+void FlushWriteBehindTimer(int id)
+{
+    (void)id;
+    FlushWriteBehindQueue();
+}
+#endif
+
+/*********************************************************************//**
+**
+** ExecPragma
+**
+** Executes the specified SQL pragma statement, optionally returning the value that it results in
+**
+** \param   handle - SQLite database connection to execute the pragma on
+** \param   sql - SQL pragma statement to execute
+** \param   buf - pointer to buffer in which to return the value resulting from the pragma, or NULL if the value is not required
+** \param   len - length of buffer in which to return the value
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INTERNAL_ERROR if any other error occurred
+**
+**************************************************************************/
+int ExecPragma(sqlite3 *handle, char *sql, char *buf, int len)
+{
+    sqlite3_stmt *stmt;
+    const unsigned char *value;
+    int err;
+    int result = USP_ERR_OK;
+
+    // Exit if unable to prepare the SQL statement
+    err = sqlite3_prepare_v2(handle, sql, SQLITE_ZERO_TERMINATED, &stmt, NULL);
+    if (err != SQLITE_OK)
+    {
+        USP_ERR_SQL(handle,"sqlite3_prepare_v2");
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Some pragmas return a value, and some do not
+    err = sqlite3_step(stmt);
+    if (err == SQLITE_ROW)
+    {
+        if (buf != NULL)
+        {
+            value = sqlite3_column_text(stmt, 0);
+            USP_STRNCPY(buf, (value != NULL) ? (char *)value : "", len);
+        }
+    }
+    else if (err != SQLITE_DONE)
+    {
+        USP_ERR_SQL(handle,"sqlite3_step");
+        result = USP_ERR_INTERNAL_ERROR;
+    }
+    else if (buf != NULL)
+    {
+        *buf = '\0';
+    }
+
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+/*********************************************************************//**
+**
+** RemoveJournalFiles
+**
+** Deletes the journal files associated with the specified database file (if they exist)
+**
+** \param   db_file - path of the database file
+**
+** \return  None
+**
+**************************************************************************/
+void RemoveJournalFiles(char *db_file)
+{
+    char path[256];
+    int err;
+    int i;
+    static char *suffixes[] = { "-wal", "-shm", "-journal" };
+
+    for (i=0; i < NUM_ELEM(suffixes); i++)
+    {
+        USP_SNPRINTF(path, sizeof(path), "%s%s", db_file, suffixes[i]);
+        err = remove(path);
+        if ((err == -1) && (errno != ENOENT))
+        {
+            USP_LOG_Warning("%s: Unable to delete %s (%s)", __FUNCTION__, path, strerror(errno));
+        }
+    }
+}
+
 /*********************************************************************//**
 **
 ** LogSQLStatement
@@ -41,6 +41,8 @@
 #ifndef DATABASE_H
 #define DATABASE_H
 
+struct sqlite3;     // Forward declaration, so that this header does not depend on sqlite3.h
+
 //------------------------------------------------------------------------------
 // Defines for bits in flag variable used by DATABASE_GetParameterValue() and DATABASE_SetParameterValue()
 #define OBFUSCATED_VALUE 0x00000001
@@ -58,10 +60,18 @@ void DATABASE_PerformFactoryReset_ControllerInitiated(void);
 int DATABASE_GetParameterValue(char *path, dm_hash_t hash, char *instances, char *buf, int buflen, unsigned flags);
 int DATABASE_SetParameterValue(char *path, dm_hash_t hash, char *instances, char *new_value, unsigned flags);
 int DATABASE_DeleteParameter(char *path, dm_hash_t hash, char *instances);
+int DATABASE_DeleteParameterRange(char *path, int_vector_t *hashes, char *instances);
 int DATABASE_StartTransaction(void);
 int DATABASE_CommitTransaction(void);
 int DATABASE_AbortTransaction(void);
 void DATABASE_Dump(void);
+void DATABASE_DumpCache(void);
+void DATABASE_FlushCache(void);
+int DATABASE_GetDataVersion(void);
+int DATABASE_SetTuning(char *str);
+int DATABASE_ParseTuning(char *str, db_tuning_t *tuning);
+int DATABASE_ApplyTuning(struct sqlite3 *handle, db_tuning_t *tuning);
+void DATABASE_RemoveFiles(char *db_file);
 int DATABASE_ReadDataModelInstanceNumbers(bool remove_unknown_params);
 
 #endif
@@ -0,0 +1,478 @@
+/*
+ *
+ * Copyright (C) 2019, Broadband Forum
+ * Copyright (C) 2016-2019  CommScope, Inc
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file db_bench.c
+ *
+ * Measures the performance of SQLite journal, synchronous, mmap and cache settings (see '--dbtuning' option)
+ * on the storage of the target device, using a workload shaped like the agent's own database access
+ * This code is run by the 'dbbench' CLI command, and accesses scratch database files which it creates itself
+ * (using mkstemp) in a specified directory. It never removes a file which it did not create.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sqlite3.h>
+
+#include "common_defs.h"
+#include "data_model.h"
+#include "database.h"
+#include "db_bench.h"
+
+//------------------------------------------------------------------------------
+// Shape of the workload
+#define NUM_BENCH_ROWS         2000     // Number of parameters populated in the scratch database before timing starts
+#define NUM_BENCH_OPS          5000     // Number of operations timed for each tuning setting
+#define BENCH_TRANS_SIZE       20       // Number of writes performed in each multi-write transaction
+#define BENCH_READ_PERCENT     80       // Percentage of operations which read a single parameter
+#define BENCH_WRITE_PERCENT    15       // Percentage of operations which write a single parameter (outside of a transaction)
+                                        // The remaining operations write BENCH_TRANS_SIZE parameters in a single transaction
+#define BENCH_SEED             12345    // Seed for the random number generator, so that every tuning setting runs the same sequence of operations
+
+//------------------------------------------------------------------------------
+// Tuning settings which are benchmarked
+static char *bench_tunings[] =
+{
+    "",                                             // SQLite defaults (journal=delete, sync=full)
+    "journal=truncate",
+    "journal=persist",
+    "journal=wal,sync=full",
+    "journal=wal,sync=normal",
+    "journal=wal,sync=normal,mmap=67108864",
+    "journal=wal,sync=normal,mmap=67108864,cache=-8192",
+};
+
+//------------------------------------------------------------------------------
+// Statistics collected whilst running the workload
+typedef struct
+{
+    double populate_ms;     // Time taken to populate the scratch database
+    double total_ms;        // Time taken to run all operations in the workload
+    double read_us;         // Average time taken by each read
+    double write_us;        // Average time taken by each write performed outside of a transaction
+    double trans_us;        // Average time taken by each multi-write transaction
+} bench_stats_t;
+
+//------------------------------------------------------------------------------
+// Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
+int RunBenchmark(char *dir, char *tuning_str, bench_stats_t *stats);
+int CreateBenchFile(char *dir, char *file, int len);
+int PopulateBenchDatabase(sqlite3 *handle, sqlite3_stmt *set_stmt);
+int ExecBenchSql(sqlite3 *handle, char *sql);
+int BenchRead(sqlite3_stmt *get_stmt, int row);
+int BenchWrite(sqlite3_stmt *set_stmt, int row, int value);
+double BenchTimeNow(void);
+
+/*********************************************************************//**
+**
+** DB_BENCH_Run
+**
+** Runs the database workload against a scratch database using each of the benchmarked tuning settings,
+** and prints the time taken by each
+**
+** \param   dir - directory in which to create the scratch database files. This should be on the same file system as the agent's database
+**                NOTE: Each benchmark creates a new uniquely named file in this directory, which is deleted (with its journal files) afterwards
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int DB_BENCH_Run(char *dir)
+{
+    int i;
+    int err;
+    bench_stats_t stats;
+
+    USP_DUMP("Database benchmark using %s (%d rows, %d operations: %d%% reads, %d%% writes, %d%% transactions of %d writes)",
+             dir, NUM_BENCH_ROWS, NUM_BENCH_OPS, BENCH_READ_PERCENT, BENCH_WRITE_PERCENT,
+             100-BENCH_READ_PERCENT-BENCH_WRITE_PERCENT, BENCH_TRANS_SIZE);
+    USP_DUMP("%-52s %10s %10s %10s %10s %10s", "Tuning", "Populate", "Total", "Read", "Write", "Trans");
+    USP_DUMP("%-52s %10s %10s %10s %10s %10s", "", "(ms)", "(ms)", "(us)", "(us)", "(us)");
+
+    for (i=0; i < NUM_ELEM(bench_tunings); i++)
+    {
+        // Exit if an error occurred whilst running the benchmark
+        err = RunBenchmark(dir, bench_tunings[i], &stats);
+        if (err != USP_ERR_OK)
+        {
+            return err;
+        }
+
+        USP_DUMP("%-52s %10.1f %10.1f %10.2f %10.2f %10.2f", (bench_tunings[i][0] != '\0') ? bench_tunings[i] : "(default)",
+                 stats.populate_ms, stats.total_ms, stats.read_us, stats.write_us, stats.trans_us);
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** RunBenchmark
+**
+** Runs the database workload against a freshly created scratch database using the specified tuning settings
+**
+** \param   dir - directory in which to create the scratch database file
+** \param   tuning_str - comma separated list of tuning settings to apply (see DATABASE_ParseTuning)
+** \param   stats - pointer to structure in which to return the time taken
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int RunBenchmark(char *dir, char *tuning_str, bench_stats_t *stats)
+{
+    char file[256];
+    db_tuning_t tuning = { kDbJournal_Default, kDbSync_Default, -1, 0 };
+    sqlite3 *handle = NULL;
+    sqlite3_stmt *get_stmt = NULL;
+    sqlite3_stmt *set_stmt = NULL;
+    unsigned seed = BENCH_SEED;
+    int num_reads = 0;
+    int num_writes = 0;
+    int num_trans = 0;
+    double read_ms = 0;
+    double write_ms = 0;
+    double trans_ms = 0;
+    double start;
+    double t;
+    int percent;
+    int i, j;
+    int err;
+
+    memset(stats, 0, sizeof(bench_stats_t));
+
+    // Exit if the tuning settings are invalid
+    err = DATABASE_ParseTuning(tuning_str, &tuning);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Exit if unable to create a fresh scratch database file
+    err = CreateBenchFile(dir, file, sizeof(file));
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Exit if unable to open the scratch database
+    err = sqlite3_open(file, &handle);
+    if (err != SQLITE_OK)
+    {
+        USP_ERR_SQL(handle, "sqlite3_open");
+        err = USP_ERR_INTERNAL_ERROR;
+        goto exit;
+    }
+
+    // Exit if unable to apply the tuning settings
+    err = DATABASE_ApplyTuning(handle, &tuning);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    // Exit if unable to create the table or prepare the statements (these are the same as those used by the agent's database)
+    err = ExecBenchSql(handle, "create table data_model (hash integer, instances text, value text, primary key (hash, instances));");
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    if ((sqlite3_prepare_v2(handle, "select value from data_model where hash = ?1 and instances = ?2;", -1, &get_stmt, NULL) != SQLITE_OK) ||
+        (sqlite3_prepare_v2(handle, "insert or replace into data_model(hash,instances,value) values(?1, ?2, ?3);", -1, &set_stmt, NULL) != SQLITE_OK))
+    {
+        USP_ERR_SQL(handle, "sqlite3_prepare_v2");
+        err = USP_ERR_INTERNAL_ERROR;
+        goto exit;
+    }
+
+    // Exit if unable to populate the database
+    start = BenchTimeNow();
+    err = PopulateBenchDatabase(handle, set_stmt);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+    stats->populate_ms = BenchTimeNow() - start;
+
+    // Run the workload
+    start = BenchTimeNow();
+    for (i=0; i < NUM_BENCH_OPS; i++)
+    {
+        percent = rand_r(&seed) % 100;
+        t = BenchTimeNow();
+        if (percent < BENCH_READ_PERCENT)
+        {
+            err = BenchRead(get_stmt, rand_r(&seed) % NUM_BENCH_ROWS);
+            read_ms += BenchTimeNow() - t;
+            num_reads++;
+        }
+        else if (percent < BENCH_READ_PERCENT + BENCH_WRITE_PERCENT)
+        {
+            err = BenchWrite(set_stmt, rand_r(&seed) % NUM_BENCH_ROWS, i);
+            write_ms += BenchTimeNow() - t;
+            num_writes++;
+        }
+        else
+        {
+            err = ExecBenchSql(handle, "begin transaction;");
+            for (j=0; (j < BENCH_TRANS_SIZE) && (err == USP_ERR_OK); j++)
+            {
+                err = BenchWrite(set_stmt, rand_r(&seed) % NUM_BENCH_ROWS, i);
+            }
+
+            if (err == USP_ERR_OK)
+            {
+                err = ExecBenchSql(handle, "commit transaction;");
+            }
+            trans_ms += BenchTimeNow() - t;
+            num_trans++;
+        }
+
+        // Exit if an error occurred whilst accessing the database
+        if (err != USP_ERR_OK)
+        {
+            goto exit;
+        }
+    }
+    stats->total_ms = BenchTimeNow() - start;
+
+    stats->read_us = (num_reads > 0) ? 1000*read_ms/num_reads : 0;
+    stats->write_us = (num_writes > 0) ? 1000*write_ms/num_writes : 0;
+    stats->trans_us = (num_trans > 0) ? 1000*trans_ms/num_trans : 0;
+    err = USP_ERR_OK;
+
+exit:
+    sqlite3_finalize(get_stmt);
+    sqlite3_finalize(set_stmt);
+    sqlite3_close(handle);
+
+    // Delete the scratch database file and its journal files, which were all created by this benchmark
+    DATABASE_RemoveFiles(file);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** CreateBenchFile
+**
+** Creates a new, empty, uniquely named scratch database file in the specified directory
+** NOTE: mkstemp() guarantees that the file did not previously exist, so the benchmark never overwrites or deletes an existing file
+**
+** \param   dir - directory in which to create the scratch database file
+** \param   file - buffer in which to return the path of the created file
+** \param   len - length of buffer in which to return the path of the created file
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int CreateBenchFile(char *dir, char *file, int len)
+{
+    char path[256];
+    int fd;
+    int i;
+    static char *suffixes[] = { "-wal", "-shm", "-journal" };
+
+    // Exit if unable to create the scratch database file
+    USP_SNPRINTF(file, len, "%s/obuspa_dbbench_XXXXXX", dir);
+    fd = mkstemp(file);
+    if (fd == -1)
+    {
+        USP_ERR_ERRNO("mkstemp", errno);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+    close(fd);
+
+    // Exit if any journal files for the scratch database file already exist, as SQLite would use them, and they were not created by the benchmark
+    for (i=0; i < NUM_ELEM(suffixes); i++)
+    {
+        USP_SNPRINTF(path, sizeof(path), "%s%s", file, suffixes[i]);
+        if (access(path, F_OK) == 0)
+        {
+            USP_ERR_SetMessage("%s: Refusing to run benchmark as %s already exists", __FUNCTION__, path);
+            remove(file);
+            return USP_ERR_INTERNAL_ERROR;
+        }
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** PopulateBenchDatabase
+**
+** Populates the scratch database with the parameters read and written by the workload, using a single transaction
+**
+** \param   handle - SQLite connection to the scratch database
+** \param   set_stmt - prepared statement used to write a parameter
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int PopulateBenchDatabase(sqlite3 *handle, sqlite3_stmt *set_stmt)
+{
+    int i;
+    int err;
+
+    err = ExecBenchSql(handle, "begin transaction;");
+    for (i=0; (i < NUM_BENCH_ROWS) && (err == USP_ERR_OK); i++)
+    {
+        err = BenchWrite(set_stmt, i, 0);
+    }
+
+    if (err == USP_ERR_OK)
+    {
+        err = ExecBenchSql(handle, "commit transaction;");
+    }
+
+    return err;
+}
+
+/*********************************************************************//**
+**
+** BenchRead
+**
+** Reads the value of the specified row from the scratch database
+**
+** \param   get_stmt - prepared statement used to read a parameter
+** \param   row - row to read
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BenchRead(sqlite3_stmt *get_stmt, int row)
+{
+    char instances[16];
+    int err;
+
+    // Rows are spread across a small number of hashes, similar to multi-instance objects in the data model
+    USP_SNPRINTF(instances, sizeof(instances), "%d", row/16 + 1);
+    sqlite3_bind_int(get_stmt, 1, row % 16);
+    sqlite3_bind_text(get_stmt, 2, instances, -1, SQLITE_STATIC);
+    err = sqlite3_step(get_stmt);
+    sqlite3_reset(get_stmt);
+
+    if ((err != SQLITE_ROW) && (err != SQLITE_DONE))
+    {
+        USP_ERR_SQL(sqlite3_db_handle(get_stmt), "sqlite3_step");
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** BenchWrite
+**
+** Writes a value to the specified row of the scratch database
+**
+** \param   set_stmt - prepared statement used to write a parameter
+** \param   row - row to write
+** \param   value - value to write
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BenchWrite(sqlite3_stmt *set_stmt, int row, int value)
+{
+    char instances[16];
+    char buf[64];
+    int err;
+
+    USP_SNPRINTF(instances, sizeof(instances), "%d", row/16 + 1);
+    USP_SNPRINTF(buf, sizeof(buf), "Device.LocalAgent.Benchmark.%d.Value=%d", row, value);
+    sqlite3_bind_int(set_stmt, 1, row % 16);
+    sqlite3_bind_text(set_stmt, 2, instances, -1, SQLITE_STATIC);
+    sqlite3_bind_text(set_stmt, 3, buf, -1, SQLITE_STATIC);
+    err = sqlite3_step(set_stmt);
+    sqlite3_reset(set_stmt);
+
+    if (err != SQLITE_DONE)
+    {
+        USP_ERR_SQL(sqlite3_db_handle(set_stmt), "sqlite3_step");
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** ExecBenchSql
+**
+** Executes the specified SQL statement on the scratch database
+**
+** \param   handle - SQLite connection to the scratch database
+** \param   sql - SQL statement to execute
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int ExecBenchSql(sqlite3 *handle, char *sql)
+{
+    int err;
+
+    err = sqlite3_exec(handle, sql, NULL, NULL, NULL);
+    if (err != SQLITE_OK)
+    {
+        USP_ERR_SQL(handle, "sqlite3_exec");
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** BenchTimeNow
+**
+** Returns the current time from a monotonic clock
+**
+** \param   None
+**
+** \return  current time in milliseconds
+**
+**************************************************************************/
+double BenchTimeNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1000.0 + ts.tv_nsec/1000000.0;
+}
@@ -160,9 +160,12 @@ void DEVICE_SUBSCRIPTION_ProcessAllOperationCompleteSubscriptions(char *command,
 void DEVICE_SUBSCRIPTION_ResolveObjectDeletionPaths(void);
 void DEVICE_SUBSCRIPTION_NotifyObjectLifeEvent(char *obj_path, subs_notify_t notify_type);
 void DEVICE_SUBSCRIPTION_ProcessAllObjectLifeEventSubscriptions(void);
+void DEVICE_SUBSCRIPTION_NotifyParamValueChanged(char *path);
+void DEVICE_SUBSCRIPTION_ProcessPushedValueChanges(void);
 void DEVICE_SUBSCRIPTION_ProcessAllEventCompleteSubscriptions(char *event_name, kv_vector_t *output_args);
 void DEVICE_SUBSCRIPTION_SendPeriodicEvent(int cont_instance);
 void DEVICE_SUBSCRIPTION_Dump(void);
+void DEVICE_SUBSCRIPTION_BenchWatchTable(char *path_expr, int cont_instance);
 int DEVICE_SECURITY_Init(void);
 int DEVICE_SECURITY_Start(void);
 void DEVICE_SECURITY_Stop(void);
@@ -197,6 +197,7 @@ void bulkdata_drop_oldest_retained_reports(bulkdata_profile_t *bp, int num_repor
 int bulkdata_platform_get_uri_query_name_map(int profile_id, kv_vector_t *name_map);
 int bulkdata_platform_calc_uri_query_escaped_map(kv_vector_t *name_map, kv_vector_t *escaped_map);
 char *bulkdata_platform_calc_uri_query_string(kv_vector_t *escaped_map);
+int bulkdata_add_parameter_path(char *path, dm_node_t *node, dm_instances_t *inst, int separator_split, void *cb_arg);
 
 /*********************************************************************//**
 **
@@ -1660,46 +1661,30 @@ exit:
 **************************************************************************/
 int bulkdata_platform_get_parameter_values(char *path, kv_vector_t *param_values)
 {
-    int i;
     int err;
-    str_vector_t params;
-    char value[MAX_DM_VALUE_LEN];
-    char *cur_path;
     combined_role_t combined_role;
 
-    STR_VECTOR_Init(&params);
     KV_VECTOR_Init(param_values);
 
     // Exit if unable to get the resolved paths
+    // NOTE: The resolved paths are added directly as keys of the map, rather than first being collected in a separate vector
     // NOTE: We can safely use the FullAccess role here, because we have already validated the path expression against the controller's role
     combined_role.inherited = kCTrustRole_FullAccess;
     combined_role.assigned = kCTrustRole_FullAccess;
-    err = PATH_RESOLVER_ResolveDevicePath(path, &params, kResolveOp_GetBulkData, NULL, &combined_role, 0);
+    err = PATH_RESOLVER_IterateDevicePath(path, bulkdata_add_parameter_path, param_values, kResolveOp_GetBulkData, NULL, &combined_role, 0);
     if (err != USP_ERR_OK)
     {
         goto exit;
     }
 
-    // Iterate over all parameter paths found
-    for (i=0; i<params.num_entries; i++)
+    // Exit if unable to get the values of all parameter paths found (grouped vendor params are got together)
+    err = DATA_MODEL_GetParameterValues(param_values, 0);
+    if (err != USP_ERR_OK)
     {
-        // Exit if unable to get the value of the parameter
-        cur_path = params.vector[i];
-        err = DATA_MODEL_GetParameterValue(cur_path, value, sizeof(value), 0);
-        if (err != USP_ERR_OK)
-        {
-            goto exit;
-        }
-
-        // Add the parameter to the map
-        KV_VECTOR_Add(param_values, cur_path, value);
+        goto exit;
     }
 
-    err = USP_ERR_OK;
-
 exit:
-    STR_VECTOR_Destroy(&params);
-
     if (err != USP_ERR_OK)
     {
         KV_VECTOR_Destroy(param_values);
@@ -1708,6 +1693,30 @@ exit:
     return err;
 }
 
+/*********************************************************************//**
+**
+** bulkdata_add_parameter_path
+**
+** Called by the path resolver for each parameter resolved from a bulk data parameter reference
+** Adds the path of the parameter to the map of parameter values (the value is filled in later)
+**
+** \param   path - data model path of the parameter
+** \param   node - data model node of the parameter
+** \param   inst - pointer to instance numbers of the parameter
+** \param   separator_split - point at which to split the path of the parameter (unused)
+** \param   cb_arg - pointer to map of parameter values to add the path to
+**
+** \return  USP_ERR_OK
+**
+**************************************************************************/
+int bulkdata_add_parameter_path(char *path, dm_node_t *node, dm_instances_t *inst, int separator_split, void *cb_arg)
+{
+    kv_vector_t *param_values = (kv_vector_t *) cb_arg;
+
+    KV_VECTOR_Add(param_values, path, "");
+    return USP_ERR_OK;
+}
+
 /*********************************************************************//**
 **
 ** bulkdata_platform_get_profile_control_params
@@ -96,7 +96,8 @@ typedef struct
                        // This value will be marked as INVALID, if the entry is not currently being used
     bool enable;
     char *endpoint_id;
-    controller_mtp_t mtps[MAX_CONTROLLER_MTPS];  // Array of controller MTPs
+    controller_mtp_t *mtps;    // Dynamically allocated array of controller MTPs, grown on demand
+    int num_mtps;              // Number of slots in the mtps array
 
     time_t periodic_base;
     unsigned periodic_interval;
@@ -108,8 +109,9 @@ typedef struct
 
 } controller_t;
 
-// Array of controllers
-static controller_t controllers[MAX_CONTROLLERS];
+// Dynamically allocated array of controllers, grown on demand
+static controller_t *controllers = NULL;
+static int num_controllers = 0;
 
 //------------------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
@@ -179,27 +181,14 @@ int Notify_ControllerMtpCoapEncryption(dm_req_t *req, char *value);
 int DEVICE_CONTROLLER_Init(void)
 {
     int err = USP_ERR_OK;
-    int i, j;
-    controller_t *cont;
-    controller_mtp_t *mtp;
 
     // Add timer to be called back when first periodic notification fires
     first_periodic_notification_time = END_OF_TIME;
     SYNC_TIMER_Add(PeriodicNotificationExec, 0, first_periodic_notification_time);
 
-    // Mark all controller and mtp slots as unused
-    memset(controllers, 0, sizeof(controllers));
-    for (i=0; i<MAX_CONTROLLERS; i++)
-    {
-        cont = &controllers[i];
-        cont->instance = INVALID;
-
-        for (j=0; j<MAX_CONTROLLER_MTPS; j++)
-        {
-            mtp = &cont->mtps[j];
-            mtp->instance = INVALID;
-        }
-    }
+    // Start with no controller slots. These are allocated as controllers are added
+    controllers = NULL;
+    num_controllers = 0;
 
     // Register parameters implemented by this component
     err |= USP_REGISTER_Object(DEVICE_CONT_ROOT ".{i}", ValidateAdd_Controller, NULL, Notify_ControllerAdded, 
@@ -337,7 +326,7 @@ void DEVICE_CONTROLLER_Stop(void)
     controller_t *cont;
 
     // Iterate over all controllers, freeing all memory used by them
-    for (i=0; i<MAX_CONTROLLERS; i++)
+    for (i=0; i<num_controllers; i++)
     {
         cont = &controllers[i];
         if (cont->instance != INVALID)
@@ -345,6 +334,9 @@ void DEVICE_CONTROLLER_Stop(void)
             DestroyController(cont);
         }
     }
+
+    USP_SAFE_FREE(controllers);
+    num_controllers = 0;
 }
 
 /*********************************************************************//**
@@ -516,13 +508,13 @@ void DEVICE_CONTROLLER_SetRolesFromStomp(int stomp_instance, ctrust_role_t role,
     controller_mtp_t *mtp;
 
     // Iterate over all enabled controllers
-    for (i=0; i<MAX_CONTROLLERS; i++)
+    for (i=0; i<num_controllers; i++)
     {
         cont = &controllers[i];
         if ((cont->instance != INVALID) && (cont->enable))
         {
             // Iterate over all enabled MTP slots for this controller
-            for (j=0; j<MAX_CONTROLLER_MTPS; j++)
+            for (j=0; j<cont->num_mtps; j++)
             {
                 mtp = &cont->mtps[j];
                 if ((mtp->instance != INVALID) && (mtp->enable))
@@ -666,13 +658,13 @@ void DEVICE_CONTROLLER_NotifyStompConnDeleted(int stomp_instance)
     char path[MAX_DM_PATH];
 
     // Iterate over all controllers
-    for (i=0; i<MAX_CONTROLLERS; i++)
+    for (i=0; i<num_controllers; i++)
     {
         // Iterate over all MTP slots for this controller, clearing out all references to the deleted STOMP connection
         cont = &controllers[i];
         if (cont->instance != INVALID)
         {
-            for (j=0; j<MAX_CONTROLLER_MTPS; j++)
+            for (j=0; j<cont->num_mtps; j++)
             {
                 mtp = &cont->mtps[j];
                 if ((mtp->instance != INVALID) && (mtp->protocol == kMtpProtocol_STOMP) && (mtp->stomp_connection_instance == stomp_instance))
@@ -708,7 +700,7 @@ void PeriodicNotificationExec(int id)
     USP_ASSERT(cur_time >= first_periodic_notification_time);
 
     // Iterate over all controllers
-    for (i=0; i<MAX_CONTROLLERS; i++)
+    for (i=0; i<num_controllers; i++)
     {
         // Skip this entry if it is unused
         cont = &controllers[i];
@@ -745,12 +737,23 @@ void PeriodicNotificationExec(int id)
 **************************************************************************/
 int ValidateAdd_Controller(dm_req_t *req)
 {
-    controller_t *cont;
+    int i;
+    int count = 0;
 
-    // Exit if unable to find a free controller slot
-    cont = FindUnusedController();
-    if (cont == NULL)
+    // Count the number of controllers in use
+    // NOTE: FindUnusedController() is not used here, as it would grow the controllers array
+    for (i=0; i<num_controllers; i++)
+    {
+        if (controllers[i].instance != INVALID)
+        {
+            count++;
+        }
+    }
+
+    // Exit if no more controllers may be added
+    if (count >= MAX_CONTROLLERS)
     {
+        USP_ERR_SetMessage("%s: Only %d controllers are supported.", __FUNCTION__, MAX_CONTROLLERS);
         return USP_ERR_RESOURCES_EXCEEDED;        
     }
 
@@ -771,15 +774,26 @@ int ValidateAdd_Controller(dm_req_t *req)
 int ValidateAdd_ControllerMtp(dm_req_t *req)
 {
     controller_t *cont;
-    controller_mtp_t *mtp;
+    int i;
+    int count = 0;
 
     cont = FindControllerByInstance(inst1);
     USP_ASSERT(cont != NULL);
 
-    // Exit if unable to find a free MTP slot
-    mtp = FindUnusedControllerMtp(cont);
-    if (mtp == NULL)
+    // Count the number of MTPs in use by this controller
+    // NOTE: FindUnusedControllerMtp() is not used here, as it would grow the controller's MTP array
+    for (i=0; i<cont->num_mtps; i++)
     {
+        if (cont->mtps[i].instance != INVALID)
+        {
+            count++;
+        }
+    }
+
+    // Exit if no more MTPs may be added to this controller
+    if (count >= MAX_CONTROLLER_MTPS)
+    {
+        USP_ERR_SetMessage("%s: Only %d MTPs are supported per controller.", __FUNCTION__, MAX_CONTROLLER_MTPS);
         return USP_ERR_RESOURCES_EXCEEDED;        
     }
 
@@ -1127,7 +1141,7 @@ int Notify_ControllerEnable(dm_req_t *req, char *value)
 #ifdef ENABLE_COAP
     // Iterate over all MTPs for this controller, starting or stopping its associated CoAP MTPs
     int i;
-    for (i=0; i<MAX_CONTROLLER_MTPS; i++)
+    for (i=0; i<cont->num_mtps; i++)
     {
         int err;
         controller_mtp_t *mtp;
@@ -1721,11 +1735,6 @@ int ProcessControllerAdded(int cont_instance)
     cont->instance = cont_instance;
     cont->combined_role.inherited = ROLE_DEFAULT;
     cont->combined_role.assigned = ROLE_DEFAULT;
-    
-    for (i=0; i<MAX_CONTROLLER_MTPS; i++)
-    {
-        cont->mtps[i].instance = INVALID;
-    }
 
     // Exit if unable to determine whether this controller was enabled or not
     USP_SNPRINTF(path, sizeof(path), "%s.%d.Enable", device_cont_root, cont_instance);
@@ -2031,11 +2040,11 @@ int UpdateAssignedRole(controller_t *cont, char *reference)
 **
 ** FindUnusedController
 **
-** Finds the first free controller slot
+** Finds the first free controller slot, growing the controllers array if all slots are in use
 **
 ** \param   None
 **
-** \return  Pointer to first free controller, or NULL if no controller found
+** \return  Pointer to first free controller, or NULL if MAX_CONTROLLERS slots are already in use
 **
 **************************************************************************/
 controller_t *FindUnusedController(void)
@@ -2044,7 +2053,7 @@ controller_t *FindUnusedController(void)
     controller_t *cont;
 
     // Iterate over all controllers
-    for (i=0; i<MAX_CONTROLLERS; i++)
+    for (i=0; i<num_controllers; i++)
     {
         // Exit if found an unused controller
         cont = &controllers[i];
@@ -2054,20 +2063,33 @@ controller_t *FindUnusedController(void)
         }
     }
 
-    // If the code gets here, then no free controller slot has been found
-    USP_ERR_SetMessage("%s: Only %d controllers are supported.", __FUNCTION__, MAX_CONTROLLERS);
-    return NULL;
+    // Exit if the array has already grown to its limit
+    if (num_controllers >= MAX_CONTROLLERS)
+    {
+        USP_ERR_SetMessage("%s: Only %d controllers are supported.", __FUNCTION__, MAX_CONTROLLERS);
+        return NULL;
+    }
+
+    // If the code gets here, then no free controller slot has been found, so add another slot to the array
+    // NOTE: This moves the array, so pointers to controllers must not be held across this call
+    controllers = USP_REALLOC(controllers, (num_controllers+1)*sizeof(controller_t));
+    cont = &controllers[num_controllers];
+    num_controllers++;
+
+    memset(cont, 0, sizeof(controller_t));
+    cont->instance = INVALID;
+    return cont;
 }
 
 /*********************************************************************//**
 **
 ** FindUnusedControllerMtp
 **
-** Finds the first free MTP instance for the specified controller
+** Finds the first free MTP instance for the specified controller, growing the controller's MTP array if all slots are in use
 **
 ** \param   cont - pointer to controller
 **
-** \return  Pointer to first free MTP instance, or NULL if no MTP instance found
+** \return  Pointer to first free MTP instance, or NULL if MAX_CONTROLLER_MTPS slots are already in use
 **
 **************************************************************************/
 controller_mtp_t *FindUnusedControllerMtp(controller_t *cont)
@@ -2076,7 +2098,7 @@ controller_mtp_t *FindUnusedControllerMtp(controller_t *cont)
     controller_mtp_t *mtp;
 
     // Iterate over all MTP slots for this controller
-    for (i=0; i<MAX_CONTROLLER_MTPS; i++)
+    for (i=0; i<cont->num_mtps; i++)
     {
         // Exit if found an unused controller MTP
         mtp = &cont->mtps[i];
@@ -2086,9 +2108,22 @@ controller_mtp_t *FindUnusedControllerMtp(controller_t *cont)
         }
     }
 
-    // If the code gets here, then no free MTP slot has been found for this controller
-    USP_ERR_SetMessage("%s: Only %d MTPs are supported per controller.", __FUNCTION__, MAX_CONTROLLER_MTPS);
-    return NULL;
+    // Exit if the array has already grown to its limit
+    if (cont->num_mtps >= MAX_CONTROLLER_MTPS)
+    {
+        USP_ERR_SetMessage("%s: Only %d MTPs are supported per controller.", __FUNCTION__, MAX_CONTROLLER_MTPS);
+        return NULL;
+    }
+
+    // If the code gets here, then no free MTP slot has been found for this controller, so add another slot to the array
+    cont->mtps = USP_REALLOC(cont->mtps, (cont->num_mtps+1)*sizeof(controller_mtp_t));
+    mtp = &cont->mtps[cont->num_mtps];
+    cont->num_mtps++;
+
+    memset(mtp, 0, sizeof(controller_mtp_t));
+    mtp->instance = INVALID;
+    mtp->stomp_connection_instance = INVALID;
+    return mtp;
 }
 
 /*********************************************************************//**
@@ -2147,7 +2182,7 @@ controller_t *FindControllerByInstance(int cont_instance)
     controller_t *cont;
 
     // Iterate over all controllers
-    for (i=0; i<MAX_CONTROLLERS; i++)
+    for (i=0; i<num_controllers; i++)
     {
         // Exit if found a controller that matches the instance number
         cont = &controllers[i];
@@ -2178,7 +2213,7 @@ controller_t *FindControllerByEndpointId(char *endpoint_id)
     controller_t *cont;
 
     // Iterate over all controllers
-    for (i=0; i<MAX_CONTROLLERS; i++)
+    for (i=0; i<num_controllers; i++)
     {
         // Exit if found an enabled controller that matches the endpoint_id
         cont = &controllers[i];
@@ -2210,7 +2245,7 @@ controller_t *FindEnabledControllerByEndpointId(char *endpoint_id)
     controller_t *cont;
 
     // Iterate over all controllers
-    for (i=0; i<MAX_CONTROLLERS; i++)
+    for (i=0; i<num_controllers; i++)
     {
         // Exit if found an enabled controller that matches the endpoint_id
         cont = &controllers[i];
@@ -2244,7 +2279,7 @@ controller_mtp_t *FindFirstEnabledMtp(controller_t *cont, mtp_protocol_t preferr
     controller_mtp_t *first_mtp = NULL;
     
     // Iterate over all enabled MTPs for this controller, finding the first enabled MTP for this controller
-    for (i=0; i<MAX_CONTROLLER_MTPS; i++)
+    for (i=0; i<cont->num_mtps; i++)
     {
         mtp = &cont->mtps[i];
 
@@ -2285,7 +2320,7 @@ controller_mtp_t *FindControllerMtpByInstance(controller_t *cont, int mtp_instan
     controller_mtp_t *mtp;
 
     // Iterate over all MTPs for this controller
-    for (i=0; i<MAX_CONTROLLER_MTPS; i++)
+    for (i=0; i<cont->num_mtps; i++)
     {
         // Exit if found an MTP that matches the instance number
         mtp = &cont->mtps[i];
@@ -2319,11 +2354,15 @@ void DestroyController(controller_t *cont)
     cont->enable = false;
     USP_SAFE_FREE(cont->endpoint_id);
 
-    for (i=0; i<MAX_CONTROLLER_MTPS; i++)
+    for (i=0; i<cont->num_mtps; i++)
     {
         mtp = &cont->mtps[i];
         DestroyControllerMtp(mtp);
     }
+
+    // Free the MTP slots, so that an unused controller slot takes up minimal memory
+    USP_SAFE_FREE(cont->mtps);
+    cont->num_mtps = 0;
 }
 
 /*********************************************************************//**
@@ -2403,7 +2442,7 @@ int ValidateStompMtpUniqueness(controller_t *cont, int mtp_instance)
     controller_mtp_t *mtp;
 
     // Iterate over all MTPs, seeing if any (other than the one currently being set) is enabled and a STOMP connection
-    for (i=0; i < MAX_CONTROLLER_MTPS; i++)
+    for (i=0; i<cont->num_mtps; i++)
     {
         mtp = &cont->mtps[i];
 
@@ -2451,7 +2490,7 @@ int ValidateEndpointIdUniqueness(char *endpoint_id, int cont_instance)
     controller_t *cont;
 
     // Interate over all controllers, checking that none match the new EndpointID
-    for (i=0; i<MAX_CONTROLLERS; i++)
+    for (i=0; i<num_controllers; i++)
     {
         // Skip unused controller slots
         cont = &controllers[i];
@@ -2535,7 +2574,7 @@ void UpdateFirstPeriodicNotificationTime(void)
     time_t first = END_OF_TIME;
 
     // Iterate over all controllers
-    for (i=0; i<MAX_CONTROLLERS; i++)
+    for (i=0; i<num_controllers; i++)
     {
         // Skip this entry if it is unused
         cont = &controllers[i];
@@ -80,8 +80,9 @@ typedef struct
 #endif
 } agent_mtp_t;
 
-// Array of agent MTPs
-static agent_mtp_t agent_mtps[MAX_AGENT_MTPS];
+// Dynamically allocated array of agent MTPs, grown on demand
+static agent_mtp_t *agent_mtps = NULL;
+static int num_agent_mtps = 0;
 
 //------------------------------------------------------------------------------
 // Table used to convert from a textual representation of an MTP protocol to an enumeration
@@ -148,16 +149,10 @@ int Get_CoapInterfaces(dm_req_t *req, char *buf, int len);
 int DEVICE_MTP_Init(void)
 {
     int err = USP_ERR_OK;
-    int i;
-    agent_mtp_t *mtp;
 
-    // Mark all agent mtp slots as unused
-    memset(agent_mtps, 0, sizeof(agent_mtps));
-    for (i=0; i<MAX_AGENT_MTPS; i++)
-    {
-        mtp = &agent_mtps[i];
-        mtp->instance = INVALID;
-    }
+    // Start with no agent MTP slots. These are allocated as agent MTPs are added
+    agent_mtps = NULL;
+    num_agent_mtps = 0;
 
     // Register parameters implemented by this component
     err |= USP_REGISTER_Object(DEVICE_AGENT_MTP_ROOT ".{i}", ValidateAdd_AgentMtp, NULL, Notify_AgentMtpAdded, 
@@ -265,7 +260,7 @@ void DEVICE_MTP_Stop(void)
     agent_mtp_t *mtp;
 
     // Iterate over all agent MTPs, freeing all memory used by them
-    for (i=0; i<MAX_AGENT_MTPS; i++)
+    for (i=0; i<num_agent_mtps; i++)
     {
         mtp = &agent_mtps[i];
         if (mtp->instance != INVALID)
@@ -273,6 +268,9 @@ void DEVICE_MTP_Stop(void)
             DestroyAgentMtp(mtp);
         }
     }
+
+    USP_SAFE_FREE(agent_mtps);
+    num_agent_mtps = 0;
 }
 
 
@@ -298,7 +296,7 @@ char *DEVICE_MTP_GetAgentStompQueue(int instance)
     //       However it is hard to make this work in real life because when performing an ADD request, this code does
     //       not have visibility of the other parameters being performed in the add transaction, and hence cannot
     //       check the combination of agent_queue_name and stomp_connection_instance
-    for (i=0; i<MAX_AGENT_MTPS; i++)
+    for (i=0; i<num_agent_mtps; i++)
     {
         mtp = &agent_mtps[i];
         if ((mtp->instance != INVALID) && (mtp->enable == true) && 
@@ -426,7 +424,7 @@ void DEVICE_MTP_NotifyStompConnDeleted(int stomp_instance)
     char path[MAX_DM_PATH];
 
     // Iterate over all agent MTPs, clearing out all references to the deleted STOMP connection
-    for (i=0; i<MAX_AGENT_MTPS; i++)
+    for (i=0; i<num_agent_mtps; i++)
     {
         mtp = &agent_mtps[i];
         if ((mtp->instance != INVALID) && (mtp->protocol == kMtpProtocol_STOMP) && (mtp->stomp_connection_instance == stomp_instance))
@@ -450,12 +448,23 @@ void DEVICE_MTP_NotifyStompConnDeleted(int stomp_instance)
 **************************************************************************/
 int ValidateAdd_AgentMtp(dm_req_t *req)
 {
-    agent_mtp_t *mtp;
-        
-    // Exit if unable to find a free MTP slot
-    mtp = FindUnusedAgentMtp();
-    if (mtp == NULL)
+    int i;
+    int count = 0;
+
+    // Count the number of agent MTPs in use
+    // NOTE: FindUnusedAgentMtp() is not used here, as it would grow the agent MTPs array
+    for (i=0; i<num_agent_mtps; i++)
     {
+        if (agent_mtps[i].instance != INVALID)
+        {
+            count++;
+        }
+    }
+
+    // Exit if no more agent MTPs may be added
+    if (count >= MAX_AGENT_MTPS)
+    {
+        USP_ERR_SetMessage("%s: Only %d agent MTPs are supported.", __FUNCTION__, MAX_AGENT_MTPS);
         return USP_ERR_RESOURCES_EXCEEDED;        
     }
 
@@ -1330,11 +1339,11 @@ exit:
 **
 ** FindUnusedAgentMtp
 **
-** Finds the first free agent MTP slot
+** Finds the first free agent MTP slot, growing the agent MTPs array if all slots are in use
 **
 ** \param   None
 **
-** \return  Pointer to first free agent MTP, or NULL if no free agent MTP slot found
+** \return  Pointer to first free agent MTP, or NULL if MAX_AGENT_MTPS slots are already in use
 **
 **************************************************************************/
 agent_mtp_t *FindUnusedAgentMtp(void)
@@ -1343,7 +1352,7 @@ agent_mtp_t *FindUnusedAgentMtp(void)
     agent_mtp_t *mtp;
 
     // Iterate over all agent MTPs
-    for (i=0; i<MAX_AGENT_MTPS; i++)
+    for (i=0; i<num_agent_mtps; i++)
     {
         // Exit if found an unused slot
         mtp = &agent_mtps[i];
@@ -1353,9 +1362,22 @@ agent_mtp_t *FindUnusedAgentMtp(void)
         }
     }
 
-    // If the code gets here, then no free slot has been found
-    USP_ERR_SetMessage("%s: Only %d agent MTPs are supported.", __FUNCTION__, MAX_AGENT_MTPS);
-    return NULL;
+    // Exit if the array has already grown to its limit
+    if (num_agent_mtps >= MAX_AGENT_MTPS)
+    {
+        USP_ERR_SetMessage("%s: Only %d agent MTPs are supported.", __FUNCTION__, MAX_AGENT_MTPS);
+        return NULL;
+    }
+
+    // If the code gets here, then no free slot has been found, so add another slot to the array
+    // NOTE: This moves the array, so pointers to agent MTPs must not be held across this call
+    agent_mtps = USP_REALLOC(agent_mtps, (num_agent_mtps+1)*sizeof(agent_mtp_t));
+    mtp = &agent_mtps[num_agent_mtps];
+    num_agent_mtps++;
+
+    memset(mtp, 0, sizeof(agent_mtp_t));
+    mtp->instance = INVALID;
+    return mtp;
 }
 
 /*********************************************************************//**
@@ -1401,7 +1423,7 @@ agent_mtp_t *FindAgentMtpByInstance(int instance)
     agent_mtp_t *mtp;
 
     // Iterate over all agent MTPs
-    for (i=0; i<MAX_AGENT_MTPS; i++)
+    for (i=0; i<num_agent_mtps; i++)
     {
         // Exit if found an agent mtp that matches the instance number
         mtp = &agent_mtps[i];
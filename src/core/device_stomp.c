@@ -62,7 +62,9 @@ static const char device_stomp_conn_root[] = DEVICE_STOMP_CONN_ROOT;
 
 //------------------------------------------------------------------------------
 // Cache of the parameters in the Device.STOMP.Connection table
-static stomp_conn_params_t stomp_conn_params[MAX_STOMP_CONNECTIONS];
+// This array is dynamically allocated, and grown on demand
+static stomp_conn_params_t *stomp_conn_params = NULL;
+static int num_stomp_conn_params = 0;
 
 //------------------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
@@ -111,8 +113,6 @@ void ScheduleStompReconnect(stomp_conn_params_t *sp);
 int DEVICE_STOMP_Init(void)
 {
     int err = USP_ERR_OK;
-    int i;
-    stomp_conn_params_t *sp;
 
     // Exit if unable to initialise the lower level STOMP component
     err = STOMP_Init();
@@ -121,13 +121,9 @@ int DEVICE_STOMP_Init(void)
         return err;
     }
 
-    // Mark all stomp params slots as unused
-    memset(stomp_conn_params, 0, sizeof(stomp_conn_params));
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
-    {
-        sp = &stomp_conn_params[i];
-        sp->instance = INVALID;
-    }
+    // Start with no stomp params slots. These are allocated as STOMP connections are added
+    stomp_conn_params = NULL;
+    num_stomp_conn_params = 0;
 
     // Register parameters implemented by this component
     err |= USP_REGISTER_Object(DEVICE_STOMP_CONN_ROOT ".{i}", ValidateAdd_StompConn, NULL, Notify_StompConnAdded, 
@@ -224,7 +220,7 @@ int DEVICE_STOMP_Start(void)
     err = STOMP_Start();
     if (err != USP_ERR_OK)
     {
-        return err;
+        goto exit;
     }
 
     err = USP_ERR_OK;
@@ -252,7 +248,7 @@ void DEVICE_STOMP_Stop(void)
     stomp_conn_params_t *sp;
 
     // Iterate over all STOMP connections, freeing all memory used by it
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
+    for (i=0; i<num_stomp_conn_params; i++)
     {
         sp = &stomp_conn_params[i];
         if (sp->instance != INVALID)
@@ -260,6 +256,9 @@ void DEVICE_STOMP_Stop(void)
             DestroyStompConn(sp);
         }
     }
+
+    USP_SAFE_FREE(stomp_conn_params);
+    num_stomp_conn_params = 0;
 }
 
 /*********************************************************************//**
@@ -280,7 +279,7 @@ int DEVICE_STOMP_StartAllConnections(void)
     int err;
 
     // Iterate over all STOMP connections, starting the ones that are enabled    
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
+    for (i=0; i<num_stomp_conn_params; i++)
     {
         sp = &stomp_conn_params[i];
         if ((sp->instance != INVALID) && (sp->enable == true))
@@ -437,7 +436,7 @@ int DEVICE_STOMP_CountEnabledConnections(void)
     stomp_conn_params_t *sp;
 
     // Iterate over all STOMP connections
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
+    for (i=0; i<num_stomp_conn_params; i++)
     {
         // Increase the count if found an enabled connection
         sp = &stomp_conn_params[i];
@@ -463,12 +462,23 @@ int DEVICE_STOMP_CountEnabledConnections(void)
 **************************************************************************/
 int ValidateAdd_StompConn(dm_req_t *req)
 {
-    stomp_conn_params_t *sp;
-        
-    // Exit if unable to find a free STOMP connection slot
-    sp = FindUnusedStompParams();
-    if (sp == NULL)
+    int i;
+    int count = 0;
+
+    // Count the number of STOMP connections in use
+    // NOTE: FindUnusedStompParams() is not used here, as it would grow the STOMP connections array
+    for (i=0; i<num_stomp_conn_params; i++)
+    {
+        if (stomp_conn_params[i].instance != INVALID)
+        {
+            count++;
+        }
+    }
+
+    // Exit if no more STOMP connections may be added
+    if (count >= MAX_STOMP_CONNECTIONS)
     {
+        USP_ERR_SetMessage("%s: Only %d STOMP connections are supported.", __FUNCTION__, MAX_STOMP_CONNECTIONS);
         return USP_ERR_RESOURCES_EXCEEDED;        
     }
 
@@ -1349,11 +1359,11 @@ exit:
 **
 ** FindUnusedStompParams
 **
-** Finds the first free stomp params slot
+** Finds the first free stomp params slot, growing the stomp params array if all slots are in use
 **
 ** \param   None
 **
-** \return  Pointer to first free slot, or NULL if no slot was found
+** \return  Pointer to first free slot, or NULL if MAX_STOMP_CONNECTIONS slots are already in use
 **
 **************************************************************************/
 stomp_conn_params_t *FindUnusedStompParams(void)
@@ -1362,7 +1372,7 @@ stomp_conn_params_t *FindUnusedStompParams(void)
     stomp_conn_params_t *sp;
 
     // Iterate over all STOMP connections
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
+    for (i=0; i<num_stomp_conn_params; i++)
     {
         // Exit if found an unused slot
         sp = &stomp_conn_params[i];
@@ -1372,9 +1382,22 @@ stomp_conn_params_t *FindUnusedStompParams(void)
         }
     }
 
-    // If the code gets here, then no free slot has been found
-    USP_ERR_SetMessage("%s: Only %d STOMP connections are supported.", __FUNCTION__, MAX_STOMP_CONNECTIONS);
-    return NULL;
+    // Exit if the array has already grown to its limit
+    if (num_stomp_conn_params >= MAX_STOMP_CONNECTIONS)
+    {
+        USP_ERR_SetMessage("%s: Only %d STOMP connections are supported.", __FUNCTION__, MAX_STOMP_CONNECTIONS);
+        return NULL;
+    }
+
+    // If the code gets here, then no free slot has been found, so add another slot to the array
+    // NOTE: This moves the array, so pointers to stomp params must not be held across this call
+    stomp_conn_params = USP_REALLOC(stomp_conn_params, (num_stomp_conn_params+1)*sizeof(stomp_conn_params_t));
+    sp = &stomp_conn_params[num_stomp_conn_params];
+    num_stomp_conn_params++;
+
+    memset(sp, 0, sizeof(stomp_conn_params_t));
+    sp->instance = INVALID;
+    return sp;
 }
 
 /*********************************************************************//**
@@ -1423,7 +1446,7 @@ stomp_conn_params_t *FindStompParamsByInstance(int instance)
     stomp_conn_params_t *sp;
 
     // Iterate over all STOMP connections
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
+    for (i=0; i<num_stomp_conn_params; i++)
     {
         // Exit if found a stomp connection that matches the instance number
         sp = &stomp_conn_params[i];
@@ -59,6 +59,7 @@
 #include "text_utils.h"
 #include "expr_vector.h"
 #include "json.h"
+#include "uptime.h"
 
 //------------------------------------------------------------------------------
 // List of notification types that USP Agent currently supports
@@ -97,6 +98,137 @@ typedef struct
 
 obj_life_event_vector_t object_life_events;
 
+//------------------------------------------------------------------------------
+// Paths of database parameters which have been set since the last time DEVICE_SUBSCRIPTION_ProcessPushedValueChanges() was called
+// These are checked against value change subscriptions straight away, rather than waiting for the next poll
+// NOTE: The values are not read until they are processed, so a set which is subsequently aborted does not cause a notification
+#define MAX_PUSHED_VALUE_CHANGES 256        // If more parameters than this are set, then all value change subscriptions are polled instead
+static str_vector_t pushed_value_changes;
+static bool is_pushed_value_changes_overflow = false;
+
+// Set once value change polling has started (ie once notifications have been enabled)
+// Before this, pushed value changes are discarded, as the first poll reads the values of all parameters
+static bool is_value_change_polling_started = false;
+
+// Data version of the database at the last poll. If this changes, then another process has modified database parameters
+// without pushing their value changes, so the next poll reads the values of all parameters
+static int last_poll_db_data_version = INVALID;
+
+// Time (in seconds, from tu_uptime_secs) at which all database parameters were last polled
+// This is only used if the data version of the database cannot be read, in which case they are polled every VALUE_CHANGE_POLL_PERIOD
+static unsigned last_full_poll_time = 0;
+
+// Period (in seconds) between each slice of value change polling. Only the parameters which are due to be polled are read in each slice
+#define VALUE_CHANGE_POLL_SLICE  1
+
+// Set if the last poll ran out of time budget before all parameters which were due had been polled
+// The next poll is then a continuation of it, which must not re-resolve the paths of watched parameters
+static bool is_value_change_poll_pending = false;
+
+//------------------------------------------------------------------------------
+// Table of all parameters watched by enabled value change subscriptions
+// Each parameter is present only once, however many subscriptions are watching it, so that it is only read and compared once per poll
+// To keep the table compact, each entry only holds a digest of the parameter's last value, the paths of all entries are interned
+// in a single pool, and the (usually identical) lists of subscriptions watching each parameter are interned as shared sets
+typedef struct
+{
+    unsigned long long last_value_digest;   // Digest of the value of the parameter when it was last read. Only valid if has_value is set
+    unsigned path_offset;           // Offset of the path of the parameter in the table's path pool
+    unsigned hash;                  // Hash of the path. Used to select the hash bucket
+    int next_in_bucket;             // Index of the next entry in the hash bucket chain containing this entry, or INVALID
+    int subs_set;                   // Index of the set of subscriptions watching this parameter. Set 0 is always the empty set
+    bool has_value;                 // Set if the parameter has been read
+    bool is_db_param;               // Set if the parameter is stored in the database, so its value changes are pushed rather than polled
+    bool is_grouped;                // Set if the parameter is a grouped vendor parameter, so its value must be got together with others in its group
+    bool needs_sample;              // Set if the parameter must be read, because a subscription has started watching it
+    unsigned next_poll_time;        // Time (in seconds, from tu_uptime_secs) at which the parameter is next due to be polled, or WATCH_NOT_SCHEDULED
+    unsigned short poll_period;     // Current period (in seconds) between polls of the parameter. This is adapted to the cost and change frequency of the parameter
+    unsigned short get_cost;        // Smoothed time (in microseconds) taken to get the value of the parameter
+} watched_param_t;
+
+// Value of next_poll_time for parameters which are not polled, because their value changes are pushed (ie database parameters)
+#define WATCH_NOT_SCHEDULED  0xFFFFFFFF
+
+// Maximum value of get_cost (in microseconds)
+#define MAX_WATCH_GET_COST   0xFFFF
+
+typedef struct
+{
+    watched_param_t *params;        // Entries in the order that their paths were first resolved. Notifications are sent in this order
+    int num_params;
+    int max_params;
+    int *buckets;                   // Hash table containing the index of the first entry in each chain. Number of buckets is always a power of 2
+    int num_buckets;
+    char *path_pool;                // NULL terminated paths of all entries, one after the other
+    int path_pool_len;
+    int path_pool_size;
+    int_vector_t *subs_sets;        // Distinct sets of instance numbers of the subscriptions watching parameters
+    int num_subs_sets;
+    int poll_cursor;                // Index of the entry at which to start looking for parameters which are due to be polled
+    unsigned instances_generation;  // Value of DM_PRIV_GetInstancesGeneration() when the table was last rebuilt
+    unsigned rebuild_time;          // Time (in seconds, from tu_uptime_secs) at which the table was last rebuilt
+    bool has_dynamic_paths;         // Set if any path expression contains a search expression or reference follow,
+                                    // so its resolved paths may change without object instances being added or deleted.
+                                    // These paths are re-resolved at most every VALUE_CHANGE_POLL_PERIOD
+} watch_table_t;
+
+static watch_table_t watch_table;
+
+// Path of a parameter in the watch table
+#define WATCHED_PARAM_PATH(wp)  (&watch_table.path_pool[(wp)->path_offset])
+
+// Initial number of buckets in the watch table's hash table
+#define WATCH_TABLE_INITIAL_BUCKETS 64
+
+// State remembered whilst the watch table is being rebuilt, in order to determine which subscriptions have started watching each parameter
+typedef struct
+{
+    int *prev_subs_sets;            // Index of the set of subscriptions watching each entry before the rebuild
+    int num_prev_params;            // Number of entries before the rebuild. Entries added by the rebuild were not previously watched
+    int_vector_t *prev_sets;        // Sets of subscriptions before the rebuild
+    int num_prev_sets;
+} watch_rebuild_t;
+
+//------------------------------------------------------------------------------
+// Index of the paths of all events and operations that enabled Event and OperationComplete subscriptions are subscribed to
+// This allows an event to be matched against all subscriptions by a single hash lookup, rather than by resolving the path expressions
+// of every subscription each time that an event occurs. The index is rebuilt when subscriptions are changed, when object instances
+// are added or deleted, or when the role of a controller owning a subscription changes
+typedef struct
+{
+    char *path;                     // Resolved path of the event or operation
+    unsigned hash;                  // Hash of the path. Used to select the hash bucket
+    int next_in_bucket;             // Index of the next entry in the hash bucket chain containing this entry, or INVALID
+    int_vector_t subs;              // Instance numbers of the subscriptions that reference this path, in the order of the subscriptions vector
+} event_index_entry_t;
+
+typedef struct
+{
+    int cont_instance;              // Instance number of a controller owning subscriptions in the index
+    combined_role_t combined_role;  // Role of the controller used when resolving the path expressions of its subscriptions
+    bool has_role;                  // Set if the role of the controller could be determined when the index was built
+} event_index_role_t;
+
+typedef struct
+{
+    event_index_entry_t *entries;
+    int num_entries;
+    int max_entries;
+    int *buckets;                   // Hash table containing the index of the first entry in each chain. Number of buckets is always a power of 2
+    int num_buckets;
+    int_vector_t unindexed_subs;    // Instance numbers of the subscriptions whose path expressions cannot be indexed,
+                                    // (subscriptions on 'Device.' or containing search expressions or reference follows)
+    event_index_role_t *roles;      // Roles of all controllers owning subscriptions in the index
+    int num_roles;
+    unsigned instances_generation;  // Value of DM_PRIV_GetInstancesGeneration() when the index was last rebuilt
+    bool is_valid;                  // Cleared whenever a subscription is added, deleted or changed, to cause the index to be rebuilt
+} event_index_t;
+
+static event_index_t event_index;
+
+// Initial number of buckets in the event index's hash table
+#define EVENT_INDEX_INITIAL_BUCKETS 16
+
 //------------------------------------------------------------------------------
 // Boolean which is used by an assert to check that we always call DEVICE_SUBSCRIPTION_ResolveObjectDeletionPaths()
 // before deleting an object from the data model. This is needed so that ObjectDeletion subscriptions work correctly
@@ -147,8 +279,30 @@ int DeleteNonPersistentSubscriptions(void);
 void ProcessAllBootSubscriptions(void);
 void SendBootNotify(subs_t *sub);
 void ProcessObjectLifeEventSubscription(subs_t *sub);
-void ProcessAllValueChangeSubscriptions(void);
-void ProcessValueChangeSubscription(subs_t *sub);
+bool ProcessAllValueChangeSubscriptions(bool is_full_poll);
+bool IsAnyValueChangeSubscriptionEnabled(void);
+void ClearPushedValueChanges(void);
+void RebuildWatchTable(void);
+void WatchSubscriptionParams(subs_t *sub, watch_rebuild_t *rb);
+void SampleNewlyWatchedParams(watch_rebuild_t *rb);
+bool PollDueWatchedParams(unsigned now);
+void ReadWatchedParamList(int_vector_t *indexes, watch_rebuild_t *rb);
+void UpdateWatchedParam(int index, char *value, watch_rebuild_t *rb);
+unsigned CalcNextPollTime(watched_param_t *wp, unsigned now);
+void UnwatchSubscription(int instance);
+void RemoveUnwatchedParams(void);
+int FindWatchedParam(char *path, unsigned hash);
+int AddWatchedParam(char *path, unsigned hash);
+void RehashWatchTable(int num_buckets);
+void InitSubsSets(void);
+int AddToSubsSet(int set, int instance);
+int RemoveFromSubsSet(int set, int instance);
+int FindOrAddSubsSet(int *instances, int num_instances);
+void DestroySubsSets(int_vector_t *sets, int num_sets);
+void DestroyWatchTable(void);
+void SendValueChangeNotifyToWatchers(watched_param_t *wp, char *value, int_vector_t *prev_subs);
+unsigned long long CalcValueDigest(char *value);
+bool HasDynamicPathExpressions(str_vector_t *path_expressions);
 void SendValueChangeNotify(subs_t *sub, char *path, char *value);
 void ResolveAllPathExpressions(char *source_path, str_vector_t *path_expressions, str_vector_t *resolved_paths, resolve_op_t op, int cont_instance);
 void GetAllPathExpressionParameterValues(subs_t *sub, str_vector_t *path_expressions, kv_vector_t *param_values, char *source_path);
@@ -159,6 +313,15 @@ void SeedLastValueChangeValues(void);
 bool DoesSubscriptionSendNotification(subs_t *sub, char *event_name);
 bool DoesSubscriptionMatchEvent(subs_t *subs, char *event_name);
 bool HasControllerGotEventPermission(int cont_instance, char *event_name);
+void UpdateEventIndex(void);
+bool HaveEventIndexRolesChanged(void);
+void IndexSubscriptionEvents(subs_t *sub);
+int FindOrAddEventIndexEntry(char *path);
+void RehashEventIndex(int num_buckets);
+int_vector_t *FindEventIndexSubs(char *path);
+bool IsSubscriptionMatchingEvent(subs_t *sub, char *event_name, int_vector_t *indexed_subs);
+void DestroyEventIndex(void);
+unsigned CalcWatchTableSize(void);
 
 
 /*********************************************************************//**
@@ -263,7 +426,6 @@ int DEVICE_SUBSCRIPTION_Start(void)
     }
 
     // Add all subscriptions in the subscription table to the subscriptions vector
-    // NOTE: This also seeds the initial values for all value change subscriptions
     for (i=0; i < iv.num_entries; i++)
     {
         instance = iv.vector[i];
@@ -281,6 +443,9 @@ int DEVICE_SUBSCRIPTION_Start(void)
         }
     }
 
+    // Seed the initial values of all parameters watched by value change subscriptions
+    RebuildWatchTable();
+
     // Override the initial value for SoftwareVersion with the value before the current boot cycle
     SeedLastValueChangeValues();
 
@@ -304,6 +469,9 @@ void DEVICE_SUBSCRIPTION_Stop(void)
 {
     SUBS_RETRY_Stop();
     SUBS_VECTOR_Destroy(&subscriptions);
+    ClearPushedValueChanges();
+    DestroyWatchTable();
+    DestroyEventIndex();
 }
 
 /*********************************************************************//**
@@ -312,6 +480,7 @@ void DEVICE_SUBSCRIPTION_Stop(void)
 **
 ** Periodically called to update all subscriptions
 ** The first time this function is called, it registers a sync timer to periodically poll for value change
+** Value change polling is spread over time: each call only polls the parameters which are due, within a time budget
 **
 ** \param   id - (unused) identifier of the sync timer which caused this callback
 **
@@ -322,7 +491,10 @@ void DEVICE_SUBSCRIPTION_Update(int id)
 {
     static bool boot_subs_processed = false;
     time_t cur_time;
-    int poll_period;
+    unsigned now;
+    int data_version;
+    bool is_full_poll;
+    bool is_complete;
 
     // Delete all subscriptions which have expired
     DeleteExpiredSubscriptions();
@@ -338,15 +510,33 @@ void DEVICE_SUBSCRIPTION_Update(int id)
         DeleteNonPersistentSubscriptions();
     }
 
-    // Poll all value change subscriptions for change
-    ProcessAllValueChangeSubscriptions();
+    // Determine whether database parameters need to be polled
+    // NOTE: Changes to database parameters are pushed, so their values only need to be read if another process has modified the database
+    // If the data version of the database cannot be read, then database parameters are polled every VALUE_CHANGE_POLL_PERIOD
+    now = tu_uptime_secs();
+    data_version = DATABASE_GetDataVersion();
+    if (data_version == INVALID)
+    {
+        is_full_poll = ((is_value_change_polling_started == false) || (now - last_full_poll_time >= VALUE_CHANGE_POLL_PERIOD)) ? true : false;
+    }
+    else
+    {
+        is_full_poll = (data_version != last_poll_db_data_version) ? true : false;
+    }
+
+    if (is_full_poll)
+    {
+        last_full_poll_time = now;
+    }
+    last_poll_db_data_version = data_version;
 
-    // Determine the period for value change polling
-    poll_period = VALUE_CHANGE_POLL_PERIOD;
+    // Poll the value change parameters which are due
+    is_complete = ProcessAllValueChangeSubscriptions(is_full_poll);
+    is_value_change_polling_started = true;
 
-    
     // Restart the timer to cause this function to be called periodically
-    SYNC_TIMER_Reload(DEVICE_SUBSCRIPTION_Update, 0, cur_time + poll_period);
+    // If not all due parameters could be polled within the time budget, then continue as soon as pending USP messages have been processed
+    SYNC_TIMER_Reload(DEVICE_SUBSCRIPTION_Update, 0, (is_complete) ? cur_time + VALUE_CHANGE_POLL_SLICE : cur_time);
 }
 
 /*********************************************************************//**
@@ -368,6 +558,11 @@ void DEVICE_SUBSCRIPTION_ProcessAllOperationCompleteSubscriptions(char *command,
 {
     int i;
     subs_t *sub;
+    int_vector_t *indexed_subs;
+
+    // Determine the subscriptions which reference this operation
+    UpdateEventIndex();
+    indexed_subs = FindEventIndexSubs(command);
 
     // Iterate over all enabled subscriptions, processing each operation complete subscription that matches
     // (there may be more than one subscriber)
@@ -377,7 +572,7 @@ void DEVICE_SUBSCRIPTION_ProcessAllOperationCompleteSubscriptions(char *command,
         if ((sub->enable) && (sub->notify_type == kSubNotifyType_OperationComplete))
         {
             // Send the event, if it matches this subscription
-            if (DoesSubscriptionSendNotification(sub, command))
+            if (IsSubscriptionMatchingEvent(sub, command, indexed_subs))
             {
                 SendOperationCompleteNotify(sub, command, command_key, err_code, err_msg, output_args);
             }
@@ -402,6 +597,7 @@ void DEVICE_SUBSCRIPTION_ProcessAllEventCompleteSubscriptions(char *event_name,
     int i;
     subs_t *sub;
     Usp__Msg *req;
+    int_vector_t *indexed_subs;
 
 #ifdef VALIDATE_OUTPUT_ARG_NAMES
     if (output_args != NULL)
@@ -425,6 +621,10 @@ void DEVICE_SUBSCRIPTION_ProcessAllEventCompleteSubscriptions(char *event_name,
     }
 #endif
 
+    // Determine the subscriptions which reference this event
+    UpdateEventIndex();
+    indexed_subs = FindEventIndexSubs(event_name);
+
     // Iterate over all enabled subscriptions, processing each event complete subscription that matches
     // (there may be more than one subscriber)
     for (i=0; i < subscriptions.num_entries; i++)
@@ -433,7 +633,7 @@ void DEVICE_SUBSCRIPTION_ProcessAllEventCompleteSubscriptions(char *event_name,
         if ((sub->enable) && (sub->notify_type == kSubNotifyType_Event))
         {
             // Send the event, if it matches this subscription
-            if (DoesSubscriptionSendNotification(sub, event_name))
+            if (IsSubscriptionMatchingEvent(sub, event_name, indexed_subs))
             {
                 // Create the notify message
                 req = MSG_HANDLER_CreateNotifyReq_Event(event_name, output_args, sub->subscription_id, sub->notification_retry);
@@ -575,6 +775,109 @@ void DEVICE_SUBSCRIPTION_ProcessAllObjectLifeEventSubscriptions(void)
     object_deletion_paths_resolved = false;
 }
 
+/*********************************************************************//**
+**
+** DEVICE_SUBSCRIPTION_NotifyParamValueChanged
+**
+** Called after a database parameter has been set, to queue it for checking against all value change subscriptions
+** The parameters are processed later by DEVICE_SUBSCRIPTION_ProcessPushedValueChanges()
+** We use a queue because we want any USP notification messages to be sent after the response to the USP set request,
+** and only if the transaction setting the parameter was committed
+**
+** \param   path - path of the parameter which has been set
+**
+** \return  None
+**
+**************************************************************************/
+void DEVICE_SUBSCRIPTION_NotifyParamValueChanged(char *path)
+{
+    // Exit if no value change subscriptions are enabled, or the queue has already overflowed
+    if ((is_pushed_value_changes_overflow) || (IsAnyValueChangeSubscriptionEnabled() == false))
+    {
+        return;
+    }
+
+    // If too many parameters have been set, then poll all value change subscriptions instead
+    if (pushed_value_changes.num_entries >= MAX_PUSHED_VALUE_CHANGES)
+    {
+        STR_VECTOR_Destroy(&pushed_value_changes);
+        is_pushed_value_changes_overflow = true;
+        return;
+    }
+
+    STR_VECTOR_Add_IfNotExist(&pushed_value_changes, path);
+}
+
+/*********************************************************************//**
+**
+** DEVICE_SUBSCRIPTION_ProcessPushedValueChanges
+**
+** Sends value change notifications for all database parameters which have been set since the last time this function was called
+** and whose value differs from that last notified for (or initially read by) the subscription
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void DEVICE_SUBSCRIPTION_ProcessPushedValueChanges(void)
+{
+    int i;
+    int err;
+    int index;
+    char *path;
+    char buf[MAX_DM_VALUE_LEN];
+
+    // Exit if no parameters have been set
+    if ((pushed_value_changes.num_entries == 0) && (is_pushed_value_changes_overflow == false))
+    {
+        return;
+    }
+
+    // Exit if value change polling has not started yet. The first poll will detect these changes
+    if (is_value_change_polling_started == false)
+    {
+        ClearPushedValueChanges();
+        return;
+    }
+
+    // Exit if too many parameters were set to track individually, polling all value change subscriptions instead
+    if (is_pushed_value_changes_overflow)
+    {
+        // If not all parameters could be polled within the time budget, then continue polling as soon as possible
+        ClearPushedValueChanges();
+        if (ProcessAllValueChangeSubscriptions(true) == false)
+        {
+            SYNC_TIMER_Reload(DEVICE_SUBSCRIPTION_Update, 0, time(NULL));
+        }
+        return;
+    }
+
+    for (i=0; i < pushed_value_changes.num_entries; i++)
+    {
+        // Skip if no subscription is watching this parameter
+        path = pushed_value_changes.vector[i];
+        index = FindWatchedParam(path, (unsigned)TEXT_UTILS_CalcHash(path));
+        if ((index == INVALID) || (watch_table.params[index].has_value == false))
+        {
+            continue;
+        }
+
+        // Get the current value of the parameter
+        // NOTE: Parameters which could not be got are treated as an empty string, as when polling
+        err = DATA_MODEL_GetParameterValue(path, buf, sizeof(buf), 0);
+        if (err != USP_ERR_OK)
+        {
+            buf[0] = '\0';
+        }
+
+        // Send a notification if the value has changed, and remember the value for next time
+        UpdateWatchedParam(index, buf, NULL);
+    }
+
+    ClearPushedValueChanges();
+}
+
 /*********************************************************************//**
 **
 ** DEVICE_SUBSCRIPTION_SendPeriodicEvent
@@ -630,7 +933,126 @@ void DEVICE_SUBSCRIPTION_SendPeriodicEvent(int cont_instance)
 **************************************************************************/
 void DEVICE_SUBSCRIPTION_Dump(void)
 {
+    int i, j;
+    watched_param_t *wp;
+    int_vector_t *subs;
+
     SUBS_VECTOR_Dump(&subscriptions);
+
+    // Log all watched parameters (with the digest of their last value), and the subscriptions watching them
+    USP_DUMP("Watched parameters: %d (path pool %d bytes, %d subscription sets)", watch_table.num_params, watch_table.path_pool_len, watch_table.num_subs_sets);
+    for (i=0; i < watch_table.num_params; i++)
+    {
+        wp = &watch_table.params[i];
+        if (wp->has_value)
+        {
+            USP_DUMP("%s => %016llx (poll period %us, get %uus)", WATCHED_PARAM_PATH(wp), wp->last_value_digest, wp->poll_period, wp->get_cost);
+        }
+        else
+        {
+            USP_DUMP("%s => (not read)", WATCHED_PARAM_PATH(wp));
+        }
+
+        subs = &watch_table.subs_sets[wp->subs_set];
+        for (j=0; j < subs->num_entries; j++)
+        {
+            USP_DUMP("    watched by %s.%d", device_subs_root, subs->vector[j]);
+        }
+    }
+
+    // Log the event index, if it has been built
+    USP_DUMP("Event index: %d paths (%d unindexed subscriptions)%s", event_index.num_entries, event_index.unindexed_subs.num_entries, (event_index.is_valid) ? "" : " (stale)");
+    for (i=0; i < event_index.num_entries; i++)
+    {
+        USP_DUMP("%s", event_index.entries[i].path);
+        subs = &event_index.entries[i].subs;
+        for (j=0; j < subs->num_entries; j++)
+        {
+            USP_DUMP("    referenced by %s.%d", device_subs_root, subs->vector[j]);
+        }
+    }
+}
+
+/*********************************************************************//**
+**
+** DEVICE_SUBSCRIPTION_BenchWatchTable
+**
+** Measures the memory used by the table of watched parameters, and the time taken to build and poll it,
+** when a value change subscription with the specified path expression is enabled
+** This is used by the 'dmbench' CLI command. The subscription is only added to the internal subscriptions vector
+** (not to the data model), and is removed again before returning
+** NOTE: No notifications are sent, as the values of the watched parameters do not change whilst the benchmark is running
+**
+** \param   path_expr - path expression of the parameters to watch
+** \param   cont_instance - instance number of the controller whose role is used to resolve the path expression
+**
+** \return  None
+**
+**************************************************************************/
+void DEVICE_SUBSCRIPTION_BenchWatchTable(char *path_expr, int cont_instance)
+{
+    int i;
+    subs_t sub;
+    int num_prev_params;
+    unsigned prev_size;
+    int num_params;
+    int num_polled;
+    unsigned size;
+    unsigned now;
+    int num_slices = 0;
+    bool is_complete;
+    uint64_t start_time;
+    uint64_t rebuild_time;
+    uint64_t poll_time;
+
+    // Ensure that the table only contains parameters watched by the agent's own subscriptions
+    RebuildWatchTable();
+    num_prev_params = watch_table.num_params;
+    prev_size = CalcWatchTableSize();
+
+    // Add a subscription watching the specified parameters
+    // NOTE: Its instance number is 0, which is never used by subscriptions in the data model
+    memset(&sub, 0, sizeof(sub));
+    sub.enable = true;
+    sub.instance = 0;
+    sub.cont_instance = cont_instance;
+    sub.notify_type = kSubNotifyType_ValueChange;
+    STR_VECTOR_Add(&sub.path_expressions, path_expr);
+    SUBS_VECTOR_Add(&subscriptions, &sub);
+
+    // Measure the time taken to resolve the path expression and read the initial values of the watched parameters
+    start_time = tu_uptime_usecs();
+    RebuildWatchTable();
+    rebuild_time = tu_uptime_usecs() - start_time;
+    num_params = watch_table.num_params - num_prev_params;
+    size = CalcWatchTableSize() - prev_size;
+
+    // Measure the time taken to poll all watched parameters, in as many slices as the poll budget requires
+    now = tu_uptime_secs();
+    num_polled = watch_table.num_params;
+    for (i=0; i < num_polled; i++)
+    {
+        watch_table.params[i].next_poll_time = now;
+    }
+
+    start_time = tu_uptime_usecs();
+    do
+    {
+        is_complete = PollDueWatchedParams(now);
+        num_slices++;
+    }
+    while (is_complete == false);
+    poll_time = tu_uptime_usecs() - start_time;
+
+    // Remove the subscription, and the parameters which only it was watching
+    SUBS_VECTOR_Remove(&subscriptions, &subscriptions.vector[subscriptions.num_entries-1]);
+    RebuildWatchTable();
+
+    USP_DUMP("Watch table benchmark (%s)", path_expr);
+    USP_DUMP("Watched parameters: %d (%u bytes, %.1f bytes/param)", num_params, size, (num_params > 0) ? (double)size/num_params : 0.0);
+    USP_DUMP("Resolve and read initial values: %llu us", (unsigned long long)rebuild_time);
+    USP_DUMP("Poll all %d parameters: %llu us in %d slices (%.2f us/param)", num_polled, (unsigned long long)poll_time, num_slices,
+             (num_polled > 0) ? (double)poll_time/num_polled : 0.0);
 }
 
 /*********************************************************************//**
@@ -655,7 +1077,6 @@ int ProcessSubscriptionAdded(int instance)
     // Initialise the structure representing this subscription
     memset(&sub, 0, sizeof(sub));
     sub.instance = instance;
-    KV_VECTOR_Init(&sub.last_values);
     STR_VECTOR_Init(&sub.resolved_paths);
 
     // Exit if unable to calculate the expiry time for this subscription    
@@ -744,17 +1165,11 @@ int ProcessSubscriptionAdded(int instance)
 exit:
     if (err == USP_ERR_OK)
     {
-        // Get the initial value of all parameters, if this is a value change subscription that has just been enabled
-        if ((sub.enable==true) && (sub.notify_type == kSubNotifyType_ValueChange))
-        {
-            USP_SNPRINTF(path, sizeof(path), "%s.%d", device_subs_root, sub.instance);
-            GetAllPathExpressionParameterValues(&sub, &sub.path_expressions, &sub.last_values, path);
-        }
-
         // We have successfully retrieved a subscription, so add it to the vector
         // NOTE: Ownership of the dynamically allocated memory referenced by the temp subscriber structure(sub) passes to the vector
         // So we do not have to call SUBS_VECTOR_DestroySubscriber(&sub)
         SUBS_VECTOR_Add(&subscriptions, &sub);
+        event_index.is_valid = false;
     }
     else
     {
@@ -828,11 +1243,19 @@ int CalcExpiryTime(int instance, time_t *expiry_time)
 int NotifySubsAdded(dm_req_t *req)
 {
     int err;
+    subs_t *sub;
 
     USP_LOG_Info("Subscription added (%s)", req->path);
 
     err = ProcessSubscriptionAdded(inst1);
 
+    // Get the initial value of all parameters, if this is an enabled value change subscription
+    sub = SUBS_VECTOR_GetSubsByInstance(&subscriptions, inst1);
+    if ((sub != NULL) && (sub->enable) && (sub->notify_type == kSubNotifyType_ValueChange))
+    {
+        RebuildWatchTable();
+    }
+
     return err;
 }
 
@@ -859,6 +1282,8 @@ int NotifySubsDeleted(dm_req_t *req)
     {
         SUBS_RETRY_Delete(sub->instance);
         SUBS_VECTOR_Remove(&subscriptions, sub);
+        UnwatchSubscription(inst1);
+        event_index.is_valid = false;
     }
 
     return USP_ERR_OK;
@@ -880,7 +1305,6 @@ int NotifyChange_SubsEnable(dm_req_t *req, char *value)
 {
     subs_t *sub;
     bool cur_enable;
-    char source_path[MAX_DM_PATH];
 
     // Change the subscription's enable state
     sub = SUBS_VECTOR_GetSubsByInstance(&subscriptions, inst1);
@@ -888,12 +1312,17 @@ int NotifyChange_SubsEnable(dm_req_t *req, char *value)
     {
         cur_enable = sub->enable;
         sub->enable = val_bool;
+        event_index.is_valid = false;
 
-        // Get the initial value of all parameters, if this is a value change subscription that has just been enabled
         if ((cur_enable == false) && (val_bool == true) && (sub->notify_type == kSubNotifyType_ValueChange))
         {
-            USP_SNPRINTF(source_path, sizeof(source_path), "%s.%d", device_subs_root, sub->instance);
-            GetAllPathExpressionParameterValues(sub, &sub->path_expressions, &sub->last_values, source_path);
+            // Get the initial value of all parameters, if this is a value change subscription that has just been enabled
+            RebuildWatchTable();
+        }
+        else if (val_bool == false)
+        {
+            // Stop watching all parameters, if the subscription has just been disabled
+            UnwatchSubscription(sub->instance);
         }
     }
 
@@ -917,7 +1346,6 @@ int NotifyChange_NotifyType(dm_req_t *req, char *value)
     subs_notify_t new_notify_type;
     subs_notify_t cur_notify_type;
     subs_t *sub;
-    char source_path[MAX_DM_PATH];
 
     // Convert this parameter's value to the notify type enumeration
     new_notify_type = TEXT_UTILS_StringToEnum(value, notify_types, NUM_ELEM(notify_types));
@@ -930,15 +1358,19 @@ int NotifyChange_NotifyType(dm_req_t *req, char *value)
     {
         cur_notify_type = sub->notify_type;
         sub->notify_type = new_notify_type;
+        event_index.is_valid = false;
 
-        // Get the initial value of all parameters, if this is an enabled subscription which has just changed to be a value change subscription
         if ((sub->enable == true) && (cur_notify_type != kSubNotifyType_ValueChange)
                                   && (new_notify_type == kSubNotifyType_ValueChange))
         {
-            USP_SNPRINTF(source_path, sizeof(source_path), "%s.%d", device_subs_root, sub->instance);
-            GetAllPathExpressionParameterValues(sub, &sub->path_expressions, &sub->last_values, source_path);
+            // Get the initial value of all parameters, if this is an enabled subscription which has just changed to be a value change subscription
+            RebuildWatchTable();
+        }
+        else if (new_notify_type != kSubNotifyType_ValueChange)
+        {
+            // Stop watching all parameters, if this is no longer a value change subscription
+            UnwatchSubscription(sub->instance);
         }
-
     }
     return USP_ERR_OK;
 }
@@ -995,8 +1427,14 @@ int NotifyChange_SubsRefList(dm_req_t *req, char *value)
     STR_VECTOR_Destroy(&sub->path_expressions);
 
     // Then add this new set of path expressions
-    // These will take effect at the next poll interval
     TEXT_UTILS_SplitString(value, &sub->path_expressions, ",");
+    event_index.is_valid = false;
+
+    // Update the parameters watched, getting the initial value of any newly watched parameters, if this is an enabled value change subscription
+    if ((sub->enable) && (sub->notify_type == kSubNotifyType_ValueChange))
+    {
+        RebuildWatchTable();
+    }
 
     return USP_ERR_OK;
 }
@@ -1685,165 +2123,1129 @@ exit:
 ** ProcessAllValueChangeSubscriptions
 **
 ** Called to Periodically poll all value change notifications
+** Each watched parameter is read and compared only once, even if it is watched by more than one subscription
+** Only the parameters which are due to be polled are read, and reading stops once VALUE_CHANGE_POLL_BUDGET has been used up
 **
-** \param   timer - pointer to timer which initiated this call
+** \param   is_full_poll - set if the values of all parameters should be read, including database parameters whose value changes are pushed
 **
-** \return  None
+** \return  true if all parameters which were due have been polled, false if some are still pending
+**
+**************************************************************************/
+bool ProcessAllValueChangeSubscriptions(bool is_full_poll)
+{
+    int i;
+    unsigned now;
+    watched_param_t *wp;
+    bool is_complete;
+
+    // Re-resolve the paths of all watched parameters, if object instances have been added or deleted since they were last resolved
+    // Paths containing search expressions or reference follows may also resolve differently when parameter values change,
+    // so are re-resolved every VALUE_CHANGE_POLL_PERIOD, but not when continuing a poll which ran out of time budget
+    now = tu_uptime_secs();
+    if ((watch_table.instances_generation != DM_PRIV_GetInstancesGeneration()) ||
+        ((watch_table.has_dynamic_paths) && (is_value_change_poll_pending == false) && (now - watch_table.rebuild_time >= VALUE_CHANGE_POLL_PERIOD)))
+    {
+        RebuildWatchTable();
+        now = tu_uptime_secs();
+    }
+
+    // Mark the parameters which must be read now, regardless of their schedule
+    // All parameters are read by the first poll. Database parameters are only read by a full poll
+    for (i=0; i < watch_table.num_params; i++)
+    {
+        wp = &watch_table.params[i];
+        if ((is_value_change_polling_started == false) || ((is_full_poll) && (wp->is_db_param)))
+        {
+            wp->next_poll_time = now;
+        }
+    }
+
+    // Read the watched parameters which are due, sending notifications for those whose value has changed
+    is_complete = PollDueWatchedParams(now);
+    is_value_change_poll_pending = (is_complete) ? false : true;
+
+    return is_complete;
+}
+
+/*********************************************************************//**
+**
+** IsAnyValueChangeSubscriptionEnabled
+**
+** Determines whether any value change subscriptions are enabled
+**
+** \param   None
+**
+** \return  true if at least one value change subscription is enabled
 **
 **************************************************************************/
-void ProcessAllValueChangeSubscriptions(void)
+bool IsAnyValueChangeSubscriptionEnabled(void)
 {
     int i;
     subs_t *sub;
 
-    // Iterate over all enabled subscriptions, processing each value change subscription
     for (i=0; i < subscriptions.num_entries; i++)
     {
         sub = &subscriptions.vector[i];
         if ((sub->enable) && (sub->notify_type == kSubNotifyType_ValueChange))
         {
-            ProcessValueChangeSubscription(sub);
+            return true;
         }
     }
+
+    return false;
 }
 
 /*********************************************************************//**
 **
-** ProcessValueChangeSubscription
+** ClearPushedValueChanges
 **
-** Processes one enabled subscription for value change
+** Empties the queue of database parameters which have been set
 **
-** \param   sub - pointer to subscription to poll
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void ClearPushedValueChanges(void)
+{
+    STR_VECTOR_Destroy(&pushed_value_changes);
+    is_pushed_value_changes_overflow = false;
+}
+
+/*********************************************************************//**
+**
+** RebuildWatchTable
+**
+** Resolves the path expressions of all enabled value change subscriptions, updating the table of watched parameters
+** Parameters which have started being watched are read, to get their initial value
+** Parameters which are no longer watched by any subscription are removed from the table
+**
+** \param   None
 **
 ** \return  None
 **
 **************************************************************************/
-void ProcessValueChangeSubscription(subs_t *sub)
+void RebuildWatchTable(void)
 {
     int i;
-    kv_vector_t cur_values;
-    kv_pair_t *pair;
-    int index;
-    int hint_index;
-    char *value;
-    char source_path[MAX_DM_PATH];
+    subs_t *sub;
+    watched_param_t *wp;
+    watch_rebuild_t rb;
 
-    // Get the current values of all parameters associated with this subscription
-    USP_SNPRINTF(source_path, sizeof(source_path), "%s.%d", device_subs_root, sub->instance);
-    GetAllPathExpressionParameterValues(sub, &sub->path_expressions, &cur_values, source_path);
-    
-    // Determine whether any of the values have changed from last time
-    hint_index = 0;
-    for (i=0; i < cur_values.num_entries; i++)
+    // Remember which subscriptions were watching each parameter, then start with no subscriptions watching any parameter
+    rb.num_prev_params = watch_table.num_params;
+    rb.prev_subs_sets = USP_MALLOC((watch_table.num_params+1)*sizeof(int));
+    for (i=0; i < watch_table.num_params; i++)
     {
-        pair = &cur_values.vector[i];
+        wp = &watch_table.params[i];
+        rb.prev_subs_sets[i] = wp->subs_set;
+        wp->subs_set = 0;
+    }
+    rb.prev_sets = watch_table.subs_sets;
+    rb.num_prev_sets = watch_table.num_subs_sets;
+    InitSubsSets();
 
-        // Find the index in the last_values vector matching this parameter
-        // NOTE: We pass in a hint based on where we expect to find the matching parameter
-        // This hint will be a perfect match if the list of parameters generated by the path expressions have not changed since last time
-        index = KV_VECTOR_FindKey(&sub->last_values, pair->key, hint_index);
-        if (index != INVALID)
+    // Add the parameters watched by all enabled value change subscriptions
+    watch_table.has_dynamic_paths = false;
+    for (i=0; i < subscriptions.num_entries; i++)
+    {
+        sub = &subscriptions.vector[i];
+        if ((sub->enable) && (sub->notify_type == kSubNotifyType_ValueChange))
         {
-            hint_index = index + 1;         // Calculate index for next hint
-            value = sub->last_values.vector[index].value;
-
-            if (strcmp(value, pair->value) != 0)
+            WatchSubscriptionParams(sub, &rb);
+            if (HasDynamicPathExpressions(&sub->path_expressions))
             {
-                // The value has changed since last time, so send a Value Change NotifyRequest
-                SendValueChangeNotify(sub, pair->key, pair->value);
+                watch_table.has_dynamic_paths = true;
             }
         }
-        else
-        {
-            // If we do not have a value for the parameter from last time, then this does not trigger a value change
-        }
-
     }
 
-    // Finally, replace the last set of values with the current set
-    KV_VECTOR_Destroy(&sub->last_values);
-    memcpy(&sub->last_values, &cur_values, sizeof(kv_vector_t));
+    // Read the parameters which subscriptions have started watching
+    SampleNewlyWatchedParams(&rb);
+
+    USP_FREE(rb.prev_subs_sets);
+    DestroySubsSets(rb.prev_sets, rb.num_prev_sets);
+    RemoveUnwatchedParams();
+
+    // NOTE: The generation is read after the parameters have been read, in case reading them added any object instances
+    watch_table.instances_generation = DM_PRIV_GetInstancesGeneration();
+    watch_table.rebuild_time = tu_uptime_secs();
 }
 
 /*********************************************************************//**
 **
-** GetAllPathExpressionParameterValues
+** WatchSubscriptionParams
 **
-** Gets all of the parameters and their values associated with a set of path expressions
+** Adds all parameters resolved from the path expressions of the specified subscription to the table of watched parameters
 **
-** \param   sub - pointer to subscription
-** \param   path_expressions - vector of path expressions to get the values of
-** \param   param_values - vector in which parameter values are returned (key=parameter name, value=parameter value)
-**                         NOTE: This function overwrites any contents in this vector
-** \param   source_path - string naming the table entry that the path expression came from. Used only for debug.
+** \param   sub - pointer to value change subscription
+** \param   rb - pointer to state describing the watch table before it was rebuilt
 **
 ** \return  None
 **
 **************************************************************************/
-void GetAllPathExpressionParameterValues(subs_t *sub, str_vector_t *path_expressions, kv_vector_t *param_values, char *source_path)
+void WatchSubscriptionParams(subs_t *sub, watch_rebuild_t *rb)
 {
     int i;
-    int err;
+    int index;
+    char *path;
+    watched_param_t *wp;
     str_vector_t params;
-    kv_pair_t *pair;
-    char buf[MAX_DM_VALUE_LEN];
-
-    // Form a vector list containing all the parameters to get the value of
-    ResolveAllPathExpressions(source_path, path_expressions, &params, kResolveOp_SubsValChange, sub->cont_instance);
+    int_vector_t *prev_subs;
+    int last_set = INVALID;
+    int last_new_set = INVALID;
+    char source_path[MAX_DM_PATH];
 
-    // Convert the vector list into the keys in a key-value pair vector.
-    // NOTE: We do not have to call STR_VECTOR_Destroy(&params) because STR_VECTOR_ConvertToKeyValueVector() destroys the string vector
-    STR_VECTOR_ConvertToKeyValueVector(&params, param_values);
+    // Form a vector list containing all the parameters associated with this subscription
+    USP_SNPRINTF(source_path, sizeof(source_path), "%s.%d", device_subs_root, sub->instance);
+    ResolveAllPathExpressions(source_path, &sub->path_expressions, &params, kResolveOp_SubsValChange, sub->cont_instance);
 
-    // Iterate over all parameters in the key-value pair vector, getting their values from the data model
-    for (i=0; i < param_values->num_entries; i++)
+    for (i=0; i < params.num_entries; i++)
     {
-        pair = &param_values->vector[i];
-        USP_ASSERT(pair->value == NULL);
+        // Find the parameter in the table, adding it, if it is not already being watched
+        path = params.vector[i];
+        index = FindWatchedParam(path, (unsigned)TEXT_UTILS_CalcHash(path));
+        if (index == INVALID)
+        {
+            index = AddWatchedParam(path, (unsigned)TEXT_UTILS_CalcHash(path));
+        }
+        wp = &watch_table.params[index];
 
-        // Get the value of the parameter.
-        buf[0] = '\0';
-        err = DATA_MODEL_GetParameterValue(pair->key, buf, sizeof(buf), 0);
-        if (err == USP_ERR_OK)
+        // Add this subscription to the set watching this parameter
+        // NOTE: Most parameters are watched by the same set of subscriptions, so the last set added to is remembered
+        if (wp->subs_set != last_set)
         {
-            pair->value = USP_STRDUP(buf);
+            last_set = wp->subs_set;
+            last_new_set = AddToSubsSet(last_set, sub->instance);
         }
-        else
+
+        // Skip if this subscription has already been added as watching this parameter (ie the parameter was resolved by more than one path expression)
+        if (last_new_set == wp->subs_set)
+        {
+            continue;
+        }
+        wp->subs_set = last_new_set;
+
+        // Mark the parameter as needing to be read, if this subscription was not watching it before
+        prev_subs = (index < rb->num_prev_params) ? &rb->prev_sets[ rb->prev_subs_sets[index] ] : NULL;
+        if ((prev_subs == NULL) || (INT_VECTOR_Find(prev_subs, sub->instance) == INVALID))
         {
-            // Intentionally ignoring errors by returning an empty string if they occur
-            pair->value = USP_STRDUP("");
+            wp->needs_sample = true;
         }
     }
+
+    STR_VECTOR_Destroy(&params);
 }
 
 /*********************************************************************//**
 **
-** ResolveAllPathExpressions
+** SampleNewlyWatchedParams
 **
-** Creates a single list of resolved paths, given a list of path expressions
+** Reads the parameters which subscriptions have started watching whilst rebuilding the table of watched parameters
 **
-** \param   source_path - string naming the table entry that the path expression came from. Used only for debug.
-** \param   path_expressions - list of path expressions to resolve
-** \param   resolved_paths - pointer to string vector in which to return all resolved path expressions
-** \param   op - Operation being performed
-** \param   cont_instance - Controller Instance number - used to determine the role to use for the recipient controller
+** \param   rb - pointer to state describing the watch table before it was rebuilt
 **
 ** \return  None
 **
 **************************************************************************/
-void ResolveAllPathExpressions(char *source_path, str_vector_t *path_expressions, str_vector_t *resolved_paths, resolve_op_t op, int cont_instance)
+void SampleNewlyWatchedParams(watch_rebuild_t *rb)
 {
-    char *expr;
     int i;
-    int err;
-    combined_role_t combined_role;
-
-    // Default to no resolved paths
-    STR_VECTOR_Init(resolved_paths);
+    int_vector_t indexes;
 
-    // Exit if we cannot retrieve the role to use for this endpoint
-    err = DEVICE_CONTROLLER_GetCombinedRole(cont_instance, &combined_role);
-    if (err != USP_ERR_OK)
+    INT_VECTOR_Init(&indexes);
+    for (i=0; i < watch_table.num_params; i++)
+    {
+        if (watch_table.params[i].needs_sample)
+        {
+            INT_VECTOR_Add(&indexes, i);
+        }
+    }
+
+    ReadWatchedParamList(&indexes, rb);
+    INT_VECTOR_Destroy(&indexes);
+}
+
+/*********************************************************************//**
+**
+** PollDueWatchedParams
+**
+** Reads the watched parameters which are due to be polled, sending a notification for each whose value has changed
+** The search for due parameters continues from where the last call stopped, so that all parameters are polled fairly
+** Parameters are polled until the sum of their measured get times would exceed VALUE_CHANGE_POLL_BUDGET,
+** so that polling does not hold up the processing of USP messages for too long
+**
+** \param   now - current time (in seconds, from tu_uptime_secs)
+**
+** \return  true if all parameters which were due have been polled, false if some are still pending
+**
+**************************************************************************/
+bool PollDueWatchedParams(unsigned now)
+{
+    int i;
+    int index;
+    watched_param_t *wp;
+    int_vector_t due;
+    unsigned cost = 0;
+    bool is_complete = true;
+
+    if (watch_table.poll_cursor >= watch_table.num_params)
+    {
+        watch_table.poll_cursor = 0;
+    }
+
+    // Form a list of the parameters which are due, in table order, starting from the cursor
+    INT_VECTOR_Init(&due);
+    index = watch_table.poll_cursor;
+    for (i=0; i < watch_table.num_params; i++)
+    {
+        wp = &watch_table.params[index];
+        if (wp->next_poll_time <= now)
+        {
+            // Stop if the budget has been used up, continuing from this parameter next time
+            // NOTE: At least one parameter is always polled, so that polling always makes progress
+            if ((due.num_entries > 0) && (cost + wp->get_cost > VALUE_CHANGE_POLL_BUDGET*1000))
+            {
+                watch_table.poll_cursor = index;
+                is_complete = false;
+                break;
+            }
+
+            INT_VECTOR_Add(&due, index);
+            cost += wp->get_cost;
+        }
+
+        index++;
+        if (index >= watch_table.num_params)
+        {
+            index = 0;
+        }
+    }
+
+    ReadWatchedParamList(&due, NULL);
+    INT_VECTOR_Destroy(&due);
+
+    return is_complete;
+}
+
+/*********************************************************************//**
+**
+** ReadWatchedParamList
+**
+** Reads the values of the specified watched parameters, sending a notification for each whose value has changed since it was last read
+** Parameter values are read into a single buffer (rather than allocated), except for grouped vendor parameters,
+** which are got together using a single call to each group's vendor hook
+** The time taken to get each parameter is measured, to determine how often it is polled
+**
+** \param   indexes - indexes of the entries in the table of watched parameters to read
+** \param   rb - pointer to state describing the watch table before it was rebuilt, if only the parameters which subscriptions
+**               have started watching are being read, or NULL if polling
+**
+** \return  None
+**
+**************************************************************************/
+void ReadWatchedParamList(int_vector_t *indexes, watch_rebuild_t *rb)
+{
+    int i, j;
+    int err;
+    char *value;
+    watched_param_t *wp;
+    kv_vector_t grouped;
+    uint64_t start_time;
+    unsigned grouped_cost = 0;
+    unsigned cost;
+    char buf[MAX_DM_VALUE_LEN];
+
+    // Form a vector referencing the paths of the grouped vendor parameters to read
+    grouped.vector = NULL;
+    grouped.num_entries = 0;
+    for (i=0; i < indexes->num_entries; i++)
+    {
+        wp = &watch_table.params[ indexes->vector[i] ];
+        if (wp->is_grouped)
+        {
+            if (grouped.vector == NULL)
+            {
+                grouped.vector = USP_MALLOC(indexes->num_entries * sizeof(kv_pair_t));
+            }
+            grouped.vector[grouped.num_entries].key = WATCHED_PARAM_PATH(wp);
+            grouped.vector[grouped.num_entries].value = NULL;
+            grouped.num_entries++;
+        }
+    }
+
+    // Get the values of the grouped vendor parameters, sharing the time taken between them
+    // Intentionally ignoring errors. Parameters which could not be got are returned as an empty string
+    if (grouped.num_entries > 0)
+    {
+        start_time = tu_uptime_usecs();
+        (void)DATA_MODEL_GetParameterValues(&grouped, 0);
+        grouped_cost = (unsigned)((tu_uptime_usecs() - start_time) / grouped.num_entries);
+    }
+
+    // Read all other parameters, and update all parameters, in the order given
+    j = 0;
+    for (i=0; i < indexes->num_entries; i++)
+    {
+        wp = &watch_table.params[ indexes->vector[i] ];
+        if (wp->is_grouped)
+        {
+            value = grouped.vector[j++].value;
+            cost = grouped_cost;
+        }
+        else
+        {
+            // NOTE: Parameters which could not be got are treated as an empty string
+            start_time = tu_uptime_usecs();
+            err = DATA_MODEL_GetParameterValue(WATCHED_PARAM_PATH(wp), buf, sizeof(buf), 0);
+            cost = (unsigned)(tu_uptime_usecs() - start_time);
+            if (err != USP_ERR_OK)
+            {
+                buf[0] = '\0';
+            }
+            value = buf;
+        }
+
+        // Update the estimated get time. This rises immediately (so that the poll budget is not overrun), but falls slowly
+        cost = MIN(cost, MAX_WATCH_GET_COST);
+        wp->get_cost = ((wp->has_value) && (cost < wp->get_cost)) ? (3*wp->get_cost + cost)/4 : cost;
+
+        UpdateWatchedParam(indexes->vector[i], value, rb);
+    }
+
+    // Free the values of the grouped vendor parameters (the keys are only referenced, so are not freed here)
+    for (j=0; j < grouped.num_entries; j++)
+    {
+        USP_SAFE_FREE(grouped.vector[j].value);
+    }
+    USP_SAFE_FREE(grouped.vector);
+}
+
+/*********************************************************************//**
+**
+** UpdateWatchedParam
+**
+** Compares the value just read for a watched parameter against its last value, sending a notification
+** to the subscriptions watching it if the value has changed, then remembers the value for next time
+** Whilst rebuilding, only subscriptions which were already watching the parameter are notified (and only once polling has started),
+** as they would have been by the next poll
+** Finally schedules when the parameter is next polled. Parameters which are expensive to get are polled less often whilst their value is unchanged
+**
+** \param   index - index of the entry in the table of watched parameters
+** \param   value - value of the parameter just read
+** \param   rb - pointer to state describing the watch table before it was rebuilt, or NULL if polling
+**
+** \return  None
+**
+**************************************************************************/
+void UpdateWatchedParam(int index, char *value, watch_rebuild_t *rb)
+{
+    watched_param_t *wp;
+    unsigned long long digest;
+
+    wp = &watch_table.params[index];
+    digest = CalcValueDigest(value);
+    if ((wp->has_value) && (digest != wp->last_value_digest))
+    {
+        if (rb == NULL)
+        {
+            SendValueChangeNotifyToWatchers(wp, value, NULL);
+        }
+        else if ((is_value_change_polling_started) && (index < rb->num_prev_params))
+        {
+            SendValueChangeNotifyToWatchers(wp, value, &rb->prev_sets[ rb->prev_subs_sets[index] ]);
+        }
+    }
+
+    // Adapt the poll period of the parameter. Database parameters are not polled, because their value changes are pushed
+    if (wp->is_db_param)
+    {
+        wp->next_poll_time = WATCH_NOT_SCHEDULED;
+    }
+    else
+    {
+        if ((wp->has_value == false) || (digest != wp->last_value_digest))
+        {
+            wp->poll_period = VALUE_CHANGE_POLL_PERIOD;
+        }
+        else if (wp->get_cost >= VALUE_CHANGE_EXPENSIVE_GET_TIME)
+        {
+            wp->poll_period = MIN(2*wp->poll_period, MAX(VALUE_CHANGE_MAX_POLL_PERIOD, VALUE_CHANGE_POLL_PERIOD));
+        }
+        wp->next_poll_time = CalcNextPollTime(wp, tu_uptime_secs());
+    }
+
+    wp->last_value_digest = digest;
+    wp->has_value = true;
+    wp->needs_sample = false;
+}
+
+/*********************************************************************//**
+**
+** CalcNextPollTime
+**
+** Calculates the time at which the specified watched parameter is next due to be polled
+** Each parameter is polled at a phase within its poll period derived from the hash of its path,
+** so that polling of parameters with the same poll period is spread evenly over the period
+**
+** \param   wp - pointer to entry in the table of watched parameters
+** \param   now - current time (in seconds, from tu_uptime_secs)
+**
+** \return  time (in seconds, from tu_uptime_secs) at which the parameter is next due to be polled
+**
+**************************************************************************/
+unsigned CalcNextPollTime(watched_param_t *wp, unsigned now)
+{
+    unsigned period;
+    unsigned phase;
+
+    period = MAX(wp->poll_period, 1);
+    phase = wp->hash % period;
+
+    return now + period - ((now + phase) % period);
+}
+
+/*********************************************************************//**
+**
+** UnwatchSubscription
+**
+** Removes the specified subscription from all parameters in the table of watched parameters
+** Parameters which are no longer watched by any subscription are removed from the table
+**
+** \param   instance - instance number of the subscription in the data model
+**
+** \return  None
+**
+**************************************************************************/
+void UnwatchSubscription(int instance)
+{
+    int i;
+    watched_param_t *wp;
+    int last_set = INVALID;
+    int last_new_set = INVALID;
+
+    for (i=0; i < watch_table.num_params; i++)
+    {
+        // NOTE: Most parameters are watched by the same set of subscriptions, so the last set removed from is remembered
+        wp = &watch_table.params[i];
+        if (wp->subs_set != last_set)
+        {
+            last_set = wp->subs_set;
+            last_new_set = RemoveFromSubsSet(last_set, instance);
+        }
+        wp->subs_set = last_new_set;
+    }
+
+    RemoveUnwatchedParams();
+}
+
+/*********************************************************************//**
+**
+** RemoveUnwatchedParams
+**
+** Removes all parameters which are not watched by any subscription from the table of watched parameters,
+** along with their paths and any sets of subscriptions which are no longer used
+** NOTE: The order of the remaining parameters is preserved
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void RemoveUnwatchedParams(void)
+{
+    int i;
+    int len;
+    int num_kept;
+    int num_sets_kept;
+    int *set_map;
+    char *new_pool;
+    int new_pool_len;
+    watched_param_t *wp;
+
+    // Exit if all parameters are still watched
+    for (i=0; i < watch_table.num_params; i++)
+    {
+        if (watch_table.params[i].subs_set == 0)
+        {
+            break;
+        }
+    }
+
+    if (i == watch_table.num_params)
+    {
+        return;
+    }
+
+    // Copy down all entries which are still being watched, and their paths
+    new_pool = USP_MALLOC(watch_table.path_pool_len+1);
+    new_pool_len = 0;
+    num_kept = 0;
+    for (i=0; i < watch_table.num_params; i++)
+    {
+        wp = &watch_table.params[i];
+        if (wp->subs_set != 0)
+        {
+            len = strlen(WATCHED_PARAM_PATH(wp)) + 1;
+            memcpy(&new_pool[new_pool_len], WATCHED_PARAM_PATH(wp), len);
+            wp->path_offset = new_pool_len;
+            new_pool_len += len;
+            watch_table.params[num_kept++] = *wp;
+        }
+    }
+    USP_FREE(watch_table.path_pool);
+    watch_table.path_pool = new_pool;
+    watch_table.path_pool_len = new_pool_len;
+    watch_table.path_pool_size = watch_table.path_pool_len+1;
+    watch_table.num_params = num_kept;
+    watch_table.poll_cursor = 0;
+
+    // Remove all sets of subscriptions which are no longer used (apart from the empty set, which is always set 0)
+    set_map = USP_MALLOC(watch_table.num_subs_sets*sizeof(int));
+    for (i=0; i < watch_table.num_subs_sets; i++)
+    {
+        set_map[i] = INVALID;
+    }
+    set_map[0] = 0;
+
+    for (i=0; i < watch_table.num_params; i++)
+    {
+        set_map[ watch_table.params[i].subs_set ] = 0;
+    }
+
+    num_sets_kept = 1;
+    for (i=1; i < watch_table.num_subs_sets; i++)
+    {
+        if (set_map[i] == INVALID)
+        {
+            INT_VECTOR_Destroy(&watch_table.subs_sets[i]);
+        }
+        else
+        {
+            watch_table.subs_sets[num_sets_kept] = watch_table.subs_sets[i];
+            set_map[i] = num_sets_kept++;
+        }
+    }
+    watch_table.num_subs_sets = num_sets_kept;
+
+    for (i=0; i < watch_table.num_params; i++)
+    {
+        wp = &watch_table.params[i];
+        wp->subs_set = set_map[wp->subs_set];
+    }
+    USP_FREE(set_map);
+
+    // Rebuild the hash table, as the indexes of the entries have changed
+    RehashWatchTable(watch_table.num_buckets);
+}
+
+/*********************************************************************//**
+**
+** FindWatchedParam
+**
+** Finds the specified parameter in the table of watched parameters
+**
+** \param   path - data model path of the parameter
+** \param   hash - hash of the path
+**
+** \return  index of entry in the table, or INVALID if the parameter is not being watched
+**
+**************************************************************************/
+int FindWatchedParam(char *path, unsigned hash)
+{
+    int index;
+    watched_param_t *wp;
+
+    // Exit if the table is empty
+    if (watch_table.num_buckets == 0)
+    {
+        return INVALID;
+    }
+
+    index = watch_table.buckets[ hash & (watch_table.num_buckets-1) ];
+    while (index != INVALID)
+    {
+        wp = &watch_table.params[index];
+        if ((wp->hash == hash) && (strcmp(WATCHED_PARAM_PATH(wp), path) == 0))
+        {
+            return index;
+        }
+        index = wp->next_in_bucket;
+    }
+
+    return INVALID;
+}
+
+/*********************************************************************//**
+**
+** AddWatchedParam
+**
+** Adds the specified parameter to the end of the table of watched parameters
+** The parameter is initially not watched by any subscription, and has no value
+** NOTE: This may move the entries of the table, invalidating any pointers to them
+**
+** \param   path - data model path of the parameter
+** \param   hash - hash of the path
+**
+** \return  index of new entry in the table
+**
+**************************************************************************/
+int AddWatchedParam(char *path, unsigned hash)
+{
+    int index;
+    int len;
+    int bucket;
+    watched_param_t *wp;
+
+    // Create the hash table, or increase its size, if necessary, keeping the average bucket chain length below 1
+    if (watch_table.num_buckets == 0)
+    {
+        RehashWatchTable(WATCH_TABLE_INITIAL_BUCKETS);
+    }
+    else if (watch_table.num_params >= watch_table.num_buckets)
+    {
+        RehashWatchTable(2*watch_table.num_buckets);
+    }
+
+    // Increase the size of the array of entries, if necessary
+    if (watch_table.num_params >= watch_table.max_params)
+    {
+        watch_table.max_params = (watch_table.max_params == 0) ? WATCH_TABLE_INITIAL_BUCKETS : 2*watch_table.max_params;
+        watch_table.params = USP_REALLOC(watch_table.params, watch_table.max_params*sizeof(watched_param_t));
+    }
+
+    // Add the path to the path pool, increasing its size, if necessary
+    len = strlen(path) + 1;
+    if (watch_table.path_pool_len + len > watch_table.path_pool_size)
+    {
+        watch_table.path_pool_size = 2*(watch_table.path_pool_size + len);
+        watch_table.path_pool = USP_REALLOC(watch_table.path_pool, watch_table.path_pool_size);
+    }
+    memcpy(&watch_table.path_pool[watch_table.path_pool_len], path, len);
+
+    // Fill in the entry
+    index = watch_table.num_params;
+    wp = &watch_table.params[index];
+    memset(wp, 0, sizeof(watched_param_t));
+    wp->path_offset = watch_table.path_pool_len;
+    wp->hash = hash;
+    wp->subs_set = 0;
+    wp->has_value = false;
+    wp->is_db_param = DATA_MODEL_IsDatabaseParam(path);
+    wp->is_grouped = DATA_MODEL_IsGroupedVendorParam(path);
+    wp->needs_sample = false;
+    wp->next_poll_time = 0;
+    wp->poll_period = VALUE_CHANGE_POLL_PERIOD;
+    wp->get_cost = 0;
+    watch_table.path_pool_len += len;
+    watch_table.num_params++;
+
+    // Add it to the hash table
+    bucket = hash & (watch_table.num_buckets-1);
+    wp->next_in_bucket = watch_table.buckets[bucket];
+    watch_table.buckets[bucket] = index;
+
+    return index;
+}
+
+/*********************************************************************//**
+**
+** RehashWatchTable
+**
+** Rebuilds the hash table of watched parameters, with the specified number of buckets
+**
+** \param   num_buckets - number of buckets in the hash table. This must be a power of 2
+**
+** \return  None
+**
+**************************************************************************/
+void RehashWatchTable(int num_buckets)
+{
+    int i;
+    int bucket;
+    watched_param_t *wp;
+
+    USP_SAFE_FREE(watch_table.buckets);
+    watch_table.buckets = USP_MALLOC(num_buckets*sizeof(int));
+    watch_table.num_buckets = num_buckets;
+    for (i=0; i < num_buckets; i++)
+    {
+        watch_table.buckets[i] = INVALID;
+    }
+
+    // Add all entries to the new hash table
+    for (i=0; i < watch_table.num_params; i++)
+    {
+        wp = &watch_table.params[i];
+        bucket = wp->hash & (num_buckets-1);
+        wp->next_in_bucket = watch_table.buckets[bucket];
+        watch_table.buckets[bucket] = i;
+    }
+}
+
+/*********************************************************************//**
+**
+** CalcWatchTableSize
+**
+** Calculates the memory allocated by the table of watched parameters
+**
+** \param   None
+**
+** \return  number of bytes allocated by the table
+**
+**************************************************************************/
+unsigned CalcWatchTableSize(void)
+{
+    int i;
+    unsigned size;
+
+    size = watch_table.max_params*sizeof(watched_param_t) + watch_table.num_buckets*sizeof(int) + watch_table.path_pool_size;
+    size += watch_table.num_subs_sets*sizeof(int_vector_t);
+    for (i=0; i < watch_table.num_subs_sets; i++)
+    {
+        size += watch_table.subs_sets[i].num_entries*sizeof(int);
+    }
+
+    return size;
+}
+
+/*********************************************************************//**
+**
+** InitSubsSets
+**
+** Initialises the sets of subscriptions watching parameters, to contain only the empty set (as set 0)
+** NOTE: The caller is responsible for freeing any previous sets
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void InitSubsSets(void)
+{
+    watch_table.subs_sets = USP_MALLOC(sizeof(int_vector_t));
+    INT_VECTOR_Init(&watch_table.subs_sets[0]);
+    watch_table.num_subs_sets = 1;
+}
+
+/*********************************************************************//**
+**
+** AddToSubsSet
+**
+** Determines the set of subscriptions formed by adding the specified subscription to the specified set
+**
+** \param   set - index of set of subscriptions
+** \param   instance - instance number of subscription to add
+**
+** \return  index of set of subscriptions including the specified subscription
+**
+**************************************************************************/
+int AddToSubsSet(int set, int instance)
+{
+    int_vector_t *subs;
+    int *instances;
+    int num_instances;
+    int new_set;
+
+    // Exit if the subscription is already in the set
+    subs = &watch_table.subs_sets[set];
+    if (INT_VECTOR_Find(subs, instance) != INVALID)
+    {
+        return set;
+    }
+
+    // Form the new set, appending the subscription
+    // NOTE: The set is copied because the array of sets may be reallocated when the new set is added
+    num_instances = subs->num_entries + 1;
+    instances = USP_MALLOC(num_instances*sizeof(int));
+    memcpy(instances, subs->vector, subs->num_entries*sizeof(int));
+    instances[num_instances-1] = instance;
+
+    new_set = FindOrAddSubsSet(instances, num_instances);
+    USP_FREE(instances);
+
+    return new_set;
+}
+
+/*********************************************************************//**
+**
+** RemoveFromSubsSet
+**
+** Determines the set of subscriptions formed by removing the specified subscription from the specified set
+**
+** \param   set - index of set of subscriptions
+** \param   instance - instance number of subscription to remove
+**
+** \return  index of set of subscriptions excluding the specified subscription
+**
+**************************************************************************/
+int RemoveFromSubsSet(int set, int instance)
+{
+    int_vector_t *subs;
+    int *instances;
+    int num_instances;
+    int index;
+    int new_set;
+
+    // Exit if the subscription is not in the set
+    subs = &watch_table.subs_sets[set];
+    index = INT_VECTOR_Find(subs, instance);
+    if (index == INVALID)
+    {
+        return set;
+    }
+
+    // Form the new set, without the subscription
+    // NOTE: The set is copied because the array of sets may be reallocated when the new set is added
+    num_instances = subs->num_entries - 1;
+    instances = USP_MALLOC((num_instances+1)*sizeof(int));
+    memcpy(instances, subs->vector, index*sizeof(int));
+    memcpy(&instances[index], &subs->vector[index+1], (num_instances-index)*sizeof(int));
+
+    new_set = FindOrAddSubsSet(instances, num_instances);
+    USP_FREE(instances);
+
+    return new_set;
+}
+
+/*********************************************************************//**
+**
+** FindOrAddSubsSet
+**
+** Finds the specified set of subscriptions, adding it if it does not already exist
+**
+** \param   instances - array of instance numbers of the subscriptions in the set
+** \param   num_instances - number of subscriptions in the set
+**
+** \return  index of set of subscriptions
+**
+**************************************************************************/
+int FindOrAddSubsSet(int *instances, int num_instances)
+{
+    int i;
+    int_vector_t *subs;
+
+    // Exit if the set already exists
+    // NOTE: There are usually only a few distinct sets, so a linear search is sufficient
+    for (i=0; i < watch_table.num_subs_sets; i++)
+    {
+        subs = &watch_table.subs_sets[i];
+        if ((subs->num_entries == num_instances) && (memcmp(subs->vector, instances, num_instances*sizeof(int)) == 0))
+        {
+            return i;
+        }
+    }
+
+    // Otherwise add the set
+    watch_table.subs_sets = USP_REALLOC(watch_table.subs_sets, (watch_table.num_subs_sets+1)*sizeof(int_vector_t));
+    subs = &watch_table.subs_sets[watch_table.num_subs_sets];
+    INT_VECTOR_Init(subs);
+    for (i=0; i < num_instances; i++)
+    {
+        INT_VECTOR_Add(subs, instances[i]);
+    }
+
+    return watch_table.num_subs_sets++;
+}
+
+/*********************************************************************//**
+**
+** DestroySubsSets
+**
+** Frees the specified array of sets of subscriptions
+**
+** \param   sets - array of sets of subscriptions
+** \param   num_sets - number of sets in the array
+**
+** \return  None
+**
+**************************************************************************/
+void DestroySubsSets(int_vector_t *sets, int num_sets)
+{
+    int i;
+
+    for (i=0; i < num_sets; i++)
+    {
+        INT_VECTOR_Destroy(&sets[i]);
+    }
+    USP_SAFE_FREE(sets);
+}
+
+/*********************************************************************//**
+**
+** DestroyWatchTable
+**
+** Frees all memory used by the table of watched parameters
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void DestroyWatchTable(void)
+{
+    USP_SAFE_FREE(watch_table.params);
+    USP_SAFE_FREE(watch_table.buckets);
+    USP_SAFE_FREE(watch_table.path_pool);
+    DestroySubsSets(watch_table.subs_sets, watch_table.num_subs_sets);
+    memset(&watch_table, 0, sizeof(watch_table));
+}
+
+/*********************************************************************//**
+**
+** SendValueChangeNotifyToWatchers
+**
+** Sends a value change notify request message to each subscription watching the specified parameter
+**
+** \param   wp - pointer to entry in the table of watched parameters
+** \param   value - new value of the parameter
+** \param   prev_subs - pointer to set of subscriptions which were watching the parameter before the table was rebuilt.
+**                      Only these subscriptions are notified. If NULL, all subscriptions watching the parameter are notified.
+**
+** \return  None
+**
+**************************************************************************/
+void SendValueChangeNotifyToWatchers(watched_param_t *wp, char *value, int_vector_t *prev_subs)
+{
+    int i;
+    int instance;
+    subs_t *sub;
+    int_vector_t *subs;
+
+    subs = &watch_table.subs_sets[wp->subs_set];
+    for (i=0; i < subs->num_entries; i++)
+    {
+        instance = subs->vector[i];
+        if ((prev_subs != NULL) && (INT_VECTOR_Find(prev_subs, instance) == INVALID))
+        {
+            continue;
+        }
+
+        sub = SUBS_VECTOR_GetSubsByInstance(&subscriptions, instance);
+        if (sub != NULL)
+        {
+            SendValueChangeNotify(sub, WATCHED_PARAM_PATH(wp), value);
+        }
+    }
+}
+
+/*********************************************************************//**
+**
+** CalcValueDigest
+**
+** Calculates a 64 bit digest of a parameter value, using the FNV1a algorithm
+** The digest is stored instead of the value, to determine whether the value has changed
+**
+** \param   value - value of the parameter
+**
+** \return  digest of the value
+**
+**************************************************************************/
+unsigned long long CalcValueDigest(char *value)
+{
+    #define OFFSET_BASIS_64 (0xCBF29CE484222325ULL)
+    #define FNV_PRIME_64 (0x100000001B3ULL)
+    unsigned long long digest = OFFSET_BASIS_64;
+    unsigned char *p;
+
+    for (p = (unsigned char *)value; *p != '\0'; p++)
+    {
+        digest ^= *p;
+        digest *= FNV_PRIME_64;
+    }
+
+    return digest;
+}
+
+/*********************************************************************//**
+**
+** HasDynamicPathExpressions
+**
+** Determines whether any of the specified path expressions contain a search expression or reference follow
+** The parameters resolved by these path expressions depend on the values of parameters,
+** rather than only on which object instances exist
+**
+** \param   path_expressions - vector of path expressions
+**
+** \return  true if any path expression is dynamic
+**
+**************************************************************************/
+bool HasDynamicPathExpressions(str_vector_t *path_expressions)
+{
+    int i;
+    char *expr;
+
+    for (i=0; i < path_expressions->num_entries; i++)
+    {
+        expr = path_expressions->vector[i];
+        if ((strchr(expr, '[') != NULL) || (strchr(expr, '+') != NULL))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*********************************************************************//**
+**
+** GetAllPathExpressionParameterValues
+**
+** Gets all of the parameters and their values associated with a set of path expressions
+**
+** \param   sub - pointer to subscription
+** \param   path_expressions - vector of path expressions to get the values of
+** \param   param_values - vector in which parameter values are returned (key=parameter name, value=parameter value)
+**                         NOTE: This function overwrites any contents in this vector
+** \param   source_path - string naming the table entry that the path expression came from. Used only for debug.
+**
+** \return  None
+**
+**************************************************************************/
+void GetAllPathExpressionParameterValues(subs_t *sub, str_vector_t *path_expressions, kv_vector_t *param_values, char *source_path)
+{
+    str_vector_t params;
+
+    // Form a vector list containing all the parameters to get the value of
+    ResolveAllPathExpressions(source_path, path_expressions, &params, kResolveOp_SubsValChange, sub->cont_instance);
+
+    // Convert the vector list into the keys in a key-value pair vector.
+    // NOTE: We do not have to call STR_VECTOR_Destroy(&params) because STR_VECTOR_ConvertToKeyValueVector() destroys the string vector
+    STR_VECTOR_ConvertToKeyValueVector(&params, param_values);
+
+    // Get the values of all parameters in the key-value pair vector from the data model
+    // Intentionally ignoring errors. Parameters which could not be got are returned as an empty string
+    (void)DATA_MODEL_GetParameterValues(param_values, 0);
+}
+
+/*********************************************************************//**
+**
+** ResolveAllPathExpressions
+**
+** Creates a single list of resolved paths, given a list of path expressions
+**
+** \param   source_path - string naming the table entry that the path expression came from. Used only for debug.
+** \param   path_expressions - list of path expressions to resolve
+** \param   resolved_paths - pointer to string vector in which to return all resolved path expressions
+** \param   op - Operation being performed
+** \param   cont_instance - Controller Instance number - used to determine the role to use for the recipient controller
+**
+** \return  None
+**
+**************************************************************************/
+void ResolveAllPathExpressions(char *source_path, str_vector_t *path_expressions, str_vector_t *resolved_paths, resolve_op_t op, int cont_instance)
+{
+    char *expr;
+    int i;
+    int err;
+    combined_role_t combined_role;
+
+    // Default to no resolved paths
+    STR_VECTOR_Init(resolved_paths);
+
+    // Exit if we cannot retrieve the role to use for this endpoint
+    err = DEVICE_CONTROLLER_GetCombinedRole(cont_instance, &combined_role);
+    if (err != USP_ERR_OK)
     {
         return;
     }
@@ -2176,21 +3578,22 @@ void SendNotify(Usp__Msg *req, subs_t *sub, char *path)
 **************************************************************************/
 void SeedLastValueChangeValues(void)
 {
-    int i;
-    subs_t *sub;
+    char *path = "Device.DeviceInfo.SoftwareVersion";
+    int index;
+    watched_param_t *wp;
     reboot_info_t info;
 
     // Get the last software version
     DEVICE_LOCAL_AGENT_GetRebootInfo(&info);
 
-    // Iterate over all enabled subscriptions, replacing the initial value of SoftwareVersion with the value
-    // before the current boot cycle
-    for (i=0; i < subscriptions.num_entries; i++)
+    // Replace the initial value of SoftwareVersion with the value before the current boot cycle, if any subscription is watching it
+    index = FindWatchedParam(path, (unsigned)TEXT_UTILS_CalcHash(path));
+    if (index != INVALID)
     {
-        sub = &subscriptions.vector[i];
-        if ((sub->enable) && (sub->notify_type == kSubNotifyType_ValueChange))
+        wp = &watch_table.params[index];
+        if (wp->has_value)
         {
-            KV_VECTOR_Replace(&sub->last_values, "Device.DeviceInfo.SoftwareVersion", info.last_software_version);
+            wp->last_value_digest = CalcValueDigest(info.last_software_version);
         }
     }
 }
@@ -2307,3 +3710,344 @@ bool HasControllerGotEventPermission(int cont_instance, char *event_name)
     return false;
 }
 
+
+/*********************************************************************//**
+**
+** UpdateEventIndex
+**
+** Rebuilds the index of the paths of events and operations referenced by enabled Event and OperationComplete subscriptions,
+** if subscriptions have changed, object instances have been added or deleted, or controller roles have changed since it was built
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void UpdateEventIndex(void)
+{
+    int i;
+    subs_t *sub;
+
+    // Exit if the index is still up to date
+    if ((event_index.is_valid) && (event_index.instances_generation == DM_PRIV_GetInstancesGeneration()) && (HaveEventIndexRolesChanged() == false))
+    {
+        return;
+    }
+
+    // Add the paths referenced by all enabled event and operation complete subscriptions
+    DestroyEventIndex();
+    for (i=0; i < subscriptions.num_entries; i++)
+    {
+        sub = &subscriptions.vector[i];
+        if ((sub->enable) && ((sub->notify_type == kSubNotifyType_Event) || (sub->notify_type == kSubNotifyType_OperationComplete)))
+        {
+            // Subscriptions on 'Device.' are matched using the controller's permissions, and subscriptions containing
+            // search expressions or reference follows may resolve to different paths without object instances being added or deleted,
+            // so these subscriptions are not indexed. Instead their path expressions are resolved each time that an event occurs
+            if ((STR_VECTOR_Find(&sub->path_expressions, "Device.") != INVALID) || (HasDynamicPathExpressions(&sub->path_expressions)))
+            {
+                INT_VECTOR_Add(&event_index.unindexed_subs, sub->instance);
+            }
+            else
+            {
+                IndexSubscriptionEvents(sub);
+            }
+        }
+    }
+
+    event_index.instances_generation = DM_PRIV_GetInstancesGeneration();
+    event_index.is_valid = true;
+}
+
+/*********************************************************************//**
+**
+** HaveEventIndexRolesChanged
+**
+** Determines whether the role of any controller owning subscriptions in the event index has changed since the index was built
+** This is necessary because path resolution only includes the events and operations that the controller has permission for
+**
+** \param   None
+**
+** \return  true if the role of any controller has changed
+**
+**************************************************************************/
+bool HaveEventIndexRolesChanged(void)
+{
+    int i;
+    int err;
+    event_index_role_t *eir;
+    combined_role_t combined_role;
+
+    for (i=0; i < event_index.num_roles; i++)
+    {
+        eir = &event_index.roles[i];
+        err = DEVICE_CONTROLLER_GetCombinedRole(eir->cont_instance, &combined_role);
+        if (err != USP_ERR_OK)
+        {
+            if (eir->has_role)
+            {
+                return true;
+            }
+        }
+        else if ((eir->has_role == false) || (combined_role.inherited != eir->combined_role.inherited) || (combined_role.assigned != eir->combined_role.assigned))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*********************************************************************//**
+**
+** IndexSubscriptionEvents
+**
+** Adds all paths resolved from the path expressions of the specified subscription to the event index
+**
+** \param   sub - pointer to event or operation complete subscription
+**
+** \return  None
+**
+**************************************************************************/
+void IndexSubscriptionEvents(subs_t *sub)
+{
+    int i;
+    int err;
+    int index;
+    resolve_op_t op;
+    int_vector_t *iv;
+    event_index_role_t *eir;
+    str_vector_t resolved_paths;
+
+    // Remember the role of the controller owning this subscription, if not already remembered
+    for (i=0; i < event_index.num_roles; i++)
+    {
+        if (event_index.roles[i].cont_instance == sub->cont_instance)
+        {
+            break;
+        }
+    }
+
+    if (i == event_index.num_roles)
+    {
+        event_index.roles = USP_REALLOC(event_index.roles, (event_index.num_roles+1)*sizeof(event_index_role_t));
+        eir = &event_index.roles[event_index.num_roles];
+        eir->cont_instance = sub->cont_instance;
+        err = DEVICE_CONTROLLER_GetCombinedRole(sub->cont_instance, &eir->combined_role);
+        eir->has_role = (err == USP_ERR_OK) ? true : false;
+        event_index.num_roles++;
+    }
+
+    // Resolve a list of paths that the subscription references
+    // NOTE: Resolution excludes paths for which the controller does not have permission to be notified of events
+    op = (sub->notify_type == kSubNotifyType_Event) ? kResolveOp_SubsEvent : kResolveOp_SubsOper;
+    ResolveAllPathExpressions(DEVICE_SUBS_ROOT, &sub->path_expressions, &resolved_paths, op, sub->cont_instance);
+
+    // Add this subscription to the entry for each path
+    // NOTE: A path may be resolved by more than one path expression, but the subscription is only added to its entry once
+    for (i=0; i < resolved_paths.num_entries; i++)
+    {
+        index = FindOrAddEventIndexEntry(resolved_paths.vector[i]);
+        iv = &event_index.entries[index].subs;
+        if ((iv->num_entries == 0) || (iv->vector[iv->num_entries-1] != sub->instance))
+        {
+            INT_VECTOR_Add(iv, sub->instance);
+        }
+    }
+
+    STR_VECTOR_Destroy(&resolved_paths);
+}
+
+/*********************************************************************//**
+**
+** FindOrAddEventIndexEntry
+**
+** Finds the entry in the event index for the specified path, adding it, if it does not already exist
+**
+** \param   path - resolved path of the event or operation
+**
+** \return  index of the entry in the event index
+**
+**************************************************************************/
+int FindOrAddEventIndexEntry(char *path)
+{
+    int index;
+    int bucket;
+    unsigned hash;
+    event_index_entry_t *eie;
+
+    // Exit if the path is already in the index
+    hash = (unsigned)TEXT_UTILS_CalcHash(path);
+    if (event_index.num_buckets > 0)
+    {
+        index = event_index.buckets[ hash & (event_index.num_buckets-1) ];
+        while (index != INVALID)
+        {
+            eie = &event_index.entries[index];
+            if ((eie->hash == hash) && (strcmp(eie->path, path) == 0))
+            {
+                return index;
+            }
+            index = eie->next_in_bucket;
+        }
+    }
+
+    // Create the hash table, or increase its size, if necessary, keeping the average bucket chain length below 1
+    if (event_index.num_buckets == 0)
+    {
+        RehashEventIndex(EVENT_INDEX_INITIAL_BUCKETS);
+    }
+    else if (event_index.num_entries >= event_index.num_buckets)
+    {
+        RehashEventIndex(2*event_index.num_buckets);
+    }
+
+    // Increase the size of the array of entries, if necessary
+    if (event_index.num_entries >= event_index.max_entries)
+    {
+        event_index.max_entries = (event_index.max_entries == 0) ? EVENT_INDEX_INITIAL_BUCKETS : 2*event_index.max_entries;
+        event_index.entries = USP_REALLOC(event_index.entries, event_index.max_entries*sizeof(event_index_entry_t));
+    }
+
+    // Fill in the entry, and add it to the hash table
+    index = event_index.num_entries;
+    eie = &event_index.entries[index];
+    eie->path = USP_STRDUP(path);
+    eie->hash = hash;
+    INT_VECTOR_Init(&eie->subs);
+    bucket = hash & (event_index.num_buckets-1);
+    eie->next_in_bucket = event_index.buckets[bucket];
+    event_index.buckets[bucket] = index;
+    event_index.num_entries++;
+
+    return index;
+}
+
+/*********************************************************************//**
+**
+** RehashEventIndex
+**
+** Recreates the hash table of the event index with the specified number of buckets
+**
+** \param   num_buckets - number of buckets in the new hash table. This must be a power of 2
+**
+** \return  None
+**
+**************************************************************************/
+void RehashEventIndex(int num_buckets)
+{
+    int i;
+    int bucket;
+    event_index_entry_t *eie;
+
+    USP_SAFE_FREE(event_index.buckets);
+    event_index.buckets = USP_MALLOC(num_buckets*sizeof(int));
+    event_index.num_buckets = num_buckets;
+    for (i=0; i < num_buckets; i++)
+    {
+        event_index.buckets[i] = INVALID;
+    }
+
+    // Add all entries to the new hash table
+    for (i=0; i < event_index.num_entries; i++)
+    {
+        eie = &event_index.entries[i];
+        bucket = eie->hash & (num_buckets-1);
+        eie->next_in_bucket = event_index.buckets[bucket];
+        event_index.buckets[bucket] = i;
+    }
+}
+
+/*********************************************************************//**
+**
+** FindEventIndexSubs
+**
+** Finds the subscriptions in the event index which reference the specified event or operation
+**
+** \param   path - path of the event or operation in the data model that has occurred
+**
+** \return  pointer to vector of instance numbers of the subscriptions, or NULL if no indexed subscription references the path
+**
+**************************************************************************/
+int_vector_t *FindEventIndexSubs(char *path)
+{
+    int index;
+    unsigned hash;
+    event_index_entry_t *eie;
+
+    // Exit if the index is empty
+    if (event_index.num_buckets == 0)
+    {
+        return NULL;
+    }
+
+    hash = (unsigned)TEXT_UTILS_CalcHash(path);
+    index = event_index.buckets[ hash & (event_index.num_buckets-1) ];
+    while (index != INVALID)
+    {
+        eie = &event_index.entries[index];
+        if ((eie->hash == hash) && (strcmp(eie->path, path) == 0))
+        {
+            return &eie->subs;
+        }
+        index = eie->next_in_bucket;
+    }
+
+    return NULL;
+}
+
+/*********************************************************************//**
+**
+** IsSubscriptionMatchingEvent
+**
+** Determines whether the specified subscription should send a notification for the specified operation/event, using the event index
+**
+** \param   sub - pointer to subscription to match
+** \param   event_name - path of operation/event in the data model that has occurred
+** \param   indexed_subs - pointer to vector of instance numbers of indexed subscriptions referencing the operation/event, or NULL if none
+**
+** \return  true if the specified subscription matches
+**
+**************************************************************************/
+bool IsSubscriptionMatchingEvent(subs_t *sub, char *event_name, int_vector_t *indexed_subs)
+{
+    // Subscriptions which are not in the index must be matched by resolving their path expressions
+    if (INT_VECTOR_Find(&event_index.unindexed_subs, sub->instance) != INVALID)
+    {
+        return DoesSubscriptionSendNotification(sub, event_name);
+    }
+
+    if ((indexed_subs != NULL) && (INT_VECTOR_Find(indexed_subs, sub->instance) != INVALID))
+    {
+        return true;
+    }
+
+    return false;
+}
+
+/*********************************************************************//**
+**
+** DestroyEventIndex
+**
+** Frees all memory used by the event index, leaving it empty (and invalid)
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void DestroyEventIndex(void)
+{
+    int i;
+
+    for (i=0; i < event_index.num_entries; i++)
+    {
+        USP_FREE(event_index.entries[i].path);
+        INT_VECTOR_Destroy(&event_index.entries[i].subs);
+    }
+    USP_SAFE_FREE(event_index.entries);
+    USP_SAFE_FREE(event_index.buckets);
+    USP_SAFE_FREE(event_index.roles);
+    INT_VECTOR_Destroy(&event_index.unindexed_subs);
+    memset(&event_index, 0, sizeof(event_index));
+}
@@ -52,6 +52,10 @@
 #include "expr_vector.h"
 #include "nu_ipaddr.h"
 
+//------------------------------------------------------------------------------
+// Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
+bool CompareOrderedValues(long double lh_value, expr_op_t op, long double rh_value);
+
 /*********************************************************************//**
 **
 ** DM_ACCESS_GetString
@@ -901,6 +905,220 @@ int DM_ACCESS_CompareDateTime(char *lhs, expr_op_t op, char *rhs, bool *result)
     return err;
 }
 
+/*********************************************************************//**
+**
+** DM_ACCESS_CompilePredicate
+**
+** Compiles a search expression component, for comparison against the values of a parameter of the specified type
+** This converts the constant to the type of the parameter once, so that it does not have to be converted every time
+** the expression is evaluated (see DM_ACCESS_EvaluatePredicate)
+** NOTE: This function does not report errors. If the constant cannot be converted (or the operator is not supported for the type),
+**       then the error is reported when the predicate is evaluated, in the same way as the DM_ACCESS_CompareXXX() functions
+**
+** \param   type_flags - type of the parameter whose values the constant is compared against
+** \param   op - operator to use when comparing the values
+** \param   constant - string representing the right hand operand to compare. NOTE: This must exist for the lifetime of the predicate
+** \param   pred - pointer to structure in which to return the compiled predicate
+**
+** \return  None
+**
+**************************************************************************/
+void DM_ACCESS_CompilePredicate(unsigned type_flags, expr_op_t op, char *constant, expr_predicate_t *pred)
+{
+    char *endptr;
+    time_t date;
+
+    memset(pred, 0, sizeof(expr_predicate_t));
+    pred->op = op;
+    pred->constant = constant;
+
+    // Determine the type of the comparison from the type of the parameter, and convert the constant to that type
+    if (type_flags & (DM_INT | DM_UINT | DM_ULONG))
+    {
+        // NOTE: strtold() accepts the same syntax as the sscanf("%Lf") used by DM_ACCESS_CompareNumber()
+        pred->type = kExprPredicate_Number;
+        pred->number = strtold(constant, &endptr);
+        pred->is_compiled = (endptr != constant);
+    }
+    else if (type_flags & DM_BOOL)
+    {
+        // NOTE: TEXT_UTILS_StringToBool() is not used here, as it sets an error message if the constant is not a boolean
+        pred->type = kExprPredicate_Bool;
+        if ((strcasecmp(constant, "true")==0) || (strcmp(constant, "1")==0))
+        {
+            pred->boolean = true;
+            pred->is_compiled = true;
+        }
+        else if ((strcasecmp(constant, "false")==0) || (strcmp(constant, "0")==0))
+        {
+            pred->boolean = false;
+            pred->is_compiled = true;
+        }
+
+        if ((op != kExprOp_Equal) && (op != kExprOp_NotEqual))
+        {
+            pred->is_compiled = false;
+        }
+    }
+    else if (type_flags & DM_DATETIME)
+    {
+        // NOTE: TEXT_UTILS_StringToDateTime() is not used here, as it sets an error message if the constant is not a dateTime
+        pred->type = kExprPredicate_DateTime;
+        date = iso8601_to_unix_time(constant);
+        pred->number = (long double) date;
+        pred->is_compiled = (date != INVALID_TIME);
+    }
+    else
+    {
+        // Default, and also for DM_STRING
+        pred->type = kExprPredicate_String;
+        pred->is_compiled = ((op == kExprOp_Equal) || (op == kExprOp_NotEqual));
+    }
+}
+
+/*********************************************************************//**
+**
+** DM_ACCESS_EvaluatePredicate
+**
+** Compares the specified value against a compiled search expression component
+**
+** \param   pred - pointer to compiled predicate (see DM_ACCESS_CompilePredicate)
+** \param   value - string representing the left hand operand to compare (ie the value of the parameter)
+** \param   result - pointer to boolean in which to return whether the comparison matched or not
+**
+** \return  USP_ERR_OK if validated successfully
+**
+**************************************************************************/
+int DM_ACCESS_EvaluatePredicate(expr_predicate_t *pred, char *value, bool *result)
+{
+    long double lh_number;
+    bool lh_bool;
+    time_t lh_date;
+    char *endptr;
+    int err;
+
+    // If the constant could not be compiled, then use the uncompiled comparison, as this reports the error
+    if (pred->is_compiled == false)
+    {
+        switch(pred->type)
+        {
+            case kExprPredicate_Number:
+                err = DM_ACCESS_CompareNumber(value, pred->op, pred->constant, result);
+                break;
+
+            case kExprPredicate_Bool:
+                err = DM_ACCESS_CompareBool(value, pred->op, pred->constant, result);
+                break;
+
+            case kExprPredicate_DateTime:
+                err = DM_ACCESS_CompareDateTime(value, pred->op, pred->constant, result);
+                break;
+
+            default:
+            case kExprPredicate_String:
+                err = DM_ACCESS_CompareString(value, pred->op, pred->constant, result);
+                break;
+        }
+        return err;
+    }
+
+    *result = false;    // Assume that comparison failed to match
+    switch(pred->type)
+    {
+        case kExprPredicate_Number:
+            lh_number = strtold(value, &endptr);
+            if (endptr == value)
+            {
+                // Exit if the value is empty. It does not match any number
+                if (value[strspn(value, " \t\r\n")] == '\0')
+                {
+                    return USP_ERR_OK;
+                }
+
+                // Exit if the value could not be converted
+                // NOTE: This is unexpected behaviour, as the value will have previously been read from the data model
+                USP_ERR_SetMessage("%s: Expecting expression parameter's value ('%s') to be a number", __FUNCTION__, value);
+                return USP_ERR_INTERNAL_ERROR;
+            }
+            *result = CompareOrderedValues(lh_number, pred->op, pred->number);
+            break;
+
+        case kExprPredicate_Bool:
+            // Exit if the value could not be converted
+            // NOTE: This is unexpected behaviour, as the value will have previously been read from the data model
+            err = TEXT_UTILS_StringToBool(value, &lh_bool);
+            if (err != USP_ERR_OK)
+            {
+                USP_ERR_SetMessage("%s: Expecting expression parameter's value ('%s') to be a boolean", __FUNCTION__, value);
+                return USP_ERR_INTERNAL_ERROR;
+            }
+            *result = (pred->op == kExprOp_Equal) ? (lh_bool == pred->boolean) : (lh_bool != pred->boolean);
+            break;
+
+        case kExprPredicate_DateTime:
+            // Exit if the value could not be converted
+            // NOTE: This is unexpected behaviour, as the value will have previously been read from the data model
+            err = TEXT_UTILS_StringToDateTime(value, &lh_date);
+            if (err != USP_ERR_OK)
+            {
+                USP_ERR_SetMessage("%s: Expecting expression parameter's value ('%s') to be an ISO8601 dateTime", __FUNCTION__, value);
+                return USP_ERR_INTERNAL_ERROR;
+            }
+            *result = CompareOrderedValues((long double) lh_date, pred->op, pred->number);
+            break;
+
+        default:
+        case kExprPredicate_String:
+            *result = (pred->op == kExprOp_Equal) ? (strcmp(value, pred->constant) == 0) : (strcmp(value, pred->constant) != 0);
+            break;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** CompareOrderedValues
+**
+** Compares two numeric values using the specified operator
+**
+** \param   lh_value - left hand operand to compare
+** \param   op - operator to use when comparing the values
+** \param   rh_value - right hand operand to compare
+**
+** \return  true if the comparison matched
+**
+**************************************************************************/
+bool CompareOrderedValues(long double lh_value, expr_op_t op, long double rh_value)
+{
+    switch(op)
+    {
+        case kExprOp_Equal:
+            return (lh_value == rh_value);
+
+        case kExprOp_NotEqual:
+            return (lh_value != rh_value);
+
+        case kExprOp_LessThanOrEqual:
+            return (lh_value <= rh_value);
+
+        case kExprOp_GreaterThanOrEqual:
+            return (lh_value >= rh_value);
+
+        case kExprOp_LessThan:
+            return (lh_value < rh_value);
+
+        case kExprOp_GreaterThan:
+            return (lh_value > rh_value);
+
+        default:
+            TERMINATE_BAD_CASE(op);
+            break;
+    }
+
+    return false;
+}
+
 /*********************************************************************//**
 **
 ** DM_ACCESS_RestartAsyncOperation
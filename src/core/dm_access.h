@@ -49,6 +49,30 @@
 // The prefix to use when forming the default value of an Alias parameter
 #define DEFAULT_ALIAS_PREFIX "cpe-"
 
+//-------------------------------------------------------------------------
+// Type of values compared by a search expression predicate
+typedef enum
+{
+    kExprPredicate_String,
+    kExprPredicate_Number,
+    kExprPredicate_Bool,
+    kExprPredicate_DateTime,
+} expr_predicate_type_t;
+
+//-------------------------------------------------------------------------
+// Search expression component (eg 'Enable==true'), compiled for comparison against the values of a parameter of a specific type
+// The constant is converted from a string once, rather than every time that the expression is evaluated
+typedef struct
+{
+    expr_predicate_type_t type; // type of the values being compared
+    expr_op_t op;           // operator to use when comparing the values
+    char *constant;         // constant to compare against, as a string. NOTE: This is not owned by this structure
+    bool is_compiled;       // Set if the constant was converted to the type of the values, and the operator is supported for the type
+                            // If not, DM_ACCESS_EvaluatePredicate() uses the DM_ACCESS_CompareXXX() function for the type, which reports the error
+    long double number;     // converted constant, if the type is a number or dateTime
+    bool boolean;           // converted constant, if the type is a boolean
+} expr_predicate_t;
+
 //-------------------------------------------------------------------------
 // API functions
 int DM_ACCESS_GetString(char *path, char **p_str);
@@ -74,6 +98,8 @@ int DM_ACCESS_CompareString(char *lhs, expr_op_t op, char *rhs, bool *result);
 int DM_ACCESS_CompareNumber(char *lhs, expr_op_t op, char *rhs, bool *result);
 int DM_ACCESS_CompareBool(char *lhs, expr_op_t op, char *rhs, bool *result);
 int DM_ACCESS_CompareDateTime(char *lhs, expr_op_t op, char *rhs, bool *result);
+void DM_ACCESS_CompilePredicate(unsigned type_flags, expr_op_t op, char *constant, expr_predicate_t *pred);
+int DM_ACCESS_EvaluatePredicate(expr_predicate_t *pred, char *value, bool *result);
 int DM_ACCESS_RestartAsyncOperation(dm_req_t *req, int instance, bool *is_restart, int *err_code, char *err_msg, int err_msg_len, kv_vector_t *output_args);
 int DM_ACCESS_DontRestartAsyncOperation(dm_req_t *req, int instance, bool *is_restart, int *err_code, char *err_msg, int err_msg_len, kv_vector_t *output_args);
 int DM_ACCESS_PopulateAliasParam(dm_req_t *req, char *buf, int len);
@@ -0,0 +1,811 @@
+/*
+ *
+ * Copyright (C) 2019, Broadband Forum
+ * Copyright (C) 2016-2019  CommScope, Inc
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file dm_bench.c
+ *
+ * Measures the performance of data model operations on the target device (see 'dmbench' CLI command)
+ * Each benchmark runs against the agent's own data model, within a transaction which is always aborted at the end,
+ * so that the objects it creates are never committed, and no notify vendor hooks are called for them
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common_defs.h"
+#include "data_model.h"
+#include "database.h"
+#include "dm_trans.h"
+#include "dm_inst_vector.h"
+#include "device.h"
+#include "int_vector.h"
+#include "str_vector.h"
+#include "path_resolver.h"
+#include "uptime.h"
+#include "dm_bench.h"
+
+//------------------------------------------------------------------------------
+// Shape of the database cache benchmark
+#define CACHE_BENCH_INSTANCES      2000     // Number of Device.LocalAgent.Controller.{i}.BootParameter.{i} instances created
+#define CACHE_BENCH_HOT_INSTANCES  50       // Number of instances whose parameters are read repeatedly (eg by a value change poll)
+#define CACHE_BENCH_HOT_ROUNDS     1000     // Number of times the parameters of the hot instances are read
+#define CACHE_BENCH_SCAN_ROUNDS    5        // Number of times the parameters of all instances are read (eg by a Get of BootParameter.*.)
+
+//------------------------------------------------------------------------------
+// Shape of the delete benchmark
+#define DELETE_BENCH_BOOT_PARAMS   500      // Number of Device.LocalAgent.Controller.{i}.BootParameter.{i} instances in the deleted controller
+#define DELETE_BENCH_MTPS          10       // Number of Device.LocalAgent.Controller.{i}.MTP.{i} instances in the deleted controller
+
+//------------------------------------------------------------------------------
+// Shape of the value change watch table benchmark
+#define WATCH_BENCH_INSTANCES      10000    // Number of Device.LocalAgent.Controller.{i}.BootParameter.{i} instances whose ParameterName is watched
+
+//------------------------------------------------------------------------------
+// Shape of the instance scaling benchmark
+static int instances_bench_sizes[] = { 10, 1000, 10000 };   // Numbers of Device.LocalAgent.Controller.{i}.BootParameter.{i} instances measured at
+#define INSTANCES_BENCH_GETS       1000     // Number of parameter reads timed at each size
+#define INSTANCES_BENCH_ADDS       10       // Number of instances added (then deleted) at each size
+
+//------------------------------------------------------------------------------
+// Shape of the schema path resolve benchmark
+#define RESOLVE_BENCH_PATHS        1000000  // Number of randomly chosen schema paths resolved
+
+//------------------------------------------------------------------------------
+// Shape of the nested instance benchmark
+#define NESTED_BENCH_PARENTS       100      // Number of Device.LocalAgent.Controller.{i} instances
+#define NESTED_BENCH_CHILDREN      100      // Number of Device.LocalAgent.Controller.{i}.BootParameter.{i} instances in each controller
+
+//------------------------------------------------------------------------------
+// Shape of the permissions benchmark
+#define PERMS_BENCH_INSTANCES      2000     // Number of Device.LocalAgent.Controller.{i}.BootParameter.{i} instances searched by unique key
+#define PERMS_BENCH_SEARCHES       10       // Number of times the unique key search is performed
+#define PERMS_BENCH_LOOKUPS        1000000  // Number of times the permissions of a single node are looked up
+#define PERMS_BENCH_KEY_VALUE      "Device.DeviceInfo."  // ParameterName of the only instance matched by the unique key search
+
+//------------------------------------------------------------------------------
+// Benchmarks which may be run
+typedef int (*bench_func_t)(int cont_instance);
+
+typedef struct
+{
+    char *name;             // Name of the benchmark, as given to the 'dmbench' CLI command
+    bench_func_t func;      // Function which runs the benchmark
+} bench_t;
+
+//------------------------------------------------------------------------------
+// Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
+int BenchDatabaseCache(int cont_instance);
+int BenchDelete(int cont_instance);
+int BenchWatchTable(int cont_instance);
+int BenchInstances(int cont_instance);
+int BenchResolve(int cont_instance);
+int BenchNestedInstances(int cont_instance);
+int BenchPermissions(int cont_instance);
+int AddBenchBootParams(int cont_instance, int num_instances, int_vector_t *iv);
+int ReadBenchBootParams(int cont_instance, int_vector_t *iv, int num_instances, int num_rounds, uint64_t *time_taken);
+
+static bench_t dm_benchmarks[] =
+{
+    { "dbcache", BenchDatabaseCache },
+    { "delete",  BenchDelete },
+    { "watch",   BenchWatchTable },
+    { "instances", BenchInstances },
+    { "resolve", BenchResolve },
+    { "nested",  BenchNestedInstances },
+    { "perms",   BenchPermissions },
+};
+
+/*********************************************************************//**
+**
+** DM_BENCH_Run
+**
+** Runs the specified benchmark, printing the results
+** The benchmark is run on a new Device.LocalAgent.Controller instance, created within a transaction which is then aborted
+**
+** \param   name - name of the benchmark to run
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INVALID_ARGUMENTS if the benchmark is unknown
+**
+**************************************************************************/
+int DM_BENCH_Run(char *name)
+{
+    int i;
+    int err;
+    int cont_instance;
+    bench_t *bench = NULL;
+    dm_trans_vector_t trans;
+
+    // Exit if the benchmark is unknown
+    for (i=0; i < NUM_ELEM(dm_benchmarks); i++)
+    {
+        if (strcmp(dm_benchmarks[i].name, name)==0)
+        {
+            bench = &dm_benchmarks[i];
+            break;
+        }
+    }
+
+    if (bench == NULL)
+    {
+        return USP_ERR_INVALID_ARGUMENTS;
+    }
+
+    // Exit if unable to start a transaction
+    err = DM_TRANS_Start(&trans);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Create a controller to contain the objects created by the benchmark, then run the benchmark
+    // NOTE: Validate and notify vendor hooks are not called, as the controller is never committed
+    err = DATA_MODEL_AddInstance("Device.LocalAgent.Controller.", &cont_instance, 0);
+    if (err == USP_ERR_OK)
+    {
+        err = bench->func(cont_instance);
+    }
+
+    // Always abort the transaction, discarding all objects created by the benchmark
+    DM_TRANS_Abort();
+
+    return err;
+}
+
+/*********************************************************************//**
+**
+** BenchDatabaseCache
+**
+** Measures the latency of reading database parameters, and the hit ratio of the database value cache,
+** for a small set of parameters which are read repeatedly, and for a scan of more parameters than fit in the cache
+**
+** \param   cont_instance - instance number of the controller to create the benchmark's objects in
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BenchDatabaseCache(int cont_instance)
+{
+    int err;
+    int_vector_t iv;
+    uint64_t time_taken;
+    int num_reads;
+
+    // Exit if unable to create the parameters to read
+    INT_VECTOR_Init(&iv);
+    err = AddBenchBootParams(cont_instance, CACHE_BENCH_INSTANCES, &iv);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    USP_DUMP("Database cache benchmark (%d entries, %d BootParameter instances in database)", DATABASE_CACHE_ENTRIES, CACHE_BENCH_INSTANCES);
+
+    // Read a small set of parameters repeatedly, starting from a cold cache
+    DATABASE_FlushCache();
+    err = ReadBenchBootParams(cont_instance, &iv, CACHE_BENCH_HOT_INSTANCES, CACHE_BENCH_HOT_ROUNDS, &time_taken);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+    num_reads = 2*CACHE_BENCH_HOT_INSTANCES*CACHE_BENCH_HOT_ROUNDS;
+    USP_DUMP("Hot set: %d reads of %d parameters took %llu us (%.2f us/read)", num_reads, 2*CACHE_BENCH_HOT_INSTANCES,
+             (unsigned long long)time_taken, (double)time_taken/num_reads);
+    DATABASE_DumpCache();
+
+    // Read all parameters repeatedly, starting from a cold cache. This is the worst case, as there are more parameters than cache entries
+    DATABASE_FlushCache();
+    err = ReadBenchBootParams(cont_instance, &iv, CACHE_BENCH_INSTANCES, CACHE_BENCH_SCAN_ROUNDS, &time_taken);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+    num_reads = 2*CACHE_BENCH_INSTANCES*CACHE_BENCH_SCAN_ROUNDS;
+    USP_DUMP("Scan: %d reads of %d parameters took %llu us (%.2f us/read)", num_reads, 2*CACHE_BENCH_INSTANCES,
+             (unsigned long long)time_taken, (double)time_taken/num_reads);
+    DATABASE_DumpCache();
+
+exit:
+    // NOTE: The cache is flushed, so that its statistics are not skewed by the benchmark
+    DATABASE_FlushCache();
+    INT_VECTOR_Destroy(&iv);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** BenchDelete
+**
+** Measures the time taken to delete a controller instance containing many nested child object instances
+**
+** \param   cont_instance - instance number of the controller to create the benchmark's objects in, and then delete
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BenchDelete(int cont_instance)
+{
+    int i;
+    int err;
+    int instance;
+    int_vector_t iv;
+    uint64_t start_time;
+    char path[MAX_DM_PATH];
+
+    // Exit if unable to create the nested child objects to delete
+    INT_VECTOR_Init(&iv);
+    err = AddBenchBootParams(cont_instance, DELETE_BENCH_BOOT_PARAMS, &iv);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    USP_SNPRINTF(path, sizeof(path), "Device.LocalAgent.Controller.%d.MTP.", cont_instance);
+    for (i=0; i < DELETE_BENCH_MTPS; i++)
+    {
+        err = DATA_MODEL_AddInstance(path, &instance, 0);
+        if (err != USP_ERR_OK)
+        {
+            goto exit;
+        }
+    }
+
+    // Exit if unable to delete the controller
+    USP_SNPRINTF(path, sizeof(path), "Device.LocalAgent.Controller.%d.", cont_instance);
+    start_time = tu_uptime_usecs();
+    err = DATA_MODEL_DeleteInstance(path, 0);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    USP_DUMP("Delete benchmark");
+    USP_DUMP("Deleting controller with %d BootParameter and %d MTP instances took %llu us", DELETE_BENCH_BOOT_PARAMS, DELETE_BENCH_MTPS,
+             (unsigned long long)(tu_uptime_usecs() - start_time));
+
+exit:
+    INT_VECTOR_Destroy(&iv);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** BenchWatchTable
+**
+** Measures the memory and CPU used by a value change subscription watching many parameters
+**
+** \param   cont_instance - instance number of the controller to create the benchmark's objects in
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BenchWatchTable(int cont_instance)
+{
+    int i;
+    int err;
+    int_vector_t iv;
+    int recipient = INVALID;
+    combined_role_t combined_role;
+    char path[MAX_DM_PATH];
+
+    // Exit if there is no enabled controller to act as the recipient of the subscription
+    // NOTE: The controller created by the benchmark cannot be used, as it is never committed
+    INT_VECTOR_Init(&iv);
+    err = DATA_MODEL_GetInstances("Device.LocalAgent.Controller.", &iv);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    for (i=0; i < iv.num_entries; i++)
+    {
+        if ((iv.vector[i] != cont_instance) && (DEVICE_CONTROLLER_GetCombinedRole(iv.vector[i], &combined_role) == USP_ERR_OK))
+        {
+            recipient = iv.vector[i];
+            break;
+        }
+    }
+
+    if (recipient == INVALID)
+    {
+        USP_ERR_SetMessage("%s: Benchmark requires an enabled controller", __FUNCTION__);
+        err = USP_ERR_INTERNAL_ERROR;
+        goto exit;
+    }
+
+    // Exit if unable to create the parameters to watch
+    INT_VECTOR_Destroy(&iv);
+    err = AddBenchBootParams(cont_instance, WATCH_BENCH_INSTANCES, &iv);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    USP_SNPRINTF(path, sizeof(path), "Device.LocalAgent.Controller.%d.BootParameter.*.ParameterName", cont_instance);
+    DEVICE_SUBSCRIPTION_BenchWatchTable(path, recipient);
+
+exit:
+    INT_VECTOR_Destroy(&iv);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** BenchInstances
+**
+** Measures how the latency of getting parameters, and of adding and deleting instances, scales with the number of instances of an object
+**
+** \param   cont_instance - instance number of the controller to create the benchmark's objects in
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BenchInstances(int cont_instance)
+{
+    int i, j;
+    int err;
+    int num_instances;
+    int_vector_t iv;
+    int_vector_t enum_iv;
+    int added[INSTANCES_BENCH_ADDS];
+    uint64_t start_time;
+    uint64_t get_time;
+    uint64_t enum_time;
+    uint64_t add_time;
+    uint64_t del_time;
+    char table[MAX_DM_PATH];
+    char path[MAX_DM_PATH];
+    char buf[MAX_DM_VALUE_LEN];
+
+    INT_VECTOR_Init(&iv);
+    INT_VECTOR_Init(&enum_iv);
+    USP_SNPRINTF(table, sizeof(table), "Device.LocalAgent.Controller.%d.BootParameter.", cont_instance);
+    USP_DUMP("Instance scaling benchmark (%s{i})", table);
+
+    for (i=0; i < NUM_ELEM(instances_bench_sizes); i++)
+    {
+        // Exit if unable to grow the table to the size being measured
+        num_instances = instances_bench_sizes[i];
+        err = AddBenchBootParams(cont_instance, num_instances - iv.num_entries, &iv);
+        if (err != USP_ERR_OK)
+        {
+            goto exit;
+        }
+
+        // Measure the time taken to get a parameter, from instances spread throughout the table
+        start_time = tu_uptime_usecs();
+        for (j=0; j < INSTANCES_BENCH_GETS; j++)
+        {
+            USP_SNPRINTF(path, sizeof(path), "%s%d.ParameterName", table, iv.vector[(j*7919) % num_instances]);
+            err = DATA_MODEL_GetParameterValue(path, buf, sizeof(buf), 0);
+            if (err != USP_ERR_OK)
+            {
+                goto exit;
+            }
+        }
+        get_time = tu_uptime_usecs() - start_time;
+
+        // Measure the time taken to get the instance numbers of all instances
+        start_time = tu_uptime_usecs();
+        err = DATA_MODEL_GetInstances(table, &enum_iv);
+        enum_time = tu_uptime_usecs() - start_time;
+        INT_VECTOR_Destroy(&enum_iv);
+        if (err != USP_ERR_OK)
+        {
+            goto exit;
+        }
+
+        // Measure the time taken to add instances
+        start_time = tu_uptime_usecs();
+        for (j=0; j < INSTANCES_BENCH_ADDS; j++)
+        {
+            err = DATA_MODEL_AddInstance(table, &added[j], 0);
+            if (err != USP_ERR_OK)
+            {
+                goto exit;
+            }
+        }
+        add_time = tu_uptime_usecs() - start_time;
+
+        // Measure the time taken to delete the added instances, so that the table returns to the size being measured
+        start_time = tu_uptime_usecs();
+        for (j=0; j < INSTANCES_BENCH_ADDS; j++)
+        {
+            USP_SNPRINTF(path, sizeof(path), "%s%d.", table, added[j]);
+            err = DATA_MODEL_DeleteInstance(path, 0);
+            if (err != USP_ERR_OK)
+            {
+                goto exit;
+            }
+        }
+        del_time = tu_uptime_usecs() - start_time;
+
+        USP_DUMP("%5d instances: Get %.2f us, GetInstances %llu us, Add %.2f us, Delete %.2f us", num_instances,
+                 (double)get_time/INSTANCES_BENCH_GETS, (unsigned long long)enum_time,
+                 (double)add_time/INSTANCES_BENCH_ADDS, (double)del_time/INSTANCES_BENCH_ADDS);
+    }
+
+exit:
+    INT_VECTOR_Destroy(&iv);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** BenchResolve
+**
+** Measures the time taken to find the nodes of schema paths, when walking the data model tree
+**
+** \param   cont_instance - (unused) instance number of the controller created for the benchmark
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BenchResolve(int cont_instance)
+{
+    (void)cont_instance;
+    return DATA_MODEL_BenchResolve(RESOLVE_BENCH_PATHS);
+}
+
+/*********************************************************************//**
+**
+** BenchNestedInstances
+**
+** Measures the time taken to check for and enumerate the instances of a nested object, when its parent object has many instances
+**
+** \param   cont_instance - instance number of the controller to create the benchmark's objects in
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BenchNestedInstances(int cont_instance)
+{
+    int i, j;
+    int err;
+    int parents[NESTED_BENCH_PARENTS];
+    int *children;
+    int num_nested = NESTED_BENCH_PARENTS*NESTED_BENCH_CHILDREN;
+    int num_found = 0;
+    int num_enumerated = 0;
+    int_vector_t iv;
+    dm_node_t *node;
+    dm_instances_t inst;
+    bool is_qualified_instance;
+    uint64_t start_time;
+    uint64_t add_time;
+    uint64_t exist_time;
+    uint64_t enum_time;
+    char path[MAX_DM_PATH];
+
+    INT_VECTOR_Init(&iv);
+    children = USP_MALLOC(num_nested*sizeof(int));
+
+    // Exit if unable to create the controllers (the first being the one created for the benchmark), each with the same number of BootParameter instances
+    start_time = tu_uptime_usecs();
+    parents[0] = cont_instance;
+    for (i=0; i < NESTED_BENCH_PARENTS; i++)
+    {
+        if (i > 0)
+        {
+            err = DATA_MODEL_AddInstance("Device.LocalAgent.Controller.", &parents[i], 0);
+            if (err != USP_ERR_OK)
+            {
+                goto exit;
+            }
+        }
+
+        USP_SNPRINTF(path, sizeof(path), "Device.LocalAgent.Controller.%d.BootParameter.", parents[i]);
+        for (j=0; j < NESTED_BENCH_CHILDREN; j++)
+        {
+            err = DATA_MODEL_AddInstance(path, &children[i*NESTED_BENCH_CHILDREN + j], 0);
+            if (err != USP_ERR_OK)
+            {
+                goto exit;
+            }
+        }
+    }
+    add_time = tu_uptime_usecs() - start_time;
+
+    // Exit if unable to get the node and instance structure of the nested object
+    USP_SNPRINTF(path, sizeof(path), "Device.LocalAgent.Controller.%d.BootParameter.%d", parents[0], children[0]);
+    node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
+    if (node == NULL)
+    {
+        err = USP_ERR_INTERNAL_ERROR;
+        goto exit;
+    }
+
+    // Measure the time taken to check that each nested instance exists
+    start_time = tu_uptime_usecs();
+    for (i=0; i < NESTED_BENCH_PARENTS; i++)
+    {
+        inst.instances[0] = parents[i];
+        for (j=0; j < NESTED_BENCH_CHILDREN; j++)
+        {
+            inst.instances[1] = children[i*NESTED_BENCH_CHILDREN + j];
+            if (DM_INST_VECTOR_IsExist(&inst))
+            {
+                num_found++;
+            }
+        }
+    }
+    exist_time = tu_uptime_usecs() - start_time;
+
+    // Measure the time taken to count and enumerate the nested instances of each parent
+    inst.order = 1;
+    start_time = tu_uptime_usecs();
+    for (i=0; i < NESTED_BENCH_PARENTS; i++)
+    {
+        inst.instances[0] = parents[i];
+        num_enumerated += DM_INST_VECTOR_GetNumInstances(node, &inst);
+        err = DM_INST_VECTOR_GetInstances(node, &inst, &iv);
+        if (err != USP_ERR_OK)
+        {
+            goto exit;
+        }
+        num_enumerated -= iv.num_entries;
+        INT_VECTOR_Destroy(&iv);
+    }
+    enum_time = tu_uptime_usecs() - start_time;
+
+    // Exit if the instance vector did not contain the expected instances
+    if ((num_found != num_nested) || (num_enumerated != 0))
+    {
+        USP_ERR_SetMessage("%s: Found %d of %d nested instances", __FUNCTION__, num_found, num_nested);
+        err = USP_ERR_INTERNAL_ERROR;
+        goto exit;
+    }
+
+    USP_DUMP("Nested instance benchmark (%d Controller x %d BootParameter instances)", NESTED_BENCH_PARENTS, NESTED_BENCH_CHILDREN);
+    USP_DUMP("Add: %d nested instances took %llu us (including writing their parameters to the database)", num_nested, (unsigned long long)add_time);
+    USP_DUMP("IsExist: %d checks took %llu us (%.2f us/check)", num_nested, (unsigned long long)exist_time, (double)exist_time/num_nested);
+    USP_DUMP("GetNumInstances + GetInstances: %d parents took %llu us (%.2f us/parent)", NESTED_BENCH_PARENTS,
+             (unsigned long long)enum_time, (double)enum_time/NESTED_BENCH_PARENTS);
+
+exit:
+    INT_VECTOR_Destroy(&iv);
+    USP_FREE(children);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** BenchPermissions
+**
+** Measures the time taken to check the permissions of the unique key parameters of a table, when resolving a
+** unique key search path with a controller's role. The unique key search checks the permissions once per search.
+** The per-instance time shows the cost of instead checking them for every instance's key parameter (as it used to)
+**
+** \param   cont_instance - instance number of the controller to create the benchmark's objects in
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BenchPermissions(int cont_instance)
+{
+    int i, j;
+    int err;
+    int_vector_t iv;
+    str_vector_t sv;
+    dm_node_t *node;
+    dm_instances_t inst;
+    bool is_qualified_instance;
+    combined_role_t combined_role;
+    unsigned short perm;
+    unsigned short perm_bits = 0;
+    uint64_t start_time;
+    uint64_t lookup_time;
+    uint64_t instance_time;
+    uint64_t search_time;
+    char path[MAX_DM_PATH];
+
+    INT_VECTOR_Init(&iv);
+    STR_VECTOR_Init(&sv);
+    combined_role.inherited = kCTrustRole_FullAccess;
+    combined_role.assigned = kCTrustRole_Untrusted;
+
+    // Exit if unable to create the table searched by the benchmark
+    err = AddBenchBootParams(cont_instance, PERMS_BENCH_INSTANCES, &iv);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    // Exit if unable to give the last instance a unique key value
+    USP_SNPRINTF(path, sizeof(path), "Device.LocalAgent.Controller.%d.BootParameter.%d.ParameterName", cont_instance, iv.vector[iv.num_entries-1]);
+    err = DATA_MODEL_SetParameterValue(path, PERMS_BENCH_KEY_VALUE, 0);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    // Exit if unable to get the node of the unique key parameter
+    node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
+    if (node == NULL)
+    {
+        err = USP_ERR_INTERNAL_ERROR;
+        goto exit;
+    }
+
+    // Measure the time taken to look up the permissions of a single node
+    start_time = tu_uptime_usecs();
+    for (i=0; i < PERMS_BENCH_LOOKUPS; i++)
+    {
+        perm_bits |= DM_PRIV_GetPermissions(node, &combined_role);
+    }
+    lookup_time = tu_uptime_usecs() - start_time;
+
+    // Measure the time taken to check the permissions of the unique key parameter of every instance
+    start_time = tu_uptime_usecs();
+    for (i=0; i < PERMS_BENCH_SEARCHES; i++)
+    {
+        for (j=0; j < iv.num_entries; j++)
+        {
+            USP_SNPRINTF(path, sizeof(path), "Device.LocalAgent.Controller.%d.BootParameter.%d.ParameterName", cont_instance, iv.vector[j]);
+            err = DATA_MODEL_GetPermissions(path, &combined_role, &perm);
+            if (err != USP_ERR_OK)
+            {
+                goto exit;
+            }
+            perm_bits |= perm;
+        }
+    }
+    instance_time = tu_uptime_usecs() - start_time;
+
+    // Measure the time taken to resolve the unique key search path
+    USP_SNPRINTF(path, sizeof(path), "Device.LocalAgent.Controller.%d.BootParameter.[ParameterName==\"%s\"].Enable", cont_instance, PERMS_BENCH_KEY_VALUE);
+    start_time = tu_uptime_usecs();
+    for (i=0; i < PERMS_BENCH_SEARCHES; i++)
+    {
+        err = PATH_RESOLVER_ResolvePath(path, &sv, kResolveOp_Get, NULL, &combined_role, 0);
+        if (err != USP_ERR_OK)
+        {
+            goto exit;
+        }
+
+        // Exit if the search did not find the single matching instance
+        if (sv.num_entries != 1)
+        {
+            USP_ERR_SetMessage("%s: Unique key search matched %d instances", __FUNCTION__, sv.num_entries);
+            err = USP_ERR_INTERNAL_ERROR;
+            goto exit;
+        }
+        STR_VECTOR_Destroy(&sv);
+    }
+    search_time = tu_uptime_usecs() - start_time;
+
+    USP_DUMP("Permissions benchmark (%d BootParameter instances, permission bits 0x%04x)", PERMS_BENCH_INSTANCES, perm_bits);
+    USP_DUMP("DM_PRIV_GetPermissions: %d lookups took %llu us (%.4f us/lookup)", PERMS_BENCH_LOOKUPS,
+             (unsigned long long)lookup_time, (double)lookup_time/PERMS_BENCH_LOOKUPS);
+    USP_DUMP("Unique key search: %d searches took %llu us (%.2f ms/search)", PERMS_BENCH_SEARCHES,
+             (unsigned long long)search_time, (double)search_time/(1000*PERMS_BENCH_SEARCHES));
+    USP_DUMP("Per-instance key permission checks: %d searches took %llu us (%.2f ms/search)", PERMS_BENCH_SEARCHES,
+             (unsigned long long)instance_time, (double)instance_time/(1000*PERMS_BENCH_SEARCHES));
+
+exit:
+    INT_VECTOR_Destroy(&iv);
+    STR_VECTOR_Destroy(&sv);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** AddBenchBootParams
+**
+** Creates the specified number of Device.LocalAgent.Controller.{i}.BootParameter.{i} instances, setting the ParameterName of each
+**
+** \param   cont_instance - instance number of the controller to create the instances in
+** \param   num_instances - number of instances to create
+** \param   iv - pointer to vector in which to return the instance numbers of the created instances
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int AddBenchBootParams(int cont_instance, int num_instances, int_vector_t *iv)
+{
+    int i;
+    int err;
+    int instance;
+    char path[MAX_DM_PATH];
+
+    for (i=0; i < num_instances; i++)
+    {
+        // Exit if unable to create the instance
+        USP_SNPRINTF(path, sizeof(path), "Device.LocalAgent.Controller.%d.BootParameter.", cont_instance);
+        err = DATA_MODEL_AddInstance(path, &instance, 0);
+        if (err != USP_ERR_OK)
+        {
+            return err;
+        }
+        INT_VECTOR_Add(iv, instance);
+
+        // Exit if unable to set the parameter name. NOTE: The other parameters of the instance keep their default values
+        USP_SNPRINTF(path, sizeof(path), "Device.LocalAgent.Controller.%d.BootParameter.%d.ParameterName", cont_instance, instance);
+        err = DATA_MODEL_SetParameterValue(path, "Device.LocalAgent.", 0);
+        if (err != USP_ERR_OK)
+        {
+            return err;
+        }
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** ReadBenchBootParams
+**
+** Reads the Enable and ParameterName parameters of the specified Device.LocalAgent.Controller.{i}.BootParameter.{i} instances
+**
+** \param   cont_instance - instance number of the controller containing the instances
+** \param   iv - pointer to vector containing the instance numbers of the instances
+** \param   num_instances - number of instances (from the start of the vector) to read the parameters of
+** \param   num_rounds - number of times to read the parameters of all instances
+** \param   time_taken - pointer to variable in which to return the time taken (in microseconds)
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int ReadBenchBootParams(int cont_instance, int_vector_t *iv, int num_instances, int num_rounds, uint64_t *time_taken)
+{
+    int i, j, k;
+    int err;
+    uint64_t start_time;
+    char path[MAX_DM_PATH];
+    char buf[MAX_DM_VALUE_LEN];
+    static char *param_names[] = { "Enable", "ParameterName" };
+
+    start_time = tu_uptime_usecs();
+    for (i=0; i < num_rounds; i++)
+    {
+        for (j=0; j < num_instances; j++)
+        {
+            for (k=0; k < NUM_ELEM(param_names); k++)
+            {
+                // Exit if unable to read the parameter
+                USP_SNPRINTF(path, sizeof(path), "Device.LocalAgent.Controller.%d.BootParameter.%d.%s", cont_instance, iv->vector[j], param_names[k]);
+                err = DATA_MODEL_GetParameterValue(path, buf, sizeof(buf), 0);
+                if (err != USP_ERR_OK)
+                {
+                    return err;
+                }
+            }
+        }
+    }
+
+    *time_taken = tu_uptime_usecs() - start_time;
+    return USP_ERR_OK;
+}
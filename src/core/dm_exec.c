@@ -830,6 +830,9 @@ void *DM_EXEC_Main(void *args)
         // Queue any object creation/deletion events which have been generated by the message or timer callbacks
         DEVICE_SUBSCRIPTION_ProcessAllObjectLifeEventSubscriptions();
 
+        // Queue any value change events for database parameters which have been set by the message or timer callbacks
+        DEVICE_SUBSCRIPTION_ProcessPushedValueChanges();
+
         // Print out any memory allocations that got added for this time around the loop
         //USP_MEM_Print();
     }
@@ -38,6 +38,13 @@
  * Implements a data structure containing a list of dm_inst structures
  * This is basically a list of all object instances instantiated in the data model
  *
+ * The list is kept sorted by instance number tuple. Each dm_inst structure is treated as the key sequence
+ * (nodes[0], instances[0], nodes[1], instances[1], ...), and keys are compared lexicographically (with a key that is a
+ * prefix of another key sorting before it). This means that an object instance is immediately followed by all of its
+ * nested child instances, and all instances of a child object (given its parent instances) are contiguous in the list.
+ * So existence checks can be performed with a binary search, and enumerating the instances of an object only touches
+ * the instances of that object.
+ *
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -47,11 +54,17 @@
 #include "data_model.h"
 #include "int_vector.h"
 #include "dm_inst_vector.h"
+#include "dm_key_index.h"
 
 
 //--------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
 void AddObjectInstanceIfPermitted(dm_instances_t *inst, str_vector_t *sv, combined_role_t *combined_role);
+int ComparePrefix(dm_instances_t *oi, dm_instances_t *key, int key_len);
+int CompareInstances(dm_instances_t *oi1, dm_instances_t *oi2);
+int SortInstances(const void *p1, const void *p2);
+int FindFirstMatch(dm_instances_vector_t *div, dm_instances_t *key, int key_len);
+dm_instances_vector_t *GetInstanceVector(dm_instances_t *inst);
 
 
 /*********************************************************************//**
@@ -108,10 +121,9 @@ void DM_INST_VECTOR_Destroy(dm_instances_vector_t *div)
 **************************************************************************/
 int DM_INST_VECTOR_Add(dm_instances_t *inst)
 {
-    int i;
+    int index;
     int size;
     dm_instances_t *oi;
-    dm_node_t *top_node;
     dm_instances_vector_t *div;
 
     // Exit if there are no object instances to add
@@ -122,31 +134,37 @@ int DM_INST_VECTOR_Add(dm_instances_t *inst)
     }
 
     // Determine which top level multi-instance node's DM instances array to add to
-    USP_ASSERT(inst->order > 0);
-    top_node = inst->nodes[0];
-    USP_ASSERT(top_node != NULL);
-    USP_ASSERT(top_node->type == kDMNodeType_Object_MultiInstance);
-    div = &top_node->registered.object_info.inst_vector;
+    div = GetInstanceVector(inst);
 
-    // See if this instance already exists
-    for (i=0; i < div->num_entries; i++)
+    // Find the position in the (sorted) array at which this instance should be
+    index = FindFirstMatch(div, inst, 2*inst->order);
+
+    // If this instance of the object already exists then exit, nothing more to do
+    if (index < div->num_entries)
     {
-        // If this instance of the object already exists then exit, nothing more to do
-        oi = &div->vector[i];
-        if (memcmp(oi, inst, sizeof(dm_instances_t)) == 0)
+        oi = &div->vector[index];
+        if ((oi->order == inst->order) && (ComparePrefix(oi, inst, 2*inst->order) == 0))
         {
             return USP_ERR_OK;
-        }        
+        }
     }
 
     // Otherwise, increase the size of the dm_instances_vector array
     size = (div->num_entries+1) * sizeof(dm_instances_t);
     div->vector = USP_REALLOC(div->vector, size);
 
-    // And store this object instance
-    memcpy(&div->vector[div->num_entries], inst, sizeof(dm_instances_t));
+    // And store this object instance, keeping the array sorted
+    oi = &div->vector[index];
+    memmove(&oi[1], oi, (div->num_entries - index)*sizeof(dm_instances_t));
+    memcpy(oi, inst, sizeof(dm_instances_t));
     div->num_entries++;
 
+    // Check that the array is still sorted around the new entry
+    USP_ASSERT((index == 0) || (CompareInstances(&oi[-1], oi) < 0));
+    USP_ASSERT((index == div->num_entries-1) || (CompareInstances(oi, &oi[1]) < 0));
+    DM_PRIV_InvalidatePathCache();
+    DM_KEY_INDEX_AddInstance(inst);
+
     return USP_ERR_OK;
 }
 
@@ -166,11 +184,9 @@ int DM_INST_VECTOR_Add(dm_instances_t *inst)
 **************************************************************************/
 void DM_INST_VECTOR_Remove(dm_instances_t *inst)
 {
-    int i;
-    int j;
-    int order;
-    dm_instances_t *oi;
-    dm_node_t *top_node;
+    int first;
+    int last;
+    int key_len;
     dm_instances_vector_t *div;
 
     // Exit if there is no instance to remove
@@ -180,39 +196,29 @@ void DM_INST_VECTOR_Remove(dm_instances_t *inst)
     }
 
     // Determine which top level multi-instance node's DM instances array to remove from
-    USP_ASSERT(inst->order > 0);
-    top_node = inst->nodes[0];
-    USP_ASSERT(top_node != NULL);
-    USP_ASSERT(top_node->type == kDMNodeType_Object_MultiInstance);
-    div = &top_node->registered.object_info.inst_vector;
+    div = GetInstanceVector(inst);
 
-    // Find this instance and all child nested instances and delete them
-    j = 0;
-    order = inst->order;
-    for (i=0; i < div->num_entries; i++)
+    // Find this instance and all child nested instances. These are contiguous in the array
+    key_len = 2*inst->order;
+    first = FindFirstMatch(div, inst, key_len);
+    last = first;
+    while ((last < div->num_entries) && (ComparePrefix(&div->vector[last], inst, key_len) == 0))
     {
-        oi = &div->vector[i];
-        if ((oi->order >= order) &&
-            (memcmp(oi->nodes, inst->nodes, order*sizeof(dm_node_t *)) == 0) &&
-            (memcmp(oi->instances, inst->instances, order*sizeof(int)) == 0))
-        {
-            // Delete this node. Nothing to do in this iteration of the loop - this value will be overwritten by further 
-        }
-        else
-        {
-            // Copy down later entries in the array, over ones which have been removed
-            if (j < i)
-            {
-                memcpy(&div->vector[j], oi, sizeof(dm_instances_t));
-            }
+        last++;
+    }
 
-            j++;
-        }
+    // Exit if the instance has already been removed
+    if (last == first)
+    {
+        return;
     }
 
+    // Copy down later entries in the array, over the ones which have been removed
     // NOTE: Don't bother reallocating the memory for the array (it could now be smaller).
     // It will be resized next time an instance is added.
-    div->num_entries = j;
+    memmove(&div->vector[first], &div->vector[last], (div->num_entries - last)*sizeof(dm_instances_t));
+    div->num_entries -= (last - first);
+    DM_PRIV_InvalidatePathCache();
 }
 
 /*********************************************************************//**
@@ -229,9 +235,7 @@ void DM_INST_VECTOR_Remove(dm_instances_t *inst)
 **************************************************************************/
 bool DM_INST_VECTOR_IsExist(dm_instances_t *match)
 {
-    int i;
-    dm_instances_t *inst;
-    dm_node_t *top_node;
+    int index;
     dm_instances_vector_t *div;
 
     // Exit if the object is a single instance object - these always exist
@@ -241,25 +245,13 @@ bool DM_INST_VECTOR_IsExist(dm_instances_t *match)
     }
 
     // Determine which top level multi-instance node's DM instances array to search in
-    USP_ASSERT(match->order > 0);
-    top_node = match->nodes[0];
-    USP_ASSERT(top_node != NULL);
-    USP_ASSERT(top_node->type == kDMNodeType_Object_MultiInstance);
-    div = &top_node->registered.object_info.inst_vector;
+    div = GetInstanceVector(match);
 
-    // Iterate over the array of object instances which are present in the data model
-    for (i=0; i < div->num_entries; i++)
+    // The object instance exists if it (or any of its nested child instances) is present in the array
+    index = FindFirstMatch(div, match, 2*match->order);
+    if ((index < div->num_entries) && (ComparePrefix(&div->vector[index], match, 2*match->order) == 0))
     {
-        inst = &div->vector[i];
-        if (inst->order >= match->order)
-        {
-            if ( (memcmp(inst->nodes, match->nodes, (match->order)*sizeof(dm_node_t *)) == 0) &&
-                 (memcmp(inst->instances, match->instances, (match->order)*sizeof(int)) == 0) )
-            {
-                // All specified object instances match
-                return true;
-            }
-        }
+        return true;
     }
 
     // If the code gets here, then no instances matched
@@ -287,7 +279,6 @@ int DM_INST_VECTOR_GetNextInstance(dm_node_t *node, dm_instances_t *inst, int *n
     int instance;
     int highest_instance=0;       // highest instance number encountered so far
     dm_instances_t *oi;
-    dm_node_t *top_node;
     dm_instances_vector_t *div;
 
     order = inst->order;            // NOTE: This may be 0 for a top level multi-instance node
@@ -295,18 +286,18 @@ int DM_INST_VECTOR_GetNextInstance(dm_node_t *node, dm_instances_t *inst, int *n
     inst->nodes[order] = node;
 
     // Determine which top level multi-instance node's DM instances array to iterate over
-    top_node = inst->nodes[0];
-    USP_ASSERT(top_node != NULL);
-    USP_ASSERT(top_node->type == kDMNodeType_Object_MultiInstance);
-    div = &top_node->registered.object_info.inst_vector;
+    div = GetInstanceVector(inst);
 
-    // Iterate over the table of instance numbers, determining the highest instance number for the specified object
-    for (i=0; i < div->num_entries; i++)
+    // Iterate over the instances of the specified object, determining the highest instance number
+    for (i = FindFirstMatch(div, inst, 2*order+1); i < div->num_entries; i++)
     {
         oi = &div->vector[i];
-        if ((oi->order == order+1) &&
-            (memcmp(oi->nodes, inst->nodes, (order+1)*sizeof(dm_node_t *)) == 0) &&
-            (memcmp(oi->instances, inst->instances, order*sizeof(int)) == 0))
+        if (ComparePrefix(oi, inst, 2*order+1) != 0)
+        {
+            break;
+        }
+
+        if (oi->order == order+1)
         {
             instance = oi->instances[order];
             if (instance > highest_instance)
@@ -340,7 +331,6 @@ int DM_INST_VECTOR_GetNumInstances(dm_node_t *node, dm_instances_t *inst)
     int order;
     int count;
     dm_instances_t *oi;
-    dm_node_t *top_node;
     dm_instances_vector_t *div;
 
     order = inst->order;           // NOTE: This may be 0 for a top level multi-instance node
@@ -348,19 +338,19 @@ int DM_INST_VECTOR_GetNumInstances(dm_node_t *node, dm_instances_t *inst)
     inst->nodes[order] = node;
 
     // Determine which top level multi-instance node's DM instances array to iterate over
-    top_node = inst->nodes[0];
-    USP_ASSERT(top_node != NULL);
-    USP_ASSERT(top_node->type == kDMNodeType_Object_MultiInstance);
-    div = &top_node->registered.object_info.inst_vector;
+    div = GetInstanceVector(inst);
 
-    // Iterate over the table of instance numbers, determining the highest instance number for the specified object
+    // Iterate over the instances of the specified object, counting them
     count = 0;
-    for (i=0; i < div->num_entries; i++)
+    for (i = FindFirstMatch(div, inst, 2*order+1); i < div->num_entries; i++)
     {
         oi = &div->vector[i];
-        if ((oi->order == order+1) &&
-            (memcmp(oi->nodes, inst->nodes, (order+1)*sizeof(dm_node_t *)) == 0) &&
-            (memcmp(oi->instances, inst->instances, order*sizeof(int)) == 0))
+        if (ComparePrefix(oi, inst, 2*order+1) != 0)
+        {
+            break;
+        }
+
+        if (oi->order == order+1)
         {
             count++;
         }
@@ -376,12 +366,15 @@ int DM_INST_VECTOR_GetNumInstances(dm_node_t *node, dm_instances_t *inst)
 ** DM_INST_VECTOR_GetInstances
 **
 ** Gets a vector of the instance numbers for the specified object (given it's parent instance numbers)
+** NOTE: The instance numbers are returned in ascending order
 **
 ** \param   node - pointer to object in data model
 ** \param   inst - pointer to instance structure specifying the object's parents and their instance numbers
 ** \param   iv - pointer to structure which will be populated with instance numbers by this function
+**               NOTE: If an error is returned, the vector is returned empty, so the caller need not destroy it
 **
 ** \return  USP_ERR_OK if successful
+**          USP_ERR_RESOURCES_EXCEEDED if the object has more than MAX_DM_INSTANCES instances
 **
 **************************************************************************/
 int DM_INST_VECTOR_GetInstances(dm_node_t *node, dm_instances_t *inst, int_vector_t *iv)
@@ -390,9 +383,7 @@ int DM_INST_VECTOR_GetInstances(dm_node_t *node, dm_instances_t *inst, int_vecto
     int order;
     int instance;
     dm_instances_t *oi;
-    int index;
     int err;
-    dm_node_t *top_node;
     dm_instances_vector_t *div;
 
     order = inst->order;          // NOTE: This may be 0 for a top level multi-instance node
@@ -401,32 +392,32 @@ int DM_INST_VECTOR_GetInstances(dm_node_t *node, dm_instances_t *inst, int_vecto
     INT_VECTOR_Init(iv);
 
     // Determine which top level multi-instance node's DM instances array to iterate over
-    top_node = inst->nodes[0];
-    USP_ASSERT(top_node != NULL);
-    USP_ASSERT(top_node->type == kDMNodeType_Object_MultiInstance);
-    div = &top_node->registered.object_info.inst_vector;
+    div = GetInstanceVector(inst);
 
-    // Iterate over the instances array, finding the objects which match, and their instances
-    for (i=0; i < div->num_entries; i++)
+    // Iterate over the instances of the specified object (and their nested child instances)
+    for (i = FindFirstMatch(div, inst, 2*order+1); i < div->num_entries; i++)
     {
         oi = &div->vector[i];
-        if ((oi->order >= order+1) &&
-            (memcmp(oi->nodes, inst->nodes, (order+1)*sizeof(dm_node_t *)) == 0) &&
-            (memcmp(oi->instances, inst->instances, order*sizeof(int)) == 0))
+        if (ComparePrefix(oi, inst, 2*order+1) != 0)
         {
-            instance = oi->instances[order];
+            break;
+        }
 
-            // Add the instance to the array (if it has not been added already)
-            index = INT_VECTOR_Find(iv, instance);
-            if (index == INVALID)
+        // Add the instance to the array (if it has not been added already)
+        // NOTE: As the array is sorted, all entries for the same instance number are adjacent
+        instance = oi->instances[order];
+        if ((iv->num_entries == 0) || (iv->vector[iv->num_entries-1] != instance))
+        {
+            // Exit if the object has more instances than the configured limit, freeing the instances found so far
+            if (iv->num_entries >= MAX_DM_INSTANCES)
             {
-                // Exit if array is already full
-                err = INT_VECTOR_Add(iv, instance);
-                if (err != USP_ERR_OK)
-                {
-                    goto exit;
-                }
+                USP_ERR_SetMessage("%s: More than %d instances of object", __FUNCTION__, MAX_DM_INSTANCES);
+                INT_VECTOR_Destroy(iv);
+                err = USP_ERR_RESOURCES_EXCEEDED;
+                goto exit;
             }
+
+            INT_VECTOR_Add(iv, instance);
         }
     }
 
@@ -437,6 +428,27 @@ exit:
     return err;
 }
 
+/*********************************************************************//**
+**
+** DM_INST_VECTOR_Sort
+**
+** Re-sorts the specified dm_instances_vector array
+** This must be called if the node pointers in the array have been changed (eg by compacting the schema),
+** as the sort order is defined by the nodes that they point to
+**
+** \param   div - pointer to dm_instances vector structure to sort
+**
+** \return  None
+**
+**************************************************************************/
+void DM_INST_VECTOR_Sort(dm_instances_vector_t *div)
+{
+    if (div->num_entries > 1)
+    {
+        qsort(div->vector, div->num_entries, sizeof(dm_instances_t), SortInstances);
+    }
+}
+
 /*********************************************************************//**
 **
 ** DM_INST_VECTOR_Dump
@@ -488,7 +500,6 @@ void DM_INST_VECTOR_GetAllInstancePaths_Unqualified(dm_node_t *node, dm_instance
     int i;
     int order;
     dm_instances_t *oi;
-    dm_node_t *top_node;
     dm_instances_vector_t *div;
 
     order = inst->order;          // NOTE: This may be 0 for a top level multi-instance node
@@ -496,21 +507,18 @@ void DM_INST_VECTOR_GetAllInstancePaths_Unqualified(dm_node_t *node, dm_instance
     inst->nodes[order] = node;
 
     // Determine which top level multi-instance node's DM instances array to iterate over
-    top_node = inst->nodes[0];
-    USP_ASSERT(top_node != NULL);
-    USP_ASSERT(top_node->type == kDMNodeType_Object_MultiInstance);
-    div = &top_node->registered.object_info.inst_vector;
+    div = GetInstanceVector(inst);
 
-    // Iterate over the instances array, finding all objects which match, and their instances
-    for (i=0; i < div->num_entries; i++)
+    // Iterate over all instances of the object, and their nested child instances
+    for (i = FindFirstMatch(div, inst, 2*order+1); i < div->num_entries; i++)
     {
         oi = &div->vector[i];
-        if ((oi->order >= order+1) &&
-            (memcmp(oi->nodes, inst->nodes, (order+1)*sizeof(dm_node_t *)) == 0) &&
-            (memcmp(oi->instances, inst->instances, order*sizeof(int)) == 0))
+        if (ComparePrefix(oi, inst, 2*order+1) != 0)
         {
-            AddObjectInstanceIfPermitted(oi, sv, combined_role);
+            break;
         }
+
+        AddObjectInstanceIfPermitted(oi, sv, combined_role);
     }
 
     // Undo the changes made by this function to the inst array
@@ -538,7 +546,6 @@ void DM_INST_VECTOR_GetAllInstancePaths_Qualified(dm_instances_t *inst, str_vect
     int i;
     int order;
     dm_instances_t *oi;
-    dm_node_t *top_node;
     dm_instances_vector_t *div;
 
     order = inst->order;
@@ -546,21 +553,18 @@ void DM_INST_VECTOR_GetAllInstancePaths_Qualified(dm_instances_t *inst, str_vect
     USP_ASSERT(order < MAX_DM_INSTANCE_ORDER);
 
     // Determine which top level multi-instance node's DM instances array to iterate over
-    top_node = inst->nodes[0];
-    USP_ASSERT(top_node != NULL);
-    USP_ASSERT(top_node->type == kDMNodeType_Object_MultiInstance);
-    div = &top_node->registered.object_info.inst_vector;
+    div = GetInstanceVector(inst);
 
-    // Iterate over the instances array, finding all objects which match, and their instances
-    for (i=0; i < div->num_entries; i++)
+    // Iterate over the object instance, and all of its nested child instances
+    for (i = FindFirstMatch(div, inst, 2*order); i < div->num_entries; i++)
     {
         oi = &div->vector[i];
-        if ((oi->order >= order) &&
-            (memcmp(oi->nodes, inst->nodes, order*sizeof(dm_node_t *)) == 0) &&
-            (memcmp(oi->instances, inst->instances, order*sizeof(int)) == 0))
+        if (ComparePrefix(oi, inst, 2*order) != 0)
         {
-            AddObjectInstanceIfPermitted(oi, sv, combined_role);
+            break;
         }
+
+        AddObjectInstanceIfPermitted(oi, sv, combined_role);
     }
 }
 
@@ -599,6 +603,163 @@ void AddObjectInstanceIfPermitted(dm_instances_t *inst, str_vector_t *sv, combin
     STR_VECTOR_Add(sv, path);
 }
 
+/*********************************************************************//**
+**
+** ComparePrefix
+**
+** Compares the key sequence of the specified object instance against the first key_len items of the specified key
+** The key sequence of a dm_instances_t structure is (nodes[0], instances[0], nodes[1], instances[1], ...)
+** Nodes are compared by their registration ordinal (rather than their address), so that the order is the same
+** in every build, and is not changed by compacting the schema
+** NOTE: The dm_instances_vector array is sorted by this comparison
+**
+** \param   oi - pointer to object instance in the dm_instances_vector array
+** \param   key - pointer to instance structure containing the key to compare against
+** \param   key_len - number of items in the key sequence to compare
+**                    (an odd number compares up to and including the node of the last object in the key)
+**
+** \return  -1 if oi sorts before the key, 0 if oi starts with the key, 1 if oi sorts after the key
+**
+**************************************************************************/
+int ComparePrefix(dm_instances_t *oi, dm_instances_t *key, int key_len)
+{
+    int k;
+    int i;
+    unsigned node1;
+    unsigned node2;
 
+    for (k=0; k < key_len; k++)
+    {
+        // If oi is shorter than the key (ie it is an ancestor of the key), then it sorts before the key
+        if (k >= 2*oi->order)
+        {
+            return -1;
+        }
 
+        i = k/2;
+        if ((k & 1) == 0)
+        {
+            // Compare the nodes at this level
+            node1 = oi->nodes[i]->ordinal;
+            node2 = key->nodes[i]->ordinal;
+            if (node1 != node2)
+            {
+                return (node1 < node2) ? -1 : 1;
+            }
+        }
+        else
+        {
+            // Compare the instance numbers at this level
+            if (oi->instances[i] != key->instances[i])
+            {
+                return (oi->instances[i] < key->instances[i]) ? -1 : 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*********************************************************************//**
+**
+** CompareInstances
+**
+** Compares the full key sequences of two object instances, in the order used to sort the dm_instances_vector array
+**
+** \param   oi1 - pointer to first object instance
+** \param   oi2 - pointer to second object instance
+**
+** \return  -1 if oi1 sorts before oi2, 0 if they are the same object instance, 1 if oi1 sorts after oi2
+**
+**************************************************************************/
+int CompareInstances(dm_instances_t *oi1, dm_instances_t *oi2)
+{
+    int result;
+
+    // NOTE: If oi1 starts with all of the key sequence of oi2, then oi1 is either the same object instance or a descendant of it
+    result = ComparePrefix(oi1, oi2, 2*oi2->order);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    return (oi1->order == oi2->order) ? 0 : 1;
+}
 
+/*********************************************************************//**
+**
+** SortInstances
+**
+** Function used by quicksort to sort the dm_instances_vector array
+**
+** \param   p1 - pointer to first element in the array to compare
+** \param   p2 - pointer to second element in the array to compare
+**
+** \return  -1 if p1 sorts before p2, 0 if they are the same object instance, 1 if p1 sorts after p2
+**
+**************************************************************************/
+int SortInstances(const void *p1, const void *p2)
+{
+    return CompareInstances((dm_instances_t *) p1, (dm_instances_t *) p2);
+}
+
+/*********************************************************************//**
+**
+** FindFirstMatch
+**
+** Performs a binary search of the dm_instances_vector array, returning the index of the first entry
+** which does not sort before the specified key. If any entries start with the key, then this is the first of them.
+**
+** \param   div - pointer to dm_instances vector structure to search
+** \param   key - pointer to instance structure containing the key to search for
+** \param   key_len - number of items in the key sequence to compare (see ComparePrefix)
+**
+** \return  index of first entry not sorting before the key (this is num_entries if there is none)
+**
+**************************************************************************/
+int FindFirstMatch(dm_instances_vector_t *div, dm_instances_t *key, int key_len)
+{
+    int low;
+    int high;
+    int mid;
+
+    low = 0;
+    high = div->num_entries;
+    while (low < high)
+    {
+        mid = low + (high - low)/2;
+        if (ComparePrefix(&div->vector[mid], key, key_len) < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/*********************************************************************//**
+**
+** GetInstanceVector
+**
+** Returns the dm_instances_vector which holds the specified object instance
+** This is stored in the top level multi-instance node of the object
+**
+** \param   inst - pointer to instance structure specifying the object instance
+**
+** \return  pointer to the dm_instances_vector holding the object instance
+**
+**************************************************************************/
+dm_instances_vector_t *GetInstanceVector(dm_instances_t *inst)
+{
+    dm_node_t *top_node;
+
+    top_node = inst->nodes[0];
+    USP_ASSERT(top_node != NULL);
+    USP_ASSERT(top_node->type == kDMNodeType_Object_MultiInstance);
+
+    return &top_node->registered.object_info.inst_vector;
+}
@@ -0,0 +1,737 @@
+/*
+ *
+ * Copyright (C) 2019, Broadband Forum
+ * Copyright (C) 2016-2019  CommScope, Inc
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file dm_key_index.c
+ *
+ * Implements an index of the values of the unique key parameters of multi-instance objects
+ * This is used to speed up resolving unique key search expressions (eg 'Device.LocalAgent.Controller.[Alias=="cpe-1"]')
+ * by only testing the instances which have the value being searched for, rather than all instances of the object
+ *
+ * Each multi-instance object with registered unique keys has an index, which is built the first time it is searched.
+ * Only unique key parameters that are stored in the database (and compared as strings) are indexed.
+ * The index for the instances of an object with a given set of parent instances is built from the database
+ * the first time those instances are searched, and is then kept up to date as parameters are set and instances are added.
+ *
+ * The index may contain stale entries (eg for instances which have since been deleted, or for old values of parameters).
+ * These are harmless, since the instances returned by the index are only candidates: the caller must check that each
+ * candidate exists and matches the search expression. The index is rebuilt if too many stale entries accumulate.
+ * If the database changes without going through the data model (eg a transaction is aborted), the index is discarded.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_defs.h"
+#include "data_model.h"
+#include "int_vector.h"
+#include "dm_inst_vector.h"
+#include "dm_key_index.h"
+
+//--------------------------------------------------------------------
+// Maximum number of unique key parameters which may be indexed for each multi-instance object
+#define MAX_DM_KEY_INDEX_PARAMS 8
+
+// Entry in the index. Records that the specified parameter had the specified value in the specified object instance
+// NOTE: Entries with a NULL param_node are marker entries, recording that the instances of the object with the given
+//       parent instances have been indexed
+typedef struct key_index_entry_tag
+{
+    struct key_index_entry_tag *next;       // Next entry in the hash bucket chain containing this entry
+    unsigned hash;                          // Hash of the value, parameter and parent instance numbers. Used to select the hash bucket
+    dm_node_t *param_node;                  // Unique key parameter, or NULL for a marker entry
+    int instances[MAX_DM_INSTANCE_ORDER];   // Instance numbers of the object instance (parent instances, followed by the object's own instance number)
+} key_index_entry_t;
+
+//--------------------------------------------------------------------
+// Index for a single multi-instance object
+typedef struct dm_key_index_tag
+{
+    struct dm_key_index_tag *next;          // Next index in the list of all indexes
+    dm_node_t *table_node;                  // Multi-instance object which this index is for
+    dm_node_t *params[MAX_DM_KEY_INDEX_PARAMS];  // Unique key parameters which are indexed
+    int num_params;
+    key_index_entry_t **buckets;            // Hash table of entries. Number of buckets is always a power of 2
+    int num_buckets;
+    int num_entries;
+    int num_built;                          // Number of entries added when building the index from the database
+    int num_updates;                        // Number of entries added since, as parameters were set and instances added
+} dm_key_index_t;
+
+// Initial number of buckets in an index's hash table
+#define KEY_INDEX_INITIAL_BUCKETS 64
+
+// Number of entries which may be added by updates (which may leave stale entries behind)
+// in excess of those added whilst building, before the index is discarded and rebuilt
+#define KEY_INDEX_MAX_EXCESS_UPDATES 256
+
+//--------------------------------------------------------------------
+// List of all indexes that have been created
+static dm_key_index_t *key_indexes = NULL;
+
+//--------------------------------------------------------------------
+// Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
+dm_key_index_t *GetKeyIndex(dm_node_t *param_node, bool create);
+dm_key_index_t *CreateKeyIndex(dm_node_t *table_node);
+void DestroyKeyIndex(dm_key_index_t *index);
+bool IsIndexedParam(dm_key_index_t *index, dm_node_t *param_node);
+int BuildKeyIndex(dm_key_index_t *index, dm_instances_t *parent_inst);
+void AddKeyIndexEntry(dm_key_index_t *index, dm_node_t *param_node, dm_instances_t *inst, char *value);
+key_index_entry_t *FindKeyIndexEntry(dm_key_index_t *index, unsigned hash, dm_node_t *param_node, int *instances, int order);
+void ResizeKeyIndex(dm_key_index_t *index);
+unsigned CalcKeyIndexHash(dm_node_t *param_node, int *instances, int order, char *value);
+
+/*********************************************************************//**
+**
+** DM_KEY_INDEX_FindInstances
+**
+** Finds the instances of an object which (may) have the specified value for the specified unique key parameter
+** NOTE: The instances returned are only candidates. The caller must check that each instance exists and has the value
+**
+** \param   param_node - node of the unique key parameter
+** \param   inst - pointer to instance numbers of the parameter. Only the parent instances (all except the last) are used.
+** \param   value - value of the parameter to find
+** \param   iv - pointer to vector in which to return the candidate instance numbers, sorted in ascending order
+**               NOTE: The caller must initialise and destroy this vector
+**
+** \return  true if the parameter is indexed, false if it is not (in which case the caller must test all instances of the object)
+**
+**************************************************************************/
+bool DM_KEY_INDEX_FindInstances(dm_node_t *param_node, dm_instances_t *inst, char *value, int_vector_t *iv)
+{
+    dm_key_index_t *index;
+    key_index_entry_t *entry;
+    unsigned hash;
+    int order;
+    int instance;
+    int err;
+    int i;
+
+    // Exit if this parameter is not indexed
+    index = GetKeyIndex(param_node, true);
+    if ((index == NULL) || (IsIndexedParam(index, param_node) == false))
+    {
+        return false;
+    }
+
+    // Exit if unable to index the instances of the object for these parent instances
+    // NOTE: This is the case if any of the parameters could not be read
+    order = param_node->order;
+    hash = CalcKeyIndexHash(NULL, inst->instances, order-1, "");
+    if (FindKeyIndexEntry(index, hash, NULL, inst->instances, order-1) == NULL)
+    {
+        err = BuildKeyIndex(index, inst);
+        if (err != USP_ERR_OK)
+        {
+            DestroyKeyIndex(index);
+            return false;
+        }
+    }
+
+    // Iterate over all entries in the bucket containing the value, adding the instances with a matching value
+    hash = CalcKeyIndexHash(param_node, inst->instances, order-1, value);
+    entry = index->buckets[hash & (index->num_buckets-1)];
+    while (entry != NULL)
+    {
+        if ((entry->hash == hash) && (entry->param_node == param_node) &&
+            (memcmp(entry->instances, inst->instances, (order-1)*sizeof(int)) == 0))
+        {
+            // Insert the instance number into the vector, keeping the vector sorted
+            instance = entry->instances[order-1];
+            INT_VECTOR_Add(iv, instance);
+            for (i = iv->num_entries-1; (i > 0) && (iv->vector[i-1] > instance); i--)
+            {
+                iv->vector[i] = iv->vector[i-1];
+            }
+            iv->vector[i] = instance;
+        }
+
+        entry = entry->next;
+    }
+
+    return true;
+}
+
+/*********************************************************************//**
+**
+** DM_KEY_INDEX_UpdateParam
+**
+** Called after a parameter has been set in the database, to keep the index up to date
+**
+** \param   param_node - node of the parameter which has been set
+** \param   inst - pointer to instance numbers of the parameter
+** \param   value - new value of the parameter
+**
+** \return  None
+**
+**************************************************************************/
+void DM_KEY_INDEX_UpdateParam(dm_node_t *param_node, dm_instances_t *inst, char *value)
+{
+    dm_key_index_t *index;
+    unsigned hash;
+    int order;
+
+    // Exit if this parameter is not indexed
+    index = GetKeyIndex(param_node, false);
+    if ((index == NULL) || (IsIndexedParam(index, param_node) == false))
+    {
+        return;
+    }
+
+    // Exit if the instances of the object for these parent instances have not been indexed yet
+    // (they will be read from the database, if they are ever searched)
+    order = param_node->order;
+    hash = CalcKeyIndexHash(NULL, inst->instances, order-1, "");
+    if (FindKeyIndexEntry(index, hash, NULL, inst->instances, order-1) == NULL)
+    {
+        return;
+    }
+
+    // NOTE: The entry for the old value of the parameter is left in the index. It will be filtered out by the caller of DM_KEY_INDEX_FindInstances()
+    AddKeyIndexEntry(index, param_node, inst, (value != NULL) ? value : "");
+    index->num_updates++;
+
+    // Discard the index if it contains too many (potentially stale) entries. It will be rebuilt when it is next searched
+    if (index->num_updates > index->num_built + KEY_INDEX_MAX_EXCESS_UPDATES)
+    {
+        DestroyKeyIndex(index);
+    }
+}
+
+/*********************************************************************//**
+**
+** DM_KEY_INDEX_AddInstance
+**
+** Called after an object instance has been added to the data model, to keep the index up to date
+** The values of the unique key parameters of the new instance are read, as they may already have been set in the database
+** (eg if the instance was added when reading the database at startup, or by the vendor using USP_SIGNAL_ObjectAdded)
+**
+** \param   inst - pointer to instance numbers of the object instance which has been added
+**
+** \return  None
+**
+**************************************************************************/
+void DM_KEY_INDEX_AddInstance(dm_instances_t *inst)
+{
+    dm_key_index_t *index;
+    dm_node_t *param_node;
+    char path[MAX_DM_PATH];
+    char value[MAX_DM_SHORT_VALUE_LEN];
+    unsigned hash;
+    int order;
+    int err;
+    int i;
+
+    // Exit if no indexes have been created
+    if (key_indexes == NULL)
+    {
+        return;
+    }
+
+    // Exit if the object has no index
+    // NOTE: The last instance node in the array is the object which has been added
+    index = inst->nodes[inst->order-1]->registered.object_info.key_index;
+    if (index == NULL)
+    {
+        return;
+    }
+
+    // Exit if the instances of the object for these parent instances have not been indexed yet
+    // (they will be read from the database, if they are ever searched)
+    order = inst->order;
+    hash = CalcKeyIndexHash(NULL, inst->instances, order-1, "");
+    if (FindKeyIndexEntry(index, hash, NULL, inst->instances, order-1) == NULL)
+    {
+        return;
+    }
+
+    // Iterate over all unique key parameters of the object, adding their current values to the index
+    for (i=0; i < index->num_params; i++)
+    {
+        // Exit if unable to get the value of the parameter, discarding the index. It will be rebuilt when it is next searched
+        param_node = index->params[i];
+        DM_PRIV_FormPath_FromDM(param_node, inst, path, sizeof(path));
+        err = DM_PRIV_GetParameterValue(path, param_node, inst, value, sizeof(value), 0);
+        if (err != USP_ERR_OK)
+        {
+            DestroyKeyIndex(index);
+            return;
+        }
+
+        DM_KEY_INDEX_UpdateParam(param_node, inst, value);
+
+        // Exit if the index was discarded because of too many updates
+        if (inst->nodes[inst->order-1]->registered.object_info.key_index == NULL)
+        {
+            return;
+        }
+    }
+}
+
+/*********************************************************************//**
+**
+** DM_KEY_INDEX_InvalidateAll
+**
+** Discards all indexes. They will be rebuilt from the database when they are next searched
+** This function must be called if the database is modified without going through the data model
+** (eg if a transaction is aborted)
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void DM_KEY_INDEX_InvalidateAll(void)
+{
+    while (key_indexes != NULL)
+    {
+        DestroyKeyIndex(key_indexes);
+    }
+}
+
+/*********************************************************************//**
+**
+** GetKeyIndex
+**
+** Gets the index of the object containing the specified parameter
+**
+** \param   param_node - node of the parameter
+** \param   create - set if the index should be created, if it does not already exist
+**
+** \return  pointer to index, or NULL if the parameter is not contained in a multi-instance object or the index has not been created
+**
+**************************************************************************/
+dm_key_index_t *GetKeyIndex(dm_node_t *param_node, bool create)
+{
+    dm_node_t *table_node;
+    dm_key_index_t *index;
+
+    // Exit if the parameter is not contained in a multi-instance object
+    // NOTE: Unique key parameters must be immediate children of the multi-instance object
+    if (param_node->order == 0)
+    {
+        return NULL;
+    }
+    table_node = param_node->instance_nodes[param_node->order-1];
+
+    // Exit if the index has already been created, or should not be created
+    index = table_node->registered.object_info.key_index;
+    if ((index != NULL) || (create == false))
+    {
+        return index;
+    }
+
+    index = CreateKeyIndex(table_node);
+    return index;
+}
+
+/*********************************************************************//**
+**
+** CreateKeyIndex
+**
+** Creates an (empty) index for the specified multi-instance object
+**
+** \param   table_node - multi-instance object to create the index for
+**
+** \return  pointer to index
+**
+**************************************************************************/
+dm_key_index_t *CreateKeyIndex(dm_node_t *table_node)
+{
+    dm_key_index_t *index;
+    dm_unique_key_vector_t *ukv;
+    dm_node_t *child;
+    unsigned type_flags;
+    int i, j;
+
+    index = USP_MALLOC(sizeof(dm_key_index_t));
+    memset(index, 0, sizeof(dm_key_index_t));
+    index->table_node = table_node;
+    index->num_buckets = KEY_INDEX_INITIAL_BUCKETS;
+    index->buckets = USP_MALLOC(index->num_buckets*sizeof(key_index_entry_t *));
+    memset(index->buckets, 0, index->num_buckets*sizeof(key_index_entry_t *));
+
+    // Determine which of the parameters in the unique keys can be indexed
+    // These are the ones stored in the database, which are compared as strings
+    ukv = &table_node->registered.object_info.unique_keys;
+    for (i=0; i < ukv->num_entries; i++)
+    {
+        for (j=0; (j < MAX_COMPOUND_KEY_PARAMS) && (ukv->vector[i].param[j] != NULL); j++)
+        {
+            child = DM_PRIV_FindMatchingChild(table_node, ukv->vector[i].param[j]);
+            USP_ASSERT(child != NULL);
+            switch(child->type)
+            {
+                case kDMNodeType_DBParam_ReadWrite:
+                case kDMNodeType_DBParam_ReadOnly:
+                case kDMNodeType_DBParam_ReadOnlyAuto:
+                case kDMNodeType_DBParam_ReadWriteAuto:
+                    type_flags = child->registered.param_info.type_flags;
+                    if ( ((type_flags & (DM_INT | DM_UINT | DM_ULONG | DM_BOOL | DM_DATETIME)) == 0) &&
+                         (index->num_params < MAX_DM_KEY_INDEX_PARAMS) && (IsIndexedParam(index, child) == false) )
+                    {
+                        index->params[index->num_params] = child;
+                        index->num_params++;
+                    }
+                    break;
+
+                default:
+                    // Other types of parameter are not indexed
+                    break;
+            }
+        }
+    }
+
+    // Add the index to the list of indexes
+    index->next = key_indexes;
+    key_indexes = index;
+    table_node->registered.object_info.key_index = index;
+
+    return index;
+}
+
+/*********************************************************************//**
+**
+** DestroyKeyIndex
+**
+** Frees all memory associated with the specified index, and removes it from its object
+**
+** \param   index - pointer to index to destroy
+**
+** \return  None
+**
+**************************************************************************/
+void DestroyKeyIndex(dm_key_index_t *index)
+{
+    dm_key_index_t **p;
+    key_index_entry_t *entry;
+    key_index_entry_t *next;
+    int i;
+
+    // Unlink the index from the list of indexes
+    p = &key_indexes;
+    while (*p != index)
+    {
+        USP_ASSERT(*p != NULL);
+        p = &(*p)->next;
+    }
+    *p = index->next;
+    index->table_node->registered.object_info.key_index = NULL;
+
+    // Free all entries in the index
+    for (i=0; i < index->num_buckets; i++)
+    {
+        entry = index->buckets[i];
+        while (entry != NULL)
+        {
+            next = entry->next;
+            USP_FREE(entry);
+            entry = next;
+        }
+    }
+
+    USP_FREE(index->buckets);
+    USP_FREE(index);
+}
+
+/*********************************************************************//**
+**
+** IsIndexedParam
+**
+** Determines whether the specified parameter is indexed
+**
+** \param   index - pointer to index of the object containing the parameter
+** \param   param_node - node of the parameter
+**
+** \return  true if the parameter is indexed
+**
+**************************************************************************/
+bool IsIndexedParam(dm_key_index_t *index, dm_node_t *param_node)
+{
+    int i;
+
+    for (i=0; i < index->num_params; i++)
+    {
+        if (index->params[i] == param_node)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*********************************************************************//**
+**
+** BuildKeyIndex
+**
+** Adds the values of the indexed parameters of all instances of the object with the specified parent instances to the index
+**
+** \param   index - pointer to index to add to
+** \param   parent_inst - pointer to instance numbers. Only the parent instances of the object are used.
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BuildKeyIndex(dm_key_index_t *index, dm_instances_t *parent_inst)
+{
+    int_vector_t iv;
+    dm_instances_t inst;
+    dm_node_t *table_node;
+    dm_node_t *param_node;
+    char path[MAX_DM_PATH];
+    char value[MAX_DM_SHORT_VALUE_LEN];
+    int order;
+    int err;
+    int i, j;
+
+    // Form the instance structure of the parent instances of the object
+    table_node = index->table_node;
+    order = table_node->order;
+    memset(&inst, 0, sizeof(inst));
+    memcpy(inst.instances, parent_inst->instances, (order-1)*sizeof(int));
+    memcpy(inst.nodes, table_node->instance_nodes, (order-1)*sizeof(dm_node_t *));
+    inst.order = order-1;
+
+    // Exit if unable to get the instances of the object
+    err = DM_INST_VECTOR_GetInstances(table_node, &inst, &iv);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Iterate over all instances, adding the value of each indexed parameter to the index
+    inst.nodes[order-1] = table_node;
+    inst.order = order;
+    for (i=0; i < iv.num_entries; i++)
+    {
+        inst.instances[order-1] = iv.vector[i];
+        for (j=0; j < index->num_params; j++)
+        {
+            // Exit if unable to get the value of the parameter
+            param_node = index->params[j];
+            DM_PRIV_FormPath_FromDM(param_node, &inst, path, sizeof(path));
+            err = DM_PRIV_GetParameterValue(path, param_node, &inst, value, sizeof(value), 0);
+            if (err != USP_ERR_OK)
+            {
+                goto exit;
+            }
+
+            AddKeyIndexEntry(index, param_node, &inst, value);
+            index->num_built++;
+        }
+    }
+
+    // Add a marker entry to record that the instances with these parent instances have been indexed
+    AddKeyIndexEntry(index, NULL, &inst, "");
+    err = USP_ERR_OK;
+
+exit:
+    INT_VECTOR_Destroy(&iv);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** AddKeyIndexEntry
+**
+** Adds an entry to the index, if it does not already exist
+**
+** \param   index - pointer to index to add to
+** \param   param_node - node of the parameter, or NULL if adding a marker entry
+** \param   inst - pointer to instance numbers of the parameter (for a marker entry, only the parent instances are used)
+** \param   value - value of the parameter
+**
+** \return  None
+**
+**************************************************************************/
+void AddKeyIndexEntry(dm_key_index_t *index, dm_node_t *param_node, dm_instances_t *inst, char *value)
+{
+    key_index_entry_t *entry;
+    unsigned hash;
+    int order;
+    int bucket;
+
+    // Exit if the entry already exists
+    // NOTE: The hash only includes the parent instances of the object, as these are all that is known when searching the index
+    //       Marker entries only contain the parent instances, whilst other entries also contain the object's own instance number
+    order = index->table_node->order;
+    hash = CalcKeyIndexHash(param_node, inst->instances, order-1, value);
+    if (param_node == NULL)
+    {
+        order--;
+    }
+    if (FindKeyIndexEntry(index, hash, param_node, inst->instances, order) != NULL)
+    {
+        return;
+    }
+
+    // Grow the hash table, if it is getting too full
+    if (index->num_entries >= 2*index->num_buckets)
+    {
+        ResizeKeyIndex(index);
+    }
+
+    // Add the entry to the start of its hash bucket chain
+    entry = USP_MALLOC(sizeof(key_index_entry_t));
+    memset(entry, 0, sizeof(key_index_entry_t));
+    entry->hash = hash;
+    entry->param_node = param_node;
+    memcpy(entry->instances, inst->instances, order*sizeof(int));
+
+    bucket = hash & (index->num_buckets-1);
+    entry->next = index->buckets[bucket];
+    index->buckets[bucket] = entry;
+    index->num_entries++;
+}
+
+/*********************************************************************//**
+**
+** FindKeyIndexEntry
+**
+** Finds the specified entry in the index
+** NOTE: The value of the parameter is not stored in the entry, only its hash. So if two values have the same hash,
+**       they share an entry. This is harmless, as the instances returned by the index are only candidates.
+**
+** \param   index - pointer to index to search
+** \param   hash - hash of the entry to find
+** \param   param_node - node of the parameter in the entry to find, or NULL if finding a marker entry
+** \param   instances - pointer to array of instance numbers of the entry to find
+** \param   order - number of instance numbers in the array
+**
+** \return  pointer to entry, or NULL if the entry was not found
+**
+**************************************************************************/
+key_index_entry_t *FindKeyIndexEntry(dm_key_index_t *index, unsigned hash, dm_node_t *param_node, int *instances, int order)
+{
+    key_index_entry_t *entry;
+
+    entry = index->buckets[hash & (index->num_buckets-1)];
+    while (entry != NULL)
+    {
+        if ((entry->hash == hash) && (entry->param_node == param_node) &&
+            (memcmp(entry->instances, instances, order*sizeof(int)) == 0))
+        {
+            return entry;
+        }
+
+        entry = entry->next;
+    }
+
+    return NULL;
+}
+
+/*********************************************************************//**
+**
+** ResizeKeyIndex
+**
+** Doubles the number of buckets in the index's hash table
+**
+** \param   index - pointer to index to resize
+**
+** \return  None
+**
+**************************************************************************/
+void ResizeKeyIndex(dm_key_index_t *index)
+{
+    key_index_entry_t **new_buckets;
+    key_index_entry_t *entry;
+    key_index_entry_t *next;
+    int new_num_buckets;
+    int bucket;
+    int i;
+
+    new_num_buckets = 2*index->num_buckets;
+    new_buckets = USP_MALLOC(new_num_buckets*sizeof(key_index_entry_t *));
+    memset(new_buckets, 0, new_num_buckets*sizeof(key_index_entry_t *));
+
+    // Move all entries into the new hash table
+    for (i=0; i < index->num_buckets; i++)
+    {
+        entry = index->buckets[i];
+        while (entry != NULL)
+        {
+            next = entry->next;
+            bucket = entry->hash & (new_num_buckets-1);
+            entry->next = new_buckets[bucket];
+            new_buckets[bucket] = entry;
+            entry = next;
+        }
+    }
+
+    USP_FREE(index->buckets);
+    index->buckets = new_buckets;
+    index->num_buckets = new_num_buckets;
+}
+
+/*********************************************************************//**
+**
+** CalcKeyIndexHash
+**
+** Calculates the hash of an entry in the index, using the FNV1a algorithm
+** NOTE: Values are truncated to the length used when comparing them against unique key search expressions
+**
+** \param   param_node - node of the parameter, or NULL for a marker entry
+** \param   instances - pointer to array of parent instance numbers of the object
+** \param   order - number of parent instance numbers in the array
+** \param   value - value of the parameter
+**
+** \return  hash value
+**
+**************************************************************************/
+unsigned CalcKeyIndexHash(dm_node_t *param_node, int *instances, int order, char *value)
+{
+    #define OFFSET_BASIS (0x811C9DC5)
+    #define FNV_PRIME (0x1000193)
+    unsigned hash = OFFSET_BASIS;
+    int i;
+
+    for (i=0; (i < MAX_DM_SHORT_VALUE_LEN-1) && (value[i] != '\0'); i++)
+    {
+        hash = hash * FNV_PRIME;
+        hash = hash ^ (unsigned char)value[i];
+    }
+
+    for (i=0; i < order; i++)
+    {
+        hash = hash * FNV_PRIME;
+        hash = hash ^ (unsigned)instances[i];
+    }
+
+    hash = hash * FNV_PRIME;
+    hash = hash ^ (unsigned)(param_node != NULL ? param_node->hash : 0);
+
+    return hash;
+}
@@ -50,7 +50,9 @@
 #include "database.h"
 #include "device.h"
 #include "dm_inst_vector.h"
+#include "dm_key_index.h"
 #include "vendor_api.h"
+#include "int_vector.h"
 
 
 
@@ -70,6 +72,7 @@ static const char *op_to_str[kDMOp_Max] =
 //--------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
 void ClearTransaction(dm_trans_vector_t *trans);
+void SetGroupedVendorParams(dm_trans_vector_t *trans, kv_vector_t *failed_params, int_vector_t *failed_errs);
 
 /*********************************************************************//**
 **
@@ -85,6 +88,7 @@ void ClearTransaction(dm_trans_vector_t *trans);
 **************************************************************************/
 int DM_TRANS_Start(dm_trans_vector_t *trans)
 {
+    int i;
     int err;
     dm_vendor_start_trans_cb_t   start_trans_cb;
 
@@ -92,6 +96,14 @@ int DM_TRANS_Start(dm_trans_vector_t *trans)
     trans->num_entries = 0;
     trans->vector = NULL;
 
+    // Initialise the vectors of grouped vendor parameters to set
+    for (i=0; i < MAX_VENDOR_PARAM_GROUPS; i++)
+    {
+        KV_VECTOR_Init(&trans->group_sets[i]);
+    }
+    trans->group_fail_cb = NULL;
+    trans->group_fail_arg = NULL;
+
     // Save this vector - it will be used when adding all subsequent operations
     USP_ASSERT(cur_transaction == NULL);
     cur_transaction = trans;
@@ -100,6 +112,7 @@ int DM_TRANS_Start(dm_trans_vector_t *trans)
     err = DATABASE_StartTransaction();
     if (err != USP_ERR_OK)
     {
+        cur_transaction = NULL;
         return err;
     }
 
@@ -212,6 +225,38 @@ void DM_TRANS_Add(dm_op_t op, char *path, char *value, dm_val_union_t *val_union
     cur_transaction->num_entries = new_num_entries;
 }
 
+/*********************************************************************//**
+**
+** DM_TRANS_AddGroupedSet
+**
+** Adds the new value of a grouped vendor parameter to the current transaction
+** The value is passed to the group's set vendor hook (along with all other parameters in the group which were set)
+** when the transaction is committed
+**
+** \param   group_id - group which the parameter belongs to
+** \param   path - pointer to full data model path to parameter
+** \param   value - pointer to string containing the value which was set
+**
+** \return  None
+**
+**************************************************************************/
+void DM_TRANS_AddGroupedSet(int group_id, char *path, char *value)
+{
+    kv_vector_t *kvv;
+    bool is_replaced;
+
+    USP_ASSERT(cur_transaction != NULL);
+    USP_ASSERT((group_id >= 0) && (group_id < MAX_VENDOR_PARAM_GROUPS));
+
+    // If the parameter has already been set in this transaction, then only the last value is passed to the vendor
+    kvv = &cur_transaction->group_sets[group_id];
+    is_replaced = KV_VECTOR_Replace(kvv, path, value);
+    if (is_replaced == false)
+    {
+        KV_VECTOR_Add(kvv, path, value);
+    }
+}
+
 /*********************************************************************//**
 **
 ** DM_TRANS_Commit
@@ -234,6 +279,8 @@ int DM_TRANS_Commit(void)
     dm_trans_vector_t *trans;
     dm_trans_vector_t cascade_trans;
     dm_vendor_commit_trans_cb_t   commit_trans_cb;
+    kv_vector_t failed_params;
+    int_vector_t failed_errs;
 
     USP_ASSERT(cur_transaction != NULL);
 
@@ -247,6 +294,34 @@ int DM_TRANS_Commit(void)
     }
 #endif
 
+    // Pass all grouped vendor parameters set in the transaction to the vendor, using a single call per group
+    KV_VECTOR_Init(&failed_params);
+    INT_VECTOR_Init(&failed_errs);
+    SetGroupedVendorParams(cur_transaction, &failed_params, &failed_errs);
+    if (failed_params.num_entries > 0)
+    {
+        // Let the caller attribute the failures to the parameters in its response (if it registered a handler)
+        // Otherwise only the first failure is reported, as the caller does not have the ability to report failures per parameter
+        if (cur_transaction->group_fail_cb != NULL)
+        {
+            err = cur_transaction->group_fail_cb(&failed_params, &failed_errs, cur_transaction->group_fail_arg);
+        }
+        else
+        {
+            USP_ERR_SetMessage("%s", failed_params.vector[0].value);
+            err = failed_errs.vector[0];
+        }
+        KV_VECTOR_Destroy(&failed_params);
+        INT_VECTOR_Destroy(&failed_errs);
+
+        // Exit if the failures mean that the transaction must be aborted
+        if (err != USP_ERR_OK)
+        {
+            DM_TRANS_Abort();
+            return err;
+        }
+    }
+
     // Exit if unable to commit the vendor's database successfully, aborting the transaction
     commit_trans_cb = vendor_hook_callbacks.commit_trans_cb;
     if (commit_trans_cb != NULL)
@@ -272,6 +347,7 @@ int DM_TRANS_Commit(void)
     // Exit if there are no operations in the transaction
     if (cur_transaction->num_entries == 0)
     {
+        ClearTransaction(cur_transaction);
         cur_transaction = NULL;
         return USP_ERR_OK;
     }
@@ -393,8 +469,9 @@ int DM_TRANS_Abort(void)
 
     // Remove all instance add operations which have been aborted from the data model
 
-    // Iterate over all transactions which have been aborted
-    for (i=0; i < cur_transaction->num_entries; i++)
+    // Iterate over all transactions which have been aborted, undoing them in the reverse order to which they were performed
+    // NOTE: This ensures that an object which was added then deleted within the transaction is not left in the data model
+    for (i=cur_transaction->num_entries-1; i >= 0; i--)
     {
         dt = &cur_transaction->vector[i];
 
@@ -427,6 +504,9 @@ int DM_TRANS_Abort(void)
 
     cur_transaction = NULL;
 
+    // Discard the unique key indexes, as the database is about to be rolled back to values which they do not contain
+    DM_KEY_INDEX_InvalidateAll();
+
 #ifdef ENABLE_HIDL
     // Exit if unable to abort a HIDL client transaction 
     err = HIDL_AbortTransaction();
@@ -459,6 +539,28 @@ int DM_TRANS_Abort(void)
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** DM_TRANS_SetGroupFailureHandler
+**
+** Registers a handler which DM_TRANS_Commit() calls if the vendor fails to set any grouped vendor parameters
+** This is used by the USP Set and Add message handlers, so that failures can be reported against each parameter
+** in the response, rather than failing the whole transaction
+**
+** \param   fail_cb - handler to call with the parameters which failed. It returns an error if the transaction must be aborted
+** \param   arg - argument to pass to the handler
+**
+** \return  None
+**
+**************************************************************************/
+void DM_TRANS_SetGroupFailureHandler(dm_trans_group_fail_cb_t fail_cb, void *arg)
+{
+    USP_ASSERT(cur_transaction != NULL);
+
+    cur_transaction->group_fail_cb = fail_cb;
+    cur_transaction->group_fail_arg = arg;
+}
+
 /*********************************************************************//**
 **
 ** DM_TRANS_IsWithinTransaction
@@ -497,6 +599,12 @@ void ClearTransaction(dm_trans_vector_t *trans)
     int i;
     dm_trans_t *dt;
 
+    // Free all grouped vendor parameters which were set
+    for (i=0; i < MAX_VENDOR_PARAM_GROUPS; i++)
+    {
+        KV_VECTOR_Destroy(&trans->group_sets[i]);
+    }
+
     // Exit if nothing to do
     if (trans->vector == NULL)
     {
@@ -545,3 +653,82 @@ exit:
 
 
 
+
+/*********************************************************************//**
+**
+** SetGroupedVendorParams
+**
+** Passes the new values of all grouped vendor parameters set in the transaction to the vendor,
+** using a single call to the set vendor hook of each group
+**
+** \param   trans - transaction containing the grouped vendor parameters to set
+** \param   failed_params - key-value vector in which to return the path and error message of each parameter which failed to be set
+** \param   failed_errs - vector in which to return the USP error code of each parameter which failed to be set (parallel to failed_params)
+**
+** \return  None - errors are returned in failed_params and failed_errs
+**
+**************************************************************************/
+void SetGroupedVendorParams(dm_trans_vector_t *trans, kv_vector_t *failed_params, int_vector_t *failed_errs)
+{
+    int i, j;
+    int err;
+    int *failures;
+    kv_vector_t *kvv;
+    dm_set_group_cb_t set_group_cb;
+    char *msg;
+    char buf[USP_ERR_MAXLEN];
+
+    for (i=0; i < MAX_VENDOR_PARAM_GROUPS; i++)
+    {
+        // Skip groups which did not have any parameters set
+        kvv = &trans->group_sets[i];
+        if (kvv->num_entries == 0)
+        {
+            continue;
+        }
+
+        // NOTE: The set vendor hook is guaranteed to be registered, as DATA_MODEL_SetParameterValue() checks this
+        set_group_cb = group_vendor_hooks[i].set_group_cb;
+        USP_ASSERT(set_group_cb != NULL);
+
+        // Allocate an array in which the vendor returns the error code of each parameter which it failed to set
+        failures = USP_MALLOC(kvv->num_entries * sizeof(int));
+        for (j=0; j < kvv->num_entries; j++)
+        {
+            failures[j] = USP_ERR_OK;
+        }
+
+        // Pass the parameters to the vendor
+        // If the vendor hook returns an error, then all parameters which the vendor did not mark as failed are treated as failing with that error
+        USP_ERR_ClearMessage();
+        err = set_group_cb(i, kvv, failures);
+        msg = USP_ERR_GetMessage();
+
+        // Collect the parameters which failed
+        for (j=0; j < kvv->num_entries; j++)
+        {
+            if ((failures[j] == USP_ERR_OK) && (err != USP_ERR_OK))
+            {
+                failures[j] = err;
+            }
+
+            if (failures[j] != USP_ERR_OK)
+            {
+                if (msg[0] == '\0')
+                {
+                    USP_SNPRINTF(buf, sizeof(buf), "%s: Set group callback for group %d failed to set %s (error %d)", __FUNCTION__, i, kvv->vector[j].key, failures[j]);
+                    KV_VECTOR_Add(failed_params, kvv->vector[j].key, buf);
+                }
+                else
+                {
+                    KV_VECTOR_Add(failed_params, kvv->vector[j].key, msg);
+                }
+                INT_VECTOR_Add(failed_errs, failures[j]);
+            }
+        }
+
+        // Free the parameters, now that they have been passed to the vendor
+        USP_FREE(failures);
+        KV_VECTOR_Destroy(kvv);
+    }
+}
@@ -44,6 +44,7 @@
 #define DM_TRANS_H
 
 #include "data_model.h"
+#include "int_vector.h"
 
 //-----------------------------------------------------------------------
 // Enumeration for type of operation that the Data model supports
@@ -69,20 +70,31 @@ typedef struct
     dm_val_union_t val_union;  // Stores the native value of the parameter (only used by kTransType_Set). If the parameter is a string, then it will point to the 'value' parameter in this structure
 } dm_trans_t;
 
+//-----------------------------------------------------------------------
+// Handler called by DM_TRANS_Commit() with the grouped vendor parameters which the vendor failed to set
+// It attributes the failures to the parameters in a USP response, and returns an error if the transaction must be aborted
+typedef int (*dm_trans_group_fail_cb_t)(kv_vector_t *failed_params, int_vector_t *failed_errs, void *arg);
+
 //-----------------------------------------------------------------------
 // Vector storing all operations made during a transaction
 typedef struct
 {
     int num_entries;
     dm_trans_t *vector;
+    kv_vector_t group_sets[MAX_VENDOR_PARAM_GROUPS];   // New values of grouped vendor parameters set during the transaction, indexed by group_id
+                                                       // These are passed to the group's set vendor hook when the transaction is committed
+    dm_trans_group_fail_cb_t group_fail_cb;            // Handler to call if the vendor fails to set any grouped vendor parameters, or NULL to abort the transaction
+    void *group_fail_arg;                              // Argument to pass to group_fail_cb
 } dm_trans_vector_t;
 
 //-----------------------------------------------------------------------------------------
 // API
 int DM_TRANS_Start(dm_trans_vector_t *trans);
 void DM_TRANS_Add(dm_op_t op, char *path, char *value, dm_val_union_t *val_union, dm_node_t *node, dm_instances_t *inst);
+void DM_TRANS_AddGroupedSet(int group_id, char *path, char *value);
 int DM_TRANS_Commit(void);
 int DM_TRANS_Abort(void);
 bool DM_TRANS_IsWithinTransaction(void);
+void DM_TRANS_SetGroupFailureHandler(dm_trans_group_fail_cb_t fail_cb, void *arg);
 
 #endif
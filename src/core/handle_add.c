@@ -40,6 +40,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <protobuf-c/protobuf-c.h>
 
 #include "usp-msg.pb-c.h"
@@ -60,6 +61,17 @@
 //       containing param_err objects
 str_vector_t add_oper_failure_param_names;
 
+//------------------------------------------------------------------------------
+// Structure passed to MapGroupedAddFailures(), identifying the results in the AddResponse which were added within a transaction
+typedef struct
+{
+    Usp__AddResp *add_resp;                 // AddResponse containing the results of the objects created within the transaction
+    int first_result;                       // Index of the first created_obj_result in add_resp which was added within the transaction
+    Usp__Add__CreateObject **create_objs;   // CreateObjects in the AddRequest which were processed within the transaction
+    int n_create_objs;                      // Number of entries in create_objs
+    bool required_failed;                   // Set if the vendor failed to set a grouped vendor parameter which was required to be set
+} add_group_fail_t;
+
 //------------------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
 int CreateExpressionObjects(Usp__AddResp *add_resp, Usp__Add__CreateObject *cr, bool allow_partial);
@@ -69,9 +81,13 @@ Usp__Msg *CreateAddResp(char *msg_id);
 Usp__AddResp__CreatedObjectResult__OperationStatus__OperationFailure *AddResp_OperFailure(Usp__AddResp *add_resp, char *path, char *param_name, int err_code, char *err_msg);
 Usp__AddResp__CreatedObjectResult__OperationStatus__OperationSuccess *AddResp_OperSuccess(Usp__AddResp *add_resp, char *req_path, char *path);
 void RemoveAddResp_LastCreatedObjResult(Usp__AddResp *add_resp);
+void RemoveAddResp_CreatedObjResult(Usp__AddResp *add_resp, int index);
 Usp__AddResp__ParameterError *AddResp_OperSuccess_ParamErr(Usp__AddResp__CreatedObjectResult__OperationStatus__OperationSuccess *oper_success, char *path, int err_code, char *err_msg);
 void AddOperSuccess_UniqueKeys(Usp__AddResp__CreatedObjectResult__OperationStatus__OperationSuccess *oper_success, kv_vector_t *kvv);
 int ParamError_FromAddRespToErrResp(Usp__Msg *add_msg, Usp__Msg *err_msg);
+int MapGroupedAddFailures(kv_vector_t *failed_params, int_vector_t *failed_errs, void *arg);
+bool MapGroupedAddFailure(add_group_fail_t *agf, char *path, int err_code, char *err_msg);
+Usp__Add__CreateParamSetting *FindCreateParamSetting(add_group_fail_t *agf, char *obj_path, char *param);
 
 
 /*********************************************************************//**
@@ -95,6 +111,7 @@ void MSG_HANDLER_HandleAdd(Usp__Msg *usp, char *controller_endpoint, mtp_reply_t
     Usp__Add__CreateObject *cr;
     Usp__Msg *resp = NULL;
     dm_trans_vector_t trans;
+    add_group_fail_t agf;
     int count;
 
     STR_VECTOR_Init(&add_oper_failure_param_names);
@@ -122,6 +139,7 @@ void MSG_HANDLER_HandleAdd(Usp__Msg *usp, char *controller_endpoint, mtp_reply_t
     }
 
     // Start a transaction here, if allow_partial is at the global level
+    agf.required_failed = false;
     if (add->allow_partial == false)
     {
         err = DM_TRANS_Start(&trans);
@@ -131,6 +149,13 @@ void MSG_HANDLER_HandleAdd(Usp__Msg *usp, char *controller_endpoint, mtp_reply_t
             resp = ERROR_RESP_CreateSingle(usp->header->msg_id, err, resp, NULL);
             goto exit;
         }
+
+        // Attribute any grouped vendor parameters which the vendor fails to set at commit, to the parameters in the response
+        agf.add_resp = resp->body->response->add_resp;
+        agf.first_result = 0;
+        agf.create_objs = add->create_objs;
+        agf.n_create_objs = add->n_create_objs;
+        DM_TRANS_SetGroupFailureHandler(MapGroupedAddFailures, &agf);
     }
 
     // Iterate over all create objects in the message
@@ -161,8 +186,19 @@ void MSG_HANDLER_HandleAdd(Usp__Msg *usp, char *controller_endpoint, mtp_reply_t
         err = DM_TRANS_Commit();
         if (err != USP_ERR_OK)
         {
-            // If failed to commit, delete the AddResponse message, and send an error message instead
-            resp = ERROR_RESP_CreateSingle(usp->header->msg_id, err, resp, NULL);
+            if (agf.required_failed)
+            {
+                // The vendor failed to set a required grouped vendor parameter
+                // So delete the AddResponse message, and send an error message containing the failed parameter instead
+                count = ParamError_FromAddRespToErrResp(resp, NULL);
+                err = ERROR_RESP_CalcOuterErrCode(count, err);
+                resp = ERROR_RESP_CreateSingle(usp->header->msg_id, err, resp, ParamError_FromAddRespToErrResp);
+            }
+            else
+            {
+                // If failed to commit, delete the AddResponse message, and send an error message instead
+                resp = ERROR_RESP_CreateSingle(usp->header->msg_id, err, resp, NULL);
+            }
             goto exit;
         }
     }
@@ -262,8 +298,10 @@ int CreateObject_Trans(char *obj_path, Usp__AddResp *add_resp, Usp__Add__CreateO
 {
     int err;
     dm_trans_vector_t trans;
+    add_group_fail_t agf;
     
     // Start a transaction here, if allow_partial is at the object level
+    agf.required_failed = false;
     if (allow_partial == true)
     {
         // Return OperFailure, if failed to start a transaction
@@ -273,6 +311,13 @@ int CreateObject_Trans(char *obj_path, Usp__AddResp *add_resp, Usp__Add__CreateO
             AddResp_OperFailure(add_resp, cr->obj_path, NULL, err, USP_ERR_GetMessage());
             return err;
         }
+
+        // Attribute any grouped vendor parameters which the vendor fails to set at commit, to the parameters in the response
+        agf.add_resp = add_resp;
+        agf.first_result = add_resp->n_created_obj_results;
+        agf.create_objs = &cr;
+        agf.n_create_objs = 1;
+        DM_TRANS_SetGroupFailureHandler(MapGroupedAddFailures, &agf);
     }
 
     // Create the specified object
@@ -284,7 +329,13 @@ int CreateObject_Trans(char *obj_path, Usp__AddResp *add_resp, Usp__Add__CreateO
         if (err == USP_ERR_OK)
         {
             err = DM_TRANS_Commit();
-            if (err != USP_ERR_OK)
+            if (agf.required_failed)
+            {
+                // The vendor failed to set a required grouped vendor parameter, and the response already contains an
+                // OperFailure for it. Because allow_partial=true, we do not fail the entire message
+                err = USP_ERR_OK;
+            }
+            else if (err != USP_ERR_OK)
             {
                 // If transaction failed, then replace the OperSuccess with OperFailure
                 // To do this, we remove the last OperSuccessObject from the USP message
@@ -819,3 +870,182 @@ void AddOperSuccess_UniqueKeys(Usp__AddResp__CreatedObjectResult__OperationStatu
     kvv->num_entries = 0;
 }
 
+/*********************************************************************//**
+**
+** RemoveAddResp_CreatedObjResult
+**
+** Removes the specified CreatedObjResult object from the AddResp object
+** The CreatedObjResult object will contain either an OperSuccess or an OperFailure
+**
+** \param   add_resp - pointer to add response object to modify
+** \param   index - index of the CreatedObjResult object to remove
+**
+** \return  None
+**
+**************************************************************************/
+void RemoveAddResp_CreatedObjResult(Usp__AddResp *add_resp, int index)
+{
+    Usp__AddResp__CreatedObjectResult *created_obj_res;
+    int num_after;
+
+    // Free the memory associated with the created obj_result
+    USP_ASSERT((index >= 0) && (index < add_resp->n_created_obj_results));
+    created_obj_res = add_resp->created_obj_results[index];
+    protobuf_c_message_free_unpacked ((ProtobufCMessage*)created_obj_res, pbuf_allocator);
+
+    // Fix the AddResp object, so that it does not reference the obj_result we have just removed
+    num_after = add_resp->n_created_obj_results - index - 1;
+    memmove(&add_resp->created_obj_results[index], &add_resp->created_obj_results[index+1], num_after*sizeof(void *));
+    add_resp->n_created_obj_results--;
+    add_resp->created_obj_results[add_resp->n_created_obj_results] = NULL;
+}
+
+/*********************************************************************//**
+**
+** MapGroupedAddFailures
+**
+** Called by DM_TRANS_Commit() if the vendor failed to set any grouped vendor parameters
+** This attributes each failure to the parameter in the AddResponse, honouring its required flag
+**
+** \param   failed_params - key-value vector containing the path and error message of each parameter which failed to be set
+** \param   failed_errs - vector containing the USP error code of each parameter which failed to be set (parallel to failed_params)
+** \param   arg - pointer to add_group_fail_t structure identifying the results in the AddResponse added within the transaction
+**
+** \return  USP_ERR_OK if the transaction should be committed, or the error of the first required parameter which failed
+**
+**************************************************************************/
+int MapGroupedAddFailures(kv_vector_t *failed_params, int_vector_t *failed_errs, void *arg)
+{
+    int i;
+    int err = USP_ERR_OK;
+    bool required;
+    add_group_fail_t *agf = (add_group_fail_t *) arg;
+
+    for (i=0; i < failed_params->num_entries; i++)
+    {
+        required = MapGroupedAddFailure(agf, failed_params->vector[i].key, failed_errs->vector[i], failed_params->vector[i].value);
+        if ((required) && (err == USP_ERR_OK))
+        {
+            // Save the error of the first parameter which was required to be set, but failed
+            err = failed_errs->vector[i];
+            USP_ERR_SetMessage("%s", failed_params->vector[i].value);
+        }
+    }
+
+    return err;
+}
+
+/*********************************************************************//**
+**
+** MapGroupedAddFailure
+**
+** Attributes the failure to set a grouped vendor parameter to the parameter in the AddResponse
+** If the parameter was not required, then it is added to the ParamErr list of the object
+** If the parameter was required, then the OperSuccess of the object is replaced with an OperFailure
+**
+** \param   agf - pointer to structure identifying the results in the AddResponse added within the transaction
+** \param   path - full data model path of the parameter which failed to be set
+** \param   err_code - error code representing the cause of the failure
+** \param   err_msg - string representing the cause of the failure
+**
+** \return  true if the parameter was required to be set
+**
+**************************************************************************/
+bool MapGroupedAddFailure(add_group_fail_t *agf, char *path, int err_code, char *err_msg)
+{
+    int i;
+    int len;
+    Usp__AddResp *add_resp = agf->add_resp;
+    Usp__AddResp__CreatedObjectResult *created_obj_res;
+    Usp__AddResp__CreatedObjectResult__OperationStatus *oper_status;
+    Usp__AddResp__CreatedObjectResult__OperationStatus__OperationSuccess *oper_success;
+    Usp__Add__CreateParamSetting *ps;
+    char *param;
+    char requested_path[MAX_DM_PATH];
+
+    for (i=agf->first_result; i < add_resp->n_created_obj_results; i++)
+    {
+        // Skip objects which failed to be created
+        created_obj_res = add_resp->created_obj_results[i];
+        oper_status = created_obj_res->oper_status;
+        if (oper_status->oper_status_case != USP__ADD_RESP__CREATED_OBJECT_RESULT__OPERATION_STATUS__OPER_STATUS_OPER_SUCCESS)
+        {
+            continue;
+        }
+
+        // Skip if the parameter is not one that was set in this object
+        oper_success = oper_status->oper_success;
+        len = strlen(oper_success->instantiated_path);
+        if (strncmp(path, oper_success->instantiated_path, len) != 0)
+        {
+            continue;
+        }
+        param = &path[len];
+        ps = FindCreateParamSetting(agf, created_obj_res->requested_path, param);
+        if (ps == NULL)
+        {
+            continue;
+        }
+
+        if (ps->required == false)
+        {
+            // This parameter failed to be set, but was not required
+            // So add it to the ParamErr list
+            AddResp_OperSuccess_ParamErr(oper_success, param, err_code, err_msg);
+            return false;
+        }
+
+        // This parameter was required to be set, but failed, so replace the OperSuccess with OperFailure
+        USP_STRNCPY(requested_path, created_obj_res->requested_path, sizeof(requested_path));
+        RemoveAddResp_CreatedObjResult(add_resp, i);
+        AddResp_OperFailure(add_resp, requested_path, ps->param, err_code, err_msg);
+        agf->required_failed = true;
+        return true;
+    }
+
+    // If the code gets here, then the parameter was not set by the AddRequest (eg it was set by a vendor hook),
+    // or its object has already failed because another required parameter failed
+    USP_LOG_Warning("%s: Vendor failed to set %s (%s)", __FUNCTION__, path, err_msg);
+    return false;
+}
+
+/*********************************************************************//**
+**
+** FindCreateParamSetting
+**
+** Finds the parameter setting in the AddRequest which set the specified parameter
+**
+** \param   agf - pointer to structure identifying the CreateObjects processed within the transaction
+** \param   obj_path - requested path of the CreateObject
+** \param   param - name of the parameter, relative to the object
+**
+** \return  pointer to parameter setting, or NULL if the parameter was not set by the AddRequest
+**
+**************************************************************************/
+Usp__Add__CreateParamSetting *FindCreateParamSetting(add_group_fail_t *agf, char *obj_path, char *param)
+{
+    int i, j;
+    Usp__Add__CreateObject *cr;
+    Usp__Add__CreateParamSetting *ps;
+
+    for (i=0; i < agf->n_create_objs; i++)
+    {
+        cr = agf->create_objs[i];
+        if ((cr->obj_path == NULL) || (strcmp(cr->obj_path, obj_path) != 0))
+        {
+            continue;
+        }
+
+        for (j=0; j < cr->n_param_settings; j++)
+        {
+            ps = cr->param_settings[j];
+            if (strcmp(ps->param, param)==0)
+            {
+                return ps;
+            }
+        }
+    }
+
+    return NULL;
+}
+
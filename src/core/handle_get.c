@@ -52,9 +52,27 @@
 #include "device.h"
 #include "text_utils.h"
 
+//------------------------------------------------------------------------------
+// Maximum number of resolved parameters whose values are got together, when processing a path expression in a Get request
+// Parameters are added to the response in batches of this size as they are resolved, rather than all being resolved first
+#define MAX_GET_BATCH_PARAMS 256
+
+//------------------------------------------------------------------------------
+// State used whilst adding the parameters resolved from a single path expression to the Get response
+typedef struct
+{
+    Usp__GetResp__RequestedPathResult *req_path_result; // requested path result to add the parameters to
+    kv_vector_t batch;              // Resolved parameters whose values have not been got yet
+    int separator_split;            // Point at which to split the paths of the parameters in the batch
+    int first_separator_split;      // Point at which the paths of the first batch of parameters were split, or INVALID if no batch has been added yet
+} get_path_state_t;
+
 //------------------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
 void GetSinglePath(Usp__Msg *resp, char *path_expression);
+int GetSinglePath_PathFound(char *path, dm_node_t *node, dm_instances_t *inst, int separator_split, void *cb_arg);
+int AddGetBatch(get_path_state_t *gs);
+void ResplitResolvedPathResults(Usp__GetResp__RequestedPathResult *req_path_result, int separator_split);
 void AddResolvedPathResult(Usp__GetResp__RequestedPathResult *req_path_result, char *path, char *value, int separator_split);
 Usp__GetResp__ResolvedPathResult *FindResolvedPath(Usp__GetResp__RequestedPathResult *req_path_result, char *obj_path);
 Usp__Msg *CreateGetResp(char *msg_id);
@@ -135,59 +153,171 @@ exit:
 **************************************************************************/
 void GetSinglePath(Usp__Msg *resp, char *path_expression)
 {
-    int i;
     int err;
-    str_vector_t params;
-    Usp__GetResp__RequestedPathResult *req_path_result;
-    char value[MAX_DM_VALUE_LEN];
+    get_path_state_t gs;
     int separator_split;
     combined_role_t combined_role;
 
-    // Exit if the search path is not in the schema or the search path was invalid or an error occured in evaluating the search path (eg a parameter get failed)
-    // The get response will contain an error message in this case
-    STR_VECTOR_Init(&params);
+    // Add a requested path result to the Get Response message
+    // NOTE: If no matching parameters are found in the data model, then the get response should contain an empty results list
+    gs.req_path_result = AddGetResp_ReqPathRes(resp, path_expression, USP_ERR_OK, "");
+    KV_VECTOR_Init(&gs.batch);
+    gs.separator_split = 0;
+    gs.first_separator_split = INVALID;
+
+    // Resolve the search path, adding the values of the parameters to the requested path result as they are found
     MSG_HANDLER_GetMsgRole(&combined_role);
-    err = PATH_RESOLVER_ResolveDevicePath(path_expression, &params, kResolveOp_Get, &separator_split, &combined_role, 0);
+    err = PATH_RESOLVER_IterateDevicePath(path_expression, GetSinglePath_PathFound, &gs, kResolveOp_Get, &separator_split, &combined_role, 0);
+    if (err == USP_ERR_OK)
+    {
+        gs.separator_split = separator_split;
+        err = AddGetBatch(&gs);
+    }
+
+    // Exit if the search path is not in the schema or the search path was invalid or an error occured in evaluating the search path (eg a parameter get failed)
+    // The get response will contain only an error message in this case
     if (err != USP_ERR_OK)
     {
-        req_path_result = AddGetResp_ReqPathRes(resp, path_expression, err, USP_ERR_GetMessage());
-        (void)req_path_result; // Keep Clang static analyser happy
+        DestroyCurReqPathResult(resp, gs.req_path_result);
+        gs.req_path_result = AddGetResp_ReqPathRes(resp, path_expression, err, USP_ERR_GetMessage());
+        (void)gs.req_path_result;  // Keep Clang static analyser happy
         goto exit;
     }
 
-    // Add a requested path result to the Get Response message
-    req_path_result = AddGetResp_ReqPathRes(resp, path_expression, USP_ERR_OK, "");
+    // If the point at which to split the paths increased whilst resolving (which may occur if a reference was followed),
+    // then split the paths of the parameters already added to the response at the final split point
+    if ((gs.first_separator_split != INVALID) && (gs.first_separator_split != separator_split))
+    {
+        ResplitResolvedPathResults(gs.req_path_result, separator_split);
+    }
+
+exit:
+    KV_VECTOR_Destroy(&gs.batch);
+}
+
+/*********************************************************************//**
+**
+** GetSinglePath_PathFound
+**
+** Called by the path resolver for each parameter resolved from the path expression of a Get request
+** The parameter is added to the current batch, and the batch is added to the Get response once it is full
+**
+** \param   path - data model path of the parameter
+** \param   node - data model node of the parameter
+** \param   inst - pointer to instance numbers of the parameter
+** \param   separator_split - point at which to split the path of the parameter
+** \param   cb_arg - pointer to state of the get of this path expression
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int GetSinglePath_PathFound(char *path, dm_node_t *node, dm_instances_t *inst, int separator_split, void *cb_arg)
+{
+    get_path_state_t *gs = (get_path_state_t *) cb_arg;
+    int err;
+
+    KV_VECTOR_Add(&gs->batch, path, "");
+    gs->separator_split = separator_split;
+
+    // Exit if the batch is not full yet
+    if (gs->batch.num_entries < MAX_GET_BATCH_PARAMS)
+    {
+        return USP_ERR_OK;
+    }
+
+    err = AddGetBatch(gs);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** AddGetBatch
+**
+** Gets the values of the parameters in the current batch, and adds them to the Get response
+**
+** \param   gs - pointer to state of the get of this path expression
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int AddGetBatch(get_path_state_t *gs)
+{
+    int i;
+    int err;
 
-    // Exit if no matching parameters were found in the data model
-    if (params.num_entries==0)
+    // Exit if there are no parameters in the batch
+    if (gs->batch.num_entries == 0)
+    {
+        return USP_ERR_OK;
+    }
+
+    // Exit if unable to get the value of all params in the batch (grouped vendor params are got together)
+    err = DATA_MODEL_GetParameterValues(&gs->batch, 0);
+    if (err != USP_ERR_OK)
     {
-        // The get response should contain an empty results list in this case
-        // So do not set the error message
-        //USP_ERR_SetMessage("%s: Invalid instance number or no instances found of '%s'", __FUNCTION__, path_expression);
         goto exit;
     }
 
-    // Iterate over all resolved params adding their value to the result_params
-    for (i=0; i < params.num_entries; i++)
+    // Iterate over all params in the batch, adding their value to the result_params
+    for (i=0; i < gs->batch.num_entries; i++)
+    {
+        AddResolvedPathResult(gs->req_path_result, gs->batch.vector[i].key, gs->batch.vector[i].value, gs->separator_split);
+    }
+
+    if (gs->first_separator_split == INVALID)
+    {
+        gs->first_separator_split = gs->separator_split;
+    }
+    err = USP_ERR_OK;
+
+exit:
+    KV_VECTOR_Destroy(&gs->batch);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** ResplitResolvedPathResults
+**
+** Splits the paths of all parameters in the requested path result into object path and parameter name again,
+** using the specified split point
+**
+** \param   req_path_result - pointer to requested_path_result containing the parameters
+** \param   separator_split - denotes where to split the parameter paths based on the number of separators for the object that required resolution
+**
+** \return  None
+**
+**************************************************************************/
+void ResplitResolvedPathResults(Usp__GetResp__RequestedPathResult *req_path_result, int separator_split)
+{
+    int i, j;
+    int num_resolved_path_results;
+    Usp__GetResp__ResolvedPathResult **resolved_path_results;
+    Usp__GetResp__ResolvedPathResult *resolved_path_res;
+    Usp__GetResp__ResolvedPathResult__ResultParamsEntry *res_params_entry;
+    char path[MAX_DM_PATH];
+
+    // Detach the existing resolved path results from the requested path result
+    resolved_path_results = req_path_result->resolved_path_results;
+    num_resolved_path_results = req_path_result->n_resolved_path_results;
+    req_path_result->resolved_path_results = NULL;
+    req_path_result->n_resolved_path_results = 0;
+
+    // Iterate over all parameters in the existing resolved path results, adding them back using the new split point
+    for (i=0; i < num_resolved_path_results; i++)
     {
-        // Exit if unable to get the value of a parameter
-        // The get response will contain only an error message in this case
-        err = DATA_MODEL_GetParameterValue(params.vector[i], value, sizeof(value), 0);
-        if (err != USP_ERR_OK)
+        resolved_path_res = resolved_path_results[i];
+        for (j=0; j < resolved_path_res->n_result_params; j++)
         {
-            DestroyCurReqPathResult(resp, req_path_result);
-            req_path_result = AddGetResp_ReqPathRes(resp, path_expression, err, USP_ERR_GetMessage());
-            (void)req_path_result;  // Keep Clang static analyser happy
-            goto exit;
+            res_params_entry = resolved_path_res->result_params[j];
+            USP_SNPRINTF(path, sizeof(path), "%s%s", resolved_path_res->resolved_path, res_params_entry->key);
+            AddResolvedPathResult(req_path_result, path, res_params_entry->value, separator_split);
         }
 
-        // Add a param map entry to the requested path result
-        AddResolvedPathResult(req_path_result, params.vector[i], value, separator_split);
+        DestroyResolvedPathResult(resolved_path_res);
     }
 
-
-exit:
-    STR_VECTOR_Destroy(&params);
+    USP_SAFE_FREE(resolved_path_results);
 }
 
 /*********************************************************************//**
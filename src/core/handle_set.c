@@ -54,6 +54,17 @@
 #include "path_resolver.h"
 #include "device.h"
 
+//------------------------------------------------------------------------------
+// Structure passed to MapGroupedSetFailures(), identifying the results in the SetResponse which were added within a transaction
+typedef struct
+{
+    Usp__SetResp *set_resp;                 // SetResponse containing the results of the objects updated within the transaction
+    int first_result;                       // Index of the first updated_obj_result in set_resp which was added within the transaction
+    Usp__Set__UpdateObject **update_objs;   // UpdateObjects in the SetRequest which were processed within the transaction
+    int n_update_objs;                      // Number of entries in update_objs
+    bool required_failed;                   // Set if the vendor failed to set a grouped vendor parameter which was required to be set
+} set_group_fail_t;
+
 //------------------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
 int UpdateExpressionObjects(Usp__SetResp *set_resp, Usp__Set__UpdateObject *up, bool allow_partial);
@@ -74,7 +85,12 @@ Usp__SetResp__UpdatedInstanceResult *AddOperSuccess_UpdatedInstRes(Usp__SetResp_
 Usp__SetResp__UpdatedInstanceResult__UpdatedParamsEntry *AddUpdatedInstRes_ParamsEntry(Usp__SetResp__UpdatedInstanceResult *updated_inst_result, char *key, char *value);
 Usp__SetResp__ParameterError *AddUpdatedInstRes_ParamErr(Usp__SetResp__UpdatedInstanceResult *updated_inst_result, char *path, int err_code, char *err_msg);
 void RemoveSetResp_LastUpdateObjResult(Usp__SetResp *set_resp);
+void RemoveSetResp_UpdateObjResult(Usp__SetResp *set_resp, int index);
+void RemoveUpdatedInstRes_ParamsEntry(Usp__SetResp__UpdatedInstanceResult *updated_inst_result, char *key);
 int ParamError_FromSetRespToErrResp(Usp__Msg *set_msg, Usp__Msg *err_msg);
+int MapGroupedSetFailures(kv_vector_t *failed_params, int_vector_t *failed_errs, void *arg);
+bool MapGroupedSetFailure(set_group_fail_t *sgf, char *path, int err_code, char *err_msg);
+Usp__Set__UpdateParamSetting *FindUpdateParamSetting(set_group_fail_t *sgf, char *obj_path, char *param);
 
 /*********************************************************************//**
 **
@@ -97,6 +113,7 @@ void MSG_HANDLER_HandleSet(Usp__Msg *usp, char *controller_endpoint, mtp_reply_t
     Usp__Set *set;
     Usp__Msg *resp = NULL;
     dm_trans_vector_t trans;
+    set_group_fail_t sgf;
     int count;
 
     // Exit if message is invalid or failed to parse
@@ -122,6 +139,7 @@ void MSG_HANDLER_HandleSet(Usp__Msg *usp, char *controller_endpoint, mtp_reply_t
     }
 
     // Start a transaction here, if allow_partial is at the global level
+    sgf.required_failed = false;
     if (set->allow_partial == false)
     {
         err = DM_TRANS_Start(&trans);
@@ -131,6 +149,13 @@ void MSG_HANDLER_HandleSet(Usp__Msg *usp, char *controller_endpoint, mtp_reply_t
             resp = ERROR_RESP_CreateSingle(usp->header->msg_id, err, resp, NULL);
             goto exit;
         }
+
+        // Attribute any grouped vendor parameters which the vendor fails to set at commit, to the parameters in the response
+        sgf.set_resp = resp->body->response->set_resp;
+        sgf.first_result = 0;
+        sgf.update_objs = set->update_objs;
+        sgf.n_update_objs = set->n_update_objs;
+        DM_TRANS_SetGroupFailureHandler(MapGroupedSetFailures, &sgf);
     }
 
     // Iterate over all update objects in the message
@@ -161,8 +186,19 @@ void MSG_HANDLER_HandleSet(Usp__Msg *usp, char *controller_endpoint, mtp_reply_t
         err = DM_TRANS_Commit();
         if (err != USP_ERR_OK)
         {
-            // If failed to commit, delete the SetResponse message, and send an error message instead
-            resp = ERROR_RESP_CreateSingle(usp->header->msg_id, err, resp, NULL);
+            if (sgf.required_failed)
+            {
+                // The vendor failed to set a required grouped vendor parameter
+                // So delete the SetResponse message, and send an error message containing the failed parameters instead
+                count = ParamError_FromSetRespToErrResp(resp, NULL);
+                err = ERROR_RESP_CalcOuterErrCode(count, err);
+                resp = ERROR_RESP_CreateSingle(usp->header->msg_id, err, resp, ParamError_FromSetRespToErrResp);
+            }
+            else
+            {
+                // If failed to commit, delete the SetResponse message, and send an error message instead
+                resp = ERROR_RESP_CreateSingle(usp->header->msg_id, err, resp, NULL);
+            }
             goto exit;
         }
     }
@@ -271,8 +307,10 @@ int UpdateObject_Trans(char *obj_path,
 {
     int err;
     dm_trans_vector_t trans;
+    set_group_fail_t sgf;
     
     // Start a transaction here, if allow_partial is at the object level
+    sgf.required_failed = false;
     if (allow_partial == true)
     {
         // Return OperFailure, if failed to start a transaction
@@ -282,6 +320,13 @@ int UpdateObject_Trans(char *obj_path,
             AddSetResp_OperFailure(set_resp, up->obj_path, err, USP_ERR_GetMessage());
             return err;
         }
+
+        // Attribute any grouped vendor parameters which the vendor fails to set at commit, to the parameters in the response
+        sgf.set_resp = set_resp;
+        sgf.first_result = set_resp->n_updated_obj_results;
+        sgf.update_objs = &up;
+        sgf.n_update_objs = 1;
+        DM_TRANS_SetGroupFailureHandler(MapGroupedSetFailures, &sgf);
     }
 
     // Update the specified object
@@ -293,7 +338,13 @@ int UpdateObject_Trans(char *obj_path,
         if (err == USP_ERR_OK)
         {
             err = DM_TRANS_Commit();
-            if (err != USP_ERR_OK)
+            if (sgf.required_failed)
+            {
+                // The vendor failed to set a required grouped vendor parameter, and the response already contains an
+                // OperFailure for it. Because allow_partial=true, we do not fail the entire message
+                err = USP_ERR_OK;
+            }
+            else if (err != USP_ERR_OK)
             {
                 // If transaction failed, then replace the OperSuccess with OperFailure
                 // To do this, we remove the last OperSuccessObject from the USP message
@@ -894,3 +945,253 @@ AddUpdatedInstRes_ParamErr(Usp__SetResp__UpdatedInstanceResult *updated_inst_res
     return param_err_entry;
 }
 
+/*********************************************************************//**
+**
+** RemoveSetResp_UpdateObjResult
+**
+** Removes the specified UpdateObjResult object from the SetResp object
+** The UpdateObjResult object will contain either an OperSuccess or an OperFailure
+**
+** \param   set_resp - pointer to set response object to modify
+** \param   index - index of the UpdateObjResult object to remove
+**
+** \return  None
+**
+**************************************************************************/
+void RemoveSetResp_UpdateObjResult(Usp__SetResp *set_resp, int index)
+{
+    Usp__SetResp__UpdatedObjectResult *updated_obj_res;
+    int num_after;
+
+    // Free the memory associated with the updated obj_result
+    USP_ASSERT((index >= 0) && (index < set_resp->n_updated_obj_results));
+    updated_obj_res = set_resp->updated_obj_results[index];
+    protobuf_c_message_free_unpacked ((ProtobufCMessage*)updated_obj_res, pbuf_allocator);
+
+    // Fix the SetResp object, so that it does not reference the obj_result we have just removed
+    num_after = set_resp->n_updated_obj_results - index - 1;
+    memmove(&set_resp->updated_obj_results[index], &set_resp->updated_obj_results[index+1], num_after*sizeof(void *));
+    set_resp->n_updated_obj_results--;
+    set_resp->updated_obj_results[set_resp->n_updated_obj_results] = NULL;
+}
+
+/*********************************************************************//**
+**
+** RemoveUpdatedInstRes_ParamsEntry
+**
+** Removes the specified param map entry from an updated instance result object
+**
+** \param   updated_inst_result - pointer to updated instance result object to remove the entry from
+** \param   key - name of the parameter to remove
+**
+** \return  None
+**
+**************************************************************************/
+void RemoveUpdatedInstRes_ParamsEntry(Usp__SetResp__UpdatedInstanceResult *updated_inst_result, char *key)
+{
+    int i;
+    int num_after;
+    Usp__SetResp__UpdatedInstanceResult__UpdatedParamsEntry *entry;
+
+    for (i=0; i < updated_inst_result->n_updated_params; i++)
+    {
+        entry = updated_inst_result->updated_params[i];
+        if (strcmp(entry->key, key)==0)
+        {
+            protobuf_c_message_free_unpacked ((ProtobufCMessage*)entry, pbuf_allocator);
+            num_after = updated_inst_result->n_updated_params - i - 1;
+            memmove(&updated_inst_result->updated_params[i], &updated_inst_result->updated_params[i+1], num_after*sizeof(void *));
+            updated_inst_result->n_updated_params--;
+            return;
+        }
+    }
+}
+
+/*********************************************************************//**
+**
+** MapGroupedSetFailures
+**
+** Called by DM_TRANS_Commit() if the vendor failed to set any grouped vendor parameters
+** This attributes each failure to the parameter in the SetResponse, honouring its required flag
+**
+** \param   failed_params - key-value vector containing the path and error message of each parameter which failed to be set
+** \param   failed_errs - vector containing the USP error code of each parameter which failed to be set (parallel to failed_params)
+** \param   arg - pointer to set_group_fail_t structure identifying the results in the SetResponse added within the transaction
+**
+** \return  USP_ERR_OK if the transaction should be committed, or the error of the first required parameter which failed
+**
+**************************************************************************/
+int MapGroupedSetFailures(kv_vector_t *failed_params, int_vector_t *failed_errs, void *arg)
+{
+    int i;
+    int err = USP_ERR_OK;
+    bool required;
+    set_group_fail_t *sgf = (set_group_fail_t *) arg;
+
+    for (i=0; i < failed_params->num_entries; i++)
+    {
+        required = MapGroupedSetFailure(sgf, failed_params->vector[i].key, failed_errs->vector[i], failed_params->vector[i].value);
+        if ((required) && (err == USP_ERR_OK))
+        {
+            // Save the error of the first parameter which was required to be set, but failed
+            err = failed_errs->vector[i];
+            USP_ERR_SetMessage("%s", failed_params->vector[i].value);
+        }
+    }
+
+    return err;
+}
+
+/*********************************************************************//**
+**
+** MapGroupedSetFailure
+**
+** Attributes the failure to set a grouped vendor parameter to the parameter in the SetResponse
+** If the parameter was not required, then it is moved from the ParamMap to the ParamErr list of the object
+** If the parameter was required, then the OperSuccess of the object is replaced with an OperFailure
+**
+** \param   sgf - pointer to structure identifying the results in the SetResponse added within the transaction
+** \param   path - full data model path of the parameter which failed to be set
+** \param   err_code - error code representing the cause of the failure
+** \param   err_msg - string representing the cause of the failure
+**
+** \return  true if the parameter was required to be set
+**
+**************************************************************************/
+bool MapGroupedSetFailure(set_group_fail_t *sgf, char *path, int err_code, char *err_msg)
+{
+    int i, j;
+    int len;
+    Usp__SetResp *set_resp = sgf->set_resp;
+    Usp__SetResp__UpdatedObjectResult *updated_obj_res;
+    Usp__SetResp__UpdatedObjectResult__OperationStatus *oper_status;
+    Usp__SetResp__UpdatedObjectResult__OperationStatus__OperationSuccess *oper_success;
+    Usp__SetResp__UpdatedObjectResult__OperationStatus__OperationFailure *oper_failure;
+    Usp__SetResp__UpdatedInstanceResult *updated_inst_res;
+    Usp__SetResp__UpdatedInstanceFailure *updated_inst_failure;
+    Usp__Set__UpdateParamSetting *ps;
+    char *param;
+    char requested_path[MAX_DM_PATH];
+    char obj_path[MAX_DM_PATH];
+
+    for (i=sgf->first_result; i < set_resp->n_updated_obj_results; i++)
+    {
+        updated_obj_res = set_resp->updated_obj_results[i];
+        oper_status = updated_obj_res->oper_status;
+        if (oper_status->oper_status_case == USP__SET_RESP__UPDATED_OBJECT_RESULT__OPERATION_STATUS__OPER_STATUS_OPER_SUCCESS)
+        {
+            oper_success = oper_status->oper_success;
+            for (j=0; j < oper_success->n_updated_inst_results; j++)
+            {
+                // Skip if the parameter is not one that was set in this object
+                updated_inst_res = oper_success->updated_inst_results[j];
+                len = strlen(updated_inst_res->affected_path);
+                if (strncmp(path, updated_inst_res->affected_path, len) != 0)
+                {
+                    continue;
+                }
+                param = &path[len];
+                ps = FindUpdateParamSetting(sgf, updated_obj_res->requested_path, param);
+                if (ps == NULL)
+                {
+                    continue;
+                }
+
+                // Remove the parameter from the list of parameters which were set successfully
+                RemoveUpdatedInstRes_ParamsEntry(updated_inst_res, param);
+                if (ps->required == false)
+                {
+                    // This parameter failed to be set, but was not required
+                    // So add it to the ParamErr list
+                    AddUpdatedInstRes_ParamErr(updated_inst_res, param, err_code, err_msg);
+                    return false;
+                }
+
+                // This parameter was required to be set, but failed, so replace the OperSuccess with OperFailure
+                USP_STRNCPY(requested_path, updated_obj_res->requested_path, sizeof(requested_path));
+                USP_STRNCPY(obj_path, updated_inst_res->affected_path, sizeof(obj_path));
+                obj_path[len-1] = '\0';     // Remove the trailing '.', as it is added back by AddOperFailure_UpdatedInstFailure()
+                RemoveSetResp_UpdateObjResult(set_resp, i);
+
+                oper_failure = AddSetResp_OperFailure(set_resp, requested_path, USP_ERR_REQUIRED_PARAM_FAILED, "Failed to set required parameters");
+                updated_inst_failure = AddOperFailure_UpdatedInstFailure(oper_failure, obj_path);
+                AddUpdatedInstFailure_ParamErr(updated_inst_failure, param, err_code, err_msg);
+                sgf->required_failed = true;
+                return true;
+            }
+        }
+        else
+        {
+            oper_failure = oper_status->oper_failure;
+            for (j=0; j < oper_failure->n_updated_inst_failures; j++)
+            {
+                // Skip if the parameter is not one that was set in this object
+                updated_inst_failure = oper_failure->updated_inst_failures[j];
+                len = strlen(updated_inst_failure->affected_path);
+                if (strncmp(path, updated_inst_failure->affected_path, len) != 0)
+                {
+                    continue;
+                }
+                param = &path[len];
+                ps = FindUpdateParamSetting(sgf, updated_obj_res->requested_path, param);
+                if (ps == NULL)
+                {
+                    continue;
+                }
+
+                // The object has already failed, so add this parameter to the list of failed required parameters
+                // NOTE: Non-required parameters which failed are not reported, as the object has already failed
+                if (ps->required)
+                {
+                    AddUpdatedInstFailure_ParamErr(updated_inst_failure, param, err_code, err_msg);
+                }
+                return ps->required;
+            }
+        }
+    }
+
+    // If the code gets here, then the parameter was not set by the SetRequest (eg it was set by a vendor hook)
+    USP_LOG_Warning("%s: Vendor failed to set %s (%s)", __FUNCTION__, path, err_msg);
+    return false;
+}
+
+/*********************************************************************//**
+**
+** FindUpdateParamSetting
+**
+** Finds the parameter setting in the SetRequest which set the specified parameter
+**
+** \param   sgf - pointer to structure identifying the UpdateObjects processed within the transaction
+** \param   obj_path - requested path of the UpdateObject
+** \param   param - name of the parameter, relative to the object
+**
+** \return  pointer to parameter setting, or NULL if the parameter was not set by the SetRequest
+**
+**************************************************************************/
+Usp__Set__UpdateParamSetting *FindUpdateParamSetting(set_group_fail_t *sgf, char *obj_path, char *param)
+{
+    int i, j;
+    Usp__Set__UpdateObject *up;
+    Usp__Set__UpdateParamSetting *ps;
+
+    for (i=0; i < sgf->n_update_objs; i++)
+    {
+        up = sgf->update_objs[i];
+        if ((up->obj_path == NULL) || (strcmp(up->obj_path, obj_path) != 0))
+        {
+            continue;
+        }
+
+        for (j=0; j < up->n_param_settings; j++)
+        {
+            ps = up->param_settings[j];
+            if (strcmp(ps->param, param)==0)
+            {
+                return ps;
+            }
+        }
+    }
+
+    return NULL;
+}
+
@@ -44,6 +44,10 @@
 #include "common_defs.h"
 #include "int_vector.h"
 
+//------------------------------------------------------------------------------
+// Number of entries allocated when the first integer is added to the vector
+#define MIN_INT_VECTOR_ENTRIES 16
+
 /*********************************************************************//**
 **
 ** INT_VECTOR_Init
@@ -57,7 +61,9 @@
 **************************************************************************/
 void INT_VECTOR_Init(int_vector_t *iv)
 {
+    iv->vector = NULL;
     iv->num_entries = 0;
+    iv->max_entries = 0;
 }
 
 /*********************************************************************//**
@@ -69,20 +75,21 @@ void INT_VECTOR_Init(int_vector_t *iv)
 ** \param   iv - pointer to structure to add the integer to
 ** \param   number - integer to insert
 **
-** \return  USP_ERR_OK if successful
+** \return  USP_ERR_OK. This function always succeeds, as the array grows to accommodate the integer
+**          NOTE: The return value is kept so that existing callers which check it continue to compile
 **
 **************************************************************************/
 int INT_VECTOR_Add(int_vector_t *iv, int number)
 {
-    // Exit if unable to add to the vector (array is already full)
-    if (iv->num_entries >= MAX_DM_INSTANCES)
+    // Double the size of the array, if it is already full
+    if (iv->num_entries >= iv->max_entries)
     {
-        USP_ERR_SetMessage("%s: More than %d instances of object", __FUNCTION__, MAX_DM_INSTANCES);
-        return USP_ERR_INTERNAL_ERROR;
+        iv->max_entries = (iv->max_entries == 0) ? MIN_INT_VECTOR_ENTRIES : 2*iv->max_entries;
+        iv->vector = USP_REALLOC(iv->vector, iv->max_entries*sizeof(int));
     }
 
     // Add to the vector
-    iv->vector[ iv->num_entries ] = (short) number;
+    iv->vector[ iv->num_entries ] = number;
     iv->num_entries++;
     return USP_ERR_OK;
 }
@@ -122,6 +129,7 @@ int INT_VECTOR_Find(int_vector_t *iv, int number)
 ** INT_VECTOR_Destroy
 **
 ** Deinitialises the integer vector
+** NOTE: The vector may safely be destroyed more than once
 **
 ** \param   iv - pointer to structure to re-initialize
 **
@@ -130,7 +138,9 @@ int INT_VECTOR_Find(int_vector_t *iv, int number)
 **************************************************************************/
 void INT_VECTOR_Destroy(int_vector_t *iv)
 {
+    USP_SAFE_FREE(iv->vector);
     iv->num_entries = 0;
+    iv->max_entries = 0;
 }
 
 
@@ -36,9 +36,9 @@
  * \file int_vector.h
  *
  * Implements a vector of integers
- * Unlike the other vector data structures, this has been re-implemented using a maximum fixed size array,
- * as this vector is only used to collect the instance numbers of an object.
- * Using a fixed size array minimizes the number of memory allocations, speeding up the code and minimising the risk of memory leaks
+ * This vector is used to collect the instance numbers of an object. The array is not limited in size, however
+ * DM_INST_VECTOR_GetInstances() refuses to return more than MAX_DM_INSTANCES instances of a single object.
+ * The array grows by doubling, to minimise the number of memory allocations when collecting the instances of large tables
  *
  */
 
@@ -83,6 +83,7 @@ static struct option long_options[] =
     {"help",       no_argument,       NULL, 'h'},    // Prints help for command line options
     {"log",        required_argument, NULL, 'l'},    // Sets the destination for the log file (either syslog, stdout or a filename)
     {"dbfile",     required_argument, NULL, 'f'},    // Sets the name of the path to use for the database file
+    {"dbtuning",   required_argument, NULL, 'd'},    // Sets the SQLite journal mode, synchronous level, mmap size and cache size used to access the database file
     {"verbose",    required_argument, NULL, 'v'},    // Verbosity level for debug logging
     {"meminfo",    no_argument,       NULL, 'm'},    // Collects and prints information useful to debugging memory leaks
     {"error",      no_argument,       NULL, 'e'},    // Prints the callstack whenever an error is detected
@@ -98,7 +99,7 @@ static struct option long_options[] =
 };
 
 // In the string argument, the colons (after the option) mean that those options require arguments
-static char short_options[] = "hl:f:v:a:t:r:i:mepc";
+static char short_options[] = "hl:f:d:v:a:t:r:i:mepc";
 
 //--------------------------------------------------------------------------------------
 // Variables set by command line arguments
@@ -207,6 +208,17 @@ int main(int argc, char *argv[])
                 factory_reset_text_file = optarg;
                 break;
 
+            case 'd':
+                // Set the tuning options used to access the database file
+                err = DATABASE_SetTuning(optarg);
+                if (err != USP_ERR_OK)
+                {
+                    usp_log_level = kLogLevel_Error;
+                    USP_LOG_Error("ERROR: Database tuning options (%s) are invalid", optarg);
+                    goto exit;
+                }
+                break;
+
             case 'i':
                 // Set the networking interface to use for USP communication
                 if (nu_ipaddr_is_valid_interface(optarg) != true)
@@ -434,6 +446,9 @@ void PrintUsage(void)
     printf("--help (-h)       Displays this help\n");
     printf("--log (-l)        Sets the destination for debug logging. Default is 'stdout'. Can also use 'syslog' or a filename\n");
     printf("--dbfile (-f)     Sets the path of the file to store the database in (default=%s)\n", DEFAULT_DATABASE_FILE);
+    printf("--dbtuning (-d)   Sets the SQLite tuning used to access the database file, as a comma separated list of settings\n");
+    printf("                  eg 'journal=wal,sync=normal,mmap=67108864,cache=-2048'. journal may be delete, truncate, persist or wal\n");
+    printf("                  sync may be normal (only used with wal), full or extra. Default is SQLite's defaults\n");
     printf("--verbose (-v)    Sets the debug verbosity log level: 0=Off, 1=Error(default), 2=Warning, 3=Info\n");
     printf("--prototrace (-p) Enables trace logging of the USP protocol messages\n");
     printf("--authcert (-a)   Sets the path of the PEM formatted file containing a client certificate and private key to authenticate this device with\n");
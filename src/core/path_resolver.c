@@ -46,6 +46,7 @@
 #include "common_defs.h"
 #include "data_model.h"
 #include "dm_inst_vector.h"
+#include "dm_key_index.h"
 #include "path_resolver.h"
 #include "dm_access.h"
 #include "kv_vector.h"
@@ -53,35 +54,77 @@
 #include "text_utils.h"
 
 
+//-------------------------------------------------------------------------
+// Record of a reference which has been followed during a resolution, along with the rest of the search path that was resolved after it
+// Once the rest of the search path has been resolved from a dereferenced object, resolving it again would only find duplicate paths
+typedef struct followed_ref_tag
+{
+    struct followed_ref_tag *next;  // Next entry in the hash bucket chain containing this entry
+    int hash;                       // Hash of the dereferenced path
+    char *dereferenced;             // Path of the object which the reference pointed to
+    char *unresolved;               // Rest of the search path resolved after following the reference. NOTE: This points into the search path being resolved
+} followed_ref_t;
+
+// Number of hash buckets in the table of references followed during a resolution
+#define NUM_FOLLOWED_REF_BUCKETS 256
+
 //-------------------------------------------------------------------------
 // State variable associated with the resolver. This is passed to all recursive resolver functions
 typedef struct
 {
     str_vector_t *sv;       // pointer to string vector to return the resolved paths in
-                            // or NULL if we are only interested in whether the expression exists in the schema
+                            // or NULL if the paths are returned using the callback, or if we are only interested in whether the expression exists in the schema
+    path_resolver_cb_t callback; // function to call with each resolved path, or NULL if the paths are returned in the string vector
+    void *cb_arg;           // argument to pass to the callback
+    str_vector_t paths_found; // Paths passed to the callback since a reference was followed. Used to prevent the callback being called with duplicate paths
     resolve_op_t op;        // operation being performed that requires path resolution
     int separator_count;    // Count of the number of separators before the last resolved part of the path
     combined_role_t *combined_role;  // pointer to role to use when performing the path resolution.
                             // If the search path resolves to an object or param which there is no permission for,
                             // then a error will be generated (or the path forgivingly ignored in the case of a get)
     unsigned flags;         // flags controlling resolving of the path eg GET_ALL_INSTANCES
+    int sv_initial_entries; // Number of entries in the string vector before this resolution started
+    bool is_reference_followed; // Set if a reference has been followed during this resolution.
+                            // If not, then all paths found by this resolution are unique, so they only need to be checked
+                            // against the paths present in the string vector before this resolution started
+    followed_ref_t **followed_refs; // Hash table of the references followed during this resolution, or NULL if no references have been followed
 } resolver_state_t;
 
+//-------------------------------------------------------------------------
+// Data model node that the first part of the resolved path has already been found to represent
+// This is passed down through the recursive resolver functions, so that only the rest of the path needs to be looked up in the data model
+typedef struct
+{
+    dm_node_t *node;        // node represented by the first 'len' characters of the resolved path, or NULL if not known yet
+    dm_instances_t inst;    // instance numbers parsed from the first 'len' characters of the resolved path
+    int len;                // number of characters at the start of the resolved path that 'node' and 'inst' represent
+} resolved_node_t;
+
 //-------------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
-int ExpandPath(char *resolved, char *unresolved, resolver_state_t *state);
-int ExpandWildcard(char *resolved, char *unresolved, resolver_state_t *state);
-int ResolveReferenceFollow(char *resolved, char *unresolved, resolver_state_t *state);
-int ResolveUniqueKey(char *resolved, char *unresolved, resolver_state_t *state);
-int DoesInstanceMatchUniqueKey(char *object, int instance, expr_vector_t *keys, bool *is_match, resolver_state_t *state);
-int ResolvePartialPath(char *path, resolver_state_t *state);
+int ExpandPath(char *resolved, char *unresolved, resolved_node_t *rn, resolver_state_t *state);
+int ExpandWildcard(char *resolved, char *unresolved, resolved_node_t *rn, resolver_state_t *state);
+int ResolveReferenceFollow(char *resolved, char *unresolved, resolved_node_t *rn, resolver_state_t *state);
+int ResolveUniqueKey(char *resolved, char *unresolved, resolved_node_t *rn, resolver_state_t *state);
+int ResolveUniqueKeyNodes(char *object, resolved_node_t *instance_rn, expr_vector_t *keys, resolved_node_t *key_nodes);
+int DoesInstanceMatchUniqueKey(char *object, int instance, int order, expr_vector_t *keys, resolved_node_t *key_nodes, expr_predicate_t *predicates, bool *is_match);
+int CheckUniqueKeyPermissions(char *object, int instance, expr_vector_t *keys, resolved_node_t *key_nodes, bool *is_permitted, resolver_state_t *state);
+int ResolvePartialPath(char *path, resolved_node_t *rn, resolver_state_t *state);
 int GetChildParams(char *path, int path_len, dm_node_t *node, dm_instances_t *inst, resolver_state_t *state);
 int GetChildParams_MultiInstanceObject(char *path, int path_len, dm_node_t *node, dm_instances_t *inst, resolver_state_t *state);
 int DoesInstanceMatchExpr(char *object, int instance, char *expr_variable, resolver_state_t *state, bool *is_match);
-int AddPathFound(char *path, resolver_state_t *state);
+int AddPathFound(char *path, resolved_node_t *rn, resolver_state_t *state);
+int ReturnPathFound(char *path, dm_node_t *node, dm_instances_t *inst, resolver_state_t *state);
+bool IsReferenceAlreadyFollowed(char *dereferenced, char *unresolved, resolver_state_t *state);
+void DestroyFollowedRefs(resolver_state_t *state);
+int ReturnInstancePathsFound(str_vector_t *sv, resolver_state_t *state);
 int CountPathSeparator(char *path);
-int ExpandNextSubPath(char *resolved, char *unresolved, resolver_state_t *state);
-int CheckPathProperties(char *path, resolver_state_t *state, bool *add_to_vector, unsigned *path_properties);
+int ExpandNextSubPath(char *resolved, char *unresolved, resolved_node_t *rn, resolver_state_t *state);
+int CheckPathProperties(char *path, resolved_node_t *rn, resolver_state_t *state, bool *add_to_vector, unsigned *path_properties, resolved_node_t *path_rn);
+int CheckDevicePath(char *path, resolve_op_t op);
+int ResolvePathInternal(char *path, str_vector_t *sv, path_resolver_cb_t callback, void *cb_arg, resolve_op_t op, int *separator_split, combined_role_t *combined_role, unsigned flags);
+dm_node_t *GetResolvedNode(char *path, resolved_node_t *rn, dm_instances_t *inst, bool *is_qualified_instance);
+int GetResolvedInstances(char *path, resolved_node_t *rn, resolved_node_t *instance_rn, int_vector_t *iv);
 
 /*********************************************************************//**
 **
@@ -112,37 +155,12 @@ int CheckPathProperties(char *path, resolver_state_t *state, bool *add_to_vector
 int PATH_RESOLVER_ResolveDevicePath(char *path, str_vector_t *sv, resolve_op_t op, int *separator_split, combined_role_t *combined_role, unsigned flags)
 {
     int err;
-    int len;
-
-    // Exit if the path does not begin with "Device."
-    #define DEVICE_ROOT_STR "Device."
-    if (strncmp(path, DEVICE_ROOT_STR, sizeof(DEVICE_ROOT_STR)-1) != 0)
-    {
-        USP_ERR_SetMessage("%s: Expression does not start in '%s'", __FUNCTION__, DEVICE_ROOT_STR);
-        return USP_ERR_INVALID_PATH;
-    }
 
-    // Perform checks on whether the path is terminated correctly (by '.' or not)
-    len = strlen(path);
-    if (path[len-1] == '.')
-    {
-        // Path ends in '.'
-        // Exit if the path should not end in '.'
-        if ((op==kResolveOp_Oper) || (op==kResolveOp_Event))
-        {
-            USP_ERR_SetMessage("%s: Path should not end in '.'", __FUNCTION__);
-            return USP_ERR_INVALID_PATH_SYNTAX;
-        }
-    }
-    else
+    // Exit if the path does not start with 'Device.' or is not terminated correctly for the operation
+    err = CheckDevicePath(path, op);
+    if (err != USP_ERR_OK)
     {
-        // Path does not end in '.'
-        // Exit if the path should end in '.'
-        if ((op==kResolveOp_Add) || (op==kResolveOp_Del) || (op==kResolveOp_Instances))
-        {
-            USP_ERR_SetMessage("%s: Path must end in '.'", __FUNCTION__);
-            return USP_ERR_INVALID_PATH_SYNTAX;
-        }
+        return err;
     }
 
     err = PATH_RESOLVER_ResolvePath(path, sv, op, separator_split, combined_role, flags);
@@ -176,11 +194,105 @@ int PATH_RESOLVER_ResolveDevicePath(char *path, str_vector_t *sv, resolve_op_t o
 **
 **************************************************************************/
 int PATH_RESOLVER_ResolvePath(char *path, str_vector_t *sv, resolve_op_t op, int *separator_split, combined_role_t *combined_role, unsigned flags)
+{
+    int err;
+
+    err = ResolvePathInternal(path, sv, NULL, NULL, op, separator_split, combined_role, flags);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** PATH_RESOLVER_IterateDevicePath
+**
+** Wrapper around PATH_RESOLVER_IteratePath() which ensures that the path starts with 'Device.'
+** This function should be used instead of PATH_RESOLVER_ResolveDevicePath() when the caller can process
+** each resolved path as it is found, as it avoids holding all resolved paths in memory at once
+**
+** \param   path - pointer to path expression identifying parameters in the data model
+** \param   callback - function to call with each resolved path
+** \param   cb_arg - argument to pass to the callback
+** \param   op - operation being performed that requires path resolution
+** \param   separator_split - pointer to variable in which to return where to split the resolved paths
+**                            NOTE: This argument may be NULL if the caller is not interested in the value
+** \param   combined_role - role to use when performing the resolution. If set to INTERNAL_ROLE, then permissions are ignored (used internally)
+*  \param   flags - flags controlling resolving of the path eg GET_ALL_INSTANCES
+**
+** \return  USP_ERR_OK if successful, or no instances found
+**
+**************************************************************************/
+int PATH_RESOLVER_IterateDevicePath(char *path, path_resolver_cb_t callback, void *cb_arg, resolve_op_t op, int *separator_split, combined_role_t *combined_role, unsigned flags)
+{
+    int err;
+
+    // Exit if the path does not start with 'Device.' or is not terminated correctly for the operation
+    err = CheckDevicePath(path, op);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    err = PATH_RESOLVER_IteratePath(path, callback, cb_arg, op, separator_split, combined_role, flags);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** PATH_RESOLVER_IteratePath
+**
+** Resolves the specified path expression, calling the specified callback with each path which exists in the data model, as it is found
+** The paths found are the same as those returned by PATH_RESOLVER_ResolvePath(), and are found in the same order
+** NOTE: If an error occurs during resolution, the callback may already have been called with some paths
+**
+** \param   path - pointer to path expression identifying parameters in the data model
+** \param   callback - function to call with each resolved path
+** \param   cb_arg - argument to pass to the callback
+** \param   op - operation being performed that requires path resolution
+** \param   separator_split - pointer to variable in which to return where to split the resolved paths
+**                            NOTE: This argument may be NULL if the caller is not interested in the value
+** \param   combined_role - role to use when performing the resolution
+*  \param   flags - flags controlling resolving of the path eg GET_ALL_INSTANCES
+**
+** \return  USP_ERR_OK if successful, or no instances found, or the error returned by the callback
+**
+**************************************************************************/
+int PATH_RESOLVER_IteratePath(char *path, path_resolver_cb_t callback, void *cb_arg, resolve_op_t op, int *separator_split, combined_role_t *combined_role, unsigned flags)
+{
+    int err;
+
+    USP_ASSERT(callback != NULL);
+    err = ResolvePathInternal(path, NULL, callback, cb_arg, op, separator_split, combined_role, flags);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** ResolvePathInternal
+**
+** Resolves the specified path expression into the paths which exist in the data model,
+** returning them either in a string vector, or by calling a callback with each path
+**
+** \param   path - pointer to path expression identifying parameters in the data model
+** \param   sv - pointer to string vector to return the resolved paths in
+**               or NULL if the paths are returned using the callback, or if we are only interested in whether the expression exists in the schema
+** \param   callback - function to call with each resolved path, or NULL if the paths are returned in the string vector
+** \param   cb_arg - argument to pass to the callback
+** \param   op - operation being performed that requires path resolution
+** \param   separator_split - pointer to variable in which to return where to split the resolved paths
+**                            NOTE: This argument may be NULL if the caller is not interested in the value
+** \param   combined_role - role to use when performing the resolution
+*  \param   flags - flags controlling resolving of the path eg GET_ALL_INSTANCES
+**
+** \return  USP_ERR_OK if successful, or no instances found
+**
+**************************************************************************/
+int ResolvePathInternal(char *path, str_vector_t *sv, path_resolver_cb_t callback, void *cb_arg, resolve_op_t op, int *separator_split, combined_role_t *combined_role, unsigned flags)
 {
     char resolved[MAX_DM_PATH];
     char unresolved[MAX_DM_PATH];
     int err;
     resolver_state_t state;
+    resolved_node_t rn;
 
     // Exit if path contains any path separators with no intervening objects 
     if (strstr(path, "..") != NULL)
@@ -195,12 +307,23 @@ int PATH_RESOLVER_ResolvePath(char *path, str_vector_t *sv, resolve_op_t op, int
     // Set up state variables for resolving the path, then resolve it
     resolved[0] = '\0';  // Start from an empty string for the resolved portion of the path
     state.sv = sv;
+    state.callback = callback;
+    state.cb_arg = cb_arg;
+    STR_VECTOR_Init(&state.paths_found);
     state.op = op;
     state.separator_count = 0;
     state.combined_role = combined_role;
     state.flags = flags;
+    state.sv_initial_entries = (sv != NULL) ? sv->num_entries : 0;
+    state.is_reference_followed = false;
+    state.followed_refs = NULL;
+
+    rn.node = NULL;     // None of the path has been resolved to a node yet
+    rn.len = 0;
 
-    err = ExpandPath(resolved, unresolved, &state);
+    err = ExpandPath(resolved, unresolved, &rn, &state);
+    STR_VECTOR_Destroy(&state.paths_found);
+    DestroyFollowedRefs(&state);
 
     // Return the point at which to split the path
     if (separator_split != NULL)
@@ -211,6 +334,56 @@ int PATH_RESOLVER_ResolvePath(char *path, str_vector_t *sv, resolve_op_t op, int
     return err;
 }
 
+/*********************************************************************//**
+**
+** CheckDevicePath
+**
+** Checks that the path expression starts with 'Device.' and is terminated correctly (by '.' or not) for the operation
+**
+** \param   path - pointer to path expression identifying parameters in the data model
+** \param   op - operation being performed that requires path resolution
+**
+** \return  USP_ERR_OK if the path expression is acceptable
+**
+**************************************************************************/
+int CheckDevicePath(char *path, resolve_op_t op)
+{
+    int len;
+
+    // Exit if the path does not begin with "Device."
+    #define DEVICE_ROOT_STR "Device."
+    if (strncmp(path, DEVICE_ROOT_STR, sizeof(DEVICE_ROOT_STR)-1) != 0)
+    {
+        USP_ERR_SetMessage("%s: Expression does not start in '%s'", __FUNCTION__, DEVICE_ROOT_STR);
+        return USP_ERR_INVALID_PATH;
+    }
+
+    // Perform checks on whether the path is terminated correctly (by '.' or not)
+    len = strlen(path);
+    if (path[len-1] == '.')
+    {
+        // Path ends in '.'
+        // Exit if the path should not end in '.'
+        if ((op==kResolveOp_Oper) || (op==kResolveOp_Event))
+        {
+            USP_ERR_SetMessage("%s: Path should not end in '.'", __FUNCTION__);
+            return USP_ERR_INVALID_PATH_SYNTAX;
+        }
+    }
+    else
+    {
+        // Path does not end in '.'
+        // Exit if the path should end in '.'
+        if ((op==kResolveOp_Add) || (op==kResolveOp_Del) || (op==kResolveOp_Instances))
+        {
+            USP_ERR_SetMessage("%s: Path must end in '.'", __FUNCTION__);
+            return USP_ERR_INVALID_PATH_SYNTAX;
+        }
+    }
+
+    return USP_ERR_OK;
+}
+
 /*********************************************************************//**
 **
 ** ExpandPath
@@ -220,12 +393,13 @@ int PATH_RESOLVER_ResolvePath(char *path, str_vector_t *sv, resolve_op_t op, int
 **
 ** \param   resolved - pointer to buffer containing data model path that has been resolved so far
 ** \param   unresolved - pointer to rest of search path to resolve
+** \param   rn - pointer to node which the first part of 'resolved' has already been found to represent
 ** \param   state - pointer to structure containing state variables to use with this resolution
 **
 ** \return  USP_ERR_OK if successful, or no instances found
 **
 **************************************************************************/
-int ExpandPath(char *resolved, char *unresolved, resolver_state_t *state)
+int ExpandPath(char *resolved, char *unresolved, resolved_node_t *rn, resolver_state_t *state)
 {
     int len;
     int err;
@@ -247,7 +421,7 @@ int ExpandPath(char *resolved, char *unresolved, resolver_state_t *state)
         if (c == '*')
         {
             resolved[len] = '\0';
-            err = ExpandWildcard(resolved, &unresolved[1], state);
+            err = ExpandWildcard(resolved, &unresolved[1], rn, state);
             return err;
         }
 
@@ -255,7 +429,7 @@ int ExpandPath(char *resolved, char *unresolved, resolver_state_t *state)
         if (c == '+')
         {
             resolved[len] = '\0';
-            err = ResolveReferenceFollow(resolved, &unresolved[1], state);
+            err = ResolveReferenceFollow(resolved, &unresolved[1], rn, state);
             return err;
         }
 
@@ -263,7 +437,7 @@ int ExpandPath(char *resolved, char *unresolved, resolver_state_t *state)
         if (c == '[')
         {
             resolved[len] = '\0';
-            err = ResolveUniqueKey(resolved, &unresolved[1], state);
+            err = ResolveUniqueKey(resolved, &unresolved[1], rn, state);
             return err;
         }
 
@@ -299,7 +473,7 @@ int ExpandPath(char *resolved, char *unresolved, resolver_state_t *state)
             case kResolveOp_SubsEvent:
                 // These cases allow a partial path for parameters
                 resolved[len-1] = '\0';
-                err = ResolvePartialPath(resolved, state);
+                err = ResolvePartialPath(resolved, rn, state);
                 return err;
                 break;
 
@@ -325,7 +499,7 @@ int ExpandPath(char *resolved, char *unresolved, resolver_state_t *state)
     }
 
     // Exit if an error occurred with this path, which halts further path resolution
-    err = AddPathFound(resolved, state);
+    err = AddPathFound(resolved, rn, state);
     if (err != USP_ERR_OK)
     {
         return err;
@@ -344,12 +518,13 @@ int ExpandPath(char *resolved, char *unresolved, resolver_state_t *state)
 **
 ** \param   resolved - pointer to buffer containing object that we need to search all instances of
 ** \param   unresolved - pointer to rest of search path to resolve
+** \param   rn - pointer to node which the first part of 'resolved' has already been found to represent
 ** \param   state - pointer to structure containing state variables to use with this resolution
 **
 ** \return  USP_ERR_OK if successful, or no instances found
 **
 **************************************************************************/
-int ExpandWildcard(char *resolved, char *unresolved, resolver_state_t *state)
+int ExpandWildcard(char *resolved, char *unresolved, resolved_node_t *rn, resolver_state_t *state)
 {
     int_vector_t iv;
     int i;
@@ -357,9 +532,11 @@ int ExpandWildcard(char *resolved, char *unresolved, resolver_state_t *state)
     int len;
     int len_left;
     char *p;
+    resolved_node_t instance_rn;
+    int order;
 
     // Exit if unable to get the instances of this object
-    err = DATA_MODEL_GetInstances(resolved, &iv);
+    err = GetResolvedInstances(resolved, rn, &instance_rn, &iv);
     if (err != USP_ERR_OK)
     {
         goto exit;
@@ -384,10 +561,13 @@ int ExpandWildcard(char *resolved, char *unresolved, resolver_state_t *state)
 
     // Expand the wildcard and recurse to expand the unresolved part of the path
     p = &resolved[len];
+    order = instance_rn.inst.order - 1;
     for (i=0; i < iv.num_entries; i++)
     {
         USP_SNPRINTF(p, len_left, "%d", iv.vector[i]);
-        err = ExpandNextSubPath(resolved, unresolved, state);
+        instance_rn.inst.instances[order] = iv.vector[i];
+        instance_rn.len = strlen(resolved);
+        err = ExpandNextSubPath(resolved, unresolved, &instance_rn, state);
         if (err != USP_ERR_OK)
         {
             goto exit;
@@ -410,17 +590,22 @@ exit:
 **
 ** \param   resolved - pointer to buffer containing data model path to de-reference
 ** \param   unresolved - pointer to rest of search path to resolve
+** \param   rn - pointer to node which the first part of 'resolved' has already been found to represent
 ** \param   state - pointer to structure containing state variables to use with this resolution
 **
 ** \return  USP_ERR_OK if successful, or no instances found
 **
 **************************************************************************/
-int ResolveReferenceFollow(char *resolved, char *unresolved, resolver_state_t *state)
+int ResolveReferenceFollow(char *resolved, char *unresolved, resolved_node_t *rn, resolver_state_t *state)
 {
     char dereferenced[MAX_DM_PATH];
     int err;
     unsigned flags;
     unsigned short permission_bitmask;
+    dm_node_t *node;
+    dm_instances_t inst;
+    bool is_qualified_instance;
+    resolved_node_t dereferenced_rn;
 
     // Exit if this is a Bulk Data collection operation, which does not allow reference following
     // (because the alt-name reduction rules in TR-157 do not support it)
@@ -431,11 +616,12 @@ int ResolveReferenceFollow(char *resolved, char *unresolved, resolver_state_t *s
     }
 
     // Exit if unable to determine whether we are allowed to read the reference
-    err = DATA_MODEL_GetPermissions(resolved, state->combined_role, &permission_bitmask);
-    if (err != USP_ERR_OK)
+    node = GetResolvedNode(resolved, rn, &inst, &is_qualified_instance);
+    if (node == NULL)
     {
-        return err;
+        return USP_ERR_INVALID_PATH;
     }
+    permission_bitmask = DM_PRIV_GetPermissions(node, state->combined_role);
     
     // Exit if not permitted to read the reference
     if ((permission_bitmask & PERMIT_GET) == 0)
@@ -452,16 +638,29 @@ int ResolveReferenceFollow(char *resolved, char *unresolved, resolver_state_t *s
     }
 
     // Exit if unable to get the path for the dereferenced object    
-    err = DATA_MODEL_GetParameterValue(resolved, dereferenced, sizeof(dereferenced), 0);
+    err = DM_PRIV_GetParameterValue(resolved, node, &inst, dereferenced, sizeof(dereferenced), 0);
     if (err != USP_ERR_OK)
     {
         USP_ERR_SetMessage("%s: Unable to get the value of the dereferenced path contained in %s", __FUNCTION__, resolved);
         return err;
     }
 
+    // Exit if another reference to the same object has already been followed, and the rest of the path resolved from it
+    // (eg many instances of a table referencing the same object). Resolving it again would only find the same paths again.
+    if (IsReferenceAlreadyFollowed(dereferenced, unresolved, state))
+    {
+        return USP_ERR_OK;
+    }
+
     // Exit if the dereferenced path is not a fully qualified object
     // NOTE: We do not check permissions here, since there may be further parts of the path to resolve after this reference follow
-    flags = DATA_MODEL_GetPathProperties(dereferenced, INTERNAL_ROLE, NULL);
+    dereferenced_rn.node = DM_PRIV_GetNodeFromPath(dereferenced, &dereferenced_rn.inst, &is_qualified_instance);
+    flags = 0;
+    if (dereferenced_rn.node != NULL)
+    {
+        flags = DM_PRIV_GetPathProperties(dereferenced_rn.node, &dereferenced_rn.inst, is_qualified_instance, INTERNAL_ROLE, NULL);
+    }
+
     if ( ((flags & PP_IS_OBJECT) == 0) || ((flags & PP_IS_OBJECT_INSTANCE) ==0) )
     {
         USP_ERR_SetMessage("%s: The dereferenced path contained in %s was not an object instance (got the value '%s')", __FUNCTION__, resolved, dereferenced);
@@ -479,11 +678,105 @@ int ResolveReferenceFollow(char *resolved, char *unresolved, resolver_state_t *s
 
     // If the code gets here then the resolved path has been successfully dereferenced, 
     // so continue resolving the path, using the dereferened path
-    err = ExpandNextSubPath(dereferenced, unresolved, state);
+    // NOTE: Different references may point to the same object, so paths found from now on may be duplicates
+    state->is_reference_followed = true;
+    dereferenced_rn.len = strlen(dereferenced);
+    err = ExpandNextSubPath(dereferenced, unresolved, &dereferenced_rn, state);
 
     return err;
 }
 
+/*********************************************************************//**
+**
+** IsReferenceAlreadyFollowed
+**
+** Determines whether the rest of the search path has already been resolved from the specified dereferenced object
+** during this resolution. If it has not, then this function records that it is about to be.
+**
+** \param   dereferenced - path of the object which a reference pointed to
+** \param   unresolved - pointer to rest of search path to resolve after following the reference
+** \param   state - pointer to structure containing state variables to use with this resolution
+**
+** \return  true if the reference has already been followed
+**
+**************************************************************************/
+bool IsReferenceAlreadyFollowed(char *dereferenced, char *unresolved, resolver_state_t *state)
+{
+    followed_ref_t *fr;
+    int hash;
+    int bucket;
+
+    // Create the table of followed references, if this is the first reference followed
+    if (state->followed_refs == NULL)
+    {
+        state->followed_refs = USP_MALLOC(NUM_FOLLOWED_REF_BUCKETS*sizeof(followed_ref_t *));
+        memset(state->followed_refs, 0, NUM_FOLLOWED_REF_BUCKETS*sizeof(followed_ref_t *));
+    }
+
+    // Exit if the reference has already been followed
+    // NOTE: The unresolved part of the search path is compared by pointer, as it always points into the same search path buffer
+    hash = TEXT_UTILS_CalcHash(dereferenced);
+    bucket = ((unsigned)hash) % NUM_FOLLOWED_REF_BUCKETS;
+    fr = state->followed_refs[bucket];
+    while (fr != NULL)
+    {
+        if ((fr->hash == hash) && (fr->unresolved == unresolved) && (strcmp(fr->dereferenced, dereferenced) == 0))
+        {
+            return true;
+        }
+        fr = fr->next;
+    }
+
+    // Record that the reference is being followed
+    fr = USP_MALLOC(sizeof(followed_ref_t));
+    fr->hash = hash;
+    fr->dereferenced = USP_STRDUP(dereferenced);
+    fr->unresolved = unresolved;
+    fr->next = state->followed_refs[bucket];
+    state->followed_refs[bucket] = fr;
+
+    return false;
+}
+
+/*********************************************************************//**
+**
+** DestroyFollowedRefs
+**
+** Frees the table of references followed during this resolution
+**
+** \param   state - pointer to structure containing state variables to use with this resolution
+**
+** \return  None
+**
+**************************************************************************/
+void DestroyFollowedRefs(resolver_state_t *state)
+{
+    followed_ref_t *fr;
+    followed_ref_t *next;
+    int i;
+
+    // Exit if no references were followed
+    if (state->followed_refs == NULL)
+    {
+        return;
+    }
+
+    for (i=0; i < NUM_FOLLOWED_REF_BUCKETS; i++)
+    {
+        fr = state->followed_refs[i];
+        while (fr != NULL)
+        {
+            next = fr->next;
+            USP_FREE(fr->dereferenced);
+            USP_FREE(fr);
+            fr = next;
+        }
+    }
+
+    USP_FREE(state->followed_refs);
+    state->followed_refs = NULL;
+}
+
 /*********************************************************************//**
 **
 ** ResolveUniqueKey
@@ -493,12 +786,13 @@ int ResolveReferenceFollow(char *resolved, char *unresolved, resolver_state_t *s
 **
 ** \param   resolved - pointer to data model object that we want to lookup by unique key
 ** \param   unresolved - pointer to unique key and rest of search path to resolve
+** \param   rn - pointer to node which the first part of 'resolved' has already been found to represent
 ** \param   state - pointer to structure containing state variables to use with this resolution
 **
 ** \return  USP_ERR_OK if successful, or no instances found
 **
 **************************************************************************/
-int ResolveUniqueKey(char *resolved, char *unresolved, resolver_state_t *state)
+int ResolveUniqueKey(char *resolved, char *unresolved, resolved_node_t *rn, resolver_state_t *state)
 {
     str_vector_t key_expressions;
     expr_vector_t keys;
@@ -509,7 +803,15 @@ int ResolveUniqueKey(char *resolved, char *unresolved, resolver_state_t *state)
     int_vector_t iv;
     char temp[MAX_DM_PATH];
     bool is_match;
+    bool is_permitted;
     int instance;
+    int order;
+    resolved_node_t instance_rn;
+    resolved_node_t *key_nodes = NULL;
+    expr_predicate_t *predicates = NULL;
+    int_vector_t indexed_iv;
+    int_vector_t *candidates;
+    expr_comp_t *ec;
     expr_op_t valid_ops[] = {kExprOp_Equal, kExprOp_NotEqual, kExprOp_LessThanOrEqual, kExprOp_GreaterThanOrEqual, kExprOp_LessThan, kExprOp_GreaterThan};
 
     // Exit if this is a Bulk Data collection operation, which does not allow unique key addressing
@@ -531,9 +833,10 @@ int ResolveUniqueKey(char *resolved, char *unresolved, resolver_state_t *state)
     // Initialise vectors used by this function
     STR_VECTOR_Init(&key_expressions);
     EXPR_VECTOR_Init(&keys);
+    INT_VECTOR_Init(&indexed_iv);
 
     // Exit if unable to get the instances of this object
-    err = DATA_MODEL_GetInstances(resolved, &iv);
+    err = GetResolvedInstances(resolved, rn, &instance_rn, &iv);
     if (err != USP_ERR_OK)
     {
         goto exit;
@@ -577,12 +880,63 @@ int ResolveUniqueKey(char *resolved, char *unresolved, resolver_state_t *state)
         goto exit;
     }
 
-    // Iterate over all instances of the object present in the data model
-    for (i=0; i < iv.num_entries; i++)
+    // Exit if unable to find the nodes of the parameters in the unique key
+    // NOTE: The nodes are the same for every instance of the object, so only need to be found once, rather than for every instance
+    order = instance_rn.inst.order - 1;
+    instance_rn.inst.instances[order] = iv.vector[0];
+    key_nodes = USP_MALLOC(keys.num_entries*sizeof(resolved_node_t));
+    err = ResolveUniqueKeyNodes(resolved, &instance_rn, &keys, key_nodes);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    // Exit if not permitted to read all of the parameters in the unique key
+    // NOTE: Permissions are the same for every instance of the object, so only need to be checked once, rather than for every instance
+    err = CheckUniqueKeyPermissions(resolved, iv.vector[0], &keys, key_nodes, &is_permitted, state);
+    if ((err != USP_ERR_OK) || (is_permitted == false))
+    {
+        goto exit;
+    }
+
+    // Compile the key expressions, so that their constants are only converted to the type of their parameter once, rather than for every instance
+    predicates = USP_MALLOC(keys.num_entries*sizeof(expr_predicate_t));
+    for (i=0; i < keys.num_entries; i++)
+    {
+        ec = &keys.vector[i];
+        DM_PRIV_CompilePredicate(key_nodes[i].node, ec->op, ec->value, &predicates[i]);
+    }
+
+    // Determine which instances of the object to test against the unique key
+    // If the unique key contains an equality test on an indexed parameter, then only the instances which
+    // the index says have that value need to be tested, rather than all instances of the object
+    candidates = &iv;
+    for (i=0; i < keys.num_entries; i++)
+    {
+        ec = &keys.vector[i];
+        if ((ec->op == kExprOp_Equal) && (DM_KEY_INDEX_FindInstances(key_nodes[i].node, &key_nodes[i].inst, ec->value, &indexed_iv)))
+        {
+            candidates = &indexed_iv;
+            break;
+        }
+    }
+
+    // Iterate over all candidate instances of the object
+    for (i=0; i < candidates->num_entries; i++)
     {
+        // Skip instances returned by the index which no longer exist in the data model
+        instance = candidates->vector[i];
+        if (candidates == &indexed_iv)
+        {
+            instance_rn.inst.instances[order] = instance;
+            if (DM_INST_VECTOR_IsExist(&instance_rn.inst) == false)
+            {
+                continue;
+            }
+        }
+
         // Exit if an error occurred whilst trying to determine whether this instance matched the unique key
-        instance = iv.vector[i];
-        err = DoesInstanceMatchUniqueKey(resolved, instance, &keys, &is_match, state);
+        err = DoesInstanceMatchUniqueKey(resolved, instance, order, &keys, key_nodes, predicates, &is_match);
         if (err != USP_ERR_OK)
         {
             goto exit;
@@ -592,7 +946,9 @@ int ResolveUniqueKey(char *resolved, char *unresolved, resolver_state_t *state)
         if (is_match)
         {
             USP_SNPRINTF(temp, sizeof(temp), "%s%d", resolved, instance);
-            err = ExpandNextSubPath(temp, unresolved, state);
+            instance_rn.inst.instances[order] = instance;
+            instance_rn.len = strlen(temp);
+            err = ExpandNextSubPath(temp, unresolved, &instance_rn, state);
             if (err != USP_ERR_OK)
             {
                 goto exit;
@@ -609,8 +965,11 @@ exit:
     // Ensure that the key expressions and key-values are deleted
     // NOTE: This is safe to do again here, even if they have already been deleted in the body of the function
     INT_VECTOR_Destroy(&iv);
+    INT_VECTOR_Destroy(&indexed_iv);
     STR_VECTOR_Destroy(&key_expressions);
     EXPR_VECTOR_Destroy(&keys);
+    USP_SAFE_FREE(key_nodes);
+    USP_SAFE_FREE(predicates);
     return err;
 }
 
@@ -625,12 +984,13 @@ exit:
 **
 ** \param   resolved - pointer to buffer containing data model path that has been resolved so far
 ** \param   unresolved - pointer to rest of search path to resolve
+** \param   rn - pointer to node which the first part of 'resolved' has already been found to represent
 ** \param   state - pointer to structure containing state variables to use with this resolution
 **
 ** \return  USP_ERR_OK if successful, or no instances found
 **
 **************************************************************************/
-int ExpandNextSubPath(char *resolved, char *unresolved, resolver_state_t *state)
+int ExpandNextSubPath(char *resolved, char *unresolved, resolved_node_t *rn, resolver_state_t *state)
 {
     int err;
     int separator_count;
@@ -645,7 +1005,7 @@ int ExpandNextSubPath(char *resolved, char *unresolved, resolver_state_t *state)
     }
 
     // Exit if an error occurred in resolving the path further
-    err = ExpandPath(resolved, unresolved, state);
+    err = ExpandPath(resolved, unresolved, rn, state);
     if (err != USP_ERR_OK)
     {
         return err;
@@ -663,12 +1023,13 @@ int ExpandNextSubPath(char *resolved, char *unresolved, resolver_state_t *state)
 ** NOTE: This function does not take 'op' as a parameter (unlike the other resolve functions) because it is only applicable to get operations
 **
 ** \param   path - path of the root object. NOTE: Must not include trailing '.' !
+** \param   rn - pointer to node which the first part of the path has already been found to represent
 ** \param   state - pointer to structure containing state variables to use with this resolution
 **
 ** \return  USP_ERR_OK if successful, or no instances found
 **
 **************************************************************************/
-int ResolvePartialPath(char *path, resolver_state_t *state)
+int ResolvePartialPath(char *path, resolved_node_t *rn, resolver_state_t *state)
 {
     dm_instances_t inst;
     dm_node_t *node;
@@ -680,7 +1041,7 @@ int ResolvePartialPath(char *path, resolver_state_t *state)
     int separator_count;
 
     // Exit if unable to find node representing this object
-    node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
+    node = GetResolvedNode(path, rn, &inst, &is_qualified_instance);
     if (node == NULL)
     {
         return USP_ERR_INVALID_PATH;
@@ -725,29 +1086,78 @@ int ResolvePartialPath(char *path, resolver_state_t *state)
     return err;
 }
 
+/*********************************************************************//**
+**
+** ResolveUniqueKeyNodes
+**
+** Finds the nodes (and instance numbers) of the parameters in the specified unique key, for one instance of the object
+** NOTE: The nodes are the same for all instances of the object, so the caller need only call this function once
+**
+** \param   object - data model path of object containing the unique key parameters
+** \param   instance_rn - pointer to node and instance numbers of the instance of the object to use
+** \param   keys - vector of key expressions that specify the unique key
+** \param   key_nodes - pointer to array in which to return the node and instance numbers of each parameter in the unique key
+**
+** \return  USP_ERR_OK if no errors occurred
+**
+**************************************************************************/
+int ResolveUniqueKeyNodes(char *object, resolved_node_t *instance_rn, expr_vector_t *keys, resolved_node_t *key_nodes)
+{
+    int i;
+    expr_comp_t *ec;
+    char path[MAX_DM_PATH];
+    bool is_qualified_instance;
+    int instance;
+    int len;
+
+    // Form the path of the object instance
+    instance = instance_rn->inst.instances[instance_rn->inst.order - 1];
+    len = USP_SNPRINTF(path, sizeof(path), "%s%d", object, instance);
+    instance_rn->len = len;
+
+    for (i=0; i < keys->num_entries; i++)
+    {
+        // Form parameter path of the unique key
+        ec = &keys->vector[i];
+        USP_SNPRINTF(&path[len], sizeof(path)-len, ".%s", ec->param);
+
+        // Exit if the parameter in the unique key does not exist in the schema
+        key_nodes[i].node = GetResolvedNode(path, instance_rn, &key_nodes[i].inst, &is_qualified_instance);
+        if (key_nodes[i].node == NULL)
+        {
+            return USP_ERR_INVALID_PATH;
+        }
+    }
+
+    return USP_ERR_OK;
+}
+
 /*********************************************************************//**
 **
 ** DoesInstanceMatchUniqueKey
 **
 ** Determines whether the specified object instance matches the specified unique key
+** NOTE: The caller must already have checked that the parameters in the unique key may be read (see CheckUniqueKeyPermissions)
 **
 ** \param   object - data model path of object to see if it matches the unique key
 ** \param   instance - instance number of the object to see if it matches the unique key
+** \param   order - index of the object's instance number in the instance numbers of the parameters in the unique key
 ** \param   keys - vector of key expressions that specify the unique key
+** \param   key_nodes - array containing the node and instance numbers of each parameter in the unique key (see ResolveUniqueKeyNodes)
+** \param   predicates - array containing each key expression, compiled for comparison against its parameter
 ** \param   is_match - pointer to boolean in which to return whether this instance matched the unique key
-** \param   state - pointer to structure containing state variables to use with this resolution
 **
 ** \return  USP_ERR_OK if no errors occurred
 **
 **************************************************************************/
-int DoesInstanceMatchUniqueKey(char *object, int instance, expr_vector_t *keys, bool *is_match, resolver_state_t *state)
+int DoesInstanceMatchUniqueKey(char *object, int instance, int order, expr_vector_t *keys, resolved_node_t *key_nodes, expr_predicate_t *predicates, bool *is_match)
 {
     int err;
     int i;
     expr_comp_t *ec;
     char path[MAX_DM_PATH];
     bool result;
-    unsigned short permission_bitmask;
+    dm_instances_t *inst;
 
     // Assume that this instance does not match
     *is_match = false;
@@ -758,46 +1168,80 @@ int DoesInstanceMatchUniqueKey(char *object, int instance, expr_vector_t *keys,
         // Form parameter path of the unique key to check
         ec = &keys->vector[i];
         USP_SNPRINTF(path, sizeof(path), "%s%d.%s", object, instance, ec->param);
+        inst = &key_nodes[i].inst;
+        inst->instances[order] = instance;
 
-        // Exit if unable to determine whether we are allowed to read the unique key
-        err = DATA_MODEL_GetPermissions(path, state->combined_role, &permission_bitmask);
+        // Exit if unable to compare the value of the parameter in the expression
+        err = DM_PRIV_EvaluatePredicate(path, key_nodes[i].node, inst, &predicates[i], &result);
         if (err != USP_ERR_OK)
         {
             return err;
         }
-        
+
+        // Exit if the unique key did not match the value we want
+        if (result != true)
+        {
+            return USP_ERR_OK;
+        }
+    }
+
+    // If the code gets here, then the instance matches all key expressions in the compound unique key
+    *is_match = true;
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** CheckUniqueKeyPermissions
+**
+** Determines whether the controller's role permits it to read all of the parameters in the specified unique key
+**
+** \param   object - data model path of object containing the unique key parameters
+** \param   instance - instance number of any instance of the object (used to form the paths of the unique key parameters)
+** \param   keys - vector of key expressions that specify the unique key
+** \param   key_nodes - array containing the node of each parameter in the unique key (see ResolveUniqueKeyNodes)
+** \param   is_permitted - pointer to boolean in which to return whether all parameters in the unique key may be read
+** \param   state - pointer to structure containing state variables to use with this resolution
+**
+** \return  USP_ERR_OK if no errors occurred
+**          NOTE: If not permitted, operations other than get (which are not forgiving of permissions) return an error
+**
+**************************************************************************/
+int CheckUniqueKeyPermissions(char *object, int instance, expr_vector_t *keys, resolved_node_t *key_nodes, bool *is_permitted, resolver_state_t *state)
+{
+    int i;
+    expr_comp_t *ec;
+    char path[MAX_DM_PATH];
+    unsigned short permission_bitmask;
+
+    // Assume that reading the unique key is not permitted
+    *is_permitted = false;
+
+    // Iterate over all key expressions, exiting on the first one which isn't permitted to be read
+    for (i=0; i < keys->num_entries; i++)
+    {
         // Exit if not permitted to read the parameter in the unique key
+        permission_bitmask = DM_PRIV_GetPermissions(key_nodes[i].node, state->combined_role);
         if ((permission_bitmask & PERMIT_GET) == 0)
         {
-            // Get operations are forgiving of permissions, so just give up further resolution here, 
-            // returning that this instance does not match
+            // Get operations are forgiving of permissions, so just give up further resolution here,
+            // returning that no instances match
             // NOTE: BulkData get operations are not forgiving of permissions, so will return an error
             if ((state->op == kResolveOp_Get) || (state->op == kResolveOp_SubsValChange))
             {
                 return USP_ERR_OK;
             }
-        
+
             // Other operations are not forgiving, so return an error
+            ec = &keys->vector[i];
+            USP_SNPRINTF(path, sizeof(path), "%s%d.%s", object, instance, ec->param);
             USP_ERR_SetMessage("%s: Not permitted to read unique key %s", __FUNCTION__, path);
             return USP_ERR_PERMISSION_DENIED;
         }
-
-        // Exit if unable to compare the value of the parameter in the expression
-        err = DATA_MODEL_CompareParameterValue(path, ec->op, ec->value, &result);
-        if (err != USP_ERR_OK)
-        {
-            return err;
-        }
-
-        // Exit if the unique key did not match the value we want
-        if (result != true)
-        {
-            return USP_ERR_OK;
-        }
     }
 
-    // If the code gets here, then the instance matches all key expressions in the compound unique key
-    *is_match = true;
+    // If the code gets here, then all parameters in the unique key may be read
+    *is_permitted = true;
     return USP_ERR_OK;
 }
 
@@ -923,11 +1367,15 @@ int GetChildParams(char *path, int path_len, dm_node_t *node, dm_instances_t *in
         }
 
 
-        // Add this node, if permissions have allowed it and we are returning a vector
-        if ((add_to_vector) && (state->sv != NULL))
+        // Add this node, if permissions have allowed it and we are returning paths
+        if ((add_to_vector) && ((state->sv != NULL) || (state->callback != NULL)))
         {
             USP_SNPRINTF(&path[path_len], MAX_DM_PATH-path_len, ".%s", child->name);
-            STR_VECTOR_Add(state->sv, path);
+            err = ReturnPathFound(path, child, inst, state);
+            if (err != USP_ERR_OK)
+            {
+                return err;
+            }
         }
 
         // Move to next sibling in the data model tree
@@ -1012,6 +1460,7 @@ exit:
 ** the path meets the criteria for inclusion for the specified operation being performed by this USP message
 **
 ** \param   path - pointer to path expression identifying objects in the data model
+** \param   rn - pointer to node which the first part of the path has already been found to represent
 ** \param   state - pointer to structure containing state variables to use with this resolution
 **
 ** \return  USP_ERR_OK if path resolution should continue
@@ -1020,15 +1469,18 @@ exit:
 **                continues, even if this path is not suitable for inclusion in the result vector
 **
 **************************************************************************/
-int AddPathFound(char *path, resolver_state_t *state)
+int AddPathFound(char *path, resolved_node_t *rn, resolver_state_t *state)
 {
-    int index;
+    int i;
+    int num_entries;
     int err;
     bool add_to_vector;
     unsigned path_properties;
+    resolved_node_t path_rn;
+    str_vector_t instance_paths;
 
     // Exit if the path did not match the properties we expected of it
-    err = CheckPathProperties(path, state, &add_to_vector, &path_properties);
+    err = CheckPathProperties(path, rn, state, &add_to_vector, &path_properties, &path_rn);
     if (err != USP_ERR_OK)
     {
         return err;
@@ -1040,8 +1492,8 @@ int AddPathFound(char *path, resolver_state_t *state)
         return USP_ERR_OK;
     }
 
-    // Exit if we are just validating the search path, and don't actually want to add the path to the returned vector
-    if (state->sv == NULL)
+    // Exit if we are just validating the search path, and don't actually want to return the path
+    if ((state->sv == NULL) && (state->callback == NULL))
     {
         return USP_ERR_OK;
     }
@@ -1052,35 +1504,135 @@ int AddPathFound(char *path, resolver_state_t *state)
          ((path_properties & PP_IS_OBJECT_INSTANCE) == 0) )
     {
         USP_ASSERT(path_properties & PP_IS_MULTI_INSTANCE_OBJECT);
-        err = DATA_MODEL_GetInstancePaths(path, state->sv, INTERNAL_ROLE);  // NOTE: We can use internal role because we've already checked permissions on this object
-                                                                            //       and we don't want it to check get object instance permissions anyway for subscription add/delete paths
+        STR_VECTOR_Init(&instance_paths);
+        err = DATA_MODEL_GetInstancePaths(path, &instance_paths, INTERNAL_ROLE);  // NOTE: We can use internal role because we've already checked permissions on this object
+                                                                                  //       and we don't want it to check get object instance permissions anyway for subscription add/delete paths
+        if (err == USP_ERR_OK)
+        {
+            err = ReturnInstancePathsFound(&instance_paths, state);
+        }
+        STR_VECTOR_Destroy(&instance_paths);
         return err;
     }
 
     // Handle resolving GetInstances
     if (state->op == kResolveOp_Instances)
     {
+        STR_VECTOR_Init(&instance_paths);
         if (state->flags & GET_ALL_INSTANCES)
         {
-            err = DATA_MODEL_GetAllInstancePaths(path, state->sv, state->combined_role);
+            err = DATA_MODEL_GetAllInstancePaths(path, &instance_paths, state->combined_role);
         }
         else
         {
-            err = DATA_MODEL_GetInstancePaths(path, state->sv, state->combined_role);
+            err = DATA_MODEL_GetInstancePaths(path, &instance_paths, state->combined_role);
         }
+
+        if (err == USP_ERR_OK)
+        {
+            err = ReturnInstancePathsFound(&instance_paths, state);
+        }
+        STR_VECTOR_Destroy(&instance_paths);
         return err;
     }
 
     // Normal execution path below
-    // Exit if the path already exists in the vector
-    index = STR_VECTOR_Find(state->sv, path);
-    if (index != INVALID)
-    {        
+    if (state->callback == NULL)
+    {
+        // Exit if the path already exists in the vector
+        // NOTE: Unless a reference has been followed, paths found by this resolution are unique,
+        //       so they only need to be checked against the paths present before this resolution started
+        num_entries = (state->is_reference_followed) ? state->sv->num_entries : state->sv_initial_entries;
+        for (i=0; i < num_entries; i++)
+        {
+            if (strcmp(state->sv->vector[i], path) == 0)
+            {
+                return USP_ERR_OK;
+            }
+        }
+    }
+    else if (state->is_reference_followed)
+    {
+        // Exit if the callback has already been called with this path
+        // NOTE: Only paths found after a reference has been followed may be duplicates, so only these need to be remembered
+        if (STR_VECTOR_Find(&state->paths_found, path) != INVALID)
+        {
+            return USP_ERR_OK;
+        }
+        STR_VECTOR_Add(&state->paths_found, path);
+    }
+
+    // Finally return the single path
+    err = ReturnPathFound(path, path_rn.node, &path_rn.inst, state);
+
+    return err;
+}
+
+/*********************************************************************//**
+**
+** ReturnPathFound
+**
+** Returns the specified path to the caller of the path resolver, either by adding it to the vector, or by calling the callback
+**
+** \param   path - data model path that has been resolved
+** \param   node - data model node of the path
+** \param   inst - pointer to instance numbers of the path
+** \param   state - pointer to structure containing state variables to use with this resolution
+**
+** \return  USP_ERR_OK if path resolution should continue
+**
+**************************************************************************/
+int ReturnPathFound(char *path, dm_node_t *node, dm_instances_t *inst, resolver_state_t *state)
+{
+    int err;
+
+    // Add the path to the vector, if the caller is not using a callback
+    if (state->callback == NULL)
+    {
+        STR_VECTOR_Add(state->sv, path);
         return USP_ERR_OK;
     }
 
-    // Finally add the single path to the vector
-    STR_VECTOR_Add(state->sv, path);
+    err = state->callback(path, node, inst, state->separator_count, state->cb_arg);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** ReturnInstancePathsFound
+**
+** Returns the specified object instance paths to the caller of the path resolver
+**
+** \param   sv - pointer to vector containing the object instance paths
+** \param   state - pointer to structure containing state variables to use with this resolution
+**
+** \return  USP_ERR_OK if path resolution should continue
+**
+**************************************************************************/
+int ReturnInstancePathsFound(str_vector_t *sv, resolver_state_t *state)
+{
+    int i;
+    int err;
+    dm_node_t *node;
+    dm_instances_t inst;
+    bool is_qualified_instance;
+
+    for (i=0; i < sv->num_entries; i++)
+    {
+        // Determine the node and instance numbers of the path, if calling the callback
+        node = NULL;
+        if (state->callback != NULL)
+        {
+            node = DM_PRIV_GetNodeFromPath(sv->vector[i], &inst, &is_qualified_instance);
+            USP_ASSERT(node != NULL);
+        }
+
+        err = ReturnPathFound(sv->vector[i], node, &inst, state);
+        if (err != USP_ERR_OK)
+        {
+            return err;
+        }
+    }
 
     return USP_ERR_OK;
 }
@@ -1092,9 +1644,11 @@ int AddPathFound(char *path, resolver_state_t *state)
 ** Check that the resolved path has the properties which we expect of it
 **
 ** \param   path - pointer to path expression identifying objects in the data model
+** \param   rn - pointer to node which the first part of the path has already been found to represent
 ** \param   state - pointer to structure containing state variables to use with this resolution
 ** \param   add_to_vector - pointer to variable in which to return if the path should be added to the vector of resolved objects/parameters
 ** \param   path_properties - pointer to variable in which to return the properties of the resolved object/parameter
+** \param   path_rn - pointer to structure in which to return the node and instance numbers of the path
 **
 ** \return  USP_ERR_OK if path resolution should continue
 **          
@@ -1102,17 +1656,27 @@ int AddPathFound(char *path, resolver_state_t *state)
 **                continues, even if this path is not suitable for inclusion in the result vector
 **
 **************************************************************************/
-int CheckPathProperties(char *path, resolver_state_t *state, bool *add_to_vector, unsigned *path_properties)
+int CheckPathProperties(char *path, resolved_node_t *rn, resolver_state_t *state, bool *add_to_vector, unsigned *path_properties, resolved_node_t *path_rn)
 {
     unsigned flags;
     int err;
     unsigned short permission_bitmask;
+    dm_node_t *node;
+    bool is_qualified_instance;
 
     // Assume that the path should be added to the vector
     *add_to_vector = false;
 
     // Exit if the path does not exist in the schema
-    flags = DATA_MODEL_GetPathProperties(path, state->combined_role, &permission_bitmask);
+    node = GetResolvedNode(path, rn, &path_rn->inst, &is_qualified_instance);
+    path_rn->node = node;
+    path_rn->len = strlen(path);
+    flags = 0;
+    permission_bitmask = PERMIT_NONE;
+    if (node != NULL)
+    {
+        flags = DM_PRIV_GetPathProperties(node, &path_rn->inst, is_qualified_instance, state->combined_role, &permission_bitmask);
+    }
     *path_properties = flags;
     if ((flags & PP_EXISTS_IN_SCHEMA)==0)
     {
@@ -1435,3 +1999,110 @@ int CountPathSeparator(char *path)
 
     return count;
 }
+
+/*********************************************************************//**
+**
+** GetResolvedNode
+**
+** Gets the node in the data model associated with the specified path, only looking up the part of the path
+** which has not already been resolved to a node
+**
+** \param   path - data model path to get the node of
+** \param   rn - pointer to node which the first part of the path has already been found to represent
+** \param   inst - pointer to structure in which to return the instance numbers parsed from the path
+** \param   is_qualified_instance - pointer to variable in which to return whether the path was qualified by all of its instance numbers
+**
+** \return  pointer to node representing the path, or NULL if the path does not exist in the schema
+**
+**************************************************************************/
+dm_node_t *GetResolvedNode(char *path, resolved_node_t *rn, dm_instances_t *inst, bool *is_qualified_instance)
+{
+    char c;
+
+    // Lookup the whole path, if none of it has been resolved to a node yet,
+    // or if the resolved part of the path does not end on a path segment boundary
+    c = path[rn->len];
+    if ((rn->node == NULL) || ((c != '.') && (c != '\0')))
+    {
+        return DM_PRIV_GetNodeFromPath(path, inst, is_qualified_instance);
+    }
+
+    // Otherwise, only lookup the rest of the path, starting from the node which has already been resolved
+    memcpy(inst, &rn->inst, sizeof(dm_instances_t));
+    return DM_PRIV_GetSubPathNode(path, rn->len, rn->node, inst, is_qualified_instance);
+}
+
+/*********************************************************************//**
+**
+** GetResolvedInstances
+**
+** Gets the instances of the multi-instance object represented by the specified path
+** This is equivalent to DATA_MODEL_GetInstances(), but only looks up the part of the path which has not already been resolved to a node
+**
+** \param   path - data model path of the (unqualified) multi-instance object
+** \param   rn - pointer to node which the first part of the path has already been found to represent
+** \param   instance_rn - pointer to structure in which to return the node and instance numbers of an instance of the object
+**                        NOTE: The caller must fill in the object's instance number (the last one) and the length of the path to the instance
+** \param   iv - pointer to vector in which to return the instances of the object
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int GetResolvedInstances(char *path, resolved_node_t *rn, resolved_node_t *instance_rn, int_vector_t *iv)
+{
+    int err;
+    dm_instances_t *inst;
+    dm_node_t *node;
+    bool exists;
+    bool is_qualified_instance;
+
+    INT_VECTOR_Init(iv);
+
+    // Exit if unable to find node representing this object
+    inst = &instance_rn->inst;
+    node = GetResolvedNode(path, rn, inst, &is_qualified_instance);
+    if (node == NULL)
+    {
+        return USP_ERR_OBJECT_DOES_NOT_EXIST;
+    }
+
+    // Exit if this is not a multi-instance object
+    if (node->type != kDMNodeType_Object_MultiInstance)
+    {
+        USP_ERR_SetMessage("%s: Not a multi-instance object: %s", __FUNCTION__, path);
+        return USP_ERR_NOT_A_TABLE;
+    }
+
+    // Exit if this object is already a fully qualified instance
+    // This can occur if the path given to the path resolver has an instance number immediately followed by '*' or '[]' (ie path syntax error)
+    if (is_qualified_instance)
+    {
+        USP_ERR_SetMessage("%s: Path (%s) should not contain an instance number followed by '*' or '[]'", __FUNCTION__, path);
+        return USP_ERR_INVALID_PATH_SYNTAX;
+    }
+
+    // Exit if the object instances in the path do not exist
+    exists = DM_INST_VECTOR_IsExist(inst);
+    if (exists == false)
+    {
+        USP_ERR_SetMessage("%s: Object exists in schema, but instances are invalid: %s", __FUNCTION__, path);
+        return USP_ERR_OBJECT_DOES_NOT_EXIST;
+    }
+
+    // Exit if unable to get the instances of the object
+    err = DM_INST_VECTOR_GetInstances(node, inst, iv);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Add the object's instance number to the instance structure, ready for the caller to fill it in
+    USP_ASSERT(inst->order < MAX_DM_INSTANCE_ORDER);
+    inst->nodes[inst->order] = node;
+    inst->instances[inst->order] = 0;
+    inst->order++;
+    instance_rn->node = node;
+    instance_rn->len = 0;
+
+    return USP_ERR_OK;
+}
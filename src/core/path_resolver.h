@@ -42,6 +42,7 @@
 #define PATH_RESOLVER_H
 
 #include "str_vector.h"
+#include "data_model.h"
 
 // Enumeration determining what we are attempting to resolve with the path expression
 // This affects whether the path is valid, along with which object/parameter paths are returned
@@ -71,9 +72,17 @@ typedef enum
 // Bitmask for the flags argument of PATH_RESOLVER_ResolvePath(). Thse flags control resolving of the path
 #define GET_ALL_INSTANCES 0x0001
 
+// Callback called by PATH_RESOLVER_IterateDevicePath() and PATH_RESOLVER_IteratePath() for each resolved path, as it is found
+// The path, node and instance numbers are only valid for the duration of the callback
+// separator_split is the point at which to split the path found so far. It may increase as further paths are found, if a reference has been followed
+// Returning an error from the callback stops resolution of the path, and the error is returned by the iterate function
+typedef int (*path_resolver_cb_t)(char *path, dm_node_t *node, dm_instances_t *inst, int separator_split, void *cb_arg);
+
 // API
 int PATH_RESOLVER_ResolveDevicePath(char *path, str_vector_t *sv, resolve_op_t op, int *separator_split, combined_role_t *combined_role, unsigned flags);
 int PATH_RESOLVER_ResolvePath(char *path, str_vector_t *sv, resolve_op_t op, int *separator_split, combined_role_t *combined_role, unsigned flags);
+int PATH_RESOLVER_IterateDevicePath(char *path, path_resolver_cb_t callback, void *cb_arg, resolve_op_t op, int *separator_split, combined_role_t *combined_role, unsigned flags);
+int PATH_RESOLVER_IteratePath(char *path, path_resolver_cb_t callback, void *cb_arg, resolve_op_t op, int *separator_split, combined_role_t *combined_role, unsigned flags);
 
 
 
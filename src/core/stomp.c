@@ -200,7 +200,10 @@ typedef struct
 
 //------------------------------------------------------------------------------
 // Array of enabled (ie active) STOMP connections
-static stomp_connection_t stomp_connections[MAX_STOMP_CONNECTIONS];
+// This array is grown on demand. It holds pointers, so that a connection does not move in memory once allocated
+// (the SSL object for the connection holds a pointer into its slot)
+static stomp_connection_t **stomp_connections = NULL;
+static int num_stomp_connections = 0;
 
 //------------------------------------------------------------------------------
 // USP Message to send in queue
@@ -294,18 +297,11 @@ int GetNextStompMsgToSend(stomp_connection_t *sc);
 **************************************************************************/
 int STOMP_Init(void)
 {
-    int i;
     int err;
-    stomp_connection_t *sc;
 
-    // Mark all stomp connection slots as unused
-    memset(stomp_connections, 0, sizeof(stomp_connections));
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
-    {
-        sc = &stomp_connections[i];
-        sc->instance = INVALID;
-        sc->schedule_reconnect = kScheduledAction_Off;
-    }
+    // Start with no stomp connection slots. These are allocated as STOMP connections are enabled
+    stomp_connections = NULL;
+    num_stomp_connections = 0;
 
     // Exit if unable to create mutex protecting access to this subsystem
     err = OS_UTILS_InitMutex(&stomp_access_mutex);
@@ -333,15 +329,25 @@ void STOMP_Destroy(void)
     int i;
     stomp_connection_t *sc;
 
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
+    for (i=0; i<num_stomp_connections; i++)
     {
-        sc = &stomp_connections[i];
+        sc = stomp_connections[i];
         if (sc->instance != INVALID)
         {
             STOMP_DisableConnection(sc->instance, PURGE_QUEUED_MESSAGES);
         }
     }
 
+    // Free all stomp connection slots
+    OS_UTILS_LockMutex(&stomp_access_mutex);
+    for (i=0; i<num_stomp_connections; i++)
+    {
+        USP_FREE(stomp_connections[i]);
+    }
+    USP_SAFE_FREE(stomp_connections);
+    num_stomp_connections = 0;
+    OS_UTILS_UnlockMutex(&stomp_access_mutex);
+
     // Free the OpenSSL context
     if (stomp_ssl_ctx != NULL)
     {
@@ -420,9 +426,9 @@ void STOMP_UpdateAllSockSet(socket_set_t *set)
     SOCKET_SET_UpdateTimeout(timeout*SECONDS, set);
 
     // Iterate over all STOMP connections, updating the ones that are enabled    
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
+    for (i=0; i<num_stomp_connections; i++)
     {
-        sc = &stomp_connections[i];
+        sc = stomp_connections[i];
         if (sc->instance != INVALID)
         {
             // Determine if all responses have been sent on this connection, and update whether they have been sent on all connections
@@ -509,9 +515,9 @@ bool STOMP_AreAllResponsesSent(void)
     }
 
     // Iterate over all STOMP connections,
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
+    for (i=0; i<num_stomp_connections; i++)
     {
-        sc = &stomp_connections[i];
+        sc = stomp_connections[i];
         if (sc->instance != INVALID)
         {
             // Determine if all responses have been sent on this connection, and update whether they have been sent on all connections
@@ -560,9 +566,9 @@ void STOMP_ProcessAllSocketActivity(socket_set_t *set)
     }
 
     // Iterate over all STOMP connections, processing activity on the ones that are enabled    
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
+    for (i=0; i<num_stomp_connections; i++)
     {
-        sc = &stomp_connections[i];
+        sc = stomp_connections[i];
         if ((sc->instance != INVALID) && (sc->socket_fd != INVALID))
         {
             ProcessStompConnectionSocketActivity(sc, set);
@@ -899,9 +905,9 @@ void STOMP_ActivateScheduledActions(void)
     }
 
     // Iterate over all STOMP connections, activating all reconnects which have been signalled
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
+    for (i=0; i<num_stomp_connections; i++)
     {
-        sc = &stomp_connections[i];
+        sc = stomp_connections[i];
         if (sc->schedule_reconnect == kScheduledAction_Signalled)
         {
             sc->schedule_reconnect = kScheduledAction_Activated;
@@ -3671,9 +3677,9 @@ void UpdateWANInterface(bool is_first_time)
 
     // Iterate over all STOMP connections, stopping and restarting the ones that are enabled  
     USP_LOG_Warning("Mgmt IP Address changed to %s. Restarting all STOMP connections.", cur_mgmt_ip_addr);
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
+    for (i=0; i<num_stomp_connections; i++)
     {
-        sc = &stomp_connections[i];
+        sc = stomp_connections[i];
         if (sc->instance != INVALID)
         {
             StopStompConnection(sc, DONT_PURGE_QUEUED_MESSAGES);
@@ -3705,9 +3711,9 @@ void HandleStompSourceIPAddrChanges(void)
     // Iterate over all STOMP connections, restarting any whose IP address has changed
     // NOTE: If the STOMP connection failed, then it will be retried by the retry mechanism.
     //       This code does NOT detect interfaces going up and then retrying the connection
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
+    for (i=0; i<num_stomp_connections; i++)
     {
-        sc = &stomp_connections[i];
+        sc = stomp_connections[i];
         if ((sc->instance != INVALID) && (sc->mgmt_if_name[0] != '\0') && (sc->mgmt_ip_addr[0] != '\0'))
         {
             has_changed = nu_ipaddr_has_interface_addr_changed(sc->mgmt_if_name, sc->mgmt_ip_addr, &has_addr);
@@ -3851,10 +3857,10 @@ stomp_connection_t *FindStompConnByInst(int instance)
     stomp_connection_t *sc;
 
     // Iterate over all STOMP connections
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
+    for (i=0; i<num_stomp_connections; i++)
     {
         // Exit if found a stomp connection that matches the instance number
-        sc = &stomp_connections[i];
+        sc = stomp_connections[i];
         if (sc->instance == instance)
         {
             return sc;
@@ -3869,11 +3875,12 @@ stomp_connection_t *FindStompConnByInst(int instance)
 **
 ** FindUnusedStompConn
 **
-** Finds the first free stomp connection slot
+** Finds the first free stomp connection slot, allocating a new slot if all slots are in use
+** NOTE: This function must be called with the stomp_access_mutex held
 **
 ** \param   None
 **
-** \return  Pointer to first free slot, or NULL if no slot was found
+** \return  Pointer to first free slot, or NULL if MAX_STOMP_CONNECTIONS slots are already in use
 **
 **************************************************************************/
 stomp_connection_t *FindUnusedStompConn(void)
@@ -3882,19 +3889,34 @@ stomp_connection_t *FindUnusedStompConn(void)
     stomp_connection_t *sc;
 
     // Iterate over all STOMP connections
-    for (i=0; i<MAX_STOMP_CONNECTIONS; i++)
+    for (i=0; i<num_stomp_connections; i++)
     {
         // Exit if found an unused slot
-        sc = &stomp_connections[i];
+        sc = stomp_connections[i];
         if (sc->instance == INVALID)
         {
             return sc;
         }
     }
 
-    // If the code gets here, then no free slot has been found
-    USP_LOG_Error("%s: Only %d STOMP connections are supported.", __FUNCTION__, MAX_STOMP_CONNECTIONS);
-    return NULL;
+    // Exit if the table has already grown to its limit
+    if (num_stomp_connections >= MAX_STOMP_CONNECTIONS)
+    {
+        USP_LOG_Error("%s: Only %d STOMP connections are supported.", __FUNCTION__, MAX_STOMP_CONNECTIONS);
+        return NULL;
+    }
+
+    // If the code gets here, then no free slot has been found, so allocate another slot
+    sc = USP_MALLOC(sizeof(stomp_connection_t));
+    memset(sc, 0, sizeof(stomp_connection_t));
+    sc->instance = INVALID;
+    sc->schedule_reconnect = kScheduledAction_Off;
+
+    stomp_connections = USP_REALLOC(stomp_connections, (num_stomp_connections+1)*sizeof(stomp_connection_t *));
+    stomp_connections[num_stomp_connections] = sc;
+    num_stomp_connections++;
+
+    return sc;
 }
 
 /*********************************************************************//**
@@ -163,7 +163,6 @@ void SUBS_VECTOR_DestroySubscriber(subs_t *sub)
     USP_SAFE_FREE(sub->subscription_id);
 
     STR_VECTOR_Destroy(&sub->path_expressions);
-    KV_VECTOR_Destroy(&sub->last_values);
     STR_VECTOR_Destroy(&sub->resolved_paths);
 }
 
@@ -297,12 +296,6 @@ void SUBS_VECTOR_Dump(subs_vector_t *suv)
         {
             USP_DUMP("path[%d]=%s", j, sub->path_expressions.vector[j]);
         }
-
-        // Log all last values
-        for (j=0; j < sub->last_values.num_entries; j++)
-        {
-            USP_DUMP("last_values[%d] %s => %s", j, sub->last_values.vector[j].key, sub->last_values.vector[j].value);
-        }
         USP_DUMP("-");
 
     }
@@ -76,7 +76,6 @@ typedef struct
     subs_notify_t notify_type;          // Device.LocalAgent.Subscription.{i}.NotifType
     time_t expiry_time;                 // Time at which this subscription should be stopped and removed from the DB
     unsigned retry_expiry_period;       // Device.LocalAgent.Subscription.{i}.NotifExpiration
-    kv_vector_t last_values;            // List of parameters+values from last time that the subscription was polled (if the subscription is a value change subscription)
     str_vector_t resolved_paths;       // Used to cache the resolved paths of an object deletion subscription before the object has been deleted from the data model
 } subs_t;
 
@@ -68,6 +68,26 @@ tu_uptime_msecs(void)
 	return (uint32_t)t;
 }
 
+/*********************************************************************//**
+**
+** tu_uptime_usecs
+**
+** Returns the number of micro-seconds since the kernel was rebooted
+**
+** \param   None
+**
+** \return  Number of micro-seconds
+**
+**************************************************************************/
+uint64_t
+tu_uptime_usecs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000) + (uint64_t)(ts.tv_nsec / 1000);
+}
+
 /*********************************************************************//**
 **
 ** tu_uptime_secs
@@ -45,6 +45,7 @@
 #include <stdint.h>
 
 uint32_t tu_uptime_msecs(void);
+uint64_t tu_uptime_usecs(void);
 uint32_t tu_uptime_secs(void);
 
 #endif
@@ -43,6 +43,7 @@
 #include "common_defs.h"
 #include "data_model.h"
 #include "usp_api.h"
+#include "int_vector.h"
 #include "iso8601.h"
 #include "os_utils.h"
 #include "device.h"
@@ -150,6 +151,8 @@ int USP_DM_InformInstance(char *path)
 ** Gets a vector of instance numbers for the specified object
 ** Wrapper function around data model API, that ensures the function is only called from the data model thread
 **
+** NOTE: The caller must call USP_DM_DestroyInstances() to free the vector afterwards
+**
 ** \param   path - path of the object
 ** \param   iv - pointer to structure in which to return the instance numbers
 **
@@ -161,12 +164,29 @@ int USP_DM_GetInstances(char *path, int_vector_t *iv)
     // Exit if this function is not being called from the data model thread
     if (OS_UTILS_IsDataModelThread(__FUNCTION__, PRINT_WARNING)==false)
     {
+        INT_VECTOR_Init(iv);
         return USP_ERR_INTERNAL_ERROR;
     }
 
     return DATA_MODEL_GetInstances(path, iv);
 }
 
+/*********************************************************************//**
+**
+** USP_DM_DestroyInstances
+**
+** Frees the vector of instance numbers returned by USP_DM_GetInstances()
+**
+** \param   iv - pointer to vector of instance numbers to free
+**
+** \return  None
+**
+**************************************************************************/
+void USP_DM_DestroyInstances(int_vector_t *iv)
+{
+    INT_VECTOR_Destroy(iv);
+}
+
 /*********************************************************************//**
 **
 ** USP_ARG_Create
@@ -221,6 +241,30 @@ void USP_ARG_Add(kv_vector_t *kvv, char *key, char *value)
     KV_VECTOR_Add(kvv, key, value);
 }
 
+/*********************************************************************//**
+**
+** USP_ARG_SetValue
+**
+** Sets the value of the key value pair at the specified index in the vector, replacing any previous value
+** This is typically used by a get group vendor hook to return the values of the parameters it was asked for
+**
+** \param   kvv - pointer to structure containing the key value pair
+** \param   index - index of the key value pair in the vector
+** \param   value - pointer to string to copy
+**
+** \return  None
+**
+**************************************************************************/
+void USP_ARG_SetValue(kv_vector_t *kvv, int index, char *value)
+{
+    kv_pair_t *pair;
+
+    USP_ASSERT((index >= 0) && (index < kvv->num_entries));
+    pair = &kvv->vector[index];
+    USP_SAFE_FREE(pair->value);
+    pair->value = USP_STRDUP(value);
+}
+
 /*********************************************************************//**
 **
 ** USP_ARG_AddUnsigned
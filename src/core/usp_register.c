@@ -52,6 +52,11 @@
 // NOTE: As this structure is registered early in the bootup, it is safe to be indexed from multiple threads subsequently
 vendor_hook_cb_t vendor_hook_callbacks = { NULL };
 
+//------------------------------------------------------------------------------
+// Array containing the vendor hook callback functions for each group of vendor parameters
+// NOTE: As these are registered early in the bootup, it is safe to index this array from multiple threads subsequently
+group_vendor_hook_t group_vendor_hooks[MAX_VENDOR_PARAM_GROUPS] = { { NULL, NULL } };
+
 //------------------------------------------------------------------------------
 // Commonly used strings
 static char *usp_err_invalid_param_str = "%s: Invalid parameters";
@@ -473,6 +478,7 @@ int USP_REGISTER_VendorParam_ReadOnly(char *path, dm_get_value_cb_t get_cb, unsi
     info->get_cb = get_cb;
     info->set_cb = NULL;
     info->type_flags = type_flags;
+    info->group_id = NON_GROUPED;
     return USP_ERR_OK;
 }
 
@@ -526,6 +532,152 @@ int USP_REGISTER_VendorParam_ReadWrite(char *path, dm_get_value_cb_t get_cb, dm_
     info->set_cb = set_cb;
     info->notify_set_cb = notify_set_cb;
     info->type_flags = type_flags;
+    info->group_id = NON_GROUPED;
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** USP_REGISTER_GroupedVendorParam_ReadOnly
+**
+** Registers a read only vendor parameter, whose value is got (along with the other parameters in the same group)
+** by the group's get vendor hook, rather than by a get vendor hook for each parameter
+** This is useful if the values of many parameters are obtained from the same driver or IPC backend, as the
+** values of all parameters in the group that are required by a USP message are got using a single call
+** NOTE: The group's get vendor hook is registered by USP_REGISTER_GroupVendorHooks()
+**
+** \param   group_id - group which this parameter belongs to
+** \param   path - full data model path for the parameter
+** \param   type_flags - type of the parameter
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INTERNAL_ERROR if any other error occurred
+**
+**************************************************************************/
+int USP_REGISTER_GroupedVendorParam_ReadOnly(int group_id, char *path, unsigned type_flags)
+{
+    dm_node_t *node;
+    dm_param_info_t *info;
+
+    // Exit if this function is not being called from within VENDOR_Init()
+    if (is_executing_within_dm_init == false)
+    {
+        USP_ERR_SetMessage(usp_err_bad_scope_str, __FUNCTION__, path);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if input parameters are not defined
+    if ((path == NULL) || (group_id < 0) || (group_id >= MAX_VENDOR_PARAM_GROUPS))
+    {
+        USP_ERR_SetMessage(usp_err_invalid_param_str, __FUNCTION__);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Add this path to the data model
+    node = DM_PRIV_AddSchemaPath(path, kDMNodeType_VendorParam_ReadOnly, 0);
+    if (node == NULL)
+    {
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Save registered info into the data model
+    info = &node->registered.param_info;
+    memset(info, 0, sizeof(dm_param_info_t));
+    info->get_cb = NULL;
+    info->set_cb = NULL;
+    info->type_flags = type_flags;
+    info->group_id = group_id;
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** USP_REGISTER_GroupedVendorParam_ReadWrite
+**
+** Registers a read write vendor parameter, whose value is got and set (along with the other parameters in the same group)
+** by the group's vendor hooks, rather than by vendor hooks for each parameter
+** Sets are not passed to the vendor immediately. Instead, all parameters in the group that were set in a transaction
+** are passed to the group's set vendor hook in a single call, when the transaction is committed
+** NOTE: The group's vendor hooks are registered by USP_REGISTER_GroupVendorHooks()
+**
+** \param   group_id - group which this parameter belongs to
+** \param   path - full data model path for the parameter
+** \param   type_flags - type of the parameter
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INTERNAL_ERROR if any other error occurred
+**
+**************************************************************************/
+int USP_REGISTER_GroupedVendorParam_ReadWrite(int group_id, char *path, unsigned type_flags)
+{
+    dm_node_t *node;
+    dm_param_info_t *info;
+
+    // Exit if this function is not being called from within VENDOR_Init()
+    if (is_executing_within_dm_init == false)
+    {
+        USP_ERR_SetMessage(usp_err_bad_scope_str, __FUNCTION__, path);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if input parameters are not defined
+    if ((path == NULL) || (group_id < 0) || (group_id >= MAX_VENDOR_PARAM_GROUPS))
+    {
+        USP_ERR_SetMessage(usp_err_invalid_param_str, __FUNCTION__);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Add this path to the data model
+    node = DM_PRIV_AddSchemaPath(path, kDMNodeType_VendorParam_ReadWrite, 0);
+    if (node == NULL)
+    {
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Save registered info into the data model
+    info = &node->registered.param_info;
+    memset(info, 0, sizeof(dm_param_info_t));
+    info->get_cb = NULL;
+    info->set_cb = NULL;
+    info->notify_set_cb = NULL;
+    info->type_flags = type_flags;
+    info->group_id = group_id;
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** USP_REGISTER_GroupVendorHooks
+**
+** Registers the vendor hooks used to get and set the values of the parameters in the specified group
+**
+** \param   group_id - group of vendor parameters that the vendor hooks apply to
+** \param   get_group_cb - callback called to get the values of a number of parameters in the group
+** \param   set_group_cb - callback called to set the values of all parameters in the group which were set in a transaction,
+**                         when the transaction is committed. May be NULL if the group contains no read write parameters
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INTERNAL_ERROR if any other error occurred
+**
+**************************************************************************/
+int USP_REGISTER_GroupVendorHooks(int group_id, dm_get_group_cb_t get_group_cb, dm_set_group_cb_t set_group_cb)
+{
+    // Exit if this function is not being called from within VENDOR_Init()
+    if (is_executing_within_dm_init == false)
+    {
+        USP_ERR_SetMessage(usp_err_bad_scope_str, __FUNCTION__, "undefined");
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if input parameters are incorrect
+    if ((group_id < 0) || (group_id >= MAX_VENDOR_PARAM_GROUPS) || (get_group_cb == NULL))
+    {
+        USP_ERR_SetMessage(usp_err_invalid_param_str, __FUNCTION__);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    group_vendor_hooks[group_id].get_group_cb = get_group_cb;
+    group_vendor_hooks[group_id].set_group_cb = set_group_cb;
     return USP_ERR_OK;
 }
 
@@ -1278,7 +1430,8 @@ int ValidateParamUniqueness(dm_req_t *req, char *value)
         if (strcmp(buf, value) == 0)
         {
             USP_ERR_SetMessage("%s: The value for %s (%s) is not unique (already used by instance %d)", __FUNCTION__, req->path, value, instance);
-            return USP_ERR_INVALID_ARGUMENTS;
+            err = USP_ERR_INVALID_ARGUMENTS;
+            goto exit;
         }
     }
 
@@ -62,11 +62,15 @@ typedef struct
 } kv_vector_t;
 
 //-----------------------------------------------------------------------------------------
-// Fixed-sized vector containing instance numbers
+// Vector containing instance numbers
+// NOTE: The array is dynamically allocated, and grows as instance numbers are added to it (up to MAX_DM_INSTANCES)
+// API change: Previously this structure contained a fixed size array of shorts. Vendor code which calls USP_DM_GetInstances()
+// must now call USP_DM_DestroyInstances() afterwards to free the array, and must be recompiled against this header
 typedef struct
 {
-    short vector[MAX_DM_INSTANCES];
+    int *vector;
     int num_entries;
+    int max_entries;    // Number of entries that the array has been allocated for
 } int_vector_t;
 
 //-------------------------------------------------------------------------
@@ -257,6 +261,37 @@ typedef enum
     kActivateMode_ConfirmationNeeded,
 } activate_mode_t;
 
+//-------------------------------------------------------------------------
+// Settings used to tune SQLite's access to the USP database (see '--dbtuning' command line option and get_db_tuning_cb)
+// NOTE: Journal modes and synchronous levels which are not safe against corruption on power loss (eg OFF, MEMORY) are not supported
+
+// Journal mode of the database
+typedef enum
+{
+    kDbJournal_Default,         // Do not change the journal mode stored in the database file (SQLite's default is DELETE)
+    kDbJournal_Delete,
+    kDbJournal_Truncate,
+    kDbJournal_Persist,
+    kDbJournal_Wal,
+} db_journal_mode_t;
+
+// Level of synchronisation to flash performed by SQLite
+typedef enum
+{
+    kDbSync_Default,            // Use SQLite's default (FULL)
+    kDbSync_Normal,             // Only crash-safe with WAL journaling. FULL is used with other journal modes
+    kDbSync_Full,
+    kDbSync_Extra,
+} db_sync_level_t;
+
+typedef struct
+{
+    db_journal_mode_t journal_mode;
+    db_sync_level_t synchronous;
+    long long mmap_size;        // Maximum number of bytes of the database file to access using memory-mapped I/O. 0 disables it. -1 uses SQLite's default
+    int cache_size;             // Size of the SQLite page cache. Positive values are in pages, negative values in KiB. 0 uses SQLite's default
+} db_tuning_t;
+
 //-------------------------------------------------------------------------
 // Typedefs for data model callback functions
 typedef int (*dm_get_value_cb_t)(dm_req_t *req, char *buf, int len);
@@ -277,6 +312,23 @@ typedef int (*dm_sync_oper_cb_t)(dm_req_t *req, char *command_key, kv_vector_t *
 typedef int (*dm_async_oper_cb_t)(dm_req_t *req, kv_vector_t *input_args, int instance);
 typedef int (*dm_async_restart_cb_t)(dm_req_t *req, int instance, bool *is_restart, int *err_code, char *err_msg, int err_msg_len, kv_vector_t *output_args);
 
+// Callback to get the values of a group of vendor parameters in a single call (see USP_REGISTER_GroupedVendorParam_ReadOnly)
+// The key of each entry in 'params' is the data model path of a parameter to get, and its value is initially NULL.
+// The vendor must set the value of each entry using USP_ARG_SetValue(), and must not add or remove entries. Entries left NULL are treated as failed.
+typedef int (*dm_get_group_cb_t)(int group_id, kv_vector_t *params);
+
+// Callback to set the values of a group of vendor parameters in a single call (see USP_REGISTER_GroupedVendorParam_ReadWrite)
+// The key of each entry in 'params' is the data model path of a parameter in the group which was set, and the value is its new value.
+// 'failures' is an array with one entry per entry in 'params', initialised to USP_ERR_OK. The vendor should set the entry
+// for each parameter that it failed to set to a USP error code. If the callback returns an error, then all parameters whose
+// entry is still USP_ERR_OK are treated as failing with that error. Failures are reported per parameter in USP Set and Add responses.
+// It is called once per transaction, when the transaction is committed, before the commit_trans_cb vendor hook. A USP Set or Add
+// request with allow_partial=false uses one transaction for all objects, whereas allow_partial=true uses one transaction per object.
+// If the vendor fails to set a parameter which the USP request marked as required, the transaction is aborted after this call,
+// even though the vendor may have applied the other values. Until it is called, getting a parameter which has been set returns
+// the vendor's current (old) value.
+typedef int (*dm_set_group_cb_t)(int group_id, kv_vector_t *params, int *failures);
+
 //-------------------------------------------------------------------------
 // Typedefs for core vendor hook callbacks
 
@@ -321,6 +373,10 @@ typedef int (*dm_vendor_get_mtp_password_cb_t)(int instance, char *buf, int len)
 typedef int (*load_agent_cert_cb_t)(SSL_CTX *ctx);
 typedef void (*log_message_cb_t)(char *buf);
 
+// Called at startup to allow the vendor to modify the settings used to tune SQLite's access to the USP database
+// On entry, 'tuning' contains the settings specified by the '--dbtuning' command line option (or the defaults)
+typedef int (*get_db_tuning_cb_t)(db_tuning_t *tuning);
+
 //-------------------------------------------------------------------------
 // Typedef for structure containing core vendor hook callbacks
 // IMPORTANT:  DO NOT WRITE CODE THAT DEPENDS ON THE POSITION OF THE CALLBACK WITHIN THIS STRUCTURE !
@@ -351,6 +407,7 @@ typedef struct
     dm_vendor_get_mtp_password_cb_t         get_mtp_password_cb;
     load_agent_cert_cb_t                    load_agent_cert_cb;
     log_message_cb_t                        log_message_cb;
+    get_db_tuning_cb_t                      get_db_tuning_cb;
 
 } vendor_hook_cb_t;
 
@@ -366,11 +423,16 @@ typedef struct
 //-------------------------------------------------------------------------
 // Functions to register the data model
 // These functions may only be called during startup (which for vendor code, means within VENDOR_Init())
+// NOTE: Registration closes when VENDOR_Init() returns, before VENDOR_Start() and the other vendor hooks called at startup
+//       (eg the get agent serial number and get agent endpoint ID hooks). Calling these functions from those hooks returns USP_ERR_INTERNAL_ERROR
 int USP_REGISTER_Param_Constant(char *path, char *value, unsigned type_flags);
 int USP_REGISTER_DBParam_ReadWrite(char *path, char *value, dm_validate_value_cb_t validator_cb, dm_notify_set_cb_t notify_set_cb, unsigned type_flags);
 int USP_REGISTER_Param_NumEntries(char *path, char *table_path);
 int USP_REGISTER_VendorParam_ReadOnly(char *path, dm_get_value_cb_t get_cb, unsigned type_flags);
 int USP_REGISTER_VendorParam_ReadWrite(char *path, dm_get_value_cb_t get_cb, dm_set_value_cb_t set_cb, dm_notify_set_cb_t notify_set_cb, unsigned type_flags);
+int USP_REGISTER_GroupedVendorParam_ReadOnly(int group_id, char *path, unsigned type_flags);
+int USP_REGISTER_GroupedVendorParam_ReadWrite(int group_id, char *path, unsigned type_flags);
+int USP_REGISTER_GroupVendorHooks(int group_id, dm_get_group_cb_t get_group_cb, dm_set_group_cb_t set_group_cb);
 int USP_REGISTER_DBParam_ReadOnlyAuto(char *path, dm_get_value_cb_t get_cb, unsigned type_flags);
 int USP_REGISTER_DBParam_ReadWriteAuto(char *path, dm_get_value_cb_t get_cb, dm_validate_value_cb_t validator_cb, 
                                       dm_notify_set_cb_t notify_set_cb, unsigned type_flags);
@@ -396,6 +458,7 @@ int USP_DM_SetParameterValue(char *path, char *new_value);
 int USP_DM_DeleteInstance(char *path);
 int USP_DM_InformInstance(char *path);
 int USP_DM_GetInstances(char *path, int_vector_t *iv);
+void USP_DM_DestroyInstances(int_vector_t *iv);
 int USP_DM_RegisterRoleName(ctrust_role_t role, char *name);
 int USP_DM_AddControllerTrustPermission(ctrust_role_t role, char *path, unsigned short permission_bitmask);
 
@@ -412,6 +475,7 @@ int USP_SIGNAL_ObjectDeleted(char *path);
 kv_vector_t * USP_ARG_Create(void);
 void USP_ARG_Init(kv_vector_t *kvv);
 void USP_ARG_Add(kv_vector_t *kvv, char *key, char *value);
+void USP_ARG_SetValue(kv_vector_t *kvv, int index, char *value);
 void USP_ARG_AddUnsigned(kv_vector_t *kvv, char *key, unsigned value);
 void USP_ARG_AddBool(kv_vector_t *kvv, char *key, bool value);
 void USP_ARG_AddDateTime(kv_vector_t *kvv, char *key, time_t value);